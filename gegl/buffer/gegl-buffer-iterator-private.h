@@ -24,4 +24,10 @@ G_STATIC_ASSERT (GEGL_BUFFER_READWRITE == 0x3);
 #define GEGL_ITERATOR_INCOMPATIBLE (1 << 2)
 #define GEGL_ITERATOR_NO_NOTIFY    (1 << 3)
 
+/* set in the access mode of the first buffer of an iterator, makes it stop
+ * at the next tile once the rendering job of the calling thread is
+ * cancelled; only for callers whose output is discarded in that case
+ */
+#define GEGL_ITERATOR_CANCELLABLE  (1 << 4)
+
 #endif
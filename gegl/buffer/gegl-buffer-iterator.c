@@ -47,6 +47,7 @@ typedef enum {
   GeglIteratorTileMode_DirectTile,
   GeglIteratorTileMode_LinearTile,
   GeglIteratorTileMode_GetBuffer,
+  GeglIteratorTileMode_ConvertedTile,
   GeglIteratorTileMode_Empty,
 } GeglIteratorTileMode;
 
@@ -70,6 +71,11 @@ typedef struct _SubIterState {
   /* Linear data members */
   GeglTile            *linear_tile;
   gpointer             linear;
+  /* Converted data members */
+  const Babl          *read_fish;
+  const Babl          *write_fish;
+  guchar              *tile_data;
+  gint                 tile_stride;
 } SubIterState;
 
 struct _GeglBufferIteratorPriv
@@ -161,6 +167,8 @@ _gegl_buffer_iterator_add (GeglBufferIterator  *iter,
       sub->current_tile     = NULL;
       sub->real_data        = NULL;
       sub->linear_tile      = NULL;
+      sub->read_fish        = NULL;
+      sub->write_fish       = NULL;
       sub->format           = format;
       sub->format_bpp       = babl_format_get_bytes_per_pixel (format);
       sub->level            = level;
@@ -208,6 +216,29 @@ gegl_buffer_iterator_new (GeglBuffer          *buf,
   return iter;
 }
 
+/* converts the pixels of @rect between a tile and tightly packed scratch
+ * memory, in a single batch when it spans whole rows of the tile.
+ */
+static inline void
+convert_rect (const Babl          *fish,
+              const guchar        *src,
+              gint                 src_stride,
+              guchar              *dst,
+              gint                 dst_stride,
+              const GeglRectangle *rect,
+              gboolean             contiguous)
+{
+  if (contiguous)
+    {
+      babl_process (fish, src, dst, rect->width * rect->height);
+    }
+  else
+    {
+      babl_process_rows (fish, src, src_stride, dst, dst_stride,
+                         rect->width, rect->height);
+    }
+}
+
 static inline void
 release_tile (GeglBufferIterator *iter,
               int index)
@@ -233,6 +264,32 @@ release_tile (GeglBufferIterator *iter,
       sub->current_tile = NULL;
       iter->items[index].data = NULL;
 
+      sub->current_tile_mode = GeglIteratorTileMode_Empty;
+    }
+  else if (sub->current_tile_mode == GeglIteratorTileMode_ConvertedTile)
+    {
+      if (sub->access_mode & GEGL_ACCESS_WRITE)
+        {
+          convert_rect (sub->write_fish,
+                        sub->real_data, sub->row_stride,
+                        sub->tile_data, sub->tile_stride,
+                        &sub->real_roi,
+                        sub->real_roi.width == sub->buffer->tile_width);
+
+          gegl_tile_unlock_no_void (sub->current_tile);
+        }
+      else
+        {
+          gegl_tile_read_unlock (sub->current_tile);
+        }
+      gegl_tile_unref (sub->current_tile);
+
+      gegl_scratch_free (sub->real_data);
+      sub->current_tile = NULL;
+      sub->real_data = NULL;
+      sub->tile_data = NULL;
+      iter->items[index].data = NULL;
+
       sub->current_tile_mode = GeglIteratorTileMode_Empty;
     }
   else if (sub->current_tile_mode == GeglIteratorTileMode_GetBuffer)
@@ -394,6 +451,38 @@ get_tile (GeglBufferIterator *iter,
       sub->current_tile_mode = GeglIteratorTileMode_DirectTile;
     }
 
+  if (sub->read_fish || sub->write_fish)
+    {
+      /* the sub-iterator only differs from the buffer in format; convert
+       * the part of the tile it covers directly, using the fishes resolved
+       * for the whole iteration
+       */
+      const GeglRectangle *roi = &iter->items[index].roi;
+
+      sub->tile_data = (guchar *) gegl_tile_get_data (sub->current_tile) +
+                       (roi->y - sub->real_roi.y) * sub->tile_stride      +
+                       (roi->x - sub->real_roi.x) *
+                       (sub->tile_stride / buf->tile_width);
+
+      sub->real_roi   = *roi;
+      sub->row_stride = roi->width * sub->format_bpp;
+      sub->real_data  = gegl_scratch_alloc (sub->row_stride * roi->height);
+
+      if (sub->access_mode & GEGL_ACCESS_READ)
+        {
+          convert_rect (sub->read_fish,
+                        sub->tile_data, sub->tile_stride,
+                        sub->real_data, sub->row_stride,
+                        roi, roi->width == buf->tile_width);
+        }
+
+      iter->items[index].data = sub->real_data;
+
+      sub->current_tile_mode = GeglIteratorTileMode_ConvertedTile;
+
+      return;
+    }
+
   sub->row_stride = buf->tile_width * sub->format_bpp;
 
   iter->items[index].data = gegl_tile_get_data (sub->current_tile);
@@ -452,7 +541,8 @@ needs_rows (GeglBufferIterator *iter,
   GeglBufferIteratorPriv *priv = iter->priv;
   SubIterState           *sub  = &priv->sub_iter[index];
 
-  if (sub->current_tile_mode == GeglIteratorTileMode_GetBuffer)
+  if (sub->current_tile_mode == GeglIteratorTileMode_GetBuffer ||
+      sub->current_tile_mode == GeglIteratorTileMode_ConvertedTile)
    return FALSE;
 
   if (iter->items[index].roi.width  != sub->buffer->tile_width ||
@@ -562,20 +652,20 @@ prepare_iteration (GeglBufferIterator *iter)
             }
         }
 
-      /* Format converison needed */
-      if (gegl_buffer_get_format (sub->buffer) != sub->format)
-        sub->access_mode |= GEGL_ITERATOR_INCOMPATIBLE;
       /* Incompatiable tiles */
-      else if ((priv->origin_tile.width  != buf->tile_width) ||
-               (priv->origin_tile.height != buf->tile_height) ||
-               (abs(origin_offset_x - current_offset_x) % priv->origin_tile.width != 0) ||
-               (abs(origin_offset_y - current_offset_y) % priv->origin_tile.height != 0))
+      if ((priv->origin_tile.width  != buf->tile_width) ||
+          (priv->origin_tile.height != buf->tile_height) ||
+          (abs(origin_offset_x - current_offset_x) % priv->origin_tile.width != 0) ||
+          (abs(origin_offset_y - current_offset_y) % priv->origin_tile.height != 0))
         {
+          /* Format converison needed */
+          if (gegl_buffer_get_format (sub->buffer) != sub->format)
+            sub->access_mode |= GEGL_ITERATOR_INCOMPATIBLE;
           /* Check if the buffer is a linear buffer */
-          if ((buf->extent.x      == -buf->shift_x) &&
-              (buf->extent.y      == -buf->shift_y) &&
-              (buf->extent.width  == buf->tile_width) &&
-              (buf->extent.height == buf->tile_height))
+          else if ((buf->extent.x      == -buf->shift_x) &&
+                   (buf->extent.y      == -buf->shift_y) &&
+                   (buf->extent.width  == buf->tile_width) &&
+                   (buf->extent.height == buf->tile_height))
             {
               g_rec_mutex_lock (&buf->tile_storage->mutex);
 
@@ -595,6 +685,19 @@ prepare_iteration (GeglBufferIterator *iter)
           else
             sub->access_mode |= GEGL_ITERATOR_INCOMPATIBLE;
         }
+      /* Format converison needed, between the tiles and scratch memory */
+      else if (gegl_buffer_get_format (sub->buffer) != sub->format)
+        {
+          const Babl *buf_format = gegl_buffer_get_format (sub->buffer);
+
+          sub->tile_stride = buf->tile_width *
+                             babl_format_get_bytes_per_pixel (buf_format);
+
+          if (sub->access_mode & GEGL_ACCESS_READ)
+            sub->read_fish = babl_fish (buf_format, sub->format);
+          if (sub->access_mode & GEGL_ACCESS_WRITE)
+            sub->write_fish = babl_fish (sub->format, buf_format);
+        }
     }
 }
 
@@ -855,6 +958,16 @@ gegl_buffer_iterator_next (GeglBufferIterator *iter)
             release_tile (iter, index);
         }
 
+      /* the output of cancelled jobs is discarded, don't bother with the
+       * rest of the area, if the caller allows it
+       */
+      if ((priv->sub_iter[0].access_mode & GEGL_ITERATOR_CANCELLABLE) &&
+          gegl_buffer_ext_cancelled && gegl_buffer_ext_cancelled ())
+        {
+          _gegl_buffer_iterator_stop (iter);
+          return FALSE;
+        }
+
       if (increment_rects (iter) == FALSE)
         {
           _gegl_buffer_iterator_stop (iter);
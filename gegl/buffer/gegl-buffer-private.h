@@ -156,6 +156,12 @@ struct _GeglTile
   guint            rev;         /* this tile revision */
   guint            stored_rev;  /* what revision was we when we from tile_storage?
                                    (currently set to 1 when loaded from disk */
+  guint            summary;      /* GeglTileSummary flags known to hold for
+                                    the tile data, and which of them were
+                                    checked, see gegl_tile_get_summary() */
+  guint            summary_rev;  /* the revision the summary is valid for */
+  gint             summary_lock; /* spinlock, publishing summary and
+                                    summary_rev together */
 
   gint             lock_count;       /* number of outstanding write locks */
   gint             read_lock_count;  /* number of outstanding read locks */
@@ -201,6 +207,24 @@ void     gegl_tile_unlock_no_void (GeglTile *tile);
 gboolean gegl_tile_damage         (GeglTile *tile,
                                    guint64   damage);
 
+/* flags summarizing the pixels of a tile, or of a region of a buffer.  they
+ * are checked when first asked for, and kept with the tile until its data
+ * changes.
+ */
+typedef enum
+{
+  GEGL_TILE_SUMMARY_TRANSPARENT = 1 << 0, /* the alpha of every pixel is 0  */
+  GEGL_TILE_SUMMARY_OPAQUE      = 1 << 1  /* the alpha of every pixel is 1  */
+} GeglTileSummary;
+
+guint    gegl_tile_get_summary    (GeglTile            *tile,
+                                   const Babl          *format,
+                                   guint                flags);
+
+guint    gegl_buffer_get_summary  (GeglBuffer          *buffer,
+                                   const GeglRectangle *rect,
+                                   guint                flags);
+
 void _gegl_buffer_drop_hot_tile (GeglBuffer *buffer);
 
 GeglRectangle _gegl_get_required_for_scale (const GeglRectangle *roi,
@@ -217,6 +241,9 @@ gboolean gegl_buffer_scan_compatible (GeglBuffer *bufferA,
 extern void (*gegl_tile_handler_cache_ext_flush) (void *tile_handler_cache, const GeglRectangle *rect);
 extern void (*gegl_buffer_ext_flush) (GeglBuffer *buffer, const GeglRectangle *rect);
 extern void (*gegl_buffer_ext_invalidate) (GeglBuffer *buffer, const GeglRectangle *rect);
+/* returns TRUE when the rendering job of the calling thread was cancelled,
+ * iterators stop early in this case */
+extern gboolean (*gegl_buffer_ext_cancelled) (void);
 
 
 extern void (*gegl_resample_bilinear) (guchar *dest_buf,
@@ -1301,9 +1301,59 @@ gegl_buffer_get_tile (GeglBuffer *buffer,
   return tile;
 }
 
+/* returns which of the GeglTileSummary @flags hold for all the pixels of
+ * @rect at level 0, as the tiles covering it summarize them; pixels outside
+ * of the abyss of @buffer are transparent.
+ */
+guint
+gegl_buffer_get_summary (GeglBuffer          *buffer,
+                         const GeglRectangle *rect,
+                         guint                flags)
+{
+  guint          summary = flags;
+  GeglRectangle  roi;
+  gint           x0, y0, x1, y1;
+  gint           x, y;
+
+  /* the tiles are only summarized for the format of their data */
+  if (buffer->soft_format != buffer->format)
+    return 0;
+
+  if (! gegl_rectangle_intersect (&roi, rect, &buffer->abyss))
+    return flags & GEGL_TILE_SUMMARY_TRANSPARENT;
+
+  if (! gegl_rectangle_equal (&roi, rect))
+    summary &= GEGL_TILE_SUMMARY_TRANSPARENT;
+
+  x0 = gegl_tile_indice (roi.x + buffer->shift_x, buffer->tile_width);
+  y0 = gegl_tile_indice (roi.y + buffer->shift_y, buffer->tile_height);
+  x1 = gegl_tile_indice (roi.x + roi.width  - 1 + buffer->shift_x,
+                         buffer->tile_width);
+  y1 = gegl_tile_indice (roi.y + roi.height - 1 + buffer->shift_y,
+                         buffer->tile_height);
+
+  for (y = y0; y <= y1 && summary; y++)
+    {
+      for (x = x0; x <= x1 && summary; x++)
+        {
+          GeglTile *tile = gegl_buffer_get_tile (buffer, x, y, 0);
+
+          if (! tile)
+            return 0;
+
+          summary = gegl_tile_get_summary (tile, buffer->format, summary);
+
+          gegl_tile_unref (tile);
+        }
+    }
+
+  return summary;
+}
+
 void (*gegl_tile_handler_cache_ext_flush) (void *cache, const GeglRectangle *rect)=NULL;
 void (*gegl_buffer_ext_flush) (GeglBuffer *buffer, const GeglRectangle *rect)=NULL;
 void (*gegl_buffer_ext_invalidate) (GeglBuffer *buffer, const GeglRectangle *rect)=NULL;
+gboolean (*gegl_buffer_ext_cancelled) (void)=NULL;
 
 void (*gegl_resample_bilinear) (guchar              *dest_buf,
                                 const guchar        *source_buf,
@@ -579,6 +579,68 @@ void              gegl_sampler_get            (GeglSampler       *sampler,
                                                void              *output,
                                                GeglAbyssPolicy   repeat_mode);
 
+/**
+ * GEGL_SAMPLER_BATCH_SIZE:
+ *
+ * The number of samples gegl_sampler_get_n() and gegl_sampler_get_line()
+ * process at once; longer runs are split into batches of this size, and
+ * callers computing coordinates on the fly can use it as a good size for
+ * their own batches.
+ */
+#define GEGL_SAMPLER_BATCH_SIZE 64
+
+/**
+ * gegl_sampler_get_n: (skip)
+ * @sampler: a GeglSampler gotten from gegl_buffer_sampler_new
+ * @x: (array length=n): x coordinates to sample
+ * @y: (array length=n): y coordinates to sample
+ * @n: number of samples
+ * @scale: matrix representing extent of sampling area in source buffer,
+ * shared by all the samples.
+ * @output: memory location for the @n consecutive output pixels.
+ * @repeat_mode: how requests outside the buffer extent are handled, as for
+ * gegl_sampler_get().
+ *
+ * Perform @n samplings with the provided @sampler at once, which is faster
+ * than calling the function returned by gegl_sampler_get_fun() for each of
+ * them, and gives the same results.
+ */
+void              gegl_sampler_get_n          (GeglSampler       *sampler,
+                                               const gdouble     *x,
+                                               const gdouble     *y,
+                                               gint               n,
+                                               GeglBufferMatrix2 *scale,
+                                               void              *output,
+                                               GeglAbyssPolicy    repeat_mode);
+
+/**
+ * gegl_sampler_get_line: (skip)
+ * @sampler: a GeglSampler gotten from gegl_buffer_sampler_new
+ * @x: x coordinate of the first sample
+ * @y: y coordinate of the first sample
+ * @dx: x step between consecutive samples
+ * @dy: y step between consecutive samples
+ * @n: number of samples
+ * @scale: matrix representing extent of sampling area in source buffer,
+ * shared by all the samples.
+ * @output: memory location for the @n consecutive output pixels.
+ * @repeat_mode: how requests outside the buffer extent are handled, as for
+ * gegl_sampler_get().
+ *
+ * Like gegl_sampler_get_n(), for @n samples along a line, such as the
+ * source coordinates of a scanline of an affine transform.  The coordinates
+ * of sample i + 1 are those of sample i, plus (@dx, @dy).
+ */
+void              gegl_sampler_get_line       (GeglSampler       *sampler,
+                                               gdouble            x,
+                                               gdouble            y,
+                                               gdouble            dx,
+                                               gdouble            dy,
+                                               gint               n,
+                                               GeglBufferMatrix2 *scale,
+                                               void              *output,
+                                               GeglAbyssPolicy    repeat_mode);
+
 /* code template utility, updates the jacobian matrix using
  * a user defined mapping function for displacement, example
  * with an identity transform (note that for the identity
@@ -47,6 +47,13 @@ static void            gegl_sampler_cubic_get         (      GeglSampler* restri
                                                              GeglBufferMatrix2*     scale,
                                                              void*        restrict  output,
                                                              GeglAbyssPolicy        repeat_mode);
+static void            gegl_sampler_cubic_get_n       (      GeglSampler* restrict  self,
+                                                       const gdouble               *x,
+                                                       const gdouble               *y,
+                                                             gint                   n,
+                                                             GeglBufferMatrix2*     scale,
+                                                             void*        restrict  output,
+                                                             GeglAbyssPolicy        repeat_mode);
 static void            get_property                   (      GObject               *gobject,
                                                              guint                  prop_id,
                                                              GValue                *value,
@@ -74,6 +81,7 @@ gegl_sampler_cubic_class_init (GeglSamplerCubicClass *klass)
 
   sampler_class->get         = gegl_sampler_cubic_get;
   sampler_class->interpolate = gegl_sampler_cubic_interpolate;
+  sampler_class->get_n       = gegl_sampler_cubic_get_n;
 
   g_object_class_install_property ( object_class, PROP_B,
     g_param_spec_double ("b",
@@ -142,15 +150,19 @@ gegl_sampler_cubic_init (GeglSamplerCubic *self)
   self->c = 0.5 * (1.0 - self->b);
 }
 
+/*
+ * Takes the number of components as a parameter, so that callers passing a
+ * constant get a version whose per-component loops are unrolled.
+ */
 static inline void
-gegl_sampler_cubic_interpolate (      GeglSampler     *self,
-                                const gdouble          absolute_x,
-                                const gdouble          absolute_y,
-                                      gfloat          *output,
-                                      GeglAbyssPolicy  repeat_mode)
+gegl_sampler_cubic_interpolate_nc (      GeglSampler     *self,
+                                   const gdouble          absolute_x,
+                                   const gdouble          absolute_y,
+                                         gfloat          *output,
+                                         GeglAbyssPolicy  repeat_mode,
+                                   const gint             components)
 {
   GeglSamplerCubic *cubic      = (GeglSamplerCubic*)(self);
-  gint              components = self->interpolate_components;
   gfloat            cubic_b    = cubic->b;
   gfloat            cubic_c    = cubic->c;
   gfloat           *sampler_bptr;
@@ -211,6 +223,18 @@ gegl_sampler_cubic_interpolate (      GeglSampler     *self,
     }
 }
 
+static inline void
+gegl_sampler_cubic_interpolate (      GeglSampler     *self,
+                                const gdouble          absolute_x,
+                                const gdouble          absolute_y,
+                                      gfloat          *output,
+                                      GeglAbyssPolicy  repeat_mode)
+{
+  gegl_sampler_cubic_interpolate_nc (self, absolute_x, absolute_y, output,
+                                     repeat_mode,
+                                     self->interpolate_components);
+}
+
 static void
 gegl_sampler_cubic_get (      GeglSampler       *self,
                         const gdouble            absolute_x,
@@ -235,6 +259,48 @@ gegl_sampler_cubic_get (      GeglSampler       *self,
   }
 }
 
+static void
+gegl_sampler_cubic_get_n (      GeglSampler       *self,
+                          const gdouble           *x,
+                          const gdouble           *y,
+                                gint               n,
+                                GeglBufferMatrix2 *scale,
+                                void              *output,
+                                GeglAbyssPolicy    repeat_mode)
+{
+  gfloat result[GEGL_SAMPLER_BATCH_SIZE * 5];
+  gint   nc = self->interpolate_components;
+  gint   i;
+
+  if (_gegl_sampler_box_needed (scale))
+    {
+      gint    bpp = babl_format_get_bytes_per_pixel (self->format);
+      guchar *dst = output;
+
+      for (i = 0; i < n; i++)
+        gegl_sampler_cubic_get (self, x[i], y[i], scale, dst + i * bpp,
+                                repeat_mode);
+
+      return;
+    }
+
+  /* RaGaBaA float, the common case, gets its own loop */
+  if (nc == 4)
+    {
+      for (i = 0; i < n; i++)
+        gegl_sampler_cubic_interpolate_nc (self, x[i], y[i], result + i * 4,
+                                           repeat_mode, 4);
+    }
+  else
+    {
+      for (i = 0; i < n; i++)
+        gegl_sampler_cubic_interpolate_nc (self, x[i], y[i], result + i * nc,
+                                           repeat_mode, nc);
+    }
+
+  _gegl_sampler_process_n (self, result, output, n);
+}
+
 static void
 get_property (GObject    *object,
               guint       prop_id,
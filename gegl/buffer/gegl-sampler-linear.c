@@ -43,6 +43,13 @@ static void          gegl_sampler_linear_get         (      GeglSampler* restric
                                                             GeglBufferMatrix2     *scale,
                                                             void*        restrict  output,
                                                             GeglAbyssPolicy        repeat_mode);
+static void          gegl_sampler_linear_get_n       (      GeglSampler* restrict  self,
+                                                      const gdouble               *x,
+                                                      const gdouble               *y,
+                                                            gint                   n,
+                                                            GeglBufferMatrix2     *scale,
+                                                            void*        restrict  output,
+                                                            GeglAbyssPolicy        repeat_mode);
 
 G_DEFINE_TYPE (GeglSamplerLinear, gegl_sampler_linear, GEGL_TYPE_SAMPLER)
 
@@ -53,6 +60,7 @@ gegl_sampler_linear_class_init (GeglSamplerLinearClass *klass)
 
   sampler_class->get         = gegl_sampler_linear_get;
   sampler_class->interpolate = gegl_sampler_linear_interpolate;
+  sampler_class->get_n       = gegl_sampler_linear_get_n;
 }
 
 /*
@@ -79,14 +87,18 @@ gegl_sampler_linear_init (GeglSamplerLinear *self)
   GEGL_SAMPLER (self)->level[0].context_rect.height =  3 + 2*LINEAR_EXTRA_ELBOW_ROOM;
 }
 
+/*
+ * Takes the number of components as a parameter, so that callers passing a
+ * constant get a version whose per-component loops are unrolled.
+ */
 static inline void
-gegl_sampler_linear_interpolate (      GeglSampler       *self,
-                                 const gdouble            absolute_x,
-                                 const gdouble            absolute_y,
-                                       gfloat            *output,
-                                       GeglAbyssPolicy    repeat_mode)
+gegl_sampler_linear_interpolate_nc (      GeglSampler       *self,
+                                    const gdouble            absolute_x,
+                                    const gdouble            absolute_y,
+                                          gfloat            *output,
+                                          GeglAbyssPolicy    repeat_mode,
+                                    const gint               nc)
 {
-  gint       nc                    = self->interpolate_components;
   const gint pixels_per_buffer_row = GEGL_SAMPLER_MAXIMUM_WIDTH;
 
   /*
@@ -178,6 +190,18 @@ gegl_sampler_linear_interpolate (      GeglSampler       *self,
   }
 }
 
+static inline void
+gegl_sampler_linear_interpolate (      GeglSampler       *self,
+                                 const gdouble            absolute_x,
+                                 const gdouble            absolute_y,
+                                       gfloat            *output,
+                                       GeglAbyssPolicy    repeat_mode)
+{
+  gegl_sampler_linear_interpolate_nc (self, absolute_x, absolute_y, output,
+                                      repeat_mode,
+                                      self->interpolate_components);
+}
+
 static void
 gegl_sampler_linear_get (      GeglSampler       *self,
                          const gdouble            absolute_x,
@@ -201,3 +225,45 @@ gegl_sampler_linear_get (      GeglSampler       *self,
 #endif
   }
 }
+
+static void
+gegl_sampler_linear_get_n (      GeglSampler       *self,
+                           const gdouble           *x,
+                           const gdouble           *y,
+                                 gint               n,
+                                 GeglBufferMatrix2 *scale,
+                                 void              *output,
+                                 GeglAbyssPolicy    repeat_mode)
+{
+  gfloat result[GEGL_SAMPLER_BATCH_SIZE * 5];
+  gint   nc = self->interpolate_components;
+  gint   i;
+
+  if (_gegl_sampler_box_needed (scale))
+    {
+      gint    bpp = babl_format_get_bytes_per_pixel (self->format);
+      guchar *dst = output;
+
+      for (i = 0; i < n; i++)
+        gegl_sampler_linear_get (self, x[i], y[i], scale, dst + i * bpp,
+                                 repeat_mode);
+
+      return;
+    }
+
+  /* RaGaBaA float, the common case, gets its own loop */
+  if (nc == 4)
+    {
+      for (i = 0; i < n; i++)
+        gegl_sampler_linear_interpolate_nc (self, x[i], y[i], result + i * 4,
+                                            repeat_mode, 4);
+    }
+  else
+    {
+      for (i = 0; i < n; i++)
+        gegl_sampler_linear_interpolate_nc (self, x[i], y[i], result + i * nc,
+                                            repeat_mode, nc);
+    }
+
+  _gegl_sampler_process_n (self, result, output, n);
+}
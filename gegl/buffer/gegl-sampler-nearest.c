@@ -27,6 +27,7 @@
 #include "gegl-tile-storage.h"
 #include "gegl-tile-backend.h"
 #include "gegl-sampler-nearest.h"
+#include "gegl-scratch.h"
 
 enum
 {
@@ -45,6 +46,15 @@ gegl_sampler_nearest_get (GeglSampler*    restrict self,
                           void*           restrict output,
                           GeglAbyssPolicy          repeat_mode);
 
+static void
+gegl_sampler_nearest_get_n (      GeglSampler*    restrict  self,
+                            const gdouble                  *x,
+                            const gdouble                  *y,
+                                  gint                      n,
+                                  GeglBufferMatrix2        *scale,
+                                  void*           restrict  output,
+                                  GeglAbyssPolicy           repeat_mode);
+
 static void
 gegl_sampler_nearest_prepare (GeglSampler*    restrict self);
 
@@ -59,6 +69,7 @@ gegl_sampler_nearest_class_init (GeglSamplerNearestClass *klass)
   object_class->dispose = gegl_sampler_nearest_dispose;
 
   sampler_class->get = gegl_sampler_nearest_get;
+  sampler_class->get_n = gegl_sampler_nearest_get_n;
   sampler_class->prepare = gegl_sampler_nearest_prepare;
 }
 
@@ -91,33 +102,36 @@ gegl_sampler_nearest_dispose (GObject *object)
   G_OBJECT_CLASS (gegl_sampler_nearest_parent_class)->dispose (object);
 }
 
-static inline void
-gegl_sampler_get_pixel (GeglSampler    *sampler,
-                        gint            x,
-                        gint            y,
-                        gpointer        data,
-                        GeglAbyssPolicy repeat_mode)
+/*
+ * Maps (x, y) back into the buffer according to repeat_mode, and returns
+ * TRUE, unless it's in the abyss, in which case the abyss color is stored
+ * in data instead, and FALSE is returned.
+ */
+static inline gboolean
+gegl_sampler_nearest_map (GeglSampler    *sampler,
+                          gint           *x,
+                          gint           *y,
+                          gpointer        data,
+                          GeglAbyssPolicy repeat_mode)
 {
-  GeglSamplerNearest *nearest_sampler = (GeglSamplerNearest*)(sampler);
-  GeglBuffer *buffer = sampler->buffer;
-  const GeglRectangle *abyss = &buffer->abyss;
+  const GeglRectangle *abyss = &sampler->buffer->abyss;
   guchar              *buf   = data;
 
-  if (y <  abyss->y ||
-      x <  abyss->x ||
-      y >= abyss->y + abyss->height ||
-      x >= abyss->x + abyss->width)
+  if (*y <  abyss->y ||
+      *x <  abyss->x ||
+      *y >= abyss->y + abyss->height ||
+      *x >= abyss->x + abyss->width)
     {
       switch (repeat_mode)
       {
         case GEGL_ABYSS_CLAMP:
-          x = CLAMP (x, abyss->x, abyss->x+abyss->width-1);
-          y = CLAMP (y, abyss->y, abyss->y+abyss->height-1);
+          *x = CLAMP (*x, abyss->x, abyss->x+abyss->width-1);
+          *y = CLAMP (*y, abyss->y, abyss->y+abyss->height-1);
           break;
 
         case GEGL_ABYSS_LOOP:
-          x = abyss->x + GEGL_REMAINDER (x - abyss->x, abyss->width);
-          y = abyss->y + GEGL_REMAINDER (y - abyss->y, abyss->height);
+          *x = abyss->x + GEGL_REMAINDER (*x - abyss->x, abyss->width);
+          *y = abyss->y + GEGL_REMAINDER (*y - abyss->y, abyss->height);
           break;
 
         case GEGL_ABYSS_BLACK:
@@ -127,7 +141,7 @@ gegl_sampler_get_pixel (GeglSampler    *sampler,
                           color,
                           buf,
                           1);
-            return;
+            return FALSE;
           }
 
         case GEGL_ABYSS_WHITE:
@@ -138,70 +152,102 @@ gegl_sampler_get_pixel (GeglSampler    *sampler,
                           color,
                           buf,
                           1);
-            return;
+            return FALSE;
           }
 
         default:
         case GEGL_ABYSS_NONE:
           memset (buf, 0x00, babl_format_get_bytes_per_pixel (sampler->format));
-          return;
+          return FALSE;
       }
     }
 
-  gegl_buffer_lock (sampler->buffer);
+  return TRUE;
+}
 
-  {
-    gint tile_width  = buffer->tile_width;
-    gint tile_height = buffer->tile_height;
-    gint tiledy      = y + buffer->shift_y;
-    gint tiledx      = x + buffer->shift_x;
-    gint indice_x    = gegl_tile_indice (tiledx, tile_width);
-    gint indice_y    = gegl_tile_indice (tiledy, tile_height);
+/*
+ * Returns a pointer to the pixel at (x, y), which must be inside the
+ * buffer's abyss, in the buffer's format, or NULL.  The pointer stays valid
+ * until the next call.  The buffer must be locked.
+ */
+static inline const guchar *
+gegl_sampler_nearest_get_data (GeglSampler *sampler,
+                               gint         x,
+                               gint         y)
+{
+  GeglSamplerNearest *nearest_sampler = (GeglSamplerNearest*)(sampler);
+  GeglBuffer *buffer = sampler->buffer;
 
-    GeglTile *tile = nearest_sampler->hot_tile;
+  gint tile_width  = buffer->tile_width;
+  gint tile_height = buffer->tile_height;
+  gint tiledy      = y + buffer->shift_y;
+  gint tiledx      = x + buffer->shift_x;
+  gint indice_x    = gegl_tile_indice (tiledx, tile_width);
+  gint indice_y    = gegl_tile_indice (tiledy, tile_height);
 
-    if (!(tile &&
-          tile->x == indice_x &&
-          tile->y == indice_y))
-      {
-        g_rec_mutex_lock (&buffer->tile_storage->mutex);
+  GeglTile *tile = nearest_sampler->hot_tile;
 
-        if (tile)
-          {
-            gegl_tile_read_unlock (tile);
+  if (!(tile &&
+        tile->x == indice_x &&
+        tile->y == indice_y))
+    {
+      g_rec_mutex_lock (&buffer->tile_storage->mutex);
 
-            gegl_tile_unref (tile);
-          }
+      if (tile)
+        {
+          gegl_tile_read_unlock (tile);
 
-        tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
-                                          indice_x, indice_y,
-                                          0);
-        nearest_sampler->hot_tile = tile;
+          gegl_tile_unref (tile);
+        }
 
-        gegl_tile_read_lock (tile);
+      tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
+                                        indice_x, indice_y,
+                                        0);
+      nearest_sampler->hot_tile = tile;
 
-        g_rec_mutex_unlock (&buffer->tile_storage->mutex);
-      }
+      gegl_tile_read_lock (tile);
 
-    if (tile)
-      {
-        gint tile_origin_x = indice_x * tile_width;
-        gint tile_origin_y = indice_y * tile_height;
-        gint       offsetx = tiledx - tile_origin_x;
-        gint       offsety = tiledy - tile_origin_y;
+      g_rec_mutex_unlock (&buffer->tile_storage->mutex);
+    }
 
-        guchar *tp;
+  if (tile)
+    {
+      gint tile_origin_x = indice_x * tile_width;
+      gint tile_origin_y = indice_y * tile_height;
+      gint       offsetx = tiledx - tile_origin_x;
+      gint       offsety = tiledy - tile_origin_y;
 
-        tp = gegl_tile_get_data (tile) +
+      return gegl_tile_get_data (tile) +
              (offsety * tile_width + offsetx) * nearest_sampler->buffer_bpp;
+    }
 
+  return NULL;
+}
+
+static inline void
+gegl_sampler_get_pixel (GeglSampler    *sampler,
+                        gint            x,
+                        gint            y,
+                        gpointer        data,
+                        GeglAbyssPolicy repeat_mode)
+{
+  const guchar *tp;
+
+  if (! gegl_sampler_nearest_map (sampler, &x, &y, data, repeat_mode))
+    return;
+
+  gegl_buffer_lock (sampler->buffer);
+
+  tp = gegl_sampler_nearest_get_data (sampler, x, y);
+
+  if (tp)
+    {
 #if BABL_MINOR_VERSION>1 || (BABL_MINOR_VERSION==1 && BABL_MICRO_VERSION >= 90)
-    sampler->fish_process (sampler->fish, (void*)tp, (void*)buf, 1, NULL);
+    sampler->fish_process (sampler->fish, (void*)tp, (void*)data, 1, NULL);
 #else
-    babl_process (sampler->fish, (void*)tp, (void*)buf, 1);
+    babl_process (sampler->fish, (void*)tp, (void*)data, 1);
 #endif
-      }
-  }
+    }
 
   gegl_buffer_unlock (sampler->buffer);
 }
@@ -220,6 +266,67 @@ gegl_sampler_nearest_get (      GeglSampler*    restrict  sampler,
 }
 
 
+/*
+ * The pixels are gathered in the buffer's format, and converted to the
+ * output format a whole run of consecutive non-abyss pixels at a time.
+ */
+static void
+gegl_sampler_nearest_get_n (      GeglSampler*    restrict  sampler,
+                            const gdouble                  *x,
+                            const gdouble                  *y,
+                                  gint                      n,
+                                  GeglBufferMatrix2        *scale,
+                                  void*           restrict  output,
+                                  GeglAbyssPolicy           repeat_mode)
+{
+  const gint  buffer_bpp = GEGL_SAMPLER_NEAREST (sampler)->buffer_bpp;
+  const gint  bpp        = babl_format_get_bytes_per_pixel (sampler->format);
+  guchar     *pixels     = gegl_scratch_alloc (n * buffer_bpp);
+  guchar     *dst        = output;
+  gint        start      = 0;
+  gint        i;
+
+  gegl_buffer_lock (sampler->buffer);
+
+  for (i = 0; i < n; i++)
+    {
+      gint          ix = int_floorf (x[i]);
+      gint          iy = int_floorf (y[i]);
+      const guchar *tp;
+
+      if (! gegl_sampler_nearest_map (sampler, &ix, &iy, dst + i * bpp,
+                                      repeat_mode))
+        {
+          if (i > start)
+            {
+              _gegl_sampler_process_n (sampler, pixels + start * buffer_bpp,
+                                       dst + start * bpp, i - start);
+            }
+
+          start = i + 1;
+
+          continue;
+        }
+
+      tp = gegl_sampler_nearest_get_data (sampler, ix, iy);
+
+      if (tp)
+        memcpy (pixels + i * buffer_bpp, tp, buffer_bpp);
+      else
+        memset (pixels + i * buffer_bpp, 0, buffer_bpp);
+    }
+
+  if (n > start)
+    {
+      _gegl_sampler_process_n (sampler, pixels + start * buffer_bpp,
+                               dst + start * bpp, n - start);
+    }
+
+  gegl_buffer_unlock (sampler->buffer);
+
+  gegl_scratch_free (pixels);
+}
+
 static void
 gegl_sampler_nearest_prepare (GeglSampler* restrict sampler)
 {
@@ -73,6 +73,14 @@ static void buffer_contents_changed (GeglBuffer          *buffer,
 
 static void constructed (GObject *sampler);
 
+static void gegl_sampler_real_get_n (GeglSampler         *self,
+                                     const gdouble       *x,
+                                     const gdouble       *y,
+                                     gint                 n,
+                                     GeglBufferMatrix2   *scale,
+                                     void                *output,
+                                     GeglAbyssPolicy      repeat_mode);
+
 static GType gegl_sampler_gtype_from_enum  (GeglSamplerType      sampler_type);
 
 G_DEFINE_TYPE (GeglSampler, gegl_sampler, G_TYPE_OBJECT)
@@ -90,6 +98,7 @@ gegl_sampler_class_init (GeglSamplerClass *klass)
   klass->get         = NULL;
   klass->interpolate = NULL;
   klass->set_buffer  = set_buffer;
+  klass->get_n       = gegl_sampler_real_get_n;
 
   object_class->set_property = set_property;
   object_class->get_property = get_property;
@@ -129,6 +138,11 @@ gegl_sampler_init (GeglSampler *sampler)
   do {
     GeglRectangle context_rect      = {0,0,1,1};
     GeglRectangle sampler_rectangle = {0,0,0,0};
+
+    /* mipmap levels are interpolated bilinearly */
+    if (i > 0)
+      context_rect.width = context_rect.height = 2;
+
     sampler->level[i].sampler_buffer = NULL;
     sampler->level[i].context_rect   = context_rect;
     sampler->level[i].sampler_rectangle = sampler_rectangle;
@@ -147,6 +161,7 @@ constructed (GObject *self)
 
   sampler->get         = klass->get;
   sampler->interpolate = klass->interpolate;
+  sampler->get_n       = klass->get_n;
 
   if (sampler->buffer)
     {
@@ -192,10 +207,129 @@ gegl_sampler_get (GeglSampler       *self,
   self->get (self, x, y, scale, output, repeat_mode);
 }
 
+static void
+gegl_sampler_real_get_n (GeglSampler       *self,
+                         const gdouble     *x,
+                         const gdouble     *y,
+                         gint               n,
+                         GeglBufferMatrix2 *scale,
+                         void              *output,
+                         GeglAbyssPolicy    repeat_mode)
+{
+  gint i;
+
+  if (self->interpolate && ! _gegl_sampler_box_needed (scale))
+    {
+      /* interpolation formats have at most 5 components */
+      gfloat result[GEGL_SAMPLER_BATCH_SIZE * 5];
+      gint   nc = self->interpolate_components;
+
+      for (i = 0; i < n; i++)
+        self->interpolate (self, x[i], y[i], result + i * nc, repeat_mode);
+
+      _gegl_sampler_process_n (self, result, output, n);
+    }
+  else
+    {
+      gint    bpp = babl_format_get_bytes_per_pixel (self->format);
+      guchar *dst = output;
+
+      for (i = 0; i < n; i++)
+        self->get (self, x[i], y[i], scale, dst + i * bpp, repeat_mode);
+    }
+}
+
+void
+gegl_sampler_get_n (GeglSampler       *self,
+                    const gdouble     *x,
+                    const gdouble     *y,
+                    gint               n,
+                    GeglBufferMatrix2 *scale,
+                    void              *output,
+                    GeglAbyssPolicy    repeat_mode)
+{
+  gdouble  batch_x[GEGL_SAMPLER_BATCH_SIZE];
+  gdouble  batch_y[GEGL_SAMPLER_BATCH_SIZE];
+  guchar  *dst = output;
+  gint     bpp;
+  gint     i;
+
+  if (n <= 0)
+    return;
+
+  if (G_UNLIKELY (gegl_buffer_ext_flush))
+    gegl_buffer_ext_flush (self->buffer, NULL);
+
+  bpp = babl_format_get_bytes_per_pixel (self->format);
+
+  for (i = 0; i < n; i += GEGL_SAMPLER_BATCH_SIZE)
+    {
+      gint batch_n = MIN (n - i, GEGL_SAMPLER_BATCH_SIZE);
+      gint j;
+
+      for (j = 0; j < batch_n; j++)
+        {
+          batch_x[j] = G_LIKELY (isfinite (x[i + j])) ? x[i + j] : 0.0;
+          batch_y[j] = G_LIKELY (isfinite (y[i + j])) ? y[i + j] : 0.0;
+        }
+
+      self->get_n (self, batch_x, batch_y, batch_n, scale,
+                   dst + (gsize) i * bpp, repeat_mode);
+    }
+}
+
+void
+gegl_sampler_get_line (GeglSampler       *self,
+                       gdouble            x,
+                       gdouble            y,
+                       gdouble            dx,
+                       gdouble            dy,
+                       gint               n,
+                       GeglBufferMatrix2 *scale,
+                       void              *output,
+                       GeglAbyssPolicy    repeat_mode)
+{
+  gdouble  batch_x[GEGL_SAMPLER_BATCH_SIZE];
+  gdouble  batch_y[GEGL_SAMPLER_BATCH_SIZE];
+  guchar  *dst = output;
+  gint     bpp;
+  gint     i;
+
+  if (n <= 0)
+    return;
+
+  if (G_UNLIKELY (gegl_buffer_ext_flush))
+    gegl_buffer_ext_flush (self->buffer, NULL);
+
+  bpp = babl_format_get_bytes_per_pixel (self->format);
+
+  for (i = 0; i < n; i += GEGL_SAMPLER_BATCH_SIZE)
+    {
+      gint batch_n = MIN (n - i, GEGL_SAMPLER_BATCH_SIZE);
+      gint j;
+
+      /* the coordinates are accumulated, rather than computed as
+       * x + i * dx, so that they match those of a per-pixel loop
+       */
+      for (j = 0; j < batch_n; j++)
+        {
+          batch_x[j] = G_LIKELY (isfinite (x)) ? x : 0.0;
+          batch_y[j] = G_LIKELY (isfinite (y)) ? y : 0.0;
+
+          x += dx;
+          y += dy;
+        }
+
+      self->get_n (self, batch_x, batch_y, batch_n, scale,
+                   dst + (gsize) i * bpp, repeat_mode);
+    }
+}
+
 void
 gegl_sampler_prepare (GeglSampler *self)
 {
   GeglSamplerClass *klass;
+  gint              i;
 
   g_return_if_fail (GEGL_IS_SAMPLER (self));
 
@@ -273,11 +407,14 @@ gegl_sampler_prepare (GeglSampler *self)
   }
 
   /*
-   * This makes the cache rect invalid, in case the data in the buffer
+   * This makes the cache rects invalid, in case the data in the buffer
    * has changed:
    */
-  self->level[0].sampler_rectangle.width = 0;
-  self->level[0].sampler_rectangle.height = 0;
+  for (i = 0; i < GEGL_SAMPLER_MIPMAP_LEVELS; i++)
+    {
+      self->level[i].sampler_rectangle.width = 0;
+      self->level[i].sampler_rectangle.height = 0;
+    }
 }
 
 void
@@ -360,8 +497,22 @@ gegl_sampler_get_from_mipmap (GeglSampler    *sampler,
        * fetch_rectangle will become the value of
        * sampler->sampler_rectangle[level]:
        */
-      level->sampler_rectangle = _gegl_sampler_compute_rectangle (sampler, x, y,
-                                                                  level_no);
+      if (level_no > 0)
+        {
+          /* mipmap levels are sampled sparsely, along the footprints of
+           * the output pixels, fetch a larger area around the pixel
+           */
+          level->sampler_rectangle.x      = x - maximum_width  / 4;
+          level->sampler_rectangle.y      = y - maximum_height / 4;
+          level->sampler_rectangle.width  = maximum_width  / 2;
+          level->sampler_rectangle.height = maximum_height / 2;
+        }
+      else
+        {
+          level->sampler_rectangle = _gegl_sampler_compute_rectangle (sampler,
+                                                                      x, y,
+                                                                      level_no);
+        }
       if (!level->sampler_buffer)
         level->sampler_buffer =
           g_malloc (GEGL_SAMPLER_MAXIMUM_WIDTH * sampler->interpolate_bpp * GEGL_SAMPLER_MAXIMUM_HEIGHT);
@@ -383,6 +534,142 @@ gegl_sampler_get_from_mipmap (GeglSampler    *sampler,
   return (gfloat*) (buffer_ptr + sof);
 }
 
+/* bilinearly interpolates mipmap level @level_no at (@x, @y), given in the
+ * coordinates of level 0, or uses the sampler's interpolate() function at
+ * level 0
+ */
+static inline void
+gegl_sampler_mipmap_interpolate (GeglSampler     *self,
+                                 gdouble          x,
+                                 gdouble          y,
+                                 gint             level_no,
+                                 gfloat          *output,
+                                 GeglAbyssPolicy  repeat_mode)
+{
+  const gint     nc     = self->interpolate_components;
+  const gint     stride = GEGL_SAMPLER_MAXIMUM_WIDTH * nc;
+  const gdouble  factor = 1.0 / (1 << level_no);
+  const gfloat  *p;
+  gdouble        lx, ly;
+  gfloat         fx, fy;
+  gint           ix, iy;
+  gint           c;
+
+  if (level_no == 0)
+    {
+      self->interpolate (self, x, y, output, repeat_mode);
+
+      return;
+    }
+
+  lx = x * factor - 0.5;
+  ly = y * factor - 0.5;
+  ix = floor (lx);
+  iy = floor (ly);
+  fx = lx - ix;
+  fy = ly - iy;
+
+  p = gegl_sampler_get_from_mipmap (self, ix, iy, level_no, repeat_mode);
+
+  for (c = 0; c < nc; c++)
+    {
+      const gfloat top    = p[c]          + fx * (p[nc + c]          - p[c]);
+      const gfloat bottom = p[stride + c] + fx * (p[stride + nc + c] - p[stride + c]);
+
+      output[c] = top + fy * (bottom - top);
+    }
+}
+
+/*
+ * Samples the footprint given by the columns of @scale, when it's too large
+ * for the box filter of _gegl_sampler_box_get().
+ *
+ * Up to GEGL_SAMPLER_MAX_ANISOTROPY probes are taken along the major axis
+ * of the footprint, each of which is interpolated from the two mipmap levels
+ * whose texels are closest in size to the distance between the probes, or
+ * to the minor axis, if it's larger, and linearly blended between them.  The
+ * cost per output pixel is therefore bounded, however large the footprint
+ * is, and the source is only read at level 0 for footprints smaller than
+ * two pixels across.
+ */
+void
+_gegl_sampler_mipmap_get (GeglSampler       *self,
+                          gdouble            absolute_x,
+                          gdouble            absolute_y,
+                          GeglBufferMatrix2 *scale,
+                          void              *output,
+                          GeglAbyssPolicy    repeat_mode)
+{
+  const gint nc      = self->interpolate_components;
+  gdouble    major_x = scale->coeff[0][0];
+  gdouble    major_y = scale->coeff[1][0];
+  gdouble    major   = hypot (scale->coeff[0][0], scale->coeff[1][0]);
+  gdouble    minor   = hypot (scale->coeff[0][1], scale->coeff[1][1]);
+  gdouble    width;
+  gdouble    lod;
+  gfloat     result[nc];
+  gfloat     sample0[nc];
+  gfloat     sample1[nc];
+  gfloat     t;
+  gint       n_probes;
+  gint       level_no;
+  gint       i, c;
+
+  if (minor > major)
+    {
+      gdouble tmp = major;
+
+      major_x = scale->coeff[0][1];
+      major_y = scale->coeff[1][1];
+      major   = minor;
+      minor   = tmp;
+    }
+
+  n_probes = CLAMP ((gint) ceil (major / MAX (minor, 1.0)),
+                    1, GEGL_SAMPLER_MAX_ANISOTROPY);
+  width    = MAX (minor, major / n_probes);
+
+  lod      = log2 (MAX (width, 1.0));
+  level_no = floor (lod);
+  t        = lod - level_no;
+
+  if (level_no >= GEGL_SAMPLER_MIPMAP_LEVELS - 1)
+    {
+      level_no = GEGL_SAMPLER_MIPMAP_LEVELS - 1;
+      t        = 0.0f;
+    }
+
+  for (c = 0; c < nc; c++)
+    result[c] = 0.0f;
+
+  for (i = 0; i < n_probes; i++)
+    {
+      const gdouble offset = (i + 0.5) / n_probes - 0.5;
+      const gdouble x      = absolute_x + offset * major_x;
+      const gdouble y      = absolute_y + offset * major_y;
+
+      gegl_sampler_mipmap_interpolate (self, x, y, level_no,
+                                       sample0, repeat_mode);
+
+      if (t > 0.0f)
+        {
+          gegl_sampler_mipmap_interpolate (self, x, y, level_no + 1,
+                                           sample1, repeat_mode);
+
+          for (c = 0; c < nc; c++)
+            sample0[c] += t * (sample1[c] - sample0[c]);
+        }
+
+      for (c = 0; c < nc; c++)
+        result[c] += sample0[c];
+    }
+
+  for (c = 0; c < nc; c++)
+    result[c] /= n_probes;
+
+  babl_process (self->fish, result, output, 1);
+}
+
 static void
 get_property (GObject    *object,
               guint       property_id,
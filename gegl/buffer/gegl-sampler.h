@@ -39,6 +39,12 @@ G_BEGIN_DECLS
  * starting at 0 = no box filtering) actually used by any sampler.
  */
 #define GEGL_SAMPLER_MIPMAP_LEVELS (8)
+/*
+ * The largest number of probes _gegl_sampler_mipmap_get() takes along the
+ * major axis of a footprint; more elongated footprints get blurred along
+ * their minor axis.
+ */
+#define GEGL_SAMPLER_MAX_ANISOTROPY (8)
 /*
  * Best thing to do seems to use rectangular buffer tiles that are
  * twice as wide as they are tall.
@@ -59,6 +65,23 @@ typedef void (* GeglSamplerInterpolateFun) (GeglSampler     *self,
                                             gfloat          *output,
                                             GeglAbyssPolicy  repeat_mode);
 
+/* samplers may provide a get_n() function, which samples the @n points whose
+ * coordinates are given by @x and @y at once, using a @scale matrix common to
+ * all of them, and stores the results consecutively in @output, using the
+ * sampler's output format.  @n is at most GEGL_SAMPLER_BATCH_SIZE, and the
+ * coordinates are finite.  the default implementation calls interpolate()
+ * for all the points, and converts the results to the output format in one
+ * go, when no box filtering is needed, or calls get() for each point
+ * otherwise.
+ */
+typedef void (* GeglSamplerGetNFun) (GeglSampler       *self,
+                                     const gdouble     *x,
+                                     const gdouble     *y,
+                                     gint               n,
+                                     GeglBufferMatrix2 *scale,
+                                     void              *output,
+                                     GeglAbyssPolicy    repeat_mode);
+
 typedef struct _GeglSamplerClass GeglSamplerClass;
 
 typedef struct GeglSamplerLevel
@@ -79,6 +102,7 @@ struct _GeglSampler
 
   GeglSamplerGetFun          get;
   GeglSamplerInterpolateFun  interpolate;
+  GeglSamplerGetNFun         get_n;
 
   /*< private >*/
   GeglBuffer                *buffer;
@@ -104,6 +128,7 @@ struct _GeglSamplerClass
   GeglSamplerInterpolateFun    interpolate;
   void                      (* set_buffer) (GeglSampler *self,
                                             GeglBuffer  *buffer);
+  GeglSamplerGetNFun           get_n;
 };
 
 GType gegl_sampler_get_type    (void) G_GNUC_CONST;
@@ -126,6 +151,12 @@ gfloat * _gegl_sampler_get_ptr        (GeglSampler     *sampler,
                                        gint             x,
                                        gint             y,
                                        GeglAbyssPolicy  repeat_mode);
+void     _gegl_sampler_mipmap_get     (GeglSampler       *self,
+                                       gdouble            absolute_x,
+                                       gdouble            absolute_y,
+                                       GeglBufferMatrix2 *scale,
+                                       void              *output,
+                                       GeglAbyssPolicy    repeat_mode);
 
 static inline GeglRectangle _gegl_sampler_compute_rectangle (
                                       GeglSampler *sampler,
@@ -278,8 +309,23 @@ _gegl_sampler_box_get (GeglSampler*    restrict  self,
 
       if (u_norm2 >= 4.0 || v_norm2 >= 4.0)
         {
-          gfloat  result[channels];
-          gdouble uv_samples_inv;
+          const gdouble max_norm2 = (max_n_samples + 1) *
+                                    (max_n_samples + 1);
+          gfloat        result[channels];
+          gdouble       uv_samples_inv;
+
+          /* past max_n_samples samples along an axis, the box filter
+           * skips source pixels, and the samples are far enough apart to
+           * refetch the level 0 context for each of them.  sample the
+           * mipmap levels of the buffer instead.
+           */
+          if (u_norm2 >= max_norm2 || v_norm2 >= max_norm2)
+            {
+              _gegl_sampler_mipmap_get (self, absolute_x, absolute_y, scale,
+                                        output, repeat_mode);
+
+              return TRUE;
+            }
 
           for (gint c = 0; c < channels; c++)
             result[c] = 0.0f;
@@ -383,6 +429,37 @@ _gegl_sampler_box_get (GeglSampler*    restrict  self,
   return FALSE;
 }
 
+/* whether _gegl_sampler_box_get() box-filters for @scale */
+static inline gboolean
+_gegl_sampler_box_needed (const GeglBufferMatrix2 *scale)
+{
+  if (scale)
+    {
+      const gdouble u_norm2 = scale->coeff[0][0] * scale->coeff[0][0] +
+                              scale->coeff[1][0] * scale->coeff[1][0];
+      const gdouble v_norm2 = scale->coeff[0][1] * scale->coeff[0][1] +
+                              scale->coeff[1][1] * scale->coeff[1][1];
+
+      return u_norm2 >= 4.0 || v_norm2 >= 4.0;
+    }
+
+  return FALSE;
+}
+
+/* converts @n interpolated pixels to the sampler's output format */
+static inline void
+_gegl_sampler_process_n (GeglSampler *self,
+                         const void  *interpolated,
+                         void        *output,
+                         gint         n)
+{
+#if BABL_MINOR_VERSION > 1 || (BABL_MINOR_VERSION ==1 && BABL_MICRO_VERSION >= 90)
+  self->fish_process (self->fish, (void *) interpolated, output, n, NULL);
+#else
+  babl_process (self->fish, (void *) interpolated, output, n);
+#endif
+}
+
 G_END_DECLS
 
 #endif /* __GEGL_SAMPLER_H__ */
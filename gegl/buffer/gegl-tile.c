@@ -452,6 +452,203 @@ gegl_tile_damage (GeglTile *tile,
     }
 }
 
+/* the type of the alpha component of @format, and its offset in the pixels,
+ * if it is the last component, as in all of the formats with alpha but the
+ * cairo ones; or NULL.
+ */
+static const Babl *
+gegl_tile_get_alpha_type (const Babl *format,
+                          gint       *offset)
+{
+  const gchar *encoding = babl_format_get_encoding (format);
+  const gchar *space    = strrchr (encoding, ' ');
+  const Babl  *type;
+
+  if (! space || ! babl_format_has_alpha (format))
+    return NULL;
+
+  if (space[-1] != 'A' &&
+      (space - encoding < 5 || strncmp (space - 5, "alpha", 5)))
+    {
+      return NULL;
+    }
+
+  type = babl_format_get_type (format,
+                               babl_format_get_n_components (format) - 1);
+
+  *offset = babl_format_get_bytes_per_pixel (format) -
+            babl_format_get_bytes_per_pixel (babl_format_n (type, 1));
+
+  return type;
+}
+
+#define SCAN_ALPHA(ctype, is_transparent, is_opaque)                       \
+  for (i = 0; i < n_pixels && summary; i++)                                \
+    {                                                                      \
+      ctype a;                                                             \
+                                                                           \
+      memcpy (&a, data + (gsize) i * bpp + offset, sizeof (ctype));        \
+                                                                           \
+      if (! (is_transparent))                                              \
+        summary &= ~GEGL_TILE_SUMMARY_TRANSPARENT;                         \
+      if (! (is_opaque))                                                   \
+        summary &= ~GEGL_TILE_SUMMARY_OPAQUE;                              \
+    }
+
+/* returns which of @flags hold for the @n_pixels pixels of @data.  the scan
+ * stops at the first pixel which rules all of them out, so that only tiles
+ * which turn out transparent or opaque are read in full.
+ */
+static guint
+gegl_tile_compute_summary (const guchar *data,
+                           gint          n_pixels,
+                           const Babl   *format,
+                           guint         flags)
+{
+  const Babl *alpha_type;
+  gint        bpp     = babl_format_get_bytes_per_pixel (format);
+  gint        offset  = 0;
+  guint       summary = flags;
+  gint        i;
+
+  if (! babl_format_has_alpha (format))
+    return flags & GEGL_TILE_SUMMARY_OPAQUE;
+
+  alpha_type = gegl_tile_get_alpha_type (format, &offset);
+
+  if (! alpha_type)
+    return 0;
+
+  if (alpha_type == babl_type ("float"))
+    {
+      SCAN_ALPHA (gfloat, a == 0.0f, a == 1.0f)
+    }
+  else if (alpha_type == babl_type ("u8"))
+    {
+      SCAN_ALPHA (guint8, a == 0, a == G_MAXUINT8)
+    }
+  else if (alpha_type == babl_type ("u16"))
+    {
+      SCAN_ALPHA (guint16, a == 0, a == G_MAXUINT16)
+    }
+  else if (alpha_type == babl_type ("half"))
+    {
+      SCAN_ALPHA (guint16, (a & 0x7fff) == 0, a == 0x3c00)
+    }
+  else if (alpha_type == babl_type ("u32"))
+    {
+      SCAN_ALPHA (guint32, a == 0, a == G_MAXUINT32)
+    }
+  else if (alpha_type == babl_type ("double"))
+    {
+      SCAN_ALPHA (gdouble, a == 0.0, a == 1.0)
+    }
+  else
+    {
+      summary = 0;
+    }
+
+  return summary;
+}
+
+#undef SCAN_ALPHA
+
+/* tile->summary holds the flags known to hold in its low bits, and the flags
+ * which were checked above them
+ */
+#define SUMMARY_CHECKED_SHIFT 2
+#define SUMMARY_ALL_FLAGS     (GEGL_TILE_SUMMARY_TRANSPARENT | \
+                               GEGL_TILE_SUMMARY_OPAQUE)
+
+static inline void
+gegl_tile_summary_lock (GeglTile *tile)
+{
+  while (! g_atomic_int_compare_and_exchange (&tile->summary_lock, 0, 1));
+}
+
+static inline void
+gegl_tile_summary_unlock (GeglTile *tile)
+{
+  g_atomic_int_set (&tile->summary_lock, 0);
+}
+
+/* returns which of the GeglTileSummary @flags hold for the data of @tile,
+ * whose pixels are in @format.  each flag is checked at most once per
+ * revision of the tile.
+ *
+ * the summary and the revision it was computed for are read and published
+ * together, under a spinlock, while the pixels are scanned outside of it.  a
+ * summary computed while the tile is being written to is tagged with the
+ * revision from before the write, which unlocking the tile then bumps.
+ */
+guint
+gegl_tile_get_summary (GeglTile   *tile,
+                       const Babl *format,
+                       guint       flags)
+{
+  guint rev     = g_atomic_int_get (&tile->rev);
+  guint cached  = 0;
+  guint checked;
+  guint summary;
+
+  flags &= SUMMARY_ALL_FLAGS;
+
+  gegl_tile_summary_lock (tile);
+
+  if (tile->summary_rev == rev)
+    cached = tile->summary;
+
+  gegl_tile_summary_unlock (tile);
+
+  checked = cached >> SUMMARY_CHECKED_SHIFT;
+
+  if ((flags & checked) == flags)
+    return cached & flags;
+
+  gegl_tile_read_lock (tile);
+
+  /* all the pixels of a zero tile are the same as its first one */
+  summary = gegl_tile_compute_summary (gegl_tile_get_data (tile),
+                                       tile->is_zero_tile ?
+                                         1 :
+                                         tile->size /
+                                         babl_format_get_bytes_per_pixel (format),
+                                       format, flags);
+
+  gegl_tile_read_unlock (tile);
+
+  /* the tile was written to meanwhile, the summary is already stale */
+  if (g_atomic_int_get (&tile->rev) != rev)
+    return summary & flags;
+
+  gegl_tile_summary_lock (tile);
+
+  /* keep the flags checked by other queries for the same revision */
+  if (tile->summary_rev == rev)
+    {
+      guint other = tile->summary;
+
+      checked = (other >> SUMMARY_CHECKED_SHIFT) & ~flags;
+
+      summary |= other & checked;
+      checked |= flags;
+    }
+  else
+    {
+      checked = flags;
+    }
+
+  tile->summary_rev = rev;
+  tile->summary     = summary | (checked << SUMMARY_CHECKED_SHIFT);
+
+  gegl_tile_summary_unlock (tile);
+
+  return summary & flags;
+}
+
+#undef SUMMARY_CHECKED_SHIFT
+#undef SUMMARY_ALL_FLAGS
+
 gboolean gegl_tile_store (GeglTile *tile)
 {
   gboolean ret;
@@ -630,6 +630,7 @@ gegl_post_parse_hook (GOptionContext *context,
   gegl_tile_alloc_init ();
   gegl_buffer_swap_init ();
   gegl_parallel_init ();
+  gegl_buffer_ext_cancelled = gegl_parallel_is_cancelled;
   gegl_compression_init ();
   gegl_operation_gtype_init ();
   gegl_tile_cache_init ();
@@ -18,6 +18,8 @@
 
 #include "config.h"
 
+#include <math.h>
+
 #include <glib-object.h>
 
 #include "gegl.h"
@@ -159,3 +161,197 @@ gegl_lookup_free (GeglLookup *lookup)
 {
   g_free (lookup);
 }
+
+/* the range of the number of pieces per power of two of a lookup table */
+#define GEGL_LOOKUP_TABLE_MIN_SHIFT 16
+#define GEGL_LOOKUP_TABLE_MAX_SHIFT 20
+
+/* the number of points of each piece the error is measured at */
+#define GEGL_LOOKUP_TABLE_SAMPLES   16
+
+static gfloat
+gegl_lookup_table_value (guint32 bits)
+{
+  union
+  {
+    float   f;
+    guint32 i;
+  } u;
+
+  u.i = bits;
+
+  return u.f;
+}
+
+/* fits a cubic polynomial in t to @function over the piece of @table
+ * starting at @bits, interpolating it at the chebyshev nodes, which is
+ * close to the minimax polynomial.
+ */
+static gboolean
+gegl_lookup_table_fit (GeglLookupTable *table,
+                       guint32          bits,
+                       gfloat          *c)
+{
+  const gdouble x0 = gegl_lookup_table_value (bits);
+  const gdouble x1 = gegl_lookup_table_value (bits + table->mask + 1);
+  gdouble       m[4][5];
+  gint          i, j, k;
+
+  for (i = 0; i < 4; i++)
+    {
+      gfloat  x = x0 + (x1 - x0) * (0.5 - 0.5 * cos ((2 * i + 1) * G_PI / 8));
+      gdouble t = (x - x0) / (x1 - x0);
+      gdouble y = table->function (x, table->data);
+
+      if (! isfinite (y))
+        return FALSE;
+
+      for (j = 0; j < 4; j++)
+        m[i][j] = pow (t, j);
+      m[i][4] = y;
+    }
+
+  /* solve the vandermonde system by gaussian elimination; the nodes are
+   * distinct, and far enough apart not to need pivoting
+   */
+  for (k = 0; k < 4; k++)
+    {
+      for (i = k + 1; i < 4; i++)
+        {
+          gdouble f = m[i][k] / m[k][k];
+
+          for (j = k; j < 5; j++)
+            m[i][j] -= f * m[k][j];
+        }
+    }
+
+  for (k = 3; k >= 0; k--)
+    {
+      gdouble v = m[k][4];
+
+      for (j = k + 1; j < 4; j++)
+        v -= m[k][j] * c[j];
+
+      c[k] = v / m[k][k];
+    }
+
+  return TRUE;
+}
+
+static GeglLookupTable *
+gegl_lookup_table_build (GeglLookupFunction function,
+                         gpointer           data,
+                         gfloat             start,
+                         gfloat             end,
+                         gint               shift)
+{
+  GeglLookupTable *table;
+  union
+  {
+    float   f;
+    guint32 i;
+  } u;
+  guint32 mask = (1u << shift) - 1;
+  guint32 first, last;
+  guint32 bits;
+  gint    n_pieces;
+  gint    i;
+
+  u.f   = start;
+  first = u.i & ~mask;
+  u.f   = end;
+  last  = (u.i + mask) & ~mask;
+
+  n_pieces = (last - first) >> shift;
+
+  table = g_malloc (sizeof (GeglLookupTable) +
+                    sizeof (gfloat) * 4 * n_pieces);
+
+  table->function = function;
+  table->data     = data;
+  table->shift    = shift;
+  table->mask     = mask;
+  table->first    = first;
+  table->last     = last;
+  table->scale    = 1.0f / (mask + 1);
+  table->error    = 0.0f;
+
+  for (i = 0, bits = first; i < n_pieces; i++, bits += mask + 1)
+    {
+      if (! gegl_lookup_table_fit (table, bits, table->coefficients + 4 * i))
+        {
+          table->error = G_MAXFLOAT;
+
+          return table;
+        }
+    }
+
+  /* measure the error of the table as it is evaluated */
+  for (i = 0, bits = first; i < n_pieces; i++, bits += mask + 1)
+    {
+      gint j;
+
+      for (j = 0; j <= GEGL_LOOKUP_TABLE_SAMPLES; j++)
+        {
+          guint32 offset = MIN ((guint64) j * (mask + 1) /
+                                GEGL_LOOKUP_TABLE_SAMPLES, mask);
+          gfloat  x      = gegl_lookup_table_value (bits + offset);
+          gfloat  y      = function (x, data);
+          gfloat  error;
+
+          error = fabsf (gegl_lookup_table_eval (table, x) - y) /
+                  MAX (fabsf (y), 1.0f);
+
+          if (! (error <= table->error))
+            table->error = isfinite (error) ? error : G_MAXFLOAT;
+        }
+    }
+
+  return table;
+}
+
+GeglLookupTable *
+gegl_lookup_table_new (GeglLookupFunction function,
+                       gpointer           data,
+                       gfloat             start,
+                       gfloat             end,
+                       gfloat             max_error)
+{
+  gint shift = GEGL_LOOKUP_TABLE_MAX_SHIFT;
+
+  g_return_val_if_fail (function != NULL, NULL);
+  g_return_val_if_fail (start > 0.0f && end > start && isfinite (end), NULL);
+
+  /* start from the fewest pieces, and make them smaller until the error is
+   * within the bound
+   */
+  while (TRUE)
+    {
+      GeglLookupTable *table;
+      gint             steps;
+
+      table = gegl_lookup_table_build (function, data, start, end, shift);
+
+      if (table->error <= max_error)
+        return table;
+
+      /* halving the size of the pieces divides the error of cubic
+       * polynomials by about 16; skip the sizes which, by that estimate,
+       * can't meet the bound
+       */
+      steps = ceil (log ((gdouble) table->error / max_error) / log (16.0));
+
+      g_free (table);
+
+      if (shift == GEGL_LOOKUP_TABLE_MIN_SHIFT)
+        return NULL;
+
+      shift -= CLAMP (steps, 1, shift - GEGL_LOOKUP_TABLE_MIN_SHIFT);
+    }
+}
+
+void
+gegl_lookup_table_free (GeglLookupTable *table)
+{
+  g_free (table);
+}
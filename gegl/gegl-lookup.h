@@ -103,6 +103,102 @@ gegl_lookup (GeglLookup *lookup,
   return lookup->table[i];
 }
 
+typedef struct GeglLookupTable
+{
+  GeglLookupFunction function;
+  gpointer           data;
+  gint               shift;
+  guint32            mask;
+  guint32            first, last;
+  gfloat             scale;
+  gfloat             error;
+  gfloat             coefficients[];
+} GeglLookupTable;
+
+
+/**
+ * gegl_lookup_table_new: (skip)
+ * @function: The function to approximate
+ * @data: A user data pointer passed to @function
+ * @start: Lower bound of the table, which must be positive
+ * @end: Upper bound of the table
+ * @max_error: The largest error allowed, relative to the value of @function
+ * for values of magnitude above 1, and absolute otherwise
+ *
+ * Approximates @function between @start and @end with a piecewise cubic
+ * polynomial, whose pieces are a fixed fraction of each power of two, such
+ * that the piece a value falls in is found from its bits alone.  Values
+ * outside of the table are passed to @function.
+ *
+ * Return value: a #GeglLookupTable, or NULL if @function can't be
+ * approximated within @max_error.
+ */
+GeglLookupTable *gegl_lookup_table_new  (GeglLookupFunction  function,
+                                         gpointer            data,
+                                         gfloat              start,
+                                         gfloat              end,
+                                         gfloat              max_error);
+
+/**
+ * gegl_lookup_table_free: (skip)
+ * @table: #GeglLookupTable to free
+ */
+void             gegl_lookup_table_free (GeglLookupTable    *table);
+
+
+/* evaluates the piece of @table which @number falls in.  @number must be in
+ * the table, see gegl_lookup_table_contains(); other values, including those
+ * below the table and negative ones, are evaluated with the last piece, which
+ * only keeps the access within the table.
+ */
+static inline gfloat
+gegl_lookup_table_eval (const GeglLookupTable *table,
+                        gfloat                 number)
+{
+  union
+  {
+    float   f;
+    guint32 i;
+  } u;
+  const gfloat *c;
+  guint32       offset;
+  gfloat        t;
+
+  u.f = number;
+  offset = u.i - table->first;
+  offset = MIN (offset, table->last - table->first - 1);
+
+  c = table->coefficients + 4 * (offset >> table->shift);
+  t = (offset & table->mask) * table->scale;
+
+  return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+}
+
+static inline gboolean
+gegl_lookup_table_contains (const GeglLookupTable *table,
+                            gfloat                 number)
+{
+  union
+  {
+    float   f;
+    guint32 i;
+  } u;
+
+  u.f = number;
+
+  return u.i - table->first < table->last - table->first;
+}
+
+static inline gfloat
+gegl_lookup_table (const GeglLookupTable *table,
+                   gfloat                 number)
+{
+  if (gegl_lookup_table_contains (table, number))
+    return gegl_lookup_table_eval (table, number);
+  else
+    return table->function (number, table->data);
+}
+
 #endif /* __cplusplus */
 
 G_END_DECLS
@@ -31,6 +31,14 @@ gdouble   gegl_parallel_distribute_get_thread_time       (void);
 gint      gegl_parallel_distribute_get_optimal_n_threads (gdouble n_elements,
                                                           gdouble thread_cost);
 
+/* the cancellation token of the calling thread: a pointer to an int which is
+ * set to non-zero (atomically) to cancel the rendering job the thread is
+ * working on, or NULL when the job can't be cancelled.  the token is passed
+ * on to the threads work is distributed to.
+ */
+const gint * gegl_parallel_get_cancel_token              (void);
+const gint * gegl_parallel_set_cancel_token              (const gint *token);
+
 
 /*  stats  */
 
@@ -20,6 +20,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <glib.h>
 
@@ -32,12 +33,16 @@
 #define GEGL_PARALLEL_DISTRIBUTE_MAX_THREADS           GEGL_MAX_THREADS
 #define GEGL_PARALLEL_DISTRIBUTE_THREAD_TIME_N_SAMPLES 10
 
+#define GEGL_PARALLEL_REDUCE_ALIGNMENT                 64
+#define GEGL_PARALLEL_REDUCE_BUFFER_THREAD_COST        (64.0 * 64.0)
+
 
 typedef struct
 {
   GeglParallelDistributeFunc func;
   gint                       n;
   gpointer                   user_data;
+  const gint                *cancel_token;
 } GeglParallelDistributeTask;
 
 typedef struct
@@ -78,6 +83,8 @@ static gint                         gegl_parallel_distribute_n_assigned_threads;
 
 static gdouble                      gegl_parallel_distribute_thread_time;
 
+static GPrivate                     gegl_parallel_cancel_token;
+
 
 /*  public functions  */
 
@@ -109,6 +116,30 @@ gegl_parallel_distribute_get_thread_time (void)
   return gegl_parallel_distribute_thread_time;
 }
 
+const gint *
+gegl_parallel_get_cancel_token (void)
+{
+  return g_private_get (&gegl_parallel_cancel_token);
+}
+
+const gint *
+gegl_parallel_set_cancel_token (const gint *token)
+{
+  const gint *old_token = g_private_get (&gegl_parallel_cancel_token);
+
+  g_private_set (&gegl_parallel_cancel_token, (gpointer) token);
+
+  return old_token;
+}
+
+gboolean
+gegl_parallel_is_cancelled (void)
+{
+  const gint *token = g_private_get (&gegl_parallel_cancel_token);
+
+  return token && g_atomic_int_get (token);
+}
+
 /* calculates the optimal number of threads, n_threads, to process n_elements
  * elements, assuming the cost of processing the elements is proportional to
  * the number of elements to be processed by each thread, and assuming that
@@ -170,9 +201,10 @@ gegl_parallel_distribute (gint                       max_n,
       return;
     }
 
-  task.n         = max_n;
-  task.func      = func;
-  task.user_data = user_data;
+  task.n            = max_n;
+  task.func         = func;
+  task.user_data    = user_data;
+  task.cancel_token = gegl_parallel_get_cancel_token ();
 
   gegl_parallel_distribute_n_assigned_threads = task.n - 1;
 
@@ -271,50 +303,101 @@ gegl_parallel_distribute_range (gsize                           size,
     &data);
 }
 
-typedef struct
+/* resolves GEGL_SPLIT_STRATEGY_AUTO, and returns the number of threads to
+ * process area across
+ */
+static gint
+gegl_parallel_distribute_area_get_n_threads (const GeglRectangle *area,
+                                             gdouble              thread_cost,
+                                             GeglSplitStrategy   *split_strategy)
 {
-  const GeglRectangle            *area;
-  GeglSplitStrategy               split_strategy;
-  GeglParallelDistributeAreaFunc  func;
-  gpointer                        user_data;
-} GeglParallelDistributeAreaData;
+  gint n_threads;
+
+  if (*split_strategy == GEGL_SPLIT_STRATEGY_AUTO)
+    {
+      if (area->width > area->height)
+        *split_strategy = GEGL_SPLIT_STRATEGY_VERTICAL;
+      else
+        *split_strategy = GEGL_SPLIT_STRATEGY_HORIZONTAL;
+    }
+
+  n_threads = gegl_parallel_distribute_get_optimal_n_threads (
+    (gdouble) area->width * (gdouble) area->height,
+    thread_cost);
+
+  switch (*split_strategy)
+    {
+    case GEGL_SPLIT_STRATEGY_HORIZONTAL:
+      n_threads = MIN (n_threads, area->height);
+      break;
+
+    case GEGL_SPLIT_STRATEGY_VERTICAL:
+      n_threads = MIN (n_threads, area->width);
+      break;
 
+    default:
+      g_return_val_if_reached (1);
+    }
+
+  return n_threads;
+}
+
+/* the i-th out of n sub-areas of area */
 static void
-gegl_parallel_distribute_area_func (gint                            i,
-                                    gint                            n,
-                                    GeglParallelDistributeAreaData *data)
+gegl_parallel_distribute_area_get_sub_area (const GeglRectangle *area,
+                                            GeglSplitStrategy    split_strategy,
+                                            gint                 i,
+                                            gint                 n,
+                                            GeglRectangle       *sub_area)
 {
-  GeglRectangle sub_area;
-
-  switch (data->split_strategy)
+  switch (split_strategy)
     {
     case GEGL_SPLIT_STRATEGY_HORIZONTAL:
-      sub_area.x       = data->area->x;
-      sub_area.width   = data->area->width;
+      sub_area->x       = area->x;
+      sub_area->width   = area->width;
 
-      sub_area.y       = (2 * i       * data->area->height + n) / (2 * n);
-      sub_area.height  = (2 * (i + 1) * data->area->height + n) / (2 * n);
+      sub_area->y       = (2 * i       * area->height + n) / (2 * n);
+      sub_area->height  = (2 * (i + 1) * area->height + n) / (2 * n);
 
-      sub_area.height -= sub_area.y;
-      sub_area.y      += data->area->y;
+      sub_area->height -= sub_area->y;
+      sub_area->y      += area->y;
 
       break;
 
     case GEGL_SPLIT_STRATEGY_VERTICAL:
-      sub_area.y       = data->area->y;
-      sub_area.height  = data->area->height;
+      sub_area->y       = area->y;
+      sub_area->height  = area->height;
 
-      sub_area.x       = (2 * i       * data->area->width + n) / (2 * n);
-      sub_area.width   = (2 * (i + 1) * data->area->width + n) / (2 * n);
+      sub_area->x       = (2 * i       * area->width + n) / (2 * n);
+      sub_area->width   = (2 * (i + 1) * area->width + n) / (2 * n);
 
-      sub_area.width  -= sub_area.x;
-      sub_area.x      += data->area->x;
+      sub_area->width  -= sub_area->x;
+      sub_area->x      += area->x;
 
       break;
 
     default:
       g_return_if_reached ();
     }
+}
+
+typedef struct
+{
+  const GeglRectangle            *area;
+  GeglSplitStrategy               split_strategy;
+  GeglParallelDistributeAreaFunc  func;
+  gpointer                        user_data;
+} GeglParallelDistributeAreaData;
+
+static void
+gegl_parallel_distribute_area_func (gint                            i,
+                                    gint                            n,
+                                    GeglParallelDistributeAreaData *data)
+{
+  GeglRectangle sub_area;
+
+  gegl_parallel_distribute_area_get_sub_area (data->area, data->split_strategy,
+                                              i, n, &sub_area);
 
   data->func (&sub_area, data->user_data);
 }
@@ -335,48 +418,323 @@ gegl_parallel_distribute_area (const GeglRectangle            *area,
   if (area->width <= 0 || area->height <= 0)
     return;
 
-  if (split_strategy == GEGL_SPLIT_STRATEGY_AUTO)
+  n_threads = gegl_parallel_distribute_area_get_n_threads (area, thread_cost,
+                                                           &split_strategy);
+
+  if (n_threads == 1)
     {
-      if (area->width > area->height)
-        split_strategy = GEGL_SPLIT_STRATEGY_VERTICAL;
-      else
-        split_strategy = GEGL_SPLIT_STRATEGY_HORIZONTAL;
+      func (area, user_data);
+
+      return;
     }
 
-  n_threads = gegl_parallel_distribute_get_optimal_n_threads (
-    (gdouble) area->width * (gdouble) area->height,
-    thread_cost);
+  data.area           = area;
+  data.split_strategy = split_strategy;
+  data.func           = func;
+  data.user_data      = user_data;
 
-  switch (split_strategy)
-    {
-    case GEGL_SPLIT_STRATEGY_HORIZONTAL:
-      n_threads = MIN (n_threads, area->height);
-      break;
+  gegl_parallel_distribute (
+    n_threads,
+    (GeglParallelDistributeFunc) gegl_parallel_distribute_area_func,
+    &data);
+}
 
-    case GEGL_SPLIT_STRATEGY_VERTICAL:
-      n_threads = MIN (n_threads, area->width);
-      break;
+typedef struct
+{
+  const GeglRectangle        *area;
+  GeglSplitStrategy           split_strategy;
+  guint8                     *partials;
+  gsize                       partial_stride;
+  GeglParallelReduceAreaFunc  func;
+  gpointer                    user_data;
+} GeglParallelReduceAreaData;
 
-    default:
-      g_return_if_reached ();
-    }
+static void
+gegl_parallel_reduce_area_func (gint                        i,
+                                gint                        n,
+                                GeglParallelReduceAreaData *data)
+{
+  GeglRectangle sub_area;
+
+  gegl_parallel_distribute_area_get_sub_area (data->area, data->split_strategy,
+                                              i, n, &sub_area);
+
+  data->func (&sub_area, data->partials + i * data->partial_stride,
+              data->user_data);
+}
+
+void
+gegl_parallel_reduce_area (const GeglRectangle        *area,
+                           gdouble                     thread_cost,
+                           GeglSplitStrategy           split_strategy,
+                           gpointer                    result,
+                           gsize                       result_size,
+                           GeglParallelReduceAreaFunc  reduce_func,
+                           GeglParallelMergeFunc       merge_func,
+                           gpointer                    user_data)
+{
+  GeglParallelReduceAreaData data;
+  gint                       n_threads;
+  gint                       i;
+
+  g_return_if_fail (area != NULL);
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (reduce_func != NULL);
+  g_return_if_fail (merge_func != NULL);
+
+  if (area->width <= 0 || area->height <= 0)
+    return;
+
+  n_threads = gegl_parallel_distribute_area_get_n_threads (area, thread_cost,
+                                                           &split_strategy);
 
   if (n_threads == 1)
     {
-      func (area, user_data);
+      reduce_func (area, result, user_data);
 
       return;
     }
 
+  /* keep the partial results on separate cache lines */
+  data.partial_stride = (result_size + GEGL_PARALLEL_REDUCE_ALIGNMENT - 1) &
+                        ~(gsize) (GEGL_PARALLEL_REDUCE_ALIGNMENT - 1);
+  data.partials       = gegl_malloc (n_threads * data.partial_stride);
+
+  /* gegl_parallel_distribute() may use less than n_threads threads, in which
+   * case the rest of the partial results are left as the identity
+   */
+  for (i = 0; i < n_threads; i++)
+    memcpy (data.partials + i * data.partial_stride, result, result_size);
+
   data.area           = area;
   data.split_strategy = split_strategy;
-  data.func           = func;
+  data.func           = reduce_func;
   data.user_data      = user_data;
 
   gegl_parallel_distribute (
     n_threads,
-    (GeglParallelDistributeFunc) gegl_parallel_distribute_area_func,
+    (GeglParallelDistributeFunc) gegl_parallel_reduce_area_func,
+    &data);
+
+  for (i = 0; i < n_threads; i++)
+    merge_func (result, data.partials + i * data.partial_stride, user_data);
+
+  gegl_free (data.partials);
+}
+
+typedef struct
+{
+  GeglBuffer                   *buffer;
+  gint                          level;
+  const Babl                   *format;
+  GeglParallelReduceBufferFunc  func;
+  gpointer                      user_data;
+} GeglParallelReduceBufferData;
+
+static void
+gegl_parallel_reduce_buffer_func (const GeglRectangle          *area,
+                                  gpointer                      partial,
+                                  GeglParallelReduceBufferData *data)
+{
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (data->buffer, area, data->level,
+                                   data->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      data->func (iter->items[0].data, iter->length, partial, data->user_data);
+    }
+}
+
+void
+gegl_parallel_reduce_buffer (GeglBuffer                   *buffer,
+                             const GeglRectangle          *rect,
+                             gint                          level,
+                             const Babl                   *format,
+                             gpointer                      result,
+                             gsize                         result_size,
+                             GeglParallelReduceBufferFunc  reduce_func,
+                             GeglParallelMergeFunc         merge_func,
+                             gpointer                      user_data)
+{
+  GeglParallelReduceBufferData data;
+
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (format != NULL);
+  g_return_if_fail (reduce_func != NULL);
+
+  if (! rect)
+    rect = gegl_buffer_get_extent (buffer);
+
+  data.buffer    = buffer;
+  data.level     = level;
+  data.format    = format;
+  data.func      = reduce_func;
+  data.user_data = user_data;
+
+  /* split the area into bands of whole rows, which are cheaper to iterate
+   * over than columns
+   */
+  gegl_parallel_reduce_area (
+    rect, GEGL_PARALLEL_REDUCE_BUFFER_THREAD_COST,
+    GEGL_SPLIT_STRATEGY_HORIZONTAL,
+    result, result_size,
+    (GeglParallelReduceAreaFunc) gegl_parallel_reduce_buffer_func,
+    merge_func,
+    &data);
+}
+
+typedef struct
+{
+  gint     n_components;
+  gboolean min_max;
+  gboolean sums;
+} GeglParallelStatisticsData;
+
+/* the statistics are stored as n_components minima, maxima, sums and sums
+ * of squares, in this order
+ */
+static void
+gegl_parallel_statistics_reduce (const gfloat               *pixels,
+                                 gint                        n_pixels,
+                                 gdouble                    *partial,
+                                 GeglParallelStatisticsData *data)
+{
+  const gint  n_components = data->n_components;
+  gdouble    *min          = partial;
+  gdouble    *max          = min + n_components;
+  gdouble    *sum          = max + n_components;
+  gdouble    *sum_squares  = sum + n_components;
+  gint        i, c;
+
+  for (c = 0; c < n_components; c++)
+    {
+      const gfloat *p = pixels + c;
+
+      if (data->min_max)
+        {
+          gfloat cmin = min[c];
+          gfloat cmax = max[c];
+
+          for (i = 0; i < n_pixels; i++, p += n_components)
+            {
+              if (*p < cmin) cmin = *p;
+              if (*p > cmax) cmax = *p;
+            }
+
+          /* don't round the initial values to float */
+          min[c] = MIN (min[c], cmin);
+          max[c] = MAX (max[c], cmax);
+
+          p = pixels + c;
+        }
+
+      if (data->sums)
+        {
+          gdouble csum         = 0.0;
+          gdouble csum_squares = 0.0;
+
+          for (i = 0; i < n_pixels; i++, p += n_components)
+            {
+              csum         += *p;
+              csum_squares += (gdouble) *p * *p;
+            }
+
+          sum[c]         += csum;
+          sum_squares[c] += csum_squares;
+        }
+    }
+}
+
+static void
+gegl_parallel_statistics_merge (gdouble                    *result,
+                                const gdouble              *partial,
+                                GeglParallelStatisticsData *data)
+{
+  const gint n_components = data->n_components;
+  gint       c;
+
+  for (c = 0; c < n_components; c++)
+    {
+      result[c]                    = MIN (result[c], partial[c]);
+      result[c + n_components]     = MAX (result[c + n_components],
+                                          partial[c + n_components]);
+      result[c + 2 * n_components] += partial[c + 2 * n_components];
+      result[c + 3 * n_components] += partial[c + 3 * n_components];
+    }
+}
+
+static gboolean
+gegl_parallel_is_float_format (const Babl *format)
+{
+  const Babl *type = babl_type ("float");
+  gint        n_components;
+  gint        c;
+
+  n_components = babl_format_get_n_components (format);
+
+  for (c = 0; c < n_components; c++)
+    {
+      if (babl_format_get_type (format, c) != type)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+void
+gegl_parallel_get_buffer_statistics (GeglBuffer          *buffer,
+                                     const GeglRectangle *rect,
+                                     gint                 level,
+                                     const Babl          *format,
+                                     gdouble             *min,
+                                     gdouble             *max,
+                                     gdouble             *sum,
+                                     gdouble             *sum_squares)
+{
+  GeglParallelStatisticsData  data;
+  gdouble                    *result;
+  gint                        n_components;
+  gint                        c;
+
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (format != NULL);
+  g_return_if_fail (gegl_parallel_is_float_format (format));
+
+  n_components = babl_format_get_n_components (format);
+
+  data.n_components = n_components;
+  data.min_max      = min || max;
+  data.sums         = sum || sum_squares;
+
+  result = g_new (gdouble, 4 * n_components);
+
+  for (c = 0; c < n_components; c++)
+    {
+      result[c]                    =  G_MAXDOUBLE;
+      result[c + n_components]     = -G_MAXDOUBLE;
+      result[c + 2 * n_components] =  0.0;
+      result[c + 3 * n_components] =  0.0;
+    }
+
+  gegl_parallel_reduce_buffer (
+    buffer, rect, level, format,
+    result, 4 * n_components * sizeof (gdouble),
+    (GeglParallelReduceBufferFunc) gegl_parallel_statistics_reduce,
+    (GeglParallelMergeFunc) gegl_parallel_statistics_merge,
     &data);
+
+  for (c = 0; c < n_components; c++)
+    {
+      if (min)         min[c]         = result[c];
+      if (max)         max[c]         = result[c + n_components];
+      if (sum)         sum[c]         = result[c + 2 * n_components];
+      if (sum_squares) sum_squares[c] = result[c + 3 * n_components];
+    }
+
+  g_free (result);
 }
 
 
@@ -489,9 +847,13 @@ gegl_parallel_distribute_thread_func (GeglParallelDistributeThread *thread)
         }
       else if (thread->task)
         {
+          gegl_parallel_set_cancel_token (thread->task->cancel_token);
+
           thread->task->func (thread->i, thread->task->n,
                               thread->task->user_data);
 
+          gegl_parallel_set_cancel_token (NULL);
+
           if (g_atomic_int_dec_and_test (
                 &gegl_parallel_distribute_completion_counter))
             {
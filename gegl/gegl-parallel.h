@@ -69,6 +69,53 @@ typedef void (* GeglParallelDistributeRangeFunc) (gsize                offset,
 typedef void (* GeglParallelDistributeAreaFunc)  (const GeglRectangle *area,
                                                   gpointer             user_data);
 
+/**
+ * GeglParallelReduceAreaFunc:
+ * @area: the current sub-area
+ * @partial: the partial result of the current thread
+ * @user_data: user data pointer
+ *
+ * Specifies the type of function passed to gegl_parallel_reduce_area().
+ *
+ * The function should accumulate the sub-area specified by @area into
+ * @partial.
+ */
+typedef void (* GeglParallelReduceAreaFunc)      (const GeglRectangle *area,
+                                                  gpointer             partial,
+                                                  gpointer             user_data);
+
+/**
+ * GeglParallelReduceBufferFunc:
+ * @pixels: the current pixels
+ * @n_pixels: the number of pixels
+ * @partial: the partial result of the current thread
+ * @user_data: user data pointer
+ *
+ * Specifies the type of function passed to gegl_parallel_reduce_buffer().
+ *
+ * The function should accumulate the @n_pixels pixels at @pixels, in the
+ * format passed to gegl_parallel_reduce_buffer(), into @partial.
+ */
+typedef void (* GeglParallelReduceBufferFunc)    (gconstpointer        pixels,
+                                                  gint                 n_pixels,
+                                                  gpointer             partial,
+                                                  gpointer             user_data);
+
+/**
+ * GeglParallelMergeFunc:
+ * @result: the result
+ * @partial: a partial result
+ * @user_data: user data pointer
+ *
+ * Specifies the type of function passed to gegl_parallel_reduce_area() and
+ * gegl_parallel_reduce_buffer().
+ *
+ * The function should merge @partial into @result.
+ */
+typedef void (* GeglParallelMergeFunc)           (gpointer             result,
+                                                  gconstpointer        partial,
+                                                  gpointer             user_data);
+
 
 /**
  * gegl_parallel_distribute:
@@ -78,6 +125,11 @@ typedef void (* GeglParallelDistributeAreaFunc)  (const GeglRectangle *area,
  *
  * Distributes the execution of a function across multiple threads,
  * by calling it with a different index on each thread.
+ *
+ * The function is always called, even if the rendering job of the calling
+ * thread has been cancelled; the cancellation token is passed on to the
+ * threads, so that the function can check gegl_parallel_is_cancelled()
+ * itself.
  */
 void   gegl_parallel_distribute       (gint                             max_n,
                                        GeglParallelDistributeFunc       func,
@@ -119,6 +171,106 @@ void   gegl_parallel_distribute_area  (const GeglRectangle             *area,
                                        GeglParallelDistributeAreaFunc   func,
                                        gpointer                         user_data);
 
+/**
+ * gegl_parallel_reduce_area:
+ * @area: the area to process
+ * @thread_cost: the cost of using each additional thread, relative
+ *               to the cost of processing a single data element
+ * @split_strategy: the strategy to use for dividing the area
+ * @result: the result, initialized to the identity of @merge_func
+ * @result_size: the size of @result, in bytes
+ * @reduce_func: (closure user_data) (scope call): the function to call for
+ *               each sub-area
+ * @merge_func: (closure user_data) (scope call): the function to call for
+ *              each partial result
+ * @user_data: user data to pass to the functions
+ *
+ * Reduces a planar data-structure to a single result across multiple
+ * threads, like gegl_parallel_distribute_area().  Each thread accumulates
+ * its sub-area into its own partial result, which starts out as a copy of
+ * @result; the partial results are then merged into @result, in order, on
+ * the calling thread.  The result is therefore the same for any number of
+ * threads, as long as @merge_func is associative.
+ */
+void   gegl_parallel_reduce_area      (const GeglRectangle             *area,
+                                       gdouble                          thread_cost,
+                                       GeglSplitStrategy                split_strategy,
+                                       gpointer                         result,
+                                       gsize                            result_size,
+                                       GeglParallelReduceAreaFunc       reduce_func,
+                                       GeglParallelMergeFunc            merge_func,
+                                       gpointer                         user_data);
+
+/**
+ * gegl_parallel_reduce_buffer:
+ * @buffer: the buffer to process
+ * @rect: (nullable): the rectangle to process, in the coordinates of @level,
+ *        or %NULL for the extent of @buffer
+ * @level: the mipmap level to read
+ * @format: the format to read the pixels in
+ * @result: the result, initialized to the identity of @merge_func
+ * @result_size: the size of @result, in bytes
+ * @reduce_func: (closure user_data) (scope call): the function to call for
+ *               each run of pixels
+ * @merge_func: (closure user_data) (scope call): the function to call for
+ *              each partial result
+ * @user_data: user data to pass to the functions
+ *
+ * Reduces the pixels of @rect of @buffer to a single result across
+ * multiple threads, using gegl_parallel_reduce_area().  Each thread
+ * iterates over part of @rect, and passes the pixels to @reduce_func.
+ */
+void   gegl_parallel_reduce_buffer    (GeglBuffer                      *buffer,
+                                       const GeglRectangle             *rect,
+                                       gint                             level,
+                                       const Babl                      *format,
+                                       gpointer                         result,
+                                       gsize                            result_size,
+                                       GeglParallelReduceBufferFunc     reduce_func,
+                                       GeglParallelMergeFunc            merge_func,
+                                       gpointer                         user_data);
+
+/**
+ * gegl_parallel_get_buffer_statistics:
+ * @buffer: the buffer to process
+ * @rect: (nullable): the rectangle to process, in the coordinates of @level,
+ *        or %NULL for the extent of @buffer
+ * @level: the mipmap level to read
+ * @format: the format to read the pixels in, whose components must all be
+ *          floats
+ * @min: (out caller-allocates) (nullable): the minimum of each component
+ * @max: (out caller-allocates) (nullable): the maximum of each component
+ * @sum: (out caller-allocates) (nullable): the sum of each component
+ * @sum_squares: (out caller-allocates) (nullable): the sum of the squares of
+ *               each component
+ *
+ * Computes per-component statistics of the pixels of @rect of @buffer in
+ * parallel.  Each of the arrays, if not %NULL, receives a value for each
+ * of the components of @format.  NaN components are ignored by @min and
+ * @max, which are G_MAXDOUBLE and -G_MAXDOUBLE when there are no pixels.
+ */
+void   gegl_parallel_get_buffer_statistics
+                                      (GeglBuffer                      *buffer,
+                                       const GeglRectangle             *rect,
+                                       gint                             level,
+                                       const Babl                      *format,
+                                       gdouble                         *min,
+                                       gdouble                         *max,
+                                       gdouble                         *sum,
+                                       gdouble                         *sum_squares);
+
+/**
+ * gegl_parallel_is_cancelled:
+ *
+ * Checks whether the rendering job the calling thread is working on, if
+ * any, has been cancelled (for example using gegl_processor_cancel()).
+ * Long-running operations should poll this periodically and return early
+ * when it returns %TRUE; the output of cancelled jobs is discarded.
+ *
+ * Returns: %TRUE if the job was cancelled.
+ */
+gboolean gegl_parallel_is_cancelled   (void);
+
 
 #ifdef __cplusplus
 #if __cplusplus >= 201103
@@ -623,9 +623,14 @@ gegl_node_connect_to (GeglNode    *sink,
  * version in more coarse, potentially over-invalidating (but never under-
  * invalidating), but has lower overhead.
  *
- * TODO: decide if the higher overhead of the GeglRegion version is worth it.
+ * The GeglRegion version is used by default, since bounding-box inflation
+ * makes incremental re-rendering of sparse changes (e.g. brush strokes on a
+ * large canvas) recompute far more than what actually changed.  To keep the
+ * overhead bounded, a node's region is collapsed to its bounding box once it
+ * consists of more than GEGL_NODE_INVALIDATED_MAX_RECTS rectangles.
  */
-/* #define GEGL_NODE_INVALIDATED_USE_REGIONS */
+#define GEGL_NODE_INVALIDATED_USE_REGIONS
+#define GEGL_NODE_INVALIDATED_MAX_RECTS 16
 
 #ifdef GEGL_NODE_INVALIDATED_USE_REGIONS
 
@@ -645,6 +650,12 @@ gegl_node_invalidated_invalidate_node (GeglNode *node,
   gegl_region_get_rectangles (region,
                               &rects, &n_rects);
 
+  if (n_rects > GEGL_NODE_INVALIDATED_MAX_RECTS)
+    {
+      gegl_region_get_clipbox (region, &rects[0]);
+      n_rects = 1;
+    }
+
   for (i = 0; i < n_rects; i++)
     {
       if (node->cache)
@@ -683,7 +694,8 @@ gegl_node_invalidated_invalidate_node (GeglNode *node,
         }
       else
         {
-          gegl_region_union (sink_region, region);
+          for (i = 0; i < n_rects; i++)
+            gegl_region_union_with_rect (sink_region, &rects[i]);
         }
     }
 
@@ -1241,12 +1253,19 @@ gegl_node_blit (GeglNode            *self,
               gint  level = gegl_mipmap_rendering_enabled()?gegl_level_from_scale (scale):0;
 
               gegl_node_blit_buffer (self, buffer, &unscaled_roi, level, GEGL_ABYSS_NONE);
-              gegl_cache_computed (cache, &unscaled_roi, level);
+              /* a cancelled render may have left partial results */
+              if (! gegl_parallel_is_cancelled ())
+                gegl_cache_computed (cache, &unscaled_roi, level);
+              else
+                gegl_cache_invalidate (cache, &unscaled_roi);
             }
           else
             {
               gegl_node_blit_buffer (self, buffer, roi, 0, GEGL_ABYSS_NONE);
-              gegl_cache_computed (cache, roi, 0);
+              if (! gegl_parallel_is_cancelled ())
+                gegl_cache_computed (cache, roi, 0);
+              else
+                gegl_cache_invalidate (cache, roi);
             }
         }
 
@@ -64,6 +64,8 @@ struct _GeglOperationContext
   GHashTable    *contexts;      /* to be able to look up the context of
                                    other nodes/ops in the graph we store the
                                    hashtable we will be stored in */
+  const gint    *cancel_token;  /* set to non-zero when the job this context
+                                   is part of is cancelled, or NULL */
 };
 
 GeglOperationContext *gegl_operation_context_new       (GeglOperation        *operation,
@@ -378,6 +378,12 @@ gegl_operation_context_get_level (GeglOperationContext *ctxt)
   return ctxt->level;
 }
 
+gboolean
+gegl_operation_context_is_cancelled (GeglOperationContext *ctxt)
+{
+  return ctxt->cancel_token && g_atomic_int_get (ctxt->cancel_token);
+}
+
 
 GeglBuffer *
 gegl_operation_context_get_output_maybe_in_place (GeglOperation *operation,
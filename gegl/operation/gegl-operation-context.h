@@ -43,6 +43,8 @@ void            gegl_operation_context_purge           (GeglOperationContext *se
 
 gint            gegl_operation_context_get_level       (GeglOperationContext *self);
 
+gboolean        gegl_operation_context_is_cancelled    (GeglOperationContext *self);
+
 /* the rest of these functions are for internal use only */
 
 GeglBuffer *    gegl_operation_context_get_output_maybe_in_place (GeglOperation        *operation,
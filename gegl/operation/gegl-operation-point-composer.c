@@ -29,6 +29,7 @@
 #include "gegl-config.h"
 #include "gegl-types-internal.h"
 #include "gegl-buffer-private.h"
+#include "gegl-buffer-iterator-private.h"
 #include "gegl-tile-storage.h"
 #include <sys/types.h>
 #include <unistd.h>
@@ -51,6 +52,8 @@ typedef struct ThreadData
   const Babl *input_format;
   const Babl *aux_format;
   const Babl *output_format;
+
+  const GeglRectangle *areas;
 } ThreadData;
 
 static void
@@ -63,7 +66,7 @@ thread_process (const GeglRectangle *area,
                                                     area,
                                                     data->level,
                                                     data->output_format,
-                                                    GEGL_ACCESS_WRITE,
+                                                    GEGL_ACCESS_WRITE | GEGL_ITERATOR_CANCELLABLE,
                                                     GEGL_ABYSS_NONE,
                                                     4);
 
@@ -85,6 +88,17 @@ thread_process (const GeglRectangle *area,
   }
 }
 
+static void
+thread_process_areas (gsize       offset,
+                      gsize       size,
+                      ThreadData *data)
+{
+  gsize i;
+
+  for (i = offset; i < offset + size; i++)
+    thread_process (&data->areas[i], data);
+}
+
 static gboolean
 gegl_operation_composer_process (GeglOperation        *operation,
                                  GeglOperationContext *context,
@@ -282,6 +296,178 @@ gegl_operation_point_composer_init (GeglOperationPointComposer *self)
 
 }
 
+typedef enum
+{
+  AUX_TILE_PROCESS,
+  AUX_TILE_PASS_THROUGH,
+  AUX_TILE_REPLACE
+} AuxTileAction;
+
+typedef struct
+{
+  GeglRectangle rect;
+  AuxTileAction action;
+} AuxTileRun;
+
+/*
+ * Operations whose result is their input wherever aux is transparent set the
+ * "transparent-aux-passthrough" key, and operations whose result is aux
+ * wherever it is opaque set the "opaque-aux-replaces" key.  The tiles of aux
+ * which are summarized as such are then copied from input or aux instead of
+ * being processed, which lets a sparse layer over a large canvas only be
+ * composited where it has content; copying whole tiles usually shares them.
+ *
+ * Returns FALSE, without processing anything, if no tile can be skipped.
+ */
+static gboolean
+gegl_operation_point_composer_process_aux_tiles (GeglOperation       *operation,
+                                                 ThreadData          *data,
+                                                 const GeglRectangle *result,
+                                                 gboolean             threaded)
+{
+  GeglOperationClass *operation_class = GEGL_OPERATION_GET_CLASS (operation);
+  GeglBuffer         *aux             = data->aux;
+  gboolean            pass_through;
+  gboolean            replace;
+  guint               flags           = 0;
+  gboolean            skipped         = FALSE;
+  GArray             *runs;
+  GArray             *areas;
+  gdouble             n_pixels        = 0.0;
+  gint                x, y;
+  guint               i;
+
+  pass_through = ! g_strcmp0 (gegl_operation_class_get_key (
+                                operation_class,
+                                "transparent-aux-passthrough"), "true");
+  replace      = ! g_strcmp0 (gegl_operation_class_get_key (
+                                operation_class,
+                                "opaque-aux-replaces"), "true");
+
+  if (pass_through)
+    flags |= GEGL_TILE_SUMMARY_TRANSPARENT;
+  if (replace)
+    flags |= GEGL_TILE_SUMMARY_OPAQUE;
+
+  if (! flags)
+    return FALSE;
+
+  if (gegl_cl_is_accelerated ())
+    {
+      gegl_buffer_flush_ext (data->input, result);
+      gegl_buffer_flush_ext (aux, result);
+    }
+
+  runs = g_array_new (FALSE, FALSE, sizeof (AuxTileRun));
+
+  /* classify the parts of the result covered by each tile of aux, merging
+   * runs of tiles along rows
+   */
+  for (y = result->y; y < result->y + result->height;)
+    {
+      gint ty = gegl_tile_indice (y + aux->shift_y, aux->tile_height);
+      gint y1 = MIN ((ty + 1) * aux->tile_height - aux->shift_y,
+                     result->y + result->height);
+
+      for (x = result->x; x < result->x + result->width;)
+        {
+          gint          tx = gegl_tile_indice (x + aux->shift_x,
+                                               aux->tile_width);
+          gint          x1 = MIN ((tx + 1) * aux->tile_width - aux->shift_x,
+                                  result->x + result->width);
+          GeglRectangle cell = {x, y, x1 - x, y1 - y};
+          AuxTileAction action = AUX_TILE_PROCESS;
+          guint         summary;
+
+          summary = gegl_buffer_get_summary (aux, &cell, flags);
+
+          if (pass_through && (summary & GEGL_TILE_SUMMARY_TRANSPARENT))
+            action = AUX_TILE_PASS_THROUGH;
+          else if (replace && (summary & GEGL_TILE_SUMMARY_OPAQUE))
+            action = AUX_TILE_REPLACE;
+
+          if (action != AUX_TILE_PROCESS)
+            skipped = TRUE;
+
+          if (runs->len > 0 &&
+              g_array_index (runs, AuxTileRun, runs->len - 1).action == action &&
+              g_array_index (runs, AuxTileRun, runs->len - 1).rect.y == y)
+            {
+              g_array_index (runs, AuxTileRun, runs->len - 1).rect.width +=
+                cell.width;
+            }
+          else
+            {
+              AuxTileRun run = {cell, action};
+
+              g_array_append_val (runs, run);
+            }
+
+          x = x1;
+        }
+
+      y = y1;
+    }
+
+  if (! skipped)
+    {
+      g_array_free (runs, TRUE);
+
+      return FALSE;
+    }
+
+  areas = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
+  for (i = 0; i < runs->len; i++)
+    {
+      AuxTileRun *run = &g_array_index (runs, AuxTileRun, i);
+
+      switch (run->action)
+        {
+        case AUX_TILE_PROCESS:
+          g_array_append_val (areas, run->rect);
+          n_pixels += (gdouble) run->rect.width * run->rect.height;
+          break;
+
+        case AUX_TILE_PASS_THROUGH:
+          if (data->input != data->output)
+            {
+              gegl_buffer_copy (data->input, &run->rect, GEGL_ABYSS_NONE,
+                                data->output, &run->rect);
+            }
+          break;
+
+        case AUX_TILE_REPLACE:
+          gegl_buffer_copy (aux, &run->rect, GEGL_ABYSS_NONE,
+                            data->output, &run->rect);
+          break;
+        }
+    }
+
+  data->areas = (const GeglRectangle *) areas->data;
+
+  if (threaded && areas->len > 1)
+    {
+      gegl_parallel_distribute_range (
+        areas->len,
+        gegl_operation_get_pixels_per_thread (operation) /
+        (n_pixels / areas->len),
+        (GeglParallelDistributeRangeFunc) thread_process_areas,
+        data);
+    }
+  else
+    {
+      thread_process_areas (0, areas->len, data);
+    }
+
+  data->areas = NULL;
+
+  g_array_free (areas, TRUE);
+  g_array_free (runs, TRUE);
+
+  return TRUE;
+}
+
 static gboolean
 gegl_operation_point_composer_process (GeglOperation       *operation,
                                        GeglBuffer          *input,
@@ -305,6 +491,28 @@ gegl_operation_point_composer_process (GeglOperation       *operation,
               return TRUE;
         }
 
+      if (input && aux && level == 0)
+        {
+          ThreadData data;
+
+          data.klass = point_composer_class;
+          data.operation = operation;
+          data.input = input;
+          data.aux = aux;
+          data.output = output;
+          data.level = level;
+          data.input_format = in_format;
+          data.aux_format = aux_format;
+          data.output_format = out_format;
+
+          if (gegl_operation_point_composer_process_aux_tiles (
+                operation, &data, result,
+                gegl_operation_use_threading (operation, result)))
+            {
+              return TRUE;
+            }
+        }
+
       if (gegl_operation_use_threading (operation, result))
       {
         ThreadData data;
@@ -338,7 +546,7 @@ gegl_operation_point_composer_process (GeglOperation       *operation,
       }
       else
       {
-        GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, out_format, GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 4);
+        GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, out_format, GEGL_ACCESS_WRITE | GEGL_ITERATOR_CANCELLABLE, GEGL_ABYSS_NONE, 4);
         gint foo = 0, read = 0;
 
         if (input)
@@ -27,6 +27,7 @@
 #include "gegl-types-internal.h"
 #include "gegl-config.h"
 #include "gegl-buffer-private.h"
+#include "gegl-buffer-iterator-private.h"
 #include "gegl-tile-storage.h"
 #include <sys/types.h>
 #include <unistd.h>
@@ -61,7 +62,7 @@ thread_process (const GeglRectangle *area,
                                                     area,
                                                     data->level,
                                                     data->output_format,
-                                                    GEGL_ACCESS_WRITE,
+                                                    GEGL_ACCESS_WRITE | GEGL_ITERATOR_CANCELLABLE,
                                                     GEGL_ABYSS_NONE, 4);
 
   if (data->input)
@@ -257,7 +258,7 @@ gegl_operation_point_composer3_process (GeglOperation       *operation,
       else
       {
         GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, out_format,
-                                                          GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 4);
+                                                          GEGL_ACCESS_WRITE | GEGL_ITERATOR_CANCELLABLE, GEGL_ABYSS_NONE, 4);
         gint foo = 0, bar = 0, read = 0;
 
         if (input)
@@ -28,6 +28,7 @@
 #include "gegl-config.h"
 #include "gegl-types-internal.h"
 #include "gegl-buffer-private.h"
+#include "gegl-buffer-iterator-private.h"
 #include "gegl-tile-storage.h"
 #include <sys/types.h>
 #include <unistd.h>
@@ -57,7 +58,7 @@ thread_process (const GeglRectangle *area,
                                                     area,
                                                     data->level,
                                                     data->output_format,
-                                                    GEGL_ACCESS_WRITE,
+                                                    GEGL_ACCESS_WRITE | GEGL_ITERATOR_CANCELLABLE,
                                                     GEGL_ABYSS_NONE, 4);
   gint read = 0;
   if (data->input)
@@ -297,7 +298,7 @@ gegl_operation_point_filter_process (GeglOperation       *operation,
       else
       {
         GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, out_format,
-                                                          GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 4);
+                                                          GEGL_ACCESS_WRITE | GEGL_ITERATOR_CANCELLABLE, GEGL_ABYSS_NONE, 4);
         gint read = 0;
 
         if (input)
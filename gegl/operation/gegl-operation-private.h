@@ -22,7 +22,12 @@
 G_BEGIN_DECLS
 
 
-gboolean   gegl_operation_use_cache (GeglOperation *operation);
+gboolean   gegl_operation_use_cache      (GeglOperation *operation);
+
+/* returns the measured processing time per pixel of the operation, in
+ * seconds, or a negative value if it hasn't been measured yet
+ */
+gdouble    gegl_operation_get_pixel_time (GeglOperation *operation);
 
 
 G_END_DECLS
@@ -140,6 +140,7 @@ gegl_operation_process (GeglOperation        *operation,
   gint64              n_pixels;
   gboolean            update_pixel_time;
   gboolean            success;
+  const gint         *cancel_token;
 
   g_return_val_if_fail (GEGL_IS_OPERATION (operation), FALSE);
   g_return_val_if_fail (result != NULL, FALSE);
@@ -173,8 +174,19 @@ gegl_operation_process (GeglOperation        *operation,
   if (update_pixel_time)
     t = g_get_monotonic_time ();
 
+  /* make the job's cancellation token available to the operation, and to
+   * the threads it distributes work to
+   */
+  cancel_token = gegl_parallel_set_cancel_token (context->cancel_token);
+
   success = klass->process (operation, context, output_pad, result, level);
 
+  gegl_parallel_set_cancel_token (cancel_token);
+
+  /* don't let a truncated run skew the timing */
+  if (gegl_operation_context_is_cancelled (context))
+    update_pixel_time = FALSE;
+
   if (success && update_pixel_time)
     {
       t = g_get_monotonic_time () - t;
@@ -935,6 +947,14 @@ gegl_operation_get_pixels_per_thread (GeglOperation *operation)
               GEGL_OPERATION_MAX_PIXELS_PER_THREAD);
 }
 
+gdouble
+gegl_operation_get_pixel_time (GeglOperation *operation)
+{
+  GeglOperationPrivate *priv = gegl_operation_get_instance_private (operation);
+
+  return priv->pixel_time;
+}
+
 static void
 gegl_operation_update_pixel_time (GeglOperation       *self,
                                   const GeglRectangle *roi,
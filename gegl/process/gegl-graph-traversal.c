@@ -25,6 +25,7 @@
 #include "gegl.h"
 #include "gegl-debug.h"
 #include "gegl-instrument.h"
+#include "gegl-parallel-private.h"
 
 #include "gegl-region.h"
 
@@ -39,9 +40,15 @@
 #include "process/gegl-graph-traversal-private.h"
 
 #include "operation/gegl-operation.h"
+#include "operation/gegl-operation-private.h"
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
 
+/* per-pixel processing time assumed for nodes whose time hasn't been
+ * measured yet, when estimating rendering costs
+ */
+#define GEGL_GRAPH_DEFAULT_PIXEL_TIME 1e-8
+
 typedef struct
 {
   const gchar *name;
@@ -363,6 +370,73 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
     }
 }
 
+/**
+ * gegl_graph_get_halo_overhead:
+ * @path: The traversal path
+ * @roi: The request rect
+ * @level: The mipmap level of the request
+ *
+ * Estimate the relative amount of extra work needed to render @roi,
+ * compared to rendering only the pixels of @roi in each node, due to the
+ * context (halo) required by area operations.  Each node is weighted by its
+ * measured per-pixel processing time.  This prepares the request rects of
+ * @path for @roi, and has the same prerequisites as
+ * gegl_graph_prepare_request().
+ *
+ * Return value: The overhead ratio; 0.0 means no extra work.
+ */
+gdouble
+gegl_graph_get_halo_overhead (GeglGraphTraversal  *path,
+                              const GeglRectangle *roi,
+                              gint                 level)
+{
+  GList   *list_iter;
+  gdouble  roi_area;
+  gdouble  cost      = 0.0;
+  gdouble  base_cost = 0.0;
+
+  g_return_val_if_fail (roi != NULL, 0.0);
+
+  roi_area = (gdouble) roi->width * (gdouble) roi->height;
+
+  if (roi_area <= 0.0)
+    return 0.0;
+
+  gegl_graph_prepare_request (path, roi, level);
+
+  for (list_iter = g_queue_peek_head_link (&path->path);
+       list_iter;
+       list_iter = list_iter->next)
+    {
+      GeglNode             *node    = GEGL_NODE (list_iter->data);
+      GeglOperationContext *context = g_hash_table_lookup (path->contexts,
+                                                           node);
+      const GeglRectangle  *need;
+      gdouble               pixel_time;
+
+      if (! node->operation || context->cached)
+        continue;
+
+      need = gegl_operation_context_get_need_rect (context);
+
+      if (need->width == 0 || need->height == 0)
+        continue;
+
+      pixel_time = gegl_operation_get_pixel_time (node->operation);
+
+      if (pixel_time <= 0.0)
+        pixel_time = GEGL_GRAPH_DEFAULT_PIXEL_TIME;
+
+      cost      += pixel_time * need->width * need->height;
+      base_cost += pixel_time * roi_area;
+    }
+
+  if (base_cost <= 0.0)
+    return 0.0;
+
+  return MAX (cost / base_cost - 1.0, 0.0);
+}
+
 void
 free_context_connection (gpointer concon)
 {
@@ -478,16 +552,32 @@ gegl_graph_process (GeglGraphTraversal *path,
                   gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
                 }
 
-              context->level = level;
+              context->level        = level;
+              context->cancel_token = gegl_parallel_get_cancel_token ();
 
-              /* note: this hard-coding of "output" makes some more custom
-               * graph topologies harder than necessary.
+              /* the remaining nodes of a cancelled job are skipped, their
+               * output would be discarded anyway
                */
-              gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
-              operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+              if (! gegl_operation_context_is_cancelled (context))
+                {
+                  /* note: this hard-coding of "output" makes some more custom
+                   * graph topologies harder than necessary.
+                   */
+                  gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
+                  operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+                }
 
               if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
-                gegl_cache_computed (operation->node->cache, &context->need_rect, level);
+                {
+                  /* the output of a cancelled operation may be incomplete,
+                   * and may have overwritten parts of the cache that were
+                   * valid before
+                   */
+                  if (gegl_operation_context_is_cancelled (context))
+                    gegl_cache_invalidate (operation->node->cache, &context->need_rect);
+                  else
+                    gegl_cache_computed (operation->node->cache, &context->need_rect, level);
+                }
             }
         }
       else
@@ -33,5 +33,8 @@ GeglBuffer         *gegl_graph_process          (GeglGraphTraversal  *path,
                                                  gint                 level);
 
 GeglRectangle       gegl_graph_get_bounding_box (GeglGraphTraversal  *path);
+gdouble             gegl_graph_get_halo_overhead (GeglGraphTraversal  *path,
+                                                  const GeglRectangle *roi,
+                                                  gint                 level);
 
 #endif /* __GEGL_GRAPH_TRAVERSAL_H__ */
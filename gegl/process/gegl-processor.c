@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <math.h>
+
 #include <glib-object.h>
 
 #include "gegl.h"
@@ -27,11 +29,14 @@
 #include "gegl-region.h"
 #include "graph/gegl-node-private.h"
 
+#include "process/gegl-graph-traversal.h"
+
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
 #include "operation/gegl-operation-sink.h"
 
 #include "gegl-config.h"
+#include "gegl-parallel-private.h"
 #include "gegl-processor.h"
 #include "gegl-processor-private.h"
 
@@ -65,8 +70,30 @@ static void      gegl_processor_get_property (GObject               *gobject,
 static void      gegl_processor_set_node     (GeglProcessor         *processor,
                                               GeglNode              *node);
 static void      gegl_processor_constructed  (GObject               *object);
+static void      gegl_processor_input_invalidated
+                                             (GeglNode              *node,
+                                              const GeglRectangle   *rect,
+                                              GeglProcessor         *processor);
 static gdouble   gegl_processor_progress     (GeglProcessor         *processor);
-static gint      gegl_processor_get_band_size(gint                   size) G_GNUC_CONST;
+static gint      gegl_processor_get_band_size(gint                   offset,
+                                              gint                   size,
+                                              gint                   tile_size) G_GNUC_CONST;
+
+/* partial cache hits that leave more missing rectangles than this are
+ * rendered as a single bounding box instead */
+#define GEGL_PROCESSOR_MAX_PARTIAL_RECTS 16
+
+/* chunks are grown (up to GEGL_PROCESSOR_MAX_CHUNK_GROWTH times their
+ * nominal area) until the estimated extra work caused by the context
+ * required by area operations is below GEGL_PROCESSOR_MAX_HALO_OVERHEAD
+ */
+#define GEGL_PROCESSOR_MAX_HALO_OVERHEAD 0.5
+#define GEGL_PROCESSOR_MAX_CHUNK_GROWTH  16
+
+/* the share of the reported progress covered by the preview pass, when
+ * rendering at a coarser level first
+ */
+#define GEGL_PROCESSOR_PREVIEW_PROGRESS  0.1
 
 
 struct _GeglProcessor
@@ -84,6 +111,16 @@ struct _GeglProcessor
   GeglRegion      *queued_region;
   GSList          *dirty_rectangles;
   gint             chunk_size;
+  gint             chunk_area;       /* 0 when it needs to be recomputed */
+
+  gboolean         has_priority;
+  GeglRectangle    priority_rectangle; /* unscaled */
+  gdouble          time_budget;        /* in seconds, 0.0 for single steps */
+  gint64           step_time;          /* duration of the last render step */
+  gint             target_level;
+  gint             preview_level;
+  gboolean         preview_pending;
+  gint             cancelled;          /* set atomically */
 
   gdouble          progress;
 };
@@ -146,6 +183,14 @@ gegl_processor_init (GeglProcessor *processor)
   processor->context          = NULL;
   processor->queued_region    = NULL;
   processor->dirty_rectangles = NULL;
+  processor->chunk_area       = 0;
+  processor->has_priority     = FALSE;
+  processor->time_budget      = 0.0;
+  processor->step_time        = 0;
+  processor->target_level     = 0;
+  processor->preview_level    = 0;
+  processor->preview_pending  = FALSE;
+  processor->cancelled        = 0;
   //processor->chunk_size       = 128 * 128;
 }
 
@@ -167,6 +212,11 @@ gegl_processor_finalize (GObject *self_object)
 
   g_clear_pointer (&processor->context, gegl_operation_context_destroy);
 
+  if (processor->input)
+    g_signal_handlers_disconnect_by_func (processor->input,
+                                          gegl_processor_input_invalidated,
+                                          processor);
+
   g_clear_object (&processor->node);
   g_clear_object (&processor->real_node);
   g_clear_object (&processor->input);
@@ -246,6 +296,14 @@ gegl_processor_set_node (GeglProcessor *processor,
   g_set_object (&processor->node, node);
   g_clear_object (&processor->real_node);
 
+  if (processor->input)
+    {
+      g_signal_handlers_disconnect_by_func (processor->input,
+                                            gegl_processor_input_invalidated,
+                                            processor);
+      g_clear_object (&processor->input);
+    }
+
   /* nodes with meta operations are also graphs and can be sinks, so
    * we don't use their output proxy */
   if (GEGL_IS_OPERATION (node->operation))
@@ -295,9 +353,24 @@ gegl_processor_set_node (GeglProcessor *processor,
 
   g_object_ref (processor->input);
 
+  /* changes to the graph or to the properties of its operations change the
+   * cost of the context of area operations, re-estimate the chunk area
+   */
+  g_signal_connect (processor->input, "invalidated",
+                    G_CALLBACK (gegl_processor_input_invalidated),
+                    processor);
+
   g_object_notify (G_OBJECT (processor), "node");
 }
 
+static void
+gegl_processor_input_invalidated (GeglNode            *node,
+                                  const GeglRectangle *rect,
+                                  GeglProcessor       *processor)
+{
+  processor->chunk_area = 0;
+}
+
 static void
 set_scaled_rectangle (GeglProcessor *processor)
 {
@@ -305,6 +378,89 @@ set_scaled_rectangle (GeglProcessor *processor)
   processor->rectangle.y = processor->rectangle_unscaled.y >> processor->level;
   processor->rectangle.width = processor->rectangle_unscaled.width >> processor->level;
   processor->rectangle.height = processor->rectangle_unscaled.height >> processor->level;
+  processor->chunk_area       = 0;
+}
+
+static void
+gegl_processor_clear_dirty_rectangles (GeglProcessor *processor)
+{
+  GSList *iter;
+
+  for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
+    {
+      g_slice_free (GeglRectangle, iter->data);
+    }
+  g_slist_free (processor->dirty_rectangles);
+  processor->dirty_rectangles = NULL;
+}
+
+/* converts the pending dirty rectangles from the coordinates of
+ * @old_level to those of @new_level, enlarging them to whole pixels
+ */
+static void
+gegl_processor_rescale_dirty_rectangles (GeglProcessor *processor,
+                                         gint           old_level,
+                                         gint           new_level)
+{
+  GSList *iter;
+
+  for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
+    {
+      GeglRectangle *rect  = iter->data;
+      gdouble        scale = (gdouble) (1 << old_level) / (1 << new_level);
+      gint           x0, y0, x1, y1;
+
+      x0 = floor (rect->x * scale);
+      y0 = floor (rect->y * scale);
+      x1 = ceil ((rect->x + rect->width)  * scale);
+      y1 = ceil ((rect->y + rect->height) * scale);
+
+      gegl_rectangle_set (rect, x0, y0, x1 - x0, y1 - y0);
+    }
+}
+
+static gboolean
+gegl_processor_has_preview (GeglProcessor *processor)
+{
+  return processor->preview_level > processor->target_level &&
+         ! processor->context;
+}
+
+/* selects the level being rendered; the preview level while a preview pass
+ * is pending, and the target level otherwise.  Pending dirty rectangles are
+ * kept, in the coordinates of the new level.
+ */
+static void
+gegl_processor_update_level (GeglProcessor *processor)
+{
+  gint level;
+
+  if (! gegl_processor_has_preview (processor))
+    processor->preview_pending = FALSE;
+
+  if (processor->preview_pending)
+    level = processor->preview_level;
+  else
+    level = processor->target_level;
+
+  if (level != processor->level)
+    {
+      gegl_processor_rescale_dirty_rectangles (processor, processor->level,
+                                               level);
+
+      processor->level = level;
+
+      /* the valid region of unbuffered rendering is in the coordinates of
+       * the previous level, and none of it is rendered at the new one
+       */
+      if (processor->valid_region)
+        {
+          gegl_region_destroy (processor->valid_region);
+          processor->valid_region = gegl_region_new ();
+        }
+    }
+
+  set_scaled_rectangle (processor);
 }
 
 
@@ -317,7 +473,6 @@ void
 gegl_processor_set_rectangle (GeglProcessor       *processor,
                               const GeglRectangle *rectangle)
 {
-  GSList        *iter;
   GeglRectangle  input_bounding_box;
 
   g_return_if_fail (processor->input != NULL);
@@ -348,16 +503,9 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       gegl_rectangle_intersect (&processor->rectangle_unscaled, &processor->rectangle_unscaled, &bounds);
 #endif
     }
-    {
 
-      /* remove already queued dirty rectangles */
-      for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
-        {
-          g_slice_free (GeglRectangle, iter->data);
-        }
-      g_slist_free (processor->dirty_rectangles);
-      processor->dirty_rectangles = NULL;
-    }
+  /* remove already queued dirty rectangles */
+  gegl_processor_clear_dirty_rectangles (processor);
 
   /* if the node's operation is a sink and it needs the full content then
    * a context will be set up together with a cache and
@@ -389,33 +537,39 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       processor->valid_region = gegl_region_new ();
     }
 
+  /* start over with a preview pass, if one is requested */
+  processor->preview_pending = TRUE;
+  gegl_processor_update_level (processor);
+
   g_object_notify (G_OBJECT (processor), "rectangle");
 }
 
-/* Will generate band_sizes that are adapted to the size of the tiles */
+/* Will generate band_sizes that are adapted to the size of the tiles; offset
+ * is the start of the band relative to the origin of the tile grid.
+ */
 static gint
-gegl_processor_get_band_size (gint size)
+gegl_processor_get_band_size (gint offset,
+                              gint size,
+                              gint tile_size)
 {
   gint band_size;
 
   band_size = size / 2;
 
-  /* try to make the rects generated match better with potential 2^n sized
-   * tiles, XXX: should be improved to make the next slice fit as well. */
-  if (band_size <= 128)
+  /* cut at the tile boundary nearest to the middle, so that both halves
+   * (and all the following slices) start and end on tile boundaries
+   */
+  if (tile_size > 0 && size > tile_size)
     {
-      band_size = MIN(band_size, 64); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
-    }
-  else if (band_size <= 256)
-    {
-      band_size = MIN(band_size, 128); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
-    }
-  else if (band_size <= 512)
-    {
-      band_size = MIN(band_size, 256); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
+      gint cut = offset + band_size + tile_size / 2;
+
+      if (cut >= 0)
+        cut = cut / tile_size * tile_size;
+      else
+        cut = -((-cut + tile_size - 1) / tile_size) * tile_size;
+
+      if (cut > offset && cut < offset + size)
+        band_size = cut - offset;
     }
 
   if (band_size < 1)
@@ -424,6 +578,128 @@ gegl_processor_get_band_size (gint size)
   return band_size;
 }
 
+/* Computes the area of the chunks rendered at a time.  The nominal area is
+ * enlarged for graphs containing area operations, so that the context each
+ * chunk requires from its inputs, weighted by the measured per-pixel cost
+ * of the nodes, doesn't dominate the work; smaller chunks would recompute
+ * the overlapping context of adjacent chunks over and over.
+ */
+static void
+gegl_processor_update_chunk_area (GeglProcessor *processor)
+{
+  GeglGraphTraversal *path;
+  GeglRectangle       probe;
+  gint                max_area;
+  gint                area;
+  gint                side;
+
+  max_area = processor->chunk_size * (1<<processor->level) *
+             (1<<processor->level) * gegl_config_threads();
+  area     = max_area;
+
+  if (processor->rectangle.width  > 0 &&
+      processor->rectangle.height > 0 &&
+      (gint64) processor->rectangle.width *
+      (gint64) processor->rectangle.height > max_area)
+    {
+      path = gegl_graph_build (processor->input);
+      gegl_graph_prepare (path);
+
+      side = MAX (sqrt (max_area), 1);
+
+      while (area < max_area * GEGL_PROCESSOR_MAX_CHUNK_GROWTH)
+        {
+          probe.width  = MIN (side, processor->rectangle.width);
+          probe.height = MIN (side, processor->rectangle.height);
+          probe.x      = processor->rectangle.x +
+                         (processor->rectangle.width  - probe.width)  / 2;
+          probe.y      = processor->rectangle.y +
+                         (processor->rectangle.height - probe.height) / 2;
+
+          if (gegl_graph_get_halo_overhead (path, &probe, processor->level) <=
+                GEGL_PROCESSOR_MAX_HALO_OVERHEAD ||
+              (probe.width  == processor->rectangle.width &&
+               probe.height == processor->rectangle.height))
+            break;
+
+          side *= 2;
+          area *= 4;
+        }
+
+      gegl_graph_free (path);
+
+      area = MIN (area, max_area * GEGL_PROCESSOR_MAX_CHUNK_GROWTH);
+    }
+
+  processor->chunk_area = MAX (area, 1);
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS, "processor chunk area for %s: %d (nominal %d)",
+             gegl_node_get_debug_name (processor->node),
+             processor->chunk_area, max_area);
+}
+
+/* returns the squared distance, in the processor's current level, between
+ * the rectangle and the center of the priority rectangle; 0 when the
+ * processor has no priority rectangle or the center lies inside the
+ * rectangle
+ */
+static gdouble
+gegl_processor_priority_distance (GeglProcessor       *processor,
+                                  const GeglRectangle *rectangle)
+{
+  gdouble cx, cy;
+  gdouble dx = 0.0;
+  gdouble dy = 0.0;
+
+  if (! processor->has_priority)
+    return 0.0;
+
+  cx = (processor->priority_rectangle.x +
+        processor->priority_rectangle.width  / 2.0) / (1 << processor->level);
+  cy = (processor->priority_rectangle.y +
+        processor->priority_rectangle.height / 2.0) / (1 << processor->level);
+
+  if (cx < rectangle->x)
+    dx = rectangle->x - cx;
+  else if (cx > rectangle->x + rectangle->width)
+    dx = cx - (rectangle->x + rectangle->width);
+
+  if (cy < rectangle->y)
+    dy = rectangle->y - cy;
+  else if (cy > rectangle->y + rectangle->height)
+    dy = cy - (rectangle->y + rectangle->height);
+
+  return dx * dx + dy * dy;
+}
+
+/* returns the index of the rectangle nearest to the priority center */
+static gint
+gegl_processor_priority_pick (GeglProcessor       *processor,
+                              const GeglRectangle *rectangles,
+                              gint                 n_rectangles)
+{
+  gdouble best_distance = G_MAXDOUBLE;
+  gint    best          = 0;
+  gint    i;
+
+  if (! processor->has_priority)
+    return 0;
+
+  for (i = 0; i < n_rectangles; i++)
+    {
+      gdouble distance = gegl_processor_priority_distance (processor,
+                                                           &rectangles[i]);
+
+      if (distance < best_distance)
+        {
+          best_distance = distance;
+          best          = i;
+        }
+    }
+
+  return best;
+}
+
 /* If the processor's dirty rectangle is too big then it will be cut, added
  * to the processor's list of dirty rectangles and TRUE will be returned.
  * If the rectangle is small enough it will be processed, using a buffer or
@@ -432,9 +708,18 @@ static gboolean
 render_rectangle (GeglProcessor *processor)
 {
   gboolean    buffered;
-  const gint  max_area = processor->chunk_size * (1<<processor->level) * (1<<processor->level) * gegl_config_threads();
-  GeglCache  *cache    = NULL;
-  const Babl *format   = NULL;
+  gint        max_area;
+  GeglCache  *cache       = NULL;
+  const Babl *format      = NULL;
+  gint        tile_width  = gegl_config ()->tile_width;
+  gint        tile_height = gegl_config ()->tile_height;
+  gint        shift_x     = 0;
+  gint        shift_y     = 0;
+
+  if (! processor->chunk_area)
+    gegl_processor_update_chunk_area (processor);
+
+  max_area = processor->chunk_area;
 
   /* Retrieve the cache if the processor's node is not buffered if its
    * operation is a sink and it doesn't use the full area  */
@@ -444,6 +729,13 @@ render_rectangle (GeglProcessor *processor)
     {
       cache = gegl_node_get_cache (processor->input);
       format = gegl_buffer_get_format ((GeglBuffer *)cache);
+
+      g_object_get (cache,
+                    "tile-width",  &tile_width,
+                    "tile-height", &tile_height,
+                    "shift-x",     &shift_x,
+                    "shift-y",     &shift_y,
+                    NULL);
     }
 
   if (processor->dirty_rectangles)
@@ -461,10 +753,15 @@ render_rectangle (GeglProcessor *processor)
 
             fragment = g_slice_dup (GeglRectangle, dr);
 
-            /* When splitting a rectangle, we'll do it on the biggest side */
+            /* When splitting a rectangle, we'll do it on the biggest side,
+             * along the tile grid of the cache.  The first slice is
+             * rendered first, so that rectangles are processed in scanline
+             * order, as before.
+             */
             if (dr->width > dr->height)
               {
-                band_size = gegl_processor_get_band_size ( dr->width );
+                band_size = gegl_processor_get_band_size (
+                  dr->x + (shift_x >> processor->level), dr->width, tile_width);
 
                 fragment->width = band_size;
                 dr->width      -= band_size;
@@ -472,13 +769,22 @@ render_rectangle (GeglProcessor *processor)
               }
             else
               {
-                band_size = gegl_processor_get_band_size (dr->height);
+                band_size = gegl_processor_get_band_size (
+                  dr->y + (shift_y >> processor->level), dr->height, tile_height);
 
                 fragment->height = band_size;
                 dr->height      -= band_size;
                 dr->y           += band_size;
               }
-            processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, fragment);
+
+            /* with a priority rectangle, the slice nearest to its center is
+             * rendered first, so that rendering proceeds center-out
+             */
+            if (gegl_processor_priority_distance (processor, dr) <
+                gegl_processor_priority_distance (processor, fragment))
+              processor->dirty_rectangles = g_slist_insert (processor->dirty_rectangles, fragment, 1);
+            else
+              processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, fragment);
           }
           return TRUE;
         }
@@ -502,17 +808,68 @@ render_rectangle (GeglProcessor *processor)
               found_full = TRUE;
               break;
             }
-            /* XXX: dr should be adjusted to be the bounding box of not-found
-             * in cache if there is partial hits
-             */
           }
 
           if (!found_full)
             {
+              const gint    *cancel_token;
+              GeglRegion    *missing = gegl_region_rectangle (dr);
+              GeglRectangle *rectangles;
+              gint           n_rectangles;
+
+              /* only recompute the parts of dr that are not valid in the
+               * cache; partial hits are common when re-rendering after a
+               * region-precise invalidation */
+              gegl_region_subtract (missing,
+                                    cache->valid_region[processor->level]);
+              gegl_region_get_rectangles (missing, &rectangles, &n_rectangles);
+
+              if (n_rectangles == 0)
+                {
+                  g_free (rectangles);
+                  gegl_region_destroy (missing);
+                  g_slice_free (GeglRectangle, dr);
+
+                  return processor->dirty_rectangles != NULL;
+                }
+              else if (n_rectangles > 1 &&
+                       n_rectangles <= GEGL_PROCESSOR_MAX_PARTIAL_RECTS)
+                {
+                  gint i;
+
+                  for (i = n_rectangles - 1; i >= 0; i--)
+                    processor->dirty_rectangles =
+                      g_slist_prepend (processor->dirty_rectangles,
+                                       g_slice_dup (GeglRectangle,
+                                                    &rectangles[i]));
+
+                  g_free (rectangles);
+                  gegl_region_destroy (missing);
+                  g_slice_free (GeglRectangle, dr);
+
+                  return TRUE;
+                }
+
+              /* a single missing rectangle, or one too fragmented to be
+               * worth splitting up; render its bounding box */
+              gegl_region_get_clipbox (missing, dr);
+              g_free (rectangles);
+              gegl_region_destroy (missing);
+
               /* do the image calculations using the buffer */
+              cancel_token = gegl_parallel_set_cancel_token (&processor->cancelled);
               gegl_node_blit (processor->input, 1.0/(1<<processor->level),
                               dr, format, NULL,
                               GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+              gegl_parallel_set_cancel_token (cancel_token);
+
+              if (g_atomic_int_get (&processor->cancelled))
+                {
+                  /* render the rectangle again next time */
+                  processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, dr);
+
+                  return TRUE;
+                }
 
               /* tells the cache that the rectangle (dr) has been computed */
               gegl_cache_computed (cache, dr, processor->level);
@@ -521,9 +878,21 @@ render_rectangle (GeglProcessor *processor)
         }
       else
         {
+           const gint *cancel_token;
+
+           cancel_token = gegl_parallel_set_cancel_token (&processor->cancelled);
            gegl_node_blit (processor->real_node, 1.0/(1<<processor->level),
                            dr, NULL, NULL,
                            GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+           gegl_parallel_set_cancel_token (cancel_token);
+
+           if (g_atomic_int_get (&processor->cancelled))
+             {
+               processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, dr);
+
+               return TRUE;
+             }
+
            gegl_region_union_with_rect (processor->valid_region, dr);
            g_slice_free (GeglRectangle, dr);
         }
@@ -688,15 +1057,25 @@ gegl_processor_render (GeglProcessor *processor,
       gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
       gegl_region_destroy (region);
 
-      for (i = 0; i < n_rectangles && i < 1; i++)
+      if (n_rectangles > 0)
         {
-          GeglRectangle  roi = rectangles[i];
-          GeglRegion    *tr = gegl_region_rectangle (&roi);
+          GeglRectangle  roi;
+          GeglRegion    *tr;
+
+          i   = gegl_processor_priority_pick (processor,
+                                              rectangles, n_rectangles);
+          roi = rectangles[i];
+          tr  = gegl_region_rectangle (&roi);
           gegl_region_subtract (processor->queued_region, tr);
           gegl_region_destroy (tr);
 
           processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
                                                          g_slice_dup (GeglRectangle, &roi));
+
+          /* re-estimate the chunk area for each new area, with the
+           * processing times measured while rendering the previous ones
+           */
+          processor->chunk_area = 0;
         }
 
       g_free (rectangles);
@@ -723,15 +1102,25 @@ gegl_processor_render (GeglProcessor *processor,
       gegl_region_get_rectangles (processor->queued_region, &rectangles,
                                   &n_rectangles);
 
-      for (i = 0; i < n_rectangles && i < 1; i++)
+      if (n_rectangles > 0)
         {
-          GeglRectangle  roi = rectangles[i];
-          GeglRegion    *tr = gegl_region_rectangle (&roi);
+          GeglRectangle  roi;
+          GeglRegion    *tr;
+
+          i   = gegl_processor_priority_pick (processor,
+                                              rectangles, n_rectangles);
+          roi = rectangles[i];
+          tr  = gegl_region_rectangle (&roi);
           gegl_region_subtract (processor->queued_region, tr);
           gegl_region_destroy (tr);
 
           processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
                                                          g_slice_dup (GeglRectangle, &roi));
+
+          /* re-estimate the chunk area for each new area, with the
+           * processing times measured while rendering the previous ones
+           */
+          processor->chunk_area = 0;
         }
 
       g_free (rectangles);
@@ -760,6 +1149,7 @@ gegl_processor_work (GeglProcessor *processor,
                      gdouble       *progress)
 {
   gboolean   more_work = FALSE;
+  gint64     deadline  = 0;
 
   if (gegl_config()->use_opencl)
     {
@@ -772,18 +1162,72 @@ gegl_processor_work (GeglProcessor *processor,
                                                NULL);
 
           if (gegl_visitor_traverse (visitor, GEGL_VISITABLE (processor->real_node)))
-            processor->chunk_size = GEGL_CL_CHUNK_SIZE;
+            {
+              processor->chunk_size = GEGL_CL_CHUNK_SIZE;
+              processor->chunk_area = 0;
+            }
 
           g_object_unref (visitor);
         }
     }
 
-  more_work = gegl_processor_render (processor, &processor->rectangle, progress);
+  if (processor->time_budget > 0.0)
+    {
+      deadline = g_get_monotonic_time () +
+                 processor->time_budget * G_TIME_SPAN_SECOND;
+    }
+
+  /* with a time budget, keep rendering as long as the next step is expected
+   * to finish before the deadline, judging by the (slowly decaying) duration
+   * of the previous steps
+   */
+  do
+    {
+      gint64 t = g_get_monotonic_time ();
+
+      more_work = gegl_processor_render (processor, &processor->rectangle, progress);
+
+      t = g_get_monotonic_time () - t;
+      processor->step_time = MAX (t, processor->step_time / 2);
+    }
+  while (more_work && deadline &&
+         ! g_atomic_int_get (&processor->cancelled) &&
+         g_get_monotonic_time () + processor->step_time < deadline);
+
+  /* a cancellation only aborts the current call */
+  if (g_atomic_int_get (&processor->cancelled))
+    {
+      g_atomic_int_set (&processor->cancelled, 0);
+
+      return TRUE;
+    }
+
+  if (progress && gegl_processor_has_preview (processor))
+    {
+      if (processor->preview_pending)
+        *progress *= GEGL_PROCESSOR_PREVIEW_PROGRESS;
+      else
+        *progress = GEGL_PROCESSOR_PREVIEW_PROGRESS +
+                    (1.0 - GEGL_PROCESSOR_PREVIEW_PROGRESS) * *progress;
+    }
+
   if (more_work)
     {
       return TRUE;
     }
 
+  if (processor->preview_pending)
+    {
+      /* the preview is done, refine at the target level */
+      processor->preview_pending = FALSE;
+      gegl_processor_update_level (processor);
+
+      if (progress)
+        *progress = GEGL_PROCESSOR_PREVIEW_PROGRESS;
+
+      return TRUE;
+    }
+
   if (progress)
     {
       *progress = 1.0;
@@ -820,8 +1264,8 @@ gegl_node_new_processor (GeglNode            *node,
 void gegl_processor_set_level (GeglProcessor *processor,
                                gint           level)
 {
-  processor->level = level;
-  set_scaled_rectangle (processor);
+  processor->target_level = level;
+  gegl_processor_update_level (processor);
 }
 
 GeglBuffer *gegl_processor_get_buffer (GeglProcessor *processor)
@@ -833,6 +1277,51 @@ GeglBuffer *gegl_processor_get_buffer (GeglProcessor *processor)
 void gegl_processor_set_scale (GeglProcessor *processor,
                                gdouble        scale)
 {
-  processor->level = gegl_level_from_scale (scale);
-  set_scaled_rectangle (processor);
+  processor->target_level = gegl_level_from_scale (scale);
+  gegl_processor_update_level (processor);
+}
+
+void
+gegl_processor_set_priority_rectangle (GeglProcessor       *processor,
+                                       const GeglRectangle *rectangle)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  if (rectangle)
+    {
+      processor->priority_rectangle = *rectangle;
+      processor->has_priority       = TRUE;
+    }
+  else
+    {
+      processor->has_priority       = FALSE;
+    }
+}
+
+void
+gegl_processor_cancel (GeglProcessor *processor)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  g_atomic_int_set (&processor->cancelled, 1);
+}
+
+void
+gegl_processor_set_time_budget (GeglProcessor *processor,
+                                gdouble        seconds)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  processor->time_budget = MAX (seconds, 0.0);
+}
+
+void
+gegl_processor_set_preview_level (GeglProcessor *processor,
+                                  gint           level)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  processor->preview_level   = MAX (level, 0);
+  processor->preview_pending = TRUE;
+  gegl_processor_update_level (processor);
 }
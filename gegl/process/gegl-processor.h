@@ -91,6 +91,59 @@ gboolean       gegl_processor_work          (GeglProcessor *processor,
 
 GeglBuffer *gegl_processor_get_buffer (GeglProcessor *processor);
 
+/**
+ * gegl_processor_set_priority_rectangle:
+ * @processor: a #GeglProcessor
+ * @rectangle: (nullable): the area to render first, or NULL to render in
+ * scanline order.
+ *
+ * Make the processor render the parts of its rectangle nearest to the
+ * center of @rectangle (for example the visible part of a view) first,
+ * proceeding outwards from there.
+ */
+void        gegl_processor_set_priority_rectangle (GeglProcessor       *processor,
+                                                   const GeglRectangle *rectangle);
+
+/**
+ * gegl_processor_cancel:
+ * @processor: a #GeglProcessor
+ *
+ * Abort the work being done by the current, or next, gegl_processor_work()
+ * call as soon as possible, for example because the graph was changed and
+ * the result would be thrown away. Operations check for cancellation
+ * cooperatively, see gegl_parallel_is_cancelled(). The area being rendered
+ * is left dirty, and rendered again by later calls.
+ *
+ * This function may be called from any thread.
+ */
+void        gegl_processor_cancel                 (GeglProcessor       *processor);
+
+/**
+ * gegl_processor_set_time_budget:
+ * @processor: a #GeglProcessor
+ * @seconds: the time to spend in each gegl_processor_work() call, or 0.0
+ * to do a single iteration of work per call.
+ *
+ * Make each call to gegl_processor_work() keep rendering for as long as the
+ * next chunk is expected to finish within @seconds. This trades some
+ * throughput for predictable latency between calls.
+ */
+void        gegl_processor_set_time_budget        (GeglProcessor       *processor,
+                                                   gdouble              seconds);
+
+/**
+ * gegl_processor_set_preview_level:
+ * @processor: a #GeglProcessor
+ * @level: the mipmap level to render a preview at.
+ *
+ * When @level is coarser than the level set with gegl_processor_set_level(),
+ * the whole rectangle is first rendered at @level, and then refined at the
+ * requested level. The preview is started over each time the rectangle is
+ * set. Has no effect when processing sinks that need their full input.
+ */
+void        gegl_processor_set_preview_level      (GeglProcessor       *processor,
+                                                   gint                 level);
+
 
 G_END_DECLS
 
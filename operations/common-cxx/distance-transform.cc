@@ -55,6 +55,15 @@ property_int    (averaging, _("Grayscale Averaging"), 0)
 property_boolean (normalize, _("Normalize"), TRUE)
   description(_("Normalize output to range 0.0 to 1.0."))
 
+property_double (max_distance, _("Maximum distance"), 0.0)
+  description (_("Distances are clamped to this value, and only the part of "
+                 "the input within it is considered, which bounds the work "
+                 "and memory needed; 0 means no limit.  When normalizing, "
+                 "this distance is mapped to 1.0"))
+  value_range (0.0, 1000000.0)
+  ui_range    (0.0, 1024.0)
+  ui_gamma    (1.5)
+
 #else
 
 #define GEGL_OP_FILTER
@@ -65,6 +74,25 @@ property_boolean (normalize, _("Normalize"), TRUE)
 
 #define EPSILON 0.000000000001
 
+/* the number of columns of the first pass, and of rows of the second pass,
+ * each thread processes at once
+ */
+#define DT_STRIP_SIZE 64
+
+typedef struct
+{
+  /* whether the abyss past each edge of the processed region is above the
+   * threshold
+   */
+  gboolean top_above;
+  gboolean bottom_above;
+  gboolean left_above;
+  gboolean right_above;
+
+  gfloat   inf_dist;
+  gfloat   max_distance; /* 0 for none */
+} DTParams;
+
 static gfloat edt_f   (gfloat x, gfloat i, gfloat g_i);
 static gint   edt_sep (gint i, gint u, gfloat g_i, gfloat g_u);
 static gfloat mdt_f   (gfloat x, gfloat i, gfloat g_i);
@@ -96,12 +124,17 @@ static GeglRectangle
 get_cached_region (GeglOperation       *operation,
                    const GeglRectangle *roi)
 {
+  GeglProperties      *o = GEGL_PROPERTIES (operation);
   const GeglRectangle *in_rect =
       gegl_operation_source_get_bounding_box (operation, "input");
 
   if (! in_rect || gegl_rectangle_is_infinite_plane (in_rect))
     return *roi;
 
+  /* with a cut-off, the output only depends on the nearby input */
+  if (o->max_distance > 0.0)
+    return *roi;
+
   return *in_rect;
 }
 
@@ -110,7 +143,20 @@ get_required_for_output (GeglOperation       *operation,
                          const gchar         *input_pad,
                          const GeglRectangle *roi)
 {
-  return get_cached_region (operation, roi);
+  GeglProperties *o      = GEGL_PROPERTIES (operation);
+  GeglRectangle   result = get_cached_region (operation, roi);
+
+  if (o->max_distance > 0.0 && ! gegl_rectangle_is_infinite_plane (&result))
+    {
+      gint d = (gint) ceil (o->max_distance);
+
+      result.x      -= d;
+      result.y      -= d;
+      result.width  += 2 * d;
+      result.height += 2 * d;
+    }
+
+  return result;
 }
 
 /* Meijster helper functions for euclidean distance transform */
@@ -123,7 +169,9 @@ edt_f (gfloat x, gfloat i, gfloat g_i)
 static gint
 edt_sep (gint i, gint u, gfloat g_i, gfloat g_u)
 {
-  return (u * u - i * i + ((gint) (g_u * g_u - g_i * g_i))) / (2 * (u - i));
+  /* computed in 64 bits, since the squares overflow for huge inputs */
+  return ((gint64) u * u - (gint64) i * i +
+          ((gint64) (g_u * g_u - g_i * g_i))) / (2 * (u - i));
 }
 
 /* Meijster helper functions for manhattan distance transform */
@@ -164,23 +212,108 @@ cdt_sep (gint i, gint u, gfloat g_i, gfloat g_u)
 /* Second pass finds distance for each row by determining contiguous segments with one "minimizer" pixel each,
  * using the vertical distance information from the first pass as an input.
  * For each pixel in a segment, the minimizer gives the least distance out of any other pixel in the row when
- * using its distance from the pixel as width and the minimizer's value (from 1st pass) as height. */
+ * using its distance from the pixel as width and the minimizer's value (from 1st pass) as height.
+ * The row is processed in place; g, s and t are scratch arrays of width + 2, width + 1 and width + 1 elements. */
 static void
-binary_dt_2nd_pass (GeglOperation      *operation,
-                    gint                width,
-                    gint                height,
-                    gfloat              thres_lo,
-                    GeglDistanceMetric  metric,
-                    gfloat             *src,
-                    gfloat             *dest)
+binary_dt_row (gfloat          *dest_row,
+               gint             width,
+               gfloat         (*dt_f)   (gfloat, gfloat, gfloat),
+               gint           (*dt_sep) (gint, gint, gfloat, gfloat),
+               const DTParams  *params,
+               gfloat          *g,
+               gint            *s,
+               gint            *t)
 {
+  gint q;  /* Index of the foremost segment in t and s */
+  gint w;  /* Used to set the boundary of newly defined segments */
+  gint u;  /* Used for x-coordinate, named from paper */
+
+  /* sorry for the variable naming, they are taken from the paper */
+
+  /* Copy over dest_row to g, and line with a zero or inf_dist on either side.
+   * Mind the offset and difference in width when working between g and the dest row */
+  memcpy (&g[1], dest_row, width * sizeof (gfloat));
+  g[0]         = params->left_above  ? params->inf_dist : 0.0f;
+  g[width + 1] = params->right_above ? params->inf_dist : 0.0f;
+
+  q = 0;
+  s[0] = 0;
+  t[0] = 0;
+
+  /* Determine regions and their minimizers, scanning pixels left to right */
+  for (u = 1; u < width + 2; u++)
+    {
+      /* If the scanned pixel produces a distance less than or equal to the current
+       * minimizer, clear out the current segment and any others similarly affected */
+      while (q >= 0 &&
+             dt_f (t[q], s[q], g[s[q]]) >= dt_f (t[q], u, g[u]) + EPSILON)
+        {
+          q --;
+        }
+
+      /* Define new segment, with the currently scanned pixel as a minimizer */
+      if (q < 0)
+        {
+          q = 0;
+          s[0] = u;
+        }
+      else
+        {
+          /* function Sep from paper */
+          w = dt_sep (s[q], u, g[s[q]], g[u]);
+          w += 1;
+
+          if (w < width + 1)
+            {
+              q ++;
+              s[q] = u;
+              t[q] = w;
+            }
+        }
+    }
+
+  /* Calculate final distances within each region from its respective minimizer */
+  for (u = width; u >= 1; u--)
+    {
+      if (u == s[q])
+        dest_row[u - 1] = g[u];
+      else
+        dest_row[u - 1] = dt_f (u, s[q], g[s[q]]);
+
+      if (q > 0 && u == t[q])
+        {
+          q--;
+        }
+    }
+
+  if (params->max_distance > 0.0f)
+    {
+      for (u = 0; u < width; u++)
+        dest_row[u] = MIN (dest_row[u], params->max_distance);
+    }
+}
+
+/* Runs the second pass over the rows of @rect, reading the first pass's
+ * output from @vbuf, which spans the width of @region, and writing (or,
+ * if @accumulate is set, adding) the distances of @rect to @output.  Each
+ * thread processes strips of DT_STRIP_SIZE rows, so that only a strip of
+ * each buffer is held in memory at once.
+ */
+static void
+binary_dt_2nd_pass (GeglOperation       *operation,
+                    GeglBuffer          *vbuf,
+                    GeglBuffer          *output,
+                    const GeglRectangle *region,
+                    const GeglRectangle *rect,
+                    GeglDistanceMetric   metric,
+                    const DTParams      *params,
+                    gboolean             accumulate)
+{
+  const Babl *format   = gegl_operation_get_format (operation, "output");
+  const gint  width    = region->width;
+  const gint  n_strips = (rect->height + DT_STRIP_SIZE - 1) / DT_STRIP_SIZE;
   gfloat (*dt_f)   (gfloat, gfloat, gfloat);
   gint   (*dt_sep) (gint, gint, gfloat, gfloat);
-  GeglProperties *o = GEGL_PROPERTIES (operation);
-  gfloat inf_dist;
-
-  /* An impossibly large value for infinite distance, set to width + height as suggested from paper */
-  inf_dist = width + height;
 
   switch (metric)
     {
@@ -203,84 +336,80 @@ binary_dt_2nd_pass (GeglOperation      *operation,
    * needing to read data updated by other threads).
    */
   gegl_parallel_distribute_range (
-    height, gegl_operation_get_pixels_per_thread (operation) / width,
-    [&] (gint y0, gint size)
+    n_strips,
+    gegl_operation_get_pixels_per_thread (operation) /
+    ((gdouble) width * DT_STRIP_SIZE),
+    [&] (gint strip0, gint size)
     {
-      gfloat *dest_row; /* Current destination row, where final distance is output */
       gfloat *g; /* Current row of 1st pass's output, with an added abyss value on either side */
-      gint q;  /* Index of the foremost segment in t and s */
-      gint w;  /* Used to set the boundary of newly defined segments */
-      gint *t; /* Locations for each segment's lower boundary */
-      gint *s; /* Locations for each segment's minimizer */
-      gint u;  /* Used for x-coordinate, named from paper */
-      gint y;
-
-      /* sorry for the variable naming, they are taken from the paper */
-
-      s = (gint *) gegl_calloc (sizeof (gint), width + 1);
-      t = (gint *) gegl_calloc (sizeof (gint), width + 1);
-      g = (gfloat *) gegl_calloc (sizeof (gfloat), width + 2);
-
-      for (y = y0; y < y0 + size; y++)
+      gint   *t; /* Locations for each segment's lower boundary */
+      gint   *s; /* Locations for each segment's minimizer */
+      gfloat *rows;
+      gfloat *out = NULL;
+      gint    strip;
+
+      s    = (gint *) gegl_calloc (sizeof (gint), width + 1);
+      t    = (gint *) gegl_calloc (sizeof (gint), width + 1);
+      g    = (gfloat *) gegl_calloc (sizeof (gfloat), width + 2);
+      rows = (gfloat *) gegl_malloc (sizeof (gfloat) * width * DT_STRIP_SIZE);
+
+      if (accumulate)
+        out = (gfloat *) gegl_malloc (sizeof (gfloat) * rect->width *
+                                      DT_STRIP_SIZE);
+
+      for (strip = strip0; strip < strip0 + size; strip++)
         {
-          dest_row = &dest[0 + y * width];
+          GeglRectangle strip_rect;
+          GeglRectangle out_rect;
+          gint          x0 = rect->x - region->x;
+          gint          y;
+
+          gegl_rectangle_set (&strip_rect,
+                              region->x, rect->y + strip * DT_STRIP_SIZE,
+                              width,
+                              MIN (DT_STRIP_SIZE,
+                                   rect->height - strip * DT_STRIP_SIZE));
+          gegl_rectangle_set (&out_rect,
+                              rect->x, strip_rect.y,
+                              rect->width, strip_rect.height);
+
+          gegl_buffer_get (vbuf, &strip_rect, 1.0, format, rows,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          if (accumulate)
+            {
+              gegl_buffer_get (output, &out_rect, 1.0, format, out,
+                               GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+            }
 
-          /* Copy over dest_row to g, and line with a zero or inf_dist on either side.
-           * Mind the offset and difference in width when working between g and the dest row */
-          memcpy (&g[1], dest_row, width * sizeof (gfloat));
-          g[0] = g[width + 1] = (o->edge_handling == GEGL_DT_ABYSS_ABOVE) ? inf_dist : 0.0f;
+          for (y = 0; y < strip_rect.height; y++)
+            {
+              gfloat *dest_row = rows + (gsize) y * width;
+              gint    x;
 
-          q = 0;
-          s[0] = 0;
-          t[0] = 0;
+              binary_dt_row (dest_row, width, dt_f, dt_sep, params, g, s, t);
 
-          /* Determine regions and their minimizers, scanning pixels left to right */
-          for (u = 1; u < width + 2; u++)
-            {
-              /* If the scanned pixel produces a distance less than or equal to the current
-               * minimizer, clear out the current segment and any others similarly affected */
-              while (q >= 0 &&
-                     dt_f (t[q], s[q], g[s[q]]) >= dt_f (t[q], u, g[u]) + EPSILON)
+              /* Pack the rows of rect together */
+              if (accumulate)
                 {
-                  q --;
-                }
+                  gfloat *out_row = out + (gsize) y * rect->width;
 
-              /* Define new segment, with the currently scanned pixel as a minimizer */
-              if (q < 0)
-                {
-                  q = 0;
-                  s[0] = u;
+                  for (x = 0; x < rect->width; x++)
+                    out_row[x] += dest_row[x0 + x];
                 }
               else
                 {
-                  /* function Sep from paper */
-                  w = dt_sep (s[q], u, g[s[q]], g[u]);
-                  w += 1;
-
-                  if (w < width + 1)
-                    {
-                      q ++;
-                      s[q] = u;
-                      t[q] = w;
-                    }
+                  memmove (rows + (gsize) y * rect->width, dest_row + x0,
+                           rect->width * sizeof (gfloat));
                 }
             }
 
-          /* Calculate final distances within each region from its respective minimizer */
-          for (u = width; u >= 1; u--)
-            {
-              if (u == s[q])
-                dest_row[u - 1] = g[u];
-              else
-                dest_row[u - 1] = dt_f (u, s[q], g[s[q]]);
-
-              if (q > 0 && u == t[q])
-                {
-                  q--;
-                }
-            }
+          gegl_buffer_set (output, &out_rect, 0, format,
+                           accumulate ? out : rows, GEGL_AUTO_ROWSTRIDE);
         }
 
+      gegl_free (out);
+      gegl_free (rows);
       gegl_free (t);
       gegl_free (s);
       gegl_free (g);
@@ -288,69 +417,116 @@ binary_dt_2nd_pass (GeglOperation      *operation,
 }
 
 
-/* First pass calculates vertical distance with a simple pass down and up each column */
+/* First pass calculates vertical distance with a simple pass down and up each column.
+ * The column is processed in place, with consecutive pixels stride floats apart. */
 static void
-binary_dt_1st_pass (GeglOperation *operation,
-                    gint           width,
-                    gint           height,
-                    gfloat         thres_lo,
-                    gfloat        *src,
-                    gfloat        *dest)
+binary_dt_column (gfloat         *dest,
+                  gint            stride,
+                  gint            height,
+                  gfloat          thres_lo,
+                  const DTParams *params)
 {
-  GeglProperties *o = GEGL_PROPERTIES (operation);
-  gfloat inf_dist, edge_mult;
+  const gfloat inf_dist  = params->inf_dist;
+  const gfloat edge_mult = params->top_above ? inf_dist : 1.0f;
+  gint         y         = 1;
+
+  /* Set an initial distance for the top pixel, accounting for abyss */
+  dest[0] = dest[0] > thres_lo ? 1.0f * edge_mult : 0.0f;
+
+  /* For columns starting with inf_dist, don't increment distance until first region transition */
+  if (dest[0] > 1.0f)
+    while (y < height && dest[y * stride] > thres_lo)
+      {
+        dest[y * stride] = inf_dist;
+        y++;
+      }
+  if (y == height && params->bottom_above)
+    return;
+
+  /* Scan downwards from the top, or where the previous loop left off */
+  for (; y < height; y++)
+    {
+      if (dest[y * stride] > thres_lo)
+        dest[y * stride] = 1.0 + dest[(y - 1) * stride];
+      else
+        dest[y * stride] = 0.0;
+    }
 
-  /* An impossibly large value for infinite distance, set to width + height as suggested from paper */
-  inf_dist = width + height;
-  edge_mult = (o->edge_handling == GEGL_DT_ABYSS_ABOVE) ? inf_dist : 1.0f;
+  /* If abyss is below threshold, limit the bottom pixel's distance before we scan back up */
+  if (! params->bottom_above)
+    dest[(height - 1) * stride] = MIN (dest[(height - 1) * stride], 1.0f);
+
+  for (y = height - 2; y >= 0; y--)
+    {
+      if (dest[(y + 1) * stride] + 1.0f < dest[y * stride])
+        dest[y * stride] = dest[(y + 1) * stride] + 1.0f;
+    }
+}
+
+/* Runs the first pass over the columns of @region of @input, and writes the
+ * vertical distances of the rows of @rect to @vbuf.  Each thread processes
+ * strips of DT_STRIP_SIZE columns, so that only a strip of the input is
+ * held in memory at once.
+ */
+static void
+binary_dt_1st_pass (GeglOperation       *operation,
+                    GeglBuffer          *input,
+                    GeglBuffer          *vbuf,
+                    const GeglRectangle *region,
+                    const GeglRectangle *rect,
+                    gfloat               thres_lo,
+                    const DTParams      *params)
+{
+  const Babl *format   = gegl_operation_get_format (operation, "output");
+  const gint  height   = region->height;
+  const gint  n_strips = (region->width + DT_STRIP_SIZE - 1) / DT_STRIP_SIZE;
 
   /* Parallelize the loop. We don't even need a mutex as we edit data per
    * columns (i.e. each thread will work on a given range of columns without
    * needing to read data updated by other threads).
    */
   gegl_parallel_distribute_range (
-    width, gegl_operation_get_pixels_per_thread (operation) / height,
-    [&] (gint x0, gint size)
+    n_strips,
+    gegl_operation_get_pixels_per_thread (operation) /
+    ((gdouble) height * DT_STRIP_SIZE),
+    [&] (gint strip0, gint size)
     {
-      gint x;
-      gint y;
+      gfloat *cols;
+      gint    strip;
 
-      for (x = x0; x < x0 + size; x++)
+      cols = (gfloat *) gegl_malloc (sizeof (gfloat) * height * DT_STRIP_SIZE);
+
+      for (strip = strip0; strip < strip0 + size; strip++)
         {
-          y = 1;
-
-          /* Set an initial distance for the top pixel, accounting for abyss */
-          dest[x + 0 * width] = src[x + 0 * width] > thres_lo ? 1.0f * edge_mult : 0.0f;
-
-          /* For columns starting with inf_dist, don't increment distance until first region transition */
-          if (dest[x + 0 * width] > 1.0f)
-            while (y < height && src[x + y * width] > thres_lo)
-              {
-                dest[x + y * width] = inf_dist;
-                y++;
-              }
-          if (y == height)
-            continue;
-
-          /* Scan downwards from the top, or where the previous loop left off */
-          for (; y < height; y++)
+          GeglRectangle strip_rect;
+          GeglRectangle out_rect;
+          gint          x;
+
+          gegl_rectangle_set (&strip_rect,
+                              region->x + strip * DT_STRIP_SIZE, region->y,
+                              MIN (DT_STRIP_SIZE,
+                                   region->width - strip * DT_STRIP_SIZE),
+                              height);
+          gegl_rectangle_set (&out_rect,
+                              strip_rect.x, rect->y,
+                              strip_rect.width, rect->height);
+
+          gegl_buffer_get (input, &strip_rect, 1.0, format, cols,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          for (x = 0; x < strip_rect.width; x++)
             {
-              if (src[x + y * width] > thres_lo)
-                dest[x + y * width] = 1.0 + dest[x + (y - 1) * width];
-              else
-                dest[x + y * width] = 0.0;
+              binary_dt_column (cols + x, strip_rect.width, height,
+                                thres_lo, params);
             }
 
-          /* If abyss is below threshold, limit the bottom pixel's distance before we scan back up */
-          if (o->edge_handling == GEGL_DT_ABYSS_BELOW)
-            dest[x + (height - 1) * width] = MIN (dest[x + (height - 1) * width], 1.0f);
-
-          for (y = height - 2; y >= 0; y--)
-            {
-              if (dest[x + (y + 1) * width] + 1.0f < dest[x + y * width])
-                dest [x + y * width] = dest[x + (y + 1) * width] + 1.0f;
-            }
+          gegl_buffer_set (vbuf, &out_rect, 0, format,
+                           cols + (gsize) (rect->y - region->y) *
+                                  strip_rect.width,
+                           GEGL_AUTO_ROWSTRIDE);
         }
+
+      gegl_free (cols);
     });
 }
 
@@ -372,15 +548,19 @@ process (GeglOperation       *operation,
 {
   GeglProperties         *o = GEGL_PROPERTIES (operation);
   const Babl  *input_format = gegl_operation_get_format (operation, "output");
-  const int bytes_per_pixel = babl_format_get_bytes_per_pixel (input_format);
+  const GeglRectangle *in_rect =
+    gegl_operation_source_get_bounding_box (operation, "input");
 
   GeglDistanceMetric metric;
-  gint               width, height, averaging, i;
-  gfloat             threshold_lo, threshold_hi, maxval, *src_buf, *dst_buf;
+  GeglRectangle      region;
+  GeglRectangle      rect;
+  GeglRectangle      vrect;
+  GeglBuffer        *vbuf;
+  DTParams           params;
+  gint               averaging, n_passes, i;
+  gfloat             threshold_lo, threshold_hi, maxval;
   gboolean           normalize;
-
-  width  = result->width;
-  height = result->height;
+  gboolean           above;
 
   threshold_lo = o->threshold_lo;
   threshold_hi = o->threshold_hi;
@@ -388,57 +568,93 @@ process (GeglOperation       *operation,
   metric       = o->metric;
   averaging    = o->averaging;
 
-  src_buf = (gfloat *) gegl_malloc (width * height * bytes_per_pixel);
-  dst_buf = (gfloat *) gegl_calloc (width * height, bytes_per_pixel);
+  /* The region of the input we process: with a cut-off, only the input
+   * within the cut-off distance of the result matters
+   */
+  region = *result;
+
+  if (o->max_distance > 0.0 && in_rect)
+    {
+      gint d = (gint) ceil (o->max_distance);
+
+      gegl_rectangle_set (&region,
+                          result->x - d,          result->y - d,
+                          result->width + 2 * d,  result->height + 2 * d);
+      gegl_rectangle_intersect (&region, &region, in_rect);
+    }
+
+  /* The part of the result inside the region */
+  if (! gegl_rectangle_intersect (&rect, result, &region))
+    return TRUE;
+
+  /* Edges of the region inside the input are farther than the cut-off
+   * distance from the result, so treat the abyss past them as above the
+   * threshold
+   */
+  above = o->edge_handling == GEGL_DT_ABYSS_ABOVE;
+
+  params.top_above    = above || (in_rect && region.y > in_rect->y);
+  params.bottom_above = above || (in_rect && region.y + region.height <
+                                             in_rect->y + in_rect->height);
+  params.left_above   = above || (in_rect && region.x > in_rect->x);
+  params.right_above  = above || (in_rect && region.x + region.width <
+                                             in_rect->x + in_rect->width);
+
+  /* An impossibly large value for infinite distance, set to width + height as suggested from paper */
+  params.inf_dist     = region.width + region.height;
+  params.max_distance = o->max_distance;
+
+  /* Any value past the cut-off is as good as infinite */
+  if (o->max_distance > 0.0)
+    params.inf_dist = MIN (params.inf_dist, ceil (o->max_distance) + 1.0);
+
+  /* The first pass's output, for the full width of the region */
+  gegl_rectangle_set (&vrect,
+                      region.x, rect.y, region.width, rect.height);
+
+  vbuf = gegl_buffer_new (&vrect, input_format);
 
   gegl_operation_progress (operation, 0.0, (gchar *) "");
 
-  gegl_buffer_get (input, result, 1.0, input_format, src_buf,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  n_passes = MAX (averaging, 1);
 
-  if (!averaging)
+  for (i = 0; i < n_passes; i++)
     {
-      binary_dt_1st_pass (operation, width, height, threshold_lo,
-                          src_buf, dst_buf);
-      gegl_operation_progress (operation, 0.5, (gchar *) "");
-      binary_dt_2nd_pass (operation, width, height, threshold_lo, metric,
-                          src_buf, dst_buf);
-    }
-  else
-    {
-      gfloat *tmp_buf;
-      gint i, j;
-
-      tmp_buf = (gfloat *) gegl_malloc (width * height * bytes_per_pixel);
+      gfloat thres = threshold_lo;
 
-      for (i = 0; i < averaging; i++)
+      if (averaging)
         {
-          gfloat thres;
-
           thres = (i+1) * (threshold_hi - threshold_lo) / (averaging + 1);
           thres += threshold_lo;
-
-          binary_dt_1st_pass (operation, width, height, thres,
-                              src_buf, tmp_buf);
-          gegl_operation_progress (operation, (i + 1) / averaging - 1 / (2 * averaging),
-                                   (gchar *) "");
-          binary_dt_2nd_pass (operation, width, height, thres, metric,
-                              src_buf, tmp_buf);
-          gegl_operation_progress (operation, (i + 1) / averaging, (gchar *) "");
-
-          for (j = 0; j < width * height; j++)
-            dst_buf[j] += tmp_buf[j];
         }
 
-      gegl_free (tmp_buf);
+      binary_dt_1st_pass (operation, input, vbuf, &region, &rect, thres,
+                          &params);
+      gegl_operation_progress (operation, (2.0 * i + 1.0) / (2.0 * n_passes),
+                               (gchar *) "");
+      binary_dt_2nd_pass (operation, vbuf, output, &region, &rect, metric,
+                          &params, i > 0);
+      gegl_operation_progress (operation, (i + 1.0) / n_passes,
+                               (gchar *) "");
     }
 
+  g_object_unref (vbuf);
+
   if (normalize)
     {
-      maxval = EPSILON;
+      if (o->max_distance > 0.0)
+        {
+          maxval = o->max_distance * n_passes;
+        }
+      else
+        {
+          gdouble max;
 
-      for (i = 0; i < width * height; i++)
-        maxval = MAX (dst_buf[i], maxval);
+          gegl_parallel_get_buffer_statistics (output, &rect, 0, input_format,
+                                               NULL, &max, NULL, NULL);
+
+          maxval = MAX (max, EPSILON);
+        }
     }
   else
     {
@@ -447,17 +663,28 @@ process (GeglOperation       *operation,
 
   if (averaging > 0 || normalize)
     {
-      for (i = 0; i < width * height; i++)
-        dst_buf[i] = dst_buf[i] * threshold_hi / maxval;
-    }
+      gegl_parallel_distribute_area (
+        &rect, gegl_operation_get_pixels_per_thread (operation),
+        [&] (const GeglRectangle *area)
+        {
+          GeglBufferIterator *iter;
 
-  gegl_buffer_set (output, result, 0, input_format, dst_buf,
-                   GEGL_AUTO_ROWSTRIDE);
+          iter = gegl_buffer_iterator_new (output, area, 0, input_format,
+                                           GEGL_ACCESS_READWRITE,
+                                           GEGL_ABYSS_NONE, 1);
 
-  gegl_operation_progress (operation, 1.0, (gchar *) "");
+          while (gegl_buffer_iterator_next (iter))
+            {
+              gfloat *data = (gfloat *) iter->items[0].data;
+              gint    j;
 
-  gegl_free (dst_buf);
-  gegl_free (src_buf);
+              for (j = 0; j < iter->length; j++)
+                data[j] = data[j] * threshold_hi / maxval;
+            }
+        });
+    }
+
+  gegl_operation_progress (operation, 1.0, (gchar *) "");
 
   return TRUE;
 }
@@ -49,6 +49,14 @@ property_boolean (clip, _("Clip to input extents"), TRUE)
 property_boolean (linear_mask, _("Linear mask"), FALSE)
   description (_("Use linear mask values"))
 
+property_double (max_error, _("Maximal error"), 0.0)
+  description (_("Maximal error, relative to the range of the input, "
+                 "allowed for blurring a decimated copy of the input, which "
+                 "is faster for large blurs; 0.0 always blurs the input "
+                 "itself"))
+  value_range (0.0, 0.1)
+  ui_range    (0.0, 0.05)
+
 #else
 
 #define GEGL_OP_COMPOSER
@@ -56,6 +64,7 @@ property_boolean (linear_mask, _("Linear mask"), FALSE)
 #define GEGL_OP_C_SOURCE lens-blur.cc
 
 #include "gegl-op.h"
+#include "../common/pyramid-common.h"
 
 static void
 prepare (GeglOperation *operation)
@@ -81,6 +90,27 @@ prepare (GeglOperation *operation)
                                                                space));
 }
 
+/* the mipmap level of the input to blur instead of the input itself.
+ * blurring level n, and interpolating the result, changes it by at most
+ * about (1 << n) / radius, relative to the range of the input, as long as
+ * no highlights are enhanced.
+ */
+static gint
+get_decimation_level (GeglProperties *o)
+{
+  gint level = 0;
+
+  if (o->max_error > 0.0)
+    {
+      gint factor = pyramid_get_factor (MIN (o->max_error, 0.5) * o->radius);
+
+      while ((1 << level) < factor)
+        level++;
+    }
+
+  return level;
+}
+
 static GeglRectangle
 get_bounding_box (GeglOperation *operation)
 {
@@ -116,6 +146,13 @@ get_required_for_output (GeglOperation       *operation,
   GeglProperties *o       = GEGL_PROPERTIES (operation);
   GeglRectangle   result  = *roi;
   gint            iradius = floor (o->radius + 0.5);
+  gint            level   = get_decimation_level (o);
+
+  /* the decimated pixels around the roi, and their rounding, reach a few
+   * decimated pixels further
+   */
+  if (level)
+    iradius += 3 << level;
 
   result.x      -= iradius;
   result.y      -= iradius;
@@ -147,13 +184,42 @@ operation_process (GeglOperation        *operation,
     operation, context, output_prop, roi, level);
 }
 
-static gboolean
-process (GeglOperation       *operation,
-         GeglBuffer          *input,
-         GeglBuffer          *aux,
-         GeglBuffer          *output,
-         const GeglRectangle *roi,
-         gint                 level)
+/* the input bounding box at mipmap @level, excluding the pixels which are
+ * only partially covered by it
+ */
+static GeglRectangle
+get_source_rect (GeglOperation *operation,
+                 gint           level)
+{
+  const GeglRectangle *in_rect;
+  GeglRectangle        result  = {};
+  gint                 factor  = 1 << level;
+
+  in_rect = gegl_operation_source_get_bounding_box (operation, "input");
+
+  if (in_rect)
+    {
+      result.x      = -pyramid_div_floor (-in_rect->x, factor);
+      result.y      = -pyramid_div_floor (-in_rect->y, factor);
+      result.width  = pyramid_div_floor (in_rect->x + in_rect->width,
+                                         factor) - result.x;
+      result.height = pyramid_div_floor (in_rect->y + in_rect->height,
+                                         factor) - result.y;
+    }
+
+  return result;
+}
+
+/* blurs @roi, in the coordinates of mipmap @level of @input and @aux, into
+ * level 0 of @output
+ */
+static void
+lens_blur (GeglOperation       *operation,
+           GeglBuffer          *input,
+           GeglBuffer          *aux,
+           GeglBuffer          *output,
+           const GeglRectangle *roi,
+           gint                 level)
 {
   GeglProperties *o           = GEGL_PROPERTIES (operation);
   const Babl     *format      = gegl_operation_get_format (operation, "input");
@@ -169,7 +235,7 @@ process (GeglOperation       *operation,
   gfloat          highlight_threshold_high;
   gfloat          highlight_factor;
   gfloat          highlight_max;
-  gfloat          radius      = o->radius;
+  gfloat          radius      = o->radius / (1 << level);
   gint            iradius     = floorf (radius + 0.5f);
   gint            size        = 2 * iradius + 1;
   gint            y;
@@ -186,10 +252,9 @@ process (GeglOperation       *operation,
 
   if (o->clip)
     {
-      gegl_rectangle_intersect (
-        &rect,
-        &rect,
-        gegl_operation_source_get_bounding_box (operation, "input"));
+      GeglRectangle source_rect = get_source_rect (operation, level);
+
+      gegl_rectangle_intersect (&rect, &rect, &source_rect);
     }
 
   size = MIN (size, rect.height);
@@ -237,7 +302,7 @@ process (GeglOperation       *operation,
 
     gegl_buffer_get (input,
                      GEGL_RECTANGLE (rect.x, y, rect.width, height),
-                     1.0,
+                     1.0 / (1 << level),
                      format,
                      row,
                      GEGL_AUTO_ROWSTRIDE,
@@ -249,7 +314,7 @@ process (GeglOperation       *operation,
 
         gegl_buffer_get (aux,
                          GEGL_RECTANGLE (rect.x, y, rect.width, height),
-                         1.0,
+                         1.0 / (1 << level),
                          aux_format,
                          row_m,
                          GEGL_AUTO_ROWSTRIDE,
@@ -478,6 +543,70 @@ process (GeglOperation       *operation,
   gegl_free (out);
   gegl_free (in_w);
   gegl_free (in);
+}
+
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *aux,
+         GeglBuffer          *output,
+         const GeglRectangle *roi,
+         gint                 level)
+{
+  GeglProperties *o            = GEGL_PROPERTIES (operation);
+  const Babl     *format       = gegl_operation_get_format (operation, "input");
+  const Babl     *interp_format;
+  GeglBuffer     *blurred;
+  GeglRectangle   d_rect;
+  gfloat         *src;
+  gfloat         *dst;
+  gint            d_level      = get_decimation_level (o);
+  gint            factor       = 1 << d_level;
+
+  if (d_level && o->clip)
+    {
+      GeglRectangle source_rect = get_source_rect (operation, d_level);
+
+      /* don't decimate inputs smaller than a decimated pixel */
+      if (gegl_rectangle_is_empty (&source_rect))
+        d_level = 0;
+    }
+
+  if (! d_level)
+    {
+      lens_blur (operation, input, aux, output, roi, 0);
+
+      return TRUE;
+    }
+
+  pyramid_get_source_range (roi->x, roi->width, factor,
+                            &d_rect.x, &d_rect.width);
+  pyramid_get_source_range (roi->y, roi->height, factor,
+                            &d_rect.y, &d_rect.height);
+
+  blurred = gegl_buffer_new (&d_rect, format);
+
+  lens_blur (operation, input, aux, blurred, &d_rect, d_level);
+
+  /* interpolate premultiplied pixels */
+  interp_format = babl_format_with_space ("RaGaBaA float",
+                                          babl_format_get_space (format));
+
+  src = (gfloat *) gegl_malloc (4 * sizeof (gfloat) *
+                                d_rect.width * d_rect.height);
+  dst = (gfloat *) gegl_malloc (4 * sizeof (gfloat) *
+                                roi->width * roi->height);
+
+  gegl_buffer_get (blurred, &d_rect, 1.0, interp_format, src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  pyramid_interpolate (src, &d_rect, dst, roi, factor, 4);
+
+  gegl_buffer_set (output, roi, 0, interp_format, dst, GEGL_AUTO_ROWSTRIDE);
+
+  gegl_free (dst);
+  gegl_free (src);
+  g_object_unref (blurred);
 
   return TRUE;
 }
@@ -0,0 +1,478 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright 2012 Victor Oliveira <victormatheus@gmail.com>
+ */
+
+ /* This is an implementation of a fast approximated bilateral filter
+  * algorithm descripted in:
+  *
+  *  A Fast Approximation of the Bilateral Filter using a Signal Processing Approach
+  *  Sylvain Paris and Frédo Durand
+  *  European Conference on Computer Vision (ECCV'06)
+  *
+  * Each channel is splatted into a bilateral grid, whose cells are s_sigma
+  * pixels wide and r_sigma values deep, the grid is blurred, and the output
+  * is sliced out of it with trilinear interpolation.  The cost per pixel
+  * doesn't depend on the radius.
+  *
+  * The output is processed in blocks, in parallel, each block using its own
+  * grid.  The cells of the grid are aligned to absolute coordinates, so
+  * that the result doesn't depend on how the output is split.
+  */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+
+#ifdef GEGL_PROPERTIES
+
+property_double (r_sigma, _("Smoothness"), 50)
+    description(_("Level of smoothness"))
+    value_range (1, 100)
+
+property_int (s_sigma, _("Blur radius"), 8)
+   description(_("Radius of square pixel region, (width and height will be radius*2+1)."))
+   value_range (1, 1000)
+   ui_range    (1, 100)
+
+#else
+
+#define GEGL_OP_AREA_FILTER
+#define GEGL_OP_NAME     bilateral_filter_fast
+#define GEGL_OP_C_SOURCE bilateral-filter-fast.c
+
+#include "gegl-op.h"
+
+#define CHANNELS    4
+
+/* the number of floats in a cell of the grid, a sum and a weight for each
+ * channel
+ */
+#define CELL        (2 * CHANNELS)
+
+/* the number of empty cells around the range axis of the grid */
+#define PADDING_Z   1
+
+/* the maximal size of a block of output pixels, in grid cells, and the
+ * number of blocks to aim for, to keep the threads busy
+ */
+#define BLOCK_CELLS 32
+#define MIN_BLOCKS  16
+
+/* the number of rows of pixels read at once */
+#define STRIP_ROWS  64
+
+typedef struct
+{
+  GeglBuffer          *input;
+  GeglBuffer          *output;
+  const Babl          *format;
+  GeglRectangle        result;
+  GeglRectangle        bounds;
+  gint                 level;
+  gint                 block_size;
+  gint                 n_blocks_x;
+  gint                 s_sigma;
+  gfloat               r_sigma;
+} BilateralData;
+
+inline static float lerp(float a, float b, float v)
+{
+  return a + v * (b - a);
+}
+
+static inline gint
+div_floor (gint a,
+           gint b)
+{
+  /* we assume b is positive */
+  if (a < 0) a -= b - 1;
+  return a / b;
+}
+
+/* the number of pixels around each output pixel contributing to it, the
+ * splatting, blurring and slicing each reach over part of a cell
+ */
+static inline gint
+bilateral_get_halo (gint s_sigma)
+{
+  return 3 * s_sigma;
+}
+
+static void
+bilateral_rect_to_level (const GeglRectangle *rect,
+                         gint                 level,
+                         GeglRectangle       *level_rect)
+{
+  level_rect->x      = rect->x >> level;
+  level_rect->y      = rect->y >> level;
+  level_rect->width  = ((rect->x + rect->width)  >> level) - level_rect->x;
+  level_rect->height = ((rect->y + rect->height) >> level) - level_rect->y;
+}
+
+static void
+bilateral_prepare (GeglOperation *operation)
+{
+  const Babl              *space  = gegl_operation_get_source_space (operation, "input");
+  const Babl              *format = babl_format_with_space ("RGBA float", space);
+  GeglOperationAreaFilter *area   = GEGL_OPERATION_AREA_FILTER (operation);
+  GeglProperties          *o      = GEGL_PROPERTIES (operation);
+
+  area->left   =
+  area->right  =
+  area->top    =
+  area->bottom = bilateral_get_halo (o->s_sigma);
+
+  gegl_operation_set_format (operation, "input",  format);
+  gegl_operation_set_format (operation, "output", format);
+}
+
+/* blurs @n cells along an axis of the grid with a [1 2 1] / 4 kernel,
+ * treating the cells outside the grid as empty.  the cells are @stride
+ * floats apart, and @run contiguous floats are blurred at once, for each of
+ * @n_outer lines @outer_stride floats apart.
+ */
+static void
+bilateral_blur_axis (gfloat *grid,
+                     gint    n,
+                     gsize   stride,
+                     gsize   run,
+                     gint    n_outer,
+                     gsize   outer_stride,
+                     gfloat *prev)
+{
+  gint o;
+
+  for (o = 0; o < n_outer; o++)
+    {
+      gfloat *line = grid + o * outer_stride;
+      gint    i;
+
+      memset (prev, 0, run * sizeof (gfloat));
+
+      for (i = 0; i < n; i++)
+        {
+          gfloat *restrict cur = line + i * stride;
+          gfloat *restrict p   = prev;
+          gsize            j;
+
+          if (i + 1 < n)
+            {
+              const gfloat *restrict next = cur + stride;
+
+              for (j = 0; j < run; j++)
+                {
+                  const gfloat t = cur[j];
+
+                  cur[j] = (p[j] + 2.0f * t + next[j]) * 0.25f;
+                  p[j]   = t;
+                }
+            }
+          else
+            {
+              for (j = 0; j < run; j++)
+                {
+                  const gfloat t = cur[j];
+
+                  cur[j] = (p[j] + 2.0f * t) * 0.25f;
+                  p[j]   = t;
+                }
+            }
+        }
+    }
+}
+
+static void
+bilateral_block (const BilateralData *data,
+                 gint                 block)
+{
+  const gint     s_sigma = data->s_sigma;
+  const gfloat   r_sigma = data->r_sigma;
+  const gint     halo    = bilateral_get_halo (s_sigma);
+  const gint     depth   = (gint) (1.0f / r_sigma) + 1 + 2 * PADDING_Z;
+  GeglRectangle  out_rect;
+  GeglRectangle  in_rect;
+  GeglRectangle  splat_rect;
+  GeglRectangle  strip;
+  gint           gx0, gy0, sw, sh;
+  gsize          row_stride, plane;
+  gfloat        *buf;
+  gfloat        *grid;
+  gfloat        *prev;
+  gint          *x1;
+  gfloat        *xa;
+  gint           c, x, y;
+
+  out_rect.x      = data->result.x +
+                    (block % data->n_blocks_x) * data->block_size;
+  out_rect.y      = data->result.y +
+                    (block / data->n_blocks_x) * data->block_size;
+  out_rect.width  = MIN (data->block_size,
+                         data->result.x + data->result.width  - out_rect.x);
+  out_rect.height = MIN (data->block_size,
+                         data->result.y + data->result.height - out_rect.y);
+
+  gegl_rectangle_copy (&in_rect, &out_rect);
+  in_rect.x      -= halo;
+  in_rect.y      -= halo;
+  in_rect.width  += 2 * halo;
+  in_rect.height += 2 * halo;
+
+  /* don't splat the abyss */
+  gegl_rectangle_intersect (&splat_rect, &in_rect, &data->bounds);
+
+  /* the grid covers all cells the input is splatted into, and those the
+   * output is sliced from.  each cell holds a sum of values and a weight for
+   * each channel.
+   */
+  gx0 = div_floor (in_rect.x, s_sigma) - 1;
+  gy0 = div_floor (in_rect.y, s_sigma) - 1;
+  sw  = div_floor (in_rect.x + in_rect.width,  s_sigma) + 2 - gx0;
+  sh  = div_floor (in_rect.y + in_rect.height, s_sigma) + 2 - gy0;
+
+  row_stride = (gsize) sw * CELL;
+  plane      = row_stride * sh;
+
+  buf  = g_new  (gfloat, (gsize) MAX (splat_rect.width, out_rect.width) *
+                         STRIP_ROWS * CHANNELS);
+  grid = g_new0 (gfloat, plane * depth);
+  prev = g_new  (gfloat, row_stride);
+  x1   = g_new  (gint,   out_rect.width);
+  xa   = g_new  (gfloat, out_rect.width);
+
+  /* downsampling, reading the input in strips of rows */
+  strip.x     = splat_rect.x;
+  strip.width = splat_rect.width;
+
+  for (strip.y = splat_rect.y;
+       strip.y < splat_rect.y + splat_rect.height;
+       strip.y += STRIP_ROWS)
+    {
+      strip.height = MIN (STRIP_ROWS, splat_rect.y + splat_rect.height - strip.y);
+
+      gegl_buffer_get (data->input, &strip, 1.0 / (1 << data->level),
+                       data->format, buf,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (y = 0; y < strip.height; y++)
+        {
+          const gint    gy  = div_floor (2 * (strip.y + y) + s_sigma,
+                                         2 * s_sigma) - gy0;
+          const gfloat *src = buf + (gsize) y * strip.width * CHANNELS;
+          gfloat       *row = grid + gy * row_stride;
+
+          for (x = 0; x < strip.width; x++)
+            {
+              const gint  gx   = div_floor (2 * (strip.x + x) + s_sigma,
+                                            2 * s_sigma) - gx0;
+              gfloat     *cell = row + gx * CELL;
+
+              for (c = 0; c < CHANNELS; c++)
+                {
+                  const gfloat v  = src[c];
+                  const gint   gz = (gint) (CLAMP (v, 0.0f, 1.0f) / r_sigma + 0.5f) +
+                                    PADDING_Z;
+
+                  cell[gz * plane + 2 * c + 0] += v;
+                  cell[gz * plane + 2 * c + 1] += 1.0f;
+                }
+
+              src += CHANNELS;
+            }
+        }
+    }
+
+  /* blur in x, y and z */
+  bilateral_blur_axis (grid, sw,    CELL,       CELL,       sh * depth, row_stride, prev);
+  bilateral_blur_axis (grid, sh,    row_stride, row_stride, depth,      plane,      prev);
+  bilateral_blur_axis (grid, depth, plane,      row_stride, sh,         row_stride, prev);
+
+  /* trilinear filtering, in strips of rows */
+  for (x = 0; x < out_rect.width; x++)
+    {
+      const gfloat xf = (gfloat) (out_rect.x + x) / s_sigma;
+      const gint   xi = floorf (xf);
+
+      x1[x] = xi - gx0;
+      xa[x] = xf - xi;
+    }
+
+  strip.x     = out_rect.x;
+  strip.width = out_rect.width;
+
+  for (strip.y = out_rect.y;
+       strip.y < out_rect.y + out_rect.height;
+       strip.y += STRIP_ROWS)
+    {
+      strip.height = MIN (STRIP_ROWS, out_rect.y + out_rect.height - strip.y);
+
+      gegl_buffer_get (data->input, &strip, 1.0 / (1 << data->level),
+                       data->format, buf,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (y = 0; y < strip.height; y++)
+        {
+          const gfloat  yf    = (gfloat) (strip.y + y) / s_sigma;
+          const gint    yi    = floorf (yf);
+          const gfloat  ya    = yf - yi;
+          const gfloat *row   = grid + (yi - gy0) * row_stride;
+          gfloat       *pixel = buf + (gsize) y * strip.width * CHANNELS;
+
+          for (x = 0; x < strip.width; x++)
+            {
+              for (c = 0; c < CHANNELS; c++)
+                {
+                  const gfloat  v    = pixel[c];
+                  const gfloat  zf   = CLAMP (v, 0.0f, 1.0f) / r_sigma + PADDING_Z;
+                  const gint    zi   = (gint) zf;
+                  const gfloat  za   = zf - zi;
+                  const gfloat *c000 = row + zi * plane + x1[x] * CELL + 2 * c;
+                  const gfloat *c010 = c000 + row_stride;
+                  const gfloat *c001 = c000 + plane;
+                  const gfloat *c011 = c010 + plane;
+                  gfloat        interpolated[2];
+                  gint          i;
+
+                  /* the sums and weights are interpolated alike */
+                  for (i = 0; i < 2; i++)
+                    {
+                      const gfloat a0 = lerp (c000[i], c000[CELL + i], xa[x]);
+                      const gfloat b0 = lerp (c010[i], c010[CELL + i], xa[x]);
+                      const gfloat a1 = lerp (c001[i], c001[CELL + i], xa[x]);
+                      const gfloat b1 = lerp (c011[i], c011[CELL + i], xa[x]);
+
+                      interpolated[i] = lerp (lerp (a0, b0, ya),
+                                              lerp (a1, b1, ya), za);
+                    }
+
+                  if (interpolated[1] > 0.0f)
+                    pixel[c] = interpolated[0] / interpolated[1];
+                }
+
+              pixel += CHANNELS;
+            }
+        }
+
+      gegl_buffer_set (data->output, &strip, data->level, data->format, buf,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (buf);
+  g_free (grid);
+  g_free (prev);
+  g_free (x1);
+  g_free (xa);
+}
+
+static void
+bilateral_blocks (gsize                offset,
+                  gsize                size,
+                  const BilateralData *data)
+{
+  gsize block;
+
+  for (block = offset; block < offset + size; block++)
+    bilateral_block (data, block);
+}
+
+static gboolean
+bilateral_process (GeglOperation       *operation,
+                   GeglBuffer          *input,
+                   GeglBuffer          *output,
+                   const GeglRectangle *result,
+                   gint                 level)
+{
+  GeglProperties      *o = GEGL_PROPERTIES (operation);
+  const GeglRectangle *bounds;
+  BilateralData        data;
+  gint                 n_blocks_y;
+  gint                 block_cells;
+
+  bounds = gegl_operation_source_get_bounding_box (operation, "input");
+
+  if (! bounds)
+    return TRUE;
+
+  data.input       = input;
+  data.output      = output;
+  data.format      = gegl_operation_get_format (operation, "output");
+  data.result      = *result;
+  data.bounds      = *bounds;
+  data.level       = level;
+  data.s_sigma     = o->s_sigma;
+  data.r_sigma     = o->r_sigma / 100.0;
+
+  /* at mipmap levels > 0, process the result in the coordinates of the
+   * level, with a correspondingly smaller grid
+   */
+  if (level)
+    {
+      bilateral_rect_to_level (result, level, &data.result);
+      bilateral_rect_to_level (bounds, level, &data.bounds);
+
+      data.s_sigma = MAX (o->s_sigma >> level, 1);
+    }
+
+  /* smaller blocks waste more work on their halo, but are needed to spread
+   * small results across the threads
+   */
+  for (block_cells = BLOCK_CELLS; ; block_cells /= 2)
+    {
+      data.block_size = block_cells * data.s_sigma;
+      data.n_blocks_x = (data.result.width  + data.block_size - 1) /
+                        data.block_size;
+      n_blocks_y      = (data.result.height + data.block_size - 1) /
+                        data.block_size;
+
+      if (block_cells <= 8 || data.n_blocks_x * n_blocks_y >= MIN_BLOCKS)
+        break;
+    }
+
+  gegl_parallel_distribute_range (
+    data.n_blocks_x * n_blocks_y,
+    gegl_operation_get_pixels_per_thread (operation) /
+    ((gdouble) data.block_size * data.block_size),
+    (GeglParallelDistributeRangeFunc) bilateral_blocks,
+    &data);
+
+  return TRUE;
+}
+
+static void
+gegl_op_class_init (GeglOpClass *klass)
+{
+  GeglOperationClass       *operation_class;
+  GeglOperationFilterClass *filter_class;
+
+  operation_class = GEGL_OPERATION_CLASS (klass);
+  filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
+
+  filter_class->process = bilateral_process;
+
+  operation_class->prepare  = bilateral_prepare;
+  operation_class->threaded = FALSE;
+
+  gegl_operation_class_set_keys (operation_class,
+  "name"       , "gegl:bilateral-filter-fast",
+  "title"      , _("Fast Bilateral Filter"),
+  "categories" , "enhance:noise-reduction",
+  "reference", "A Fast Approximation of the Bilateral Filter using a Signal Processing Approach Sylvain Paris and Frédo Durand European Conference on Computer Vision (ECCV'06)",
+  "description", _("A fast approximation of bilateral filter, blurring a downsampled bilateral grid with a [1 2 1] kernel along each axis."),
+        NULL);
+}
+
+
+#endif
@@ -0,0 +1,175 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Multithreaded running-sum box blur passes over linear buffers of
+ * interleaved float components, shared by gegl:box-blur and
+ * gegl:boxblur-1d.  The cost per pixel doesn't depend on the radius.
+ *
+ * The horizontal pass distributes rows across threads; the vertical pass
+ * distributes columns across threads, and keeps a sum for each of a block
+ * of adjacent columns, which are updated a whole row at a time, so that the
+ * inner loop gets vectorized by the compiler.
+ *
+ * The running sums are kept as sums of the scaled pixels in single
+ * precision, updated in the same order as the original serial loops, so
+ * that a single iteration gives bit-identical results.
+ */
+
+#ifndef __BOX_BLUR_COMMON_H__
+#define __BOX_BLUR_COMMON_H__
+
+/* the maximal number of components of a pixel */
+#define BOX_BLUR_MAX_COMPONENTS 8
+
+/* the number of floats of a row the vertical pass keeps sums for at once */
+#define BOX_BLUR_BLOCK          512
+
+typedef struct
+{
+  const gfloat *src;
+  gfloat       *dst;
+  gint          rowstride;    /* of both src and dst, in floats */
+  gint          width;        /* of dst, in pixels */
+  gint          height;       /* of dst, in rows */
+  gint          n_components;
+  gint          radius;
+  gdouble       pixels_per_thread;
+} BoxBlurData;
+
+
+static void
+box_blur_hor_range (gsize              offset,
+                    gsize              size,
+                    const BoxBlurData *data)
+{
+  const gint    n_components = data->n_components;
+  const gint    span         = (2 * data->radius + 1) * n_components;
+  const gfloat  rad1         = 1.0f / (2 * data->radius + 1);
+  gsize         y;
+
+  for (y = offset; y < offset + size; y++)
+    {
+      const gfloat *src = data->src + y * data->rowstride;
+      gfloat       *dst = data->dst + y * data->rowstride;
+      gfloat        sum[BOX_BLUR_MAX_COMPONENTS] = { 0.0f, };
+      gint          i, c;
+
+      for (i = 0; i < span; i += n_components)
+        {
+          for (c = 0; c < n_components; c++)
+            sum[c] += src[i + c] * rad1;
+        }
+
+      for (i = 0; i < (data->width - 1) * n_components; i += n_components)
+        {
+          for (c = 0; c < n_components; c++)
+            {
+              dst[i + c] = sum[c];
+              sum[c]     = sum[c] - src[i + c] * rad1 + src[i + span + c] * rad1;
+            }
+        }
+
+      for (c = 0; c < n_components; c++)
+        dst[i + c] = sum[c];
+    }
+}
+
+/* dst[y][x] is the average of src[y][x - radius .. x + radius], where src is
+ * 2 * radius pixels wider than dst, and starts radius pixels further left.
+ */
+static void
+box_blur_hor (const BoxBlurData *data)
+{
+  if (data->width <= 0 || data->height <= 0)
+    return;
+
+  gegl_parallel_distribute_range (
+    data->height,
+    data->pixels_per_thread / (data->width + 2 * data->radius),
+    (GeglParallelDistributeRangeFunc) box_blur_hor_range,
+    (gpointer) data);
+}
+
+static void
+box_blur_ver_range (gsize              offset,
+                    gsize              size,
+                    const BoxBlurData *data)
+{
+  const gint    rowstride = data->rowstride;
+  const gint    radius    = data->radius;
+  const gfloat  rad1      = 1.0f / (2 * radius + 1);
+  gfloat        sum[BOX_BLUR_BLOCK];
+  gsize         x0;
+
+  for (x0 = offset; x0 < offset + size; x0 += BOX_BLUR_BLOCK)
+    {
+      const gint n = MIN (BOX_BLUR_BLOCK, offset + size - x0);
+      gint       y, i;
+
+      memset (sum, 0, n * sizeof (gfloat));
+
+      for (y = 0; y < 2 * radius + 1; y++)
+        {
+          const gfloat *restrict src = data->src + y * rowstride + x0;
+
+          for (i = 0; i < n; i++)
+            sum[i] += src[i] * rad1;
+        }
+
+      for (y = 0; y < data->height; y++)
+        {
+          const gfloat *restrict first = data->src + y * rowstride + x0;
+          const gfloat *restrict next  = first + (2 * radius + 1) * rowstride;
+          gfloat       *restrict dst   = data->dst + y * rowstride + x0;
+
+          /* the last row doesn't need updated sums, and its next row may
+           * be past the end of src
+           */
+          if (y + 1 < data->height)
+            {
+              for (i = 0; i < n; i++)
+                {
+                  dst[i] = sum[i];
+                  sum[i] = sum[i] - first[i] * rad1 + next[i] * rad1;
+                }
+            }
+          else
+            {
+              for (i = 0; i < n; i++)
+                dst[i] = sum[i];
+            }
+        }
+    }
+}
+
+/* dst[y][x] is the average of src[y - radius .. y + radius][x], where src is
+ * 2 * radius rows taller than dst, and starts radius rows further up.
+ */
+static void
+box_blur_ver (const BoxBlurData *data)
+{
+  if (data->width <= 0 || data->height <= 0)
+    return;
+
+  gegl_parallel_distribute_range (
+    (gsize) data->width * data->n_components,
+    data->pixels_per_thread * data->n_components /
+    (data->height + 2 * data->radius),
+    (GeglParallelDistributeRangeFunc) box_blur_ver_range,
+    (gpointer) data);
+}
+
+#endif /* __BOX_BLUR_COMMON_H__ */
@@ -28,6 +28,10 @@ property_int (radius, _("Radius"), 4)
    ui_range    (0, 100)
    ui_gamma   (1.5)
 
+property_int (iterations, _("Iterations"), 1)
+   description(_("Number of times the blur is repeated, more iterations approximate a gaussian blur"))
+   value_range (1, 8)
+
 #else
 
 #define GEGL_OP_AREA_FILTER
@@ -36,133 +40,7 @@ property_int (radius, _("Radius"), 4)
 
 #include "gegl-op.h"
 #include <stdio.h>
-
-#define SRC_OFFSET (row + u + radius * 2) * 4
-
-static void
-hor_blur (GeglBuffer          *src,
-          const GeglRectangle *src_rect,
-          GeglBuffer          *dst,
-          const GeglRectangle *dst_rect,
-          gint                 radius,
-          const Babl          *format)
-{
-  gint u,v;
-  gint i;
-  gint offset;
-  gint src_offset;
-  gint prev_rad = radius * 4 + 4;
-  gint next_rad = radius * 4;
-  gint row;
-  gfloat *src_buf;
-  gfloat *dst_buf;
-  gfloat rad1 = 1.0 / (gfloat)(radius * 2 + 1);
-
-  src_buf = g_new0 (gfloat, src_rect->width * src_rect->height * 4);
-  dst_buf = g_new0 (gfloat, dst_rect->width * dst_rect->height * 4);
-
-  gegl_buffer_get (src, src_rect, 1.0, format,
-                   src_buf, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-
-  offset = 0;
-  for (v = 0; v < dst_rect->height; v++)
-    {
-      /* here just radius, not radius * 2 as in ver_blur beacuse
-       * we enlarged dst_buf by y earlier */
-      row = (v + radius) * src_rect->width;
-      /* prepare - set first column of pixels */
-      for (u = -radius; u <= radius; u++)
-        {
-          src_offset = SRC_OFFSET;
-          for (i = 0; i < 4; i++)
-            dst_buf[offset + i] += src_buf[src_offset + i] * rad1;
-        }
-      offset += 4;
-      /* iterate other pixels by moving a window - very fast */
-      for (u = 1; u < dst_rect->width; u++)
-        {
-          src_offset = SRC_OFFSET;
-          for (i = 0; i < 4; i++)
-          {
-            dst_buf[offset] = dst_buf[offset - 4]
-                            - src_buf[src_offset - prev_rad] * rad1
-                            + src_buf[src_offset + next_rad] * rad1;
-            src_offset++;
-            offset++;
-          }
-        }
-    }
-
-  gegl_buffer_set (dst, dst_rect, 0, format,
-                   dst_buf, GEGL_AUTO_ROWSTRIDE);
-
-  g_free (src_buf);
-  g_free (dst_buf);
-}
-
-static void
-ver_blur (GeglBuffer          *src,
-          const GeglRectangle *src_rect,
-          GeglBuffer          *dst,
-          const GeglRectangle *dst_rect,
-          gint                 radius,
-          const Babl          *format)
-{
-  gint u, v;
-  gint i;
-  gint offset;
-  gint src_offset;
-  gint prev_rad = (radius * 4 + 4) * src_rect->width;
-  gint next_rad = (radius * 4) * src_rect->width;
-  gint row;
-  gfloat *src_buf;
-  gfloat *dst_buf;
-  gfloat rad1 = 1.0 / (gfloat)(radius * 2 + 1);
-
-  src_buf = g_new0 (gfloat, src_rect->width * src_rect->height * 4);
-  dst_buf = g_new0 (gfloat, dst_rect->width * dst_rect->height * 4);
-
-  gegl_buffer_get (src, src_rect, 1.0, format,
-                   src_buf, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-
-  /* prepare: set first row of pixels */
-  for (v = -radius; v <= radius; v++)
-    {
-      row = (v + radius * 2) * src_rect->width;
-      for (u = 0; u < dst_rect->width; u++)
-        {
-          src_offset = SRC_OFFSET;
-          for (i = 0; i < 4; i++)
-            dst_buf[u * 4 + i] += src_buf[src_offset + i] * rad1;
-        }
-    }
-  /* skip first row */
-  offset = dst_rect->width * 4;
-  for (v = 1; v < dst_rect->height; v++)
-    {
-      row = (v + radius * 2) * src_rect->width;
-      for (u = 0; u < dst_rect->width; u++)
-        {
-          src_offset = SRC_OFFSET;
-          for (i = 0; i < 4; i++)
-          {
-            dst_buf[offset] = dst_buf[offset - 4 * dst_rect->width]
-                            - src_buf[src_offset - prev_rad] * rad1
-                            + src_buf[src_offset + next_rad] * rad1;
-            src_offset++;
-            offset++;
-          }
-        }
-    }
-
-  gegl_buffer_set (dst, dst_rect, 0, format,
-                   dst_buf, GEGL_AUTO_ROWSTRIDE);
-
-  g_free (src_buf);
-  g_free (dst_buf);
-}
-
-#undef SRC_OFFSET
+#include "box-blur-common.h"
 
 static void prepare (GeglOperation *operation)
 {
@@ -177,7 +55,7 @@ static void prepare (GeglOperation *operation)
   op_area->left   =
   op_area->right  =
   op_area->top    =
-  op_area->bottom = o->radius;
+  op_area->bottom = o->radius * o->iterations;
 
   gegl_operation_set_format (operation, "input",  format);
   gegl_operation_set_format (operation, "output", format);
@@ -350,37 +228,75 @@ process (GeglOperation       *operation,
          const GeglRectangle *result,
          gint                 level)
 {
-  GeglRectangle rect;
-  GeglRectangle tmprect;
   GeglProperties *o = GEGL_PROPERTIES (operation);
-  GeglBuffer *temp;
   GeglOperationAreaFilter *op_area;
-  const Babl *out_format = gegl_operation_get_format (operation, "output");
+  const Babl *format = gegl_operation_get_format (operation, "output");
+  GeglRectangle rect;
+  BoxBlurData   data;
+  gfloat       *buf[2];
+  gint          i;
 
   op_area = GEGL_OPERATION_AREA_FILTER (operation);
 
-  if (gegl_operation_use_opencl (operation))
+  if (o->radius == 0)
+    {
+      gegl_buffer_copy (input, result, GEGL_ABYSS_NONE, output, result);
+      return TRUE;
+    }
+
+  if (o->iterations == 1 && gegl_operation_use_opencl (operation))
     if (cl_process (operation, input, output, result))
       return TRUE;
 
   rect = *result;
-  tmprect = *result;
 
-  rect.x       -= op_area->left * 2;
-  rect.y       -= op_area->top * 2;
-  rect.width   += (op_area->left + op_area->right) * 2;
-  rect.height  += (op_area->top + op_area->bottom) * 2;
-  /* very tricky: enlarge temp buffer to avoid seams in second pass */
-  tmprect.y      -= o->radius;
-  tmprect.height += o->radius * 2;
+  rect.x      -= op_area->left;
+  rect.y      -= op_area->top;
+  rect.width  += op_area->left + op_area->right;
+  rect.height += op_area->top  + op_area->bottom;
 
-  temp  = gegl_buffer_new (&tmprect, out_format);
+  buf[0] = g_new (gfloat, (gsize) rect.width * rect.height * 4);
+  buf[1] = g_new (gfloat, (gsize) rect.width * rect.height * 4);
 
-  /* doing second pass in separate gegl op may be significantly faster */
-  hor_blur (input, &rect, temp, &tmprect, o->radius, out_format);
-  ver_blur (temp, &rect, output, result, o->radius, out_format);
+  gegl_buffer_get (input, &rect, 1.0, format,
+                   buf[0], GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+
+  data.rowstride         = rect.width * 4;
+  data.n_components      = 4;
+  data.radius            = o->radius;
+  data.pixels_per_thread = gegl_operation_get_pixels_per_thread (operation);
+
+  /* each pass shrinks the blurred region by the radius on both sides; the
+   * horizontal passes keep the rows the vertical passes need
+   */
+  data.width  = rect.width;
+  data.height = rect.height;
+
+  for (i = 0; i < 2 * o->iterations; i++)
+    {
+      data.src = buf[i % 2];
+      data.dst = buf[(i + 1) % 2];
+
+      if (i < o->iterations)
+        {
+          data.width -= 2 * o->radius;
+
+          box_blur_hor (&data);
+        }
+      else
+        {
+          data.height -= 2 * o->radius;
+
+          box_blur_ver (&data);
+        }
+    }
+
+  gegl_buffer_set (output, result, 0, format,
+                   buf[0], data.rowstride * sizeof (gfloat));
+
+  g_free (buf[0]);
+  g_free (buf[1]);
 
-  g_object_unref (temp);
   return  TRUE;
 }
 
@@ -397,6 +313,9 @@ gegl_op_class_init (GeglOpClass *klass)
   filter_class->process    = process;
   operation_class->prepare = prepare;
 
+  /* the passes are multithreaded themselves */
+  operation_class->threaded = FALSE;
+
   operation_class->opencl_support = TRUE;
 
   gegl_operation_class_set_keys (operation_class,
@@ -33,6 +33,8 @@
 
 #include "gegl-op.h"
 
+#define N_PROGRESS_STEPS 16
+
 static void
 buffer_get_min_max (GeglOperation       *operation,
                     GeglBuffer          *buffer,
@@ -41,34 +43,38 @@ buffer_get_min_max (GeglOperation       *operation,
                     gdouble             *max,
                     const Babl          *format)
 {
-  GeglBufferIterator *gi;
-  gint                done_pixels = 0;
+  GeglRectangle band;
+  gint          band_height;
 
   gegl_operation_progress (operation, 0.0, "");
 
-  gi = gegl_buffer_iterator_new (buffer, result, 0, format,
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
-
   *min = G_MAXDOUBLE;
   *max = -G_MAXDOUBLE;
 
-  while (gegl_buffer_iterator_next (gi))
+  /* the statistics are gathered in bands of rows, so that the progress can
+   * be reported in between
+   */
+  band        = *result;
+  band_height = (result->height + N_PROGRESS_STEPS - 1) / N_PROGRESS_STEPS;
+
+  for (band.y = result->y;
+       band.y < result->y + result->height;
+       band.y += band_height)
     {
-      gint o;
-      gfloat *buf = gi->items[0].data;
+      gdouble cmin[3], cmax[3];
 
-      for (o = 0; o < gi->length; o++)
-        {
-          *min = MIN (buf[1], *min);
-          *max = MAX (buf[1], *max);
-          buf += 3;
-        }
+      band.height = MIN (band_height, result->y + result->height - band.y);
+
+      gegl_parallel_get_buffer_statistics (buffer, &band, 0, format,
+                                           cmin, cmax, NULL, NULL);
 
-      done_pixels += gi->length;
+      *min = MIN (cmin[1], *min);
+      *max = MAX (cmax[1], *max);
 
       gegl_operation_progress (operation,
-                               (gdouble) 0.5 * done_pixels /
-                               (gdouble) (result->width * result->height),
+                               (gdouble) 0.5 *
+                               (band.y + band.height - result->y) /
+                               (gdouble) result->height,
                                "");
     }
 
@@ -270,6 +270,7 @@ gegl_op_class_init (GeglOpClass *klass)
     "name",        "gegl:color-temperature",
     "title",       _("Color Temperature"),
     "categories",  "color",
+    "commutes-with-transforms", "true",
     "reference-hash", "0a5ec345755968efc091b084587de7cb",
     "description", _("Change the color temperature of the image, from an assumed original color temperature to an intended one."),
     "reference-composition", composition,
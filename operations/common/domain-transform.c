@@ -54,9 +54,21 @@ property_double (edge_preservation, _("Edge preservation"),  0.8)
 #define RF_TABLE_SIZE 768
 #define SQRT3 1.7320508075f
 #define SQRT2 1.4142135623f
-#define BLOCK_STRIDE 1
+#define N_CHAN 4            /* R'G'B'A */
+#define BLOCK_SIZE 64       /* the number of columns the vertical pass filters at once */
 #define REPORT_PROGRESS_TIME 0.5  /* time to report gegl_operation_progress */
 
+typedef struct
+{
+  gfloat        *buffer;       /* the R'G'B'A float pixels being filtered */
+  const guint8  *pixels;       /* the R'G'B' u8 input pixels */
+  guint16       *h_transforms; /* the domain transform of each pixel, */
+  guint16       *v_transforms; /* relative to its left and top neighbors */
+  const gfloat  *rf_table;     /* the feedback coefficients of the current iteration */
+  gint           width;
+  gint           height;
+} DomainTransformData;
+
 static gint16
 absolute (gint16 x)
 {
@@ -83,41 +95,199 @@ report_progress (GeglOperation  *operation,
     gegl_operation_progress (operation, progress, "");
 }
 
+static inline guint16
+pixel_difference (const guint8 *current,
+                  const guint8 *last)
+{
+  return absolute (current[0] - last[0]) +
+         absolute (current[1] - last[1]) +
+         absolute (current[2] - last[2]);
+}
+
+/* @NOTE: 'd' should be 1.0f + s_s / s_r * sum_diff
+ * However, we will store just sum_diff.
+ * 1.0f + s_s / s_r will be calculated later when calculating
+ * the RF table. This is done this way because the sum_diff is
+ * perfect to be used as the index of the RF table.
+ * d = 1.0f + (vdt_information->spatial_factor /
+ *   vdt_information->range_factor) * sum_channels_difference;
+ *
+ * The transforms only depend on the input, so they are computed once, for
+ * all the iterations.
+ */
+static void
+domain_transform_compute_transforms (gsize                offset,
+                                     gsize                size,
+                                     DomainTransformData *data)
+{
+  const gint width = data->width;
+  gsize      y;
+  gint       x;
+
+  for (y = offset; y < offset + size; y++)
+    {
+      const guint8 *row      = data->pixels + y * width * 3;
+      const guint8 *last_row = y > 0 ? row - width * 3 : row;
+      guint16      *h        = data->h_transforms + y * width;
+      guint16      *v        = data->v_transforms + y * width;
+
+      h[0] = 0;
+
+      for (x = 1; x < width; x++)
+        h[x] = pixel_difference (row + x * 3, row + (x - 1) * 3);
+
+      for (x = 0; x < width; x++)
+        v[x] = pixel_difference (row + x * 3, last_row + x * 3);
+    }
+}
+
+/* Horizontal Filter (Left-Right, then Right-Left), of a range of rows.  The
+ * channels of a pixel are filtered together.
+ */
+static void
+domain_transform_horizontal (gsize                offset,
+                             gsize                size,
+                             DomainTransformData *data)
+{
+  const gint    width    = data->width;
+  const gfloat *rf_table = data->rf_table;
+  gsize         y;
+  gint          k, c;
+
+  for (y = offset; y < offset + size; y++)
+    {
+      gfloat        *row        = data->buffer + y * width * N_CHAN;
+      const guint16 *transforms = data->h_transforms + y * width;
+      gfloat         lastf[N_CHAN];
+
+      for (c = 0; c < N_CHAN; c++)
+        lastf[c] = row[c];
+
+      for (k = 0; k < width; ++k)
+        {
+          const gfloat w = rf_table[transforms[k]];
+
+          for (c = 0; c < N_CHAN; c++)
+            {
+              lastf[c] = ((1 - w) * row[k * N_CHAN + c] + w * lastf[c]);
+              row[k * N_CHAN + c] = lastf[c];
+            }
+        }
+
+      for (c = 0; c < N_CHAN; c++)
+        lastf[c] = row[(width - 1) * N_CHAN + c];
+
+      for (k = width - 1; k >= 0; --k)
+        {
+          const gint   d_x_position = (k < width - 1) ? k + 1 : k;
+          const gfloat w            = rf_table[transforms[d_x_position]];
+
+          for (c = 0; c < N_CHAN; c++)
+            {
+              lastf[c] = ((1 - w) * row[k * N_CHAN + c] + w * lastf[c]);
+              row[k * N_CHAN + c] = lastf[c];
+            }
+        }
+    }
+}
+
+/* Vertical Filter (Top-Down, then Bottom-Up), of a range of columns.
+ * Blocks of adjacent columns are filtered together, a row at a time, so
+ * that the pixels are accessed sequentially, and the inner loop gets
+ * vectorized by the compiler.
+ */
+static void
+domain_transform_vertical (gsize                offset,
+                           gsize                size,
+                           DomainTransformData *data)
+{
+  const gint    width    = data->width;
+  const gint    height   = data->height;
+  const gfloat *rf_table = data->rf_table;
+  gfloat        lastf[BLOCK_SIZE * N_CHAN];
+  gfloat        w[BLOCK_SIZE];
+  gsize         x0;
+
+  for (x0 = offset; x0 < offset + size; x0 += BLOCK_SIZE)
+    {
+      const gint  n   = MIN (BLOCK_SIZE, offset + size - x0);
+      gfloat     *col = data->buffer + x0 * N_CHAN;
+      gint        i, k;
+
+      memcpy (lastf, col, n * N_CHAN * sizeof (gfloat));
+
+      for (k = 0; k < height; ++k)
+        {
+          const guint16 *transforms = data->v_transforms + k * width + x0;
+          gfloat        *row        = col + (gsize) k * width * N_CHAN;
+
+          for (i = 0; i < n; i++)
+            w[i] = rf_table[transforms[i]];
+
+          for (i = 0; i < n * N_CHAN; i++)
+            {
+              lastf[i] = ((1 - w[i / N_CHAN]) * row[i] +
+                          w[i / N_CHAN] * lastf[i]);
+              row[i]   = lastf[i];
+            }
+        }
+
+      memcpy (lastf, col + (gsize) (height - 1) * width * N_CHAN,
+              n * N_CHAN * sizeof (gfloat));
+
+      for (k = height - 1; k >= 0; --k)
+        {
+          const gint     d_y_position = (k < height - 1) ? k + 1 : k;
+          const guint16 *transforms   = data->v_transforms +
+                                        d_y_position * width + x0;
+          gfloat        *row          = col + (gsize) k * width * N_CHAN;
+
+          for (i = 0; i < n; i++)
+            w[i] = rf_table[transforms[i]];
+
+          for (i = 0; i < n * N_CHAN; i++)
+            {
+              lastf[i] = ((1 - w[i / N_CHAN]) * row[i] +
+                          w[i / N_CHAN] * lastf[i]);
+              row[i]   = lastf[i];
+            }
+        }
+    }
+}
+
 static gint
-domain_transform (GeglOperation  *operation,
-                  gint            width,
-                  gint            height,
-                  gint            n_chan,
-                  gfloat          spatial_factor,
-                  gfloat          range_factor,
-                  gint            n_iterations,
-                  GeglBuffer     *input,
-                  GeglBuffer     *output)
+domain_transform (GeglOperation       *operation,
+                  const GeglRectangle *rect,
+                  gint                 level,
+                  gfloat               spatial_factor,
+                  gfloat               range_factor,
+                  gint                 n_iterations,
+                  GeglBuffer          *input,
+                  GeglBuffer          *output)
 {
   const Babl *space    = gegl_operation_get_source_space (operation, "input");
   const Babl *formatu8 = babl_format_with_space ("R'G'B' u8", space);
   const Babl *format   = babl_format_with_space ("R'G'B'A float", space);
+  const gdouble scale  = 1.0 / (1 << level);
+  const gdouble pixels_per_thread =
+    gegl_operation_get_pixels_per_thread (operation);
+  DomainTransformData data;
   gfloat  **rf_table;
-  guint16  *transforms_buffer;
-  gfloat   *buffer;
-
-  gint16    last[3];
-  gint16    current[3];
-  gfloat    lastf[4];
-  gfloat    currentf[4];
-  gfloat    sum_channels_difference, a, w, sdt_dev;
-  gint      i, j, k, n;
-  gint      real_stride, d_x_position, d_y_position, biggest_dimension;
-  guint16   d;
-  GeglRectangle rect;
+  gfloat    a, sdt_dev;
+  gint      i, j, n;
+  gsize     n_pixels;
   GTimer  *timer;
 
   timer = g_timer_new ();
 
+  n_pixels = (gsize) rect->width * rect->height;
+
   /* PRE-ALLOC MEMORY */
-  biggest_dimension = (width > height) ? width : height;
-  buffer            = g_new (gfloat, BLOCK_STRIDE * biggest_dimension * n_chan);
-  transforms_buffer = g_new (guint16, BLOCK_STRIDE * biggest_dimension);
+  data.width        = rect->width;
+  data.height       = rect->height;
+  data.buffer       = g_new (gfloat, n_pixels * N_CHAN);
+  data.h_transforms = g_new (guint16, n_pixels);
+  data.v_transforms = g_new (guint16, n_pixels);
 
   rf_table = g_new (gfloat *, n_iterations);
 
@@ -148,248 +318,59 @@ domain_transform (GeglOperation  *operation,
         }
     }
 
+  /* Domain Transform */
+  {
+    guint8 *pixels = g_new (guint8, n_pixels * 3);
+
+    gegl_buffer_get (input, rect, scale, formatu8, pixels,
+                     GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+
+    data.pixels = pixels;
+
+    gegl_parallel_distribute_range (
+      rect->height, pixels_per_thread / rect->width,
+      (GeglParallelDistributeRangeFunc) domain_transform_compute_transforms,
+      &data);
+
+    data.pixels = NULL;
+
+    g_free (pixels);
+  }
+
+  gegl_buffer_get (input, rect, scale, format, data.buffer,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+
   /* Filter Iterations */
   for (n = 0; n < n_iterations; ++n)
     {
+      data.rf_table = rf_table[n];
+
       /* Horizontal Pass */
-      for (i = 0; i < height; i += BLOCK_STRIDE)
-        {
-          real_stride = (i + BLOCK_STRIDE > height) ? height - i : BLOCK_STRIDE;
-    
-          rect.x = 0;
-          rect.y = i;
-          rect.width = width;
-          rect.height = real_stride;
-    
-          gegl_buffer_get (input, &rect, 1.0, formatu8, buffer,
-                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-    
-          /* Domain Transform */
-          for (j = 0; j < rect.height; ++j)
-            {
-              last[0] = ((guint8*) buffer)[j * rect.width * 3];
-              last[1] = ((guint8*) buffer)[j * rect.width * 3 + 1];
-              last[2] = ((guint8*) buffer)[j * rect.width * 3 + 2];
-      
-              for (k = 0; k < rect.width; ++k)
-                {
-                  current[0] = ((guint8*) buffer)[j * rect.width * 3 + k * 3];
-                  current[1] = ((guint8*) buffer)[j * rect.width * 3 + k * 3 + 1];
-                  current[2] = ((guint8*) buffer)[j * rect.width * 3 + k * 3 + 2];
-        
-                  sum_channels_difference = absolute (current[0] - last[0]) +
-                                            absolute (current[1] - last[1]) +
-                                            absolute (current[2] - last[2]);
-        
-                  /* @NOTE: 'd' should be 1.0f + s_s / s_r * sum_diff
-                   * However, we will store just sum_diff.
-                   * 1.0f + s_s / s_r will be calculated later when calculating
-                   * the RF table. This is done this way because the sum_diff is
-                   * perfect to be used as the index of the RF table.
-                   * d = 1.0f + (vdt_information->spatial_factor /
-                   *   vdt_information->range_factor) * sum_channels_difference;
-                   */
-                  transforms_buffer[j * rect.width + k] = sum_channels_difference;
-        
-                  last[0] = current[0];
-                  last[1] = current[1];
-                  last[2] = current[2];
-                }
-            }
-    
-          if (n == 0)
-            gegl_buffer_get (input, &rect, 1.0, format, buffer,
-                             GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-          else
-            gegl_buffer_get (output, &rect, 1.0, format, buffer,
-                             GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-    
-          /* Horizontal Filter (Left-Right) */
-          for (j = 0; j < rect.height; ++j)
-            {
-              lastf[0] = buffer[j * rect.width * n_chan];
-              lastf[1] = buffer[j * rect.width * n_chan + 1];
-              lastf[2] = buffer[j * rect.width * n_chan + 2];
-              lastf[3] = buffer[j * rect.width * n_chan + 3];
-      
-              for (k = 0; k < rect.width; ++k)
-                {
-                  d = transforms_buffer[j * rect.width + k];
-                  w = rf_table[n][d];
-        
-                  currentf[0] = buffer[j * rect.width * n_chan + k * n_chan];
-                  currentf[1] = buffer[j * rect.width * n_chan + k * n_chan + 1];
-                  currentf[2] = buffer[j * rect.width * n_chan + k * n_chan + 2];
-                  currentf[3] = buffer[j * rect.width * n_chan + k * n_chan + 3];
-        
-                  lastf[0] = ((1 - w) * currentf[0] + w * lastf[0]);
-                  lastf[1] = ((1 - w) * currentf[1] + w * lastf[1]);
-                  lastf[2] = ((1 - w) * currentf[2] + w * lastf[2]);
-                  lastf[3] = ((1 - w) * currentf[3] + w * lastf[3]);
-        
-                  buffer[j * rect.width * n_chan + k * n_chan]     = lastf[0];
-                  buffer[j * rect.width * n_chan + k * n_chan + 1] = lastf[1];
-                  buffer[j * rect.width * n_chan + k * n_chan + 2] = lastf[2];
-                  buffer[j * rect.width * n_chan + k * n_chan + 3] = lastf[3];
-                }
-            }
-    
-          /* Horizontal Filter (Right-Left) */
-          for (j = 0; j < rect.height; ++j)
-            {
-              lastf[0] = buffer[j * rect.width * n_chan + (rect.width - 1) * n_chan];
-              lastf[1] = buffer[j * rect.width * n_chan + (rect.width - 1) * n_chan + 1];
-              lastf[2] = buffer[j * rect.width * n_chan + (rect.width - 1) * n_chan + 2];
-              lastf[3] = buffer[j * rect.width * n_chan + (rect.width - 1) * n_chan + 3];
-              
-              for (k = rect.width - 1; k >= 0; --k)
-                {
-                  d_x_position = (k < rect.width - 1) ? k + 1 : k;
-                  d = transforms_buffer[j * rect.width + d_x_position];
-                  w = rf_table[n][d];
-        
-                  currentf[0] = buffer[j * rect.width * n_chan + k * n_chan];
-                  currentf[1] = buffer[j * rect.width * n_chan + k * n_chan + 1];
-                  currentf[2] = buffer[j * rect.width * n_chan + k * n_chan + 2];
-                  currentf[3] = buffer[j * rect.width * n_chan + k * n_chan + 3];
-        
-                  lastf[0] = ((1 - w) * currentf[0] + w * lastf[0]);
-                  lastf[1] = ((1 - w) * currentf[1] + w * lastf[1]);
-                  lastf[2] = ((1 - w) * currentf[2] + w * lastf[2]);
-                  lastf[3] = ((1 - w) * currentf[3] + w * lastf[3]);
-        
-                  buffer[j * rect.width * n_chan + k * n_chan] = lastf[0];
-                  buffer[j * rect.width * n_chan + k * n_chan + 1] = lastf[1];
-                  buffer[j * rect.width * n_chan + k * n_chan + 2] = lastf[2];
-                  buffer[j * rect.width * n_chan + k * n_chan + 3] = lastf[3];
-                }
-            }
-    
-          gegl_buffer_set (output, &rect, 0, format, buffer,
-                           GEGL_AUTO_ROWSTRIDE);
-        }
-  
+      gegl_parallel_distribute_range (
+        rect->height, pixels_per_thread / rect->width,
+        (GeglParallelDistributeRangeFunc) domain_transform_horizontal,
+        &data);
+
       report_progress (operation, (2.0 * n + 1.0) / (2.0 * n_iterations), timer);
-  
+
       /* Vertical Pass */
-      for (i = 0; i < width; i += BLOCK_STRIDE)
-        {
-          real_stride = (i + BLOCK_STRIDE > width) ? width - i : BLOCK_STRIDE;
-    
-          rect.x = i;
-          rect.y = 0;
-          rect.width = real_stride;
-          rect.height = height;
-    
-          gegl_buffer_get (input, &rect, 1.0, formatu8, buffer,
-                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-    
-          /* Domain Transform */
-          for (j = 0; j < rect.width; ++j)
-            {
-              last[0] = ((guint8*) buffer)[j * 3];
-              last[1] = ((guint8*) buffer)[j * 3 + 1];
-              last[2] = ((guint8*) buffer)[j * 3 + 2];
-      
-              for (k = 0; k < rect.height; ++k)
-                {
-                  current[0] = ((guint8*) buffer)[k * rect.width * 3 + j * 3];
-                  current[1] = ((guint8*) buffer)[k * rect.width * 3 + j * 3 + 1];
-                  current[2] = ((guint8*) buffer)[k * rect.width * 3 + j * 3 + 2];
-        
-                  sum_channels_difference = absolute (current[0] - last[0]) +
-                                            absolute (current[1] - last[1]) +
-                                            absolute (current[2] - last[2]);
-        
-                  /* @NOTE: 'd' should be 1.0f + s_s / s_r * sum_diff
-                   * However, we will store just sum_diff.
-                   * 1.0f + s_s / s_r will be calculated later when calculating
-                   * the RF table. This is done this way because the sum_diff is
-                   * perfect to be used as the index of the RF table.
-                   * d = 1.0f + (vdt_information->spatial_factor /
-                   *   vdt_information->range_factor) * sum_channels_difference;
-                   */
-                  transforms_buffer[k * rect.width + j] = sum_channels_difference;
-        
-                  last[0] = current[0];
-                  last[1] = current[1];
-                  last[2] = current[2];
-                }
-            }
-    
-          gegl_buffer_get (output, &rect, 1.0, format, buffer,
-                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-    
-          /* Vertical Filter (Top-Down) */
-          for (j = 0; j < rect.width; ++j)
-            {
-              lastf[0] = buffer[j * n_chan];
-              lastf[1] = buffer[j * n_chan + 1];
-              lastf[2] = buffer[j * n_chan + 2];
-              lastf[3] = buffer[j * n_chan + 3];
-      
-              for (k = 0; k < rect.height; ++k)
-                {
-                  d = transforms_buffer[k * rect.width + j];
-                  w = rf_table[n][d];
-                  
-                  currentf[0] = buffer[k * rect.width * n_chan + j * n_chan];
-                  currentf[1] = buffer[k * rect.width * n_chan + j * n_chan + 1];
-                  currentf[2] = buffer[k * rect.width * n_chan + j * n_chan + 2];
-                  currentf[3] = buffer[k * rect.width * n_chan + j * n_chan + 3];
-        
-                  lastf[0] = ((1 - w) * currentf[0] + w * lastf[0]);
-                  lastf[1] = ((1 - w) * currentf[1] + w * lastf[1]);
-                  lastf[2] = ((1 - w) * currentf[2] + w * lastf[2]);
-                  lastf[3] = ((1 - w) * currentf[3] + w * lastf[3]);
-        
-                  buffer[k * rect.width * n_chan + j * n_chan]     = lastf[0];
-                  buffer[k * rect.width * n_chan + j * n_chan + 1] = lastf[1];
-                  buffer[k * rect.width * n_chan + j * n_chan + 2] = lastf[2];
-                  buffer[k * rect.width * n_chan + j * n_chan + 3] = lastf[3];
-                }
-            }
-    
-          /* Vertical Filter (Bottom-Up) */
-          for (j = 0; j < rect.width; ++j)
-            {
-              lastf[0] = buffer[(rect.height - 1) * rect.width * n_chan + j * n_chan];
-              lastf[1] = buffer[(rect.height - 1) * rect.width * n_chan + j * n_chan + 1];
-              lastf[2] = buffer[(rect.height - 1) * rect.width * n_chan + j * n_chan + 2];
-              lastf[3] = buffer[(rect.height - 1) * rect.width * n_chan + j * n_chan + 3];
-              
-              for (k = rect.height - 1; k >= 0; --k)
-                {
-                  d_y_position = (k < rect.height - 1) ? k + 1 : k;
-                  d = transforms_buffer[d_y_position * rect.width + j];
-                  w = rf_table[n][d];
-        
-                  currentf[0] = buffer[k * rect.width * n_chan + j * n_chan];
-                  currentf[1] = buffer[k * rect.width * n_chan + j * n_chan + 1];
-                  currentf[2] = buffer[k * rect.width * n_chan + j * n_chan + 2];
-                  currentf[3] = buffer[k * rect.width * n_chan + j * n_chan + 3];
-        
-                  lastf[0] = ((1 - w) * currentf[0] + w * lastf[0]);
-                  lastf[1] = ((1 - w) * currentf[1] + w * lastf[1]);
-                  lastf[2] = ((1 - w) * currentf[2] + w * lastf[2]);
-                  lastf[3] = ((1 - w) * currentf[3] + w * lastf[3]);
-        
-                  buffer[k * rect.width * n_chan + j * n_chan]     = lastf[0];
-                  buffer[k * rect.width * n_chan + j * n_chan + 1] = lastf[1];
-                  buffer[k * rect.width * n_chan + j * n_chan + 2] = lastf[2];
-                  buffer[k * rect.width * n_chan + j * n_chan + 3] = lastf[3];
-                }
-            }
-    
-          gegl_buffer_set (output, &rect, 0, format, buffer,
-                           GEGL_AUTO_ROWSTRIDE);
-        }
-  
+      gegl_parallel_distribute_range (
+        rect->width, pixels_per_thread / rect->height,
+        (GeglParallelDistributeRangeFunc) domain_transform_vertical,
+        &data);
+
       report_progress (operation, (2.0 * n + 2.0) / (2.0 * n_iterations), timer);
     }
 
-  g_free (transforms_buffer);
-  g_free (buffer);
+  if (! gegl_parallel_is_cancelled ())
+    {
+      gegl_buffer_set (output, rect, level, format, data.buffer,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (data.v_transforms);
+  g_free (data.h_transforms);
+  g_free (data.buffer);
 
   for (i = 0; i < n_iterations; ++i)
     g_free (rf_table[i]);
@@ -446,6 +427,7 @@ process (GeglOperation       *operation,
          gint                 level)
 {
   GeglProperties  *o = GEGL_PROPERTIES (operation);
+  GeglRectangle    rect;
   gfloat range_factor;
 
   if (o->edge_preservation != 0.0)
@@ -453,12 +435,23 @@ process (GeglOperation       *operation,
   else
     range_factor = G_MAXFLOAT;
 
-  /* Buffer is ready for domain transform */
+  /* At mipmap levels > 0, filter a downscaled proxy of the input, covering
+   * the same rectangle the point filters compute, and write the output at
+   * that level.  The blur radius is scaled along; the range factor, which
+   * is relative to it, stays the same.
+   */
+  rect.x      = result->x      >> level;
+  rect.y      = result->y      >> level;
+  rect.width  = result->width  >> level;
+  rect.height = result->height >> level;
+
+  if (gegl_rectangle_is_empty (&rect))
+    return TRUE;
+
   domain_transform (operation,
-                    result->width,
-                    result->height,
-                    4,
-                    o->spatial_factor,
+                    &rect,
+                    level,
+                    o->spatial_factor / (1 << level),
                     range_factor,
                     o->n_iterations,
                     input,
@@ -479,6 +479,7 @@ gegl_op_class_init (GeglOpClass *klass)
     "name",        "gegl:exposure",
     "title",       _("Exposure"),
     "categories",  "color",
+    "commutes-with-transforms", "true",
     "reference-hash", "a4ae5d7f933046aa462e0f7659bd1261",
     "reference-composition", composition,
     "description", _("Change exposure of an image in shutter speed stops"),
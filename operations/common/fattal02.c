@@ -54,6 +54,8 @@ property_double (noise, _("Noise"), 0.0)
 #include "gegl-op.h"
 #include "gegl-debug.h"
 #include <stdlib.h>
+#include "solver-common.h"
+#include "proxy-common.h"
 
 static const gchar *OUTPUT_FORMAT   = "RGB float";
 static const gint   MINIMUM_PYRAMID = 32;
@@ -122,9 +124,7 @@ fattal02_add_array (gfloat       *accum,
                     guint         size,
                     const gfloat *input)
 {
-  guint i;
-  for (i = 0; i < size; ++i)
-    accum[i] += input[i];
+  solver_axpy (size, 1.0f, input, accum);
 }
 
 
@@ -141,27 +141,37 @@ fattal02_copy_array (const gfloat *input,
  * Full Multigrid Algorithm for solving partial differential equations
  */
 
+typedef struct
+{
+  const gfloat        *input;
+  const GeglRectangle *extent_i;
+  gfloat              *output;
+  const GeglRectangle *extent_o;
+} Fattal02ResampleData;
+
+
 static void
-fattal02_restrict (const gfloat        *input,
-                   const GeglRectangle *extent_i,
-                   gfloat              *output,
-                   const GeglRectangle *extent_o)
+fattal02_restrict_rows (gsize                 offset,
+                        gsize                 size,
+                        Fattal02ResampleData *data)
 {
-  const guint inRows = extent_i->height,
-              inCols = extent_i->width;
+  const gfloat *input  = data->input;
+  gfloat       *output = data->output;
+
+  const guint inRows = data->extent_i->height,
+              inCols = data->extent_i->width;
 
-  const guint outRows = extent_o->height,
-              outCols = extent_o->width;
+  const guint outCols = data->extent_o->width;
 
   const gfloat dx = (gfloat)inCols / (gfloat)outCols,
-               dy = (gfloat)inRows / (gfloat)outRows;
+               dy = (gfloat)inRows / (gfloat)data->extent_o->height;
 
   const gfloat filterSize = 0.5;
 
   gfloat sx, sy;
   guint   x,  y;
 
-  for (y = 0, sy = dy / 2 - 0.5; y < outRows; ++y, sy += dy)
+  for (y = offset, sy = dy / 2 - 0.5 + y * dy; y < offset + size; ++y, sy += dy)
     {
       for (x = 0, sx = dx / 2 - 0.5; x < outCols; ++x, sx += dx )
         {
@@ -189,26 +199,41 @@ fattal02_restrict (const gfloat        *input,
 
 
 static void
-fattal02_prolongate (const gfloat        *input,
-                     const GeglRectangle *extent_i,
-                     gfloat              *output,
-                     const GeglRectangle *extent_o)
+fattal02_restrict (const gfloat        *input,
+                   const GeglRectangle *extent_i,
+                   gfloat              *output,
+                   const GeglRectangle *extent_o)
+{
+  Fattal02ResampleData data = { input, extent_i, output, extent_o };
+
+  solver_distribute_rows (extent_o->height, extent_i->width * 2,
+                          (GeglParallelDistributeRangeFunc) fattal02_restrict_rows,
+                          &data);
+}
+
+
+static void
+fattal02_prolongate_rows (gsize                 offset,
+                          gsize                 size,
+                          Fattal02ResampleData *data)
 {
-  gfloat dx = (gfloat)extent_i->width  / (gfloat)extent_o->width,
-         dy = (gfloat)extent_i->height / (gfloat)extent_o->height;
+  const gfloat *input  = data->input;
+  gfloat       *output = data->output;
 
-  const guint outRows = extent_o->height,
-              outCols = extent_o->width;
+  gfloat dx = (gfloat)data->extent_i->width  / (gfloat)data->extent_o->width,
+         dy = (gfloat)data->extent_i->height / (gfloat)data->extent_o->height;
 
-  const gfloat inRows = extent_i->height,
-               inCols = extent_i->width;
+  const guint outCols = data->extent_o->width;
+
+  const gfloat inRows = data->extent_i->height,
+               inCols = data->extent_i->width;
 
   const float filterSize = 1;
 
   gfloat sx, sy;
   guint   x,  y;
 
-  for (y = 0, sy = -dy / 2; y < outRows; ++y, sy += dy)
+  for (y = offset, sy = -dy / 2 + y * dy; y < offset + size; ++y, sy += dy)
     {
       for (x = 0, sx = -dx / 2; x < outCols; ++x, sx += dx )
         {
@@ -241,6 +266,20 @@ fattal02_prolongate (const gfloat        *input,
 }
 
 
+static void
+fattal02_prolongate (const gfloat        *input,
+                     const GeglRectangle *extent_i,
+                     gfloat              *output,
+                     const GeglRectangle *extent_o)
+{
+  Fattal02ResampleData data = { input, extent_i, output, extent_o };
+
+  solver_distribute_rows (extent_o->height, extent_o->width * 4,
+                          (GeglParallelDistributeRangeFunc) fattal02_prolongate_rows,
+                          &data);
+}
+
+
 static void
 fattal02_exact_solution (gfloat              *F,
                          const GeglRectangle *extent_f,
@@ -276,19 +315,33 @@ fattal02_smooth (gfloat              *U,
 }
 
 
+typedef struct
+{
+  gfloat              *D;
+  const GeglRectangle *extent_d;
+  gfloat              *U;
+  const GeglRectangle *extent_u;
+  gfloat              *F;
+  const GeglRectangle *extent_f;
+} Fattal02DefectData;
+
+
 static void
-fattal02_calculate_defect (gfloat              *D,
-                           const GeglRectangle *extent_d,
-                           gfloat              *U,
-                           const GeglRectangle *extent_u,
-                           gfloat              *F,
-                           const GeglRectangle *extent_f)
+fattal02_calculate_defect_rows (gsize               offset,
+                                gsize               size,
+                                Fattal02DefectData *data)
 {
+  gfloat              *D        = data->D,
+                      *U        = data->U,
+                      *F        = data->F;
+  const GeglRectangle *extent_d = data->extent_d,
+                      *extent_u = data->extent_u,
+                      *extent_f = data->extent_f;
   guint sx = extent_f->width,
         sy = extent_f->height;
   guint x, y;
 
-  for (y = 0; y < sy; ++y)
+  for (y = offset; y < offset + size; ++y)
     {
       for (x = 0; x < sx; ++x)
         {
@@ -309,6 +362,22 @@ fattal02_calculate_defect (gfloat              *D,
 }
 
 
+static void
+fattal02_calculate_defect (gfloat              *D,
+                           const GeglRectangle *extent_d,
+                           gfloat              *U,
+                           const GeglRectangle *extent_u,
+                           gfloat              *F,
+                           const GeglRectangle *extent_f)
+{
+  Fattal02DefectData data = { D, extent_d, U, extent_u, F, extent_f };
+
+  solver_distribute_rows (extent_f->height, extent_f->width,
+                          (GeglParallelDistributeRangeFunc) fattal02_calculate_defect_rows,
+                          &data);
+}
+
+
 static void
 fattal02_solve_pde_multigrid (gfloat              *F,
                               const GeglRectangle *extent_f,
@@ -372,6 +441,10 @@ fattal02_solve_pde_multigrid (gfloat              *F,
     {
       guint cycle;
 
+      /* the result is thrown away when the job was cancelled */
+      if (gegl_parallel_is_cancelled ())
+        break;
+
       /* 4. interpolate sollution from last coarse-grid to finer-grid
        * interpolate from level k+1 to level k (finer-grid)
        */
@@ -481,70 +554,86 @@ asolve (gulong n,
         gfloat x[],
         gint   itrnsp)
 {
-  guint i;
-
-  for (i = 0; i < n; ++i)
-    x[i] = -4 * b[i];
+  solver_scale (n, -4.0f, b, x);
 }
 
+typedef struct
+{
+  guint         rows;
+  guint         cols;
+  const gfloat *x;
+  gfloat       *res;
+} AtimesData;
+
+/* res = A x, where A is the laplacian with neumann boundary conditions;
+ * processes the rows [offset, offset + size)
+ */
 static void
-atimes (guint  rows,
-        guint  cols,
-        gfloat x[],
-        gfloat res[],
-        gint   itrnsp)
+atimes_rows (gsize       offset,
+             gsize       size,
+             AtimesData *data)
 {
-  guint r, c;
+  const guint            rows = data->rows,
+                         cols = data->cols;
+  const gfloat *restrict x    = data->x;
+  gfloat       *restrict res  = data->res;
+  guint                  r, c;
 
 #define IDX(R,C) ((R) * cols + (C))
 
-  for (r = 1; r < rows - 1; ++r)
+  for (r = offset; r < offset + size; ++r)
     {
-      for (c = 1; c < cols - 1; ++c)
+      const gfloat *up     = r > 0        ? &x[IDX (r - 1, 0)] : NULL;
+      const gfloat *down   = r < rows - 1 ? &x[IDX (r + 1, 0)] : NULL;
+      const gfloat *row    = &x[IDX (r, 0)];
+      gfloat       *out    = &res[IDX (r, 0)];
+      const gint    n_vert = (up != NULL) + (down != NULL);
+
+      /* the first and last columns, with one horizontal neighbor */
+      out[0]        = row[1]        - (1 + n_vert) * row[0];
+      out[cols - 1] = row[cols - 2] - (1 + n_vert) * row[cols - 1];
+
+      if (up)
         {
-          res[IDX (r,c)] = x[IDX (r-1,c)] + x[IDX (r+1,c)] +
-            x[IDX (r,c-1)] + x[IDX (r,c+1)] - 4*x[IDX (r,c)];
+          out[0]        += up[0];
+          out[cols - 1] += up[cols - 1];
+        }
+      if (down)
+        {
+          out[0]        += down[0];
+          out[cols - 1] += down[cols - 1];
         }
-    }
 
-  for (r = 1; r < rows - 1; ++r)
-    {
-      res[IDX (r, 0)] =     x[IDX (r - 1, 0)] +
-                            x[IDX (r + 1, 0)] +
-                            x[IDX (r    , 1)] -
-                        3 * x[IDX (r    , 0)];
-
-      res[IDX (r, cols - 1)] =     x[IDX (r - 1, cols - 1)] +
-                                   x[IDX (r + 1, cols - 1)] +
-                                   x[IDX (r    , cols - 2)] -
-                               3 * x[IDX (r    , cols - 1)];
-    }
+      /* the inner columns */
+      if (up && down)
+        {
+          for (c = 1; c < cols - 1; ++c)
+            out[c] = up[c] + down[c] + row[c - 1] + row[c + 1] - 4 * row[c];
+        }
+      else
+        {
+          const gfloat *vert = up ? up : down;
 
-  for (c = 1; c < cols - 1; ++c)
-    {
-      res[IDX (0, c)] =     x[IDX (1, c    )] +
-                            x[IDX (0, c - 1)] +
-                            x[IDX (0, c + 1)] -
-                        3 * x[IDX (0, c     )];
-
-      res[IDX (rows - 1, c)] =     x[IDX (rows - 2, c    )] +
-                                   x[IDX (rows - 1, c - 1)] +
-                                   x[IDX (rows - 1, c + 1)] -
-                               3 * x[IDX (rows - 1, c    )];
+          for (c = 1; c < cols - 1; ++c)
+            out[c] = vert[c] + row[c - 1] + row[c + 1] - 3 * row[c];
+        }
     }
 
-  res[IDX (0       ,        0)] =     x[IDX (1       ,        0)] +
-                                      x[IDX (0       ,        1)] -
-                                  2 * x[IDX (0       ,        0)];
-  res[IDX (rows - 1,        0)] =     x[IDX (rows - 2,        0)] +
-                                      x[IDX (rows - 1,        1)] -
-                                  2 * x[IDX (rows - 1,        0)];
-  res[IDX (0       , cols - 1)] =     x[IDX (1       , cols - 1)] +
-                                      x[IDX (0       , cols - 2)] -
-                                  2 * x[IDX (0       , cols - 1)];
-  res[IDX (rows - 1, cols - 1)] =     x[IDX (rows - 2, cols - 1)] +
-                                      x[IDX (rows - 1, cols - 2)] -
-                                  2 * x[IDX (rows - 1, cols - 1)];
+#undef IDX
+}
+
+static void
+atimes (guint  rows,
+        guint  cols,
+        gfloat x[],
+        gfloat res[],
+        gint   itrnsp)
+{
+  AtimesData data = { rows, cols, x, res };
+
+  solver_distribute_rows (rows, cols,
+                          (GeglParallelDistributeRangeFunc) atimes_rows,
+                          &data);
 }
 
 static gfloat
@@ -556,10 +645,7 @@ snrm (gulong n,
 
   if (itol <= 3)
     {
-      gfloat ans = 0.0;
-      for (i = 0; i < n; ++i)
-          ans += sx[i] * sx[i];
-      return sqrtf (ans);
+      return sqrtf (solver_dot (n, sx, sx));
     }
   else
     {
@@ -589,7 +675,6 @@ linbcg (guint   rows,
 {
   guint  n = rows * cols;
 
-  gulong j;
   gfloat ak,akden,bk,bkden,bknum,bnrm,dxnrm,xnrm,zm1nrm,znrm;
   gfloat *p,*pp,*r,*rr,*z,*zz;
 
@@ -605,11 +690,8 @@ linbcg (guint   rows,
 
   *iter=0;
   atimes (rows, cols, x, r, 0);
-  for (j = 0; j < n; ++j)
-    {
-       r[j] = b[j] - r[j];
-      rr[j] = r[j];
-    }
+  solver_sub (n, b, r);
+  memcpy (rr, r, n * sizeof (gfloat));
 
   atimes (rows, cols, r, rr, 0);       /* minimum residual */
   znrm = 1.0;
@@ -637,53 +719,38 @@ linbcg (guint   rows,
 
   asolve (n, r, z, 0);
 
-  while (*iter <= itmax)
+  while (*iter <= itmax && ! gegl_parallel_is_cancelled ())
     {
       ++(*iter);
 
       zm1nrm = znrm;
       asolve (n, rr, zz, 1);
-      for (bknum = 0.0, j = 0; j < n; ++j)
-        {
-          bknum += z[j] * rr[j];
-        }
+      bknum = solver_dot (n, z, rr);
 
       if (*iter == 1)
         {
-          for (j = 0; j < n; ++j)
-            {
-               p[j] =  z[j];
-              pp[j] = zz[j];
-            }
+          memcpy (p,   z, n * sizeof (gfloat));
+          memcpy (pp, zz, n * sizeof (gfloat));
         }
       else
         {
           bk = bknum / bkden;
 
-          for (j = 0; j < n; ++j)
-            {
-               p[j] = bk *  p[j] +  z[j];
-              pp[j] = bk * pp[j] + zz[j];
-            }
+          solver_xpby (n,  z, bk,  p);
+          solver_xpby (n, zz, bk, pp);
         }
 
       bkden = bknum;
       atimes (rows, cols, p, z, 0);
 
-      for (akden = 0.0, j = 0; j < n; ++j)
-        {
-          akden += z[j] * pp[j];
-        }
+      akden = solver_dot (n, z, pp);
 
       ak = bknum / akden;
       atimes (rows, cols, pp, zz, 1);
 
-      for (j = 0; j < n; ++j)
-        {
-           x[j] += ak *  p[j];
-           r[j] -= ak *  z[j];
-          rr[j] -= ak * zz[j];
-        }
+      solver_axpy (n,  ak,  p,  x);
+      solver_axpy (n, -ak,  z,  r);
+      solver_axpy (n, -ak, zz, rr);
 
       asolve (n, r, z, 0);
 
@@ -965,7 +1032,11 @@ fattal02_FI_matrix (gfloat               *FI,
 
   fi = g_new (gfloat*, levels);
 
-  fi[levels - 1] = g_new (gfloat, level_extent.width * level_extent.height);
+  /* with a single level, the coarsest level is the result */
+  if (levels > 1)
+    fi[levels - 1] = g_new (gfloat, level_extent.width * level_extent.height);
+  else
+    fi[levels - 1] = FI;
 
   for (i = 0; i < level_extent.width * level_extent.height; ++i)
     {
@@ -1000,7 +1071,7 @@ fattal02_FI_matrix (gfloat               *FI,
           fi[i - 1] = g_new (gfloat,
                              level_extent.width * level_extent.height);
         }
-      else
+      else if (i == 1)
         {
           fi[0] = FI;               /* highest level -> result */
         }
@@ -1178,8 +1249,10 @@ fattal02_tonemap (const gfloat        *input,   /* Y */
 
   GEGL_NOTE (GEGL_DEBUG_PROCESS, "recovering image");
 
-  /* solve pde and exponentiate (ie recover compressed image) */
-  U = g_new (gfloat, size);
+  /* solve pde and exponentiate (ie recover compressed image); the solver
+   * starts from U, and leaves it as is for images smaller than MINS
+   */
+  U = g_new0 (gfloat, size);
   fattal02_solve_pde_multigrid (divergence, extent, U, extent);
 
   for (i = 0; i < size; ++i)
@@ -1224,9 +1297,13 @@ fattal02_tonemap (const gfloat        *input,   /* Y */
 static void
 fattal02_prepare (GeglOperation *operation)
 {
-  const Babl *space = gegl_operation_get_source_space (operation, "input");
+  GeglProperties *o     = GEGL_PROPERTIES (operation);
+  const Babl     *space = gegl_operation_get_source_space (operation, "input");
   gegl_operation_set_format (operation, "input",  babl_format_with_space (OUTPUT_FORMAT, space));
   gegl_operation_set_format (operation, "output", babl_format_with_space (OUTPUT_FORMAT, space));
+
+  if (! o->user_data)
+    o->user_data = proxy_cache_new ();
 }
 
 static GeglRectangle
@@ -1257,16 +1334,20 @@ fattal02_process (GeglOperation       *operation,
                   const GeglRectangle *result,
                   gint                 level)
 {
-  const GeglProperties *o     = GEGL_PROPERTIES (operation);
+  GeglProperties   *o     = GEGL_PROPERTIES (operation);
   gfloat            noise;
   const Babl *out_format = gegl_operation_get_format (operation, "output");
   const Babl *space = babl_format_get_space (out_format);
 
-  const gint  pix_stride = 3; /* RGBA */
-  gfloat     *lum_in,
-             *lum_out,
-             *pix;
-  gint        i;
+  const gint     pix_stride = 3; /* RGBA */
+  gfloat        *lum_in,
+                *pix;
+  const gfloat  *lum_out;
+  GBytes        *state;
+  GeglRectangle  rect;
+  gdouble        params[3];
+  gint           stamp;
+  gint           i;
 
   g_return_val_if_fail (operation, FALSE);
   g_return_val_if_fail (input, FALSE);
@@ -1285,30 +1366,58 @@ fattal02_process (GeglOperation       *operation,
       noise = o->noise;
     }
 
+  /* At mipmap levels > 0 we solve for a downscaled proxy of the input */
+  proxy_get_rect (result, level, &rect);
+
   /* Obtain the pixel data */
-  lum_in  = g_new (gfloat, result->width * result->height);
-  lum_out = g_new (gfloat, result->width * result->height);
+  lum_in  = g_new (gfloat, rect.width * rect.height);
 
-  gegl_buffer_get (input, result, 1.0, babl_format_with_space ("Y float", space),
+  gegl_buffer_get (input, &rect, 1.0 / (1 << level),
+                   babl_format_with_space ("Y float", space),
                    lum_in, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  pix = g_new (gfloat, result->width * result->height * pix_stride);
-  gegl_buffer_get (input, result, 1.0, out_format,
+  pix = g_new (gfloat, rect.width * rect.height * pix_stride);
+  gegl_buffer_get (input, &rect, 1.0 / (1 << level), out_format,
                    pix, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  fattal02_tonemap (lum_in, result, lum_out, o->alpha, o->beta, noise);
+  /* The tonemapped luminance doesn't depend on the saturation, reuse it
+   * when only that changed
+   */
+  params[0] = o->alpha;
+  params[1] = o->beta;
+  params[2] = noise;
+
+  state = proxy_cache_lookup (o->user_data, operation, &rect, level,
+                              params, G_N_ELEMENTS (params), &stamp);
 
-  for (i = 0; i < result->width * result->height * pix_stride; ++i)
+  if (! state)
+    {
+      gfloat *lum = g_new (gfloat, rect.width * rect.height);
+
+      fattal02_tonemap (lum_in, &rect, lum, o->alpha, o->beta, noise);
+
+      state = g_bytes_new_take (lum,
+                                rect.width * rect.height * sizeof (gfloat));
+
+      proxy_cache_store (o->user_data, stamp, &rect, level,
+                         params, G_N_ELEMENTS (params), state);
+    }
+
+  lum_out = g_bytes_get_data (state, NULL);
+
+  for (i = 0; i < rect.width * rect.height * pix_stride; ++i)
     {
       pix[i] = (powf (pix[i] / lum_in[i / pix_stride],
                       o->saturation) *
                 lum_out[i / pix_stride]);
     }
 
-  gegl_buffer_set (output, result, 0, out_format, pix,
-                   GEGL_AUTO_ROWSTRIDE);
+  g_bytes_unref (state);
+
+  if (! gegl_parallel_is_cancelled ())
+    gegl_buffer_set (output, &rect, level, out_format, pix,
+                     GEGL_AUTO_ROWSTRIDE);
   g_free (pix);
-  g_free (lum_out);
   g_free (lum_in);
   return TRUE;
 }
@@ -1339,15 +1448,29 @@ fattal02_operation_process (GeglOperation        *operation,
                                    gegl_operation_context_get_level (context));
 }
 
+static void
+fattal02_finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, proxy_cache_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
+  GObjectClass             *object_class;
   GeglOperationClass       *operation_class;
   GeglOperationFilterClass *filter_class;
 
+  object_class    = G_OBJECT_CLASS (klass);
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  object_class->finalize = fattal02_finalize;
+
   filter_class->process = fattal02_process;
 
   operation_class->prepare                 = fattal02_prepare;
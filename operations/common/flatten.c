@@ -0,0 +1,731 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_LAYERS 16
+
+#ifdef GEGL_PROPERTIES
+
+enum_start (gegl_flatten_mode)
+  enum_value (GEGL_FLATTEN_MODE_NORMAL,      "normal",      N_("Normal"))
+  enum_value (GEGL_FLATTEN_MODE_MULTIPLY,    "multiply",    N_("Multiply"))
+  enum_value (GEGL_FLATTEN_MODE_SCREEN,      "screen",      N_("Screen"))
+  enum_value (GEGL_FLATTEN_MODE_OVERLAY,     "overlay",     N_("Overlay"))
+  enum_value (GEGL_FLATTEN_MODE_DARKEN,      "darken",      N_("Darken"))
+  enum_value (GEGL_FLATTEN_MODE_LIGHTEN,     "lighten",     N_("Lighten"))
+  enum_value (GEGL_FLATTEN_MODE_COLOR_DODGE, "color-dodge", N_("Color Dodge"))
+  enum_value (GEGL_FLATTEN_MODE_COLOR_BURN,  "color-burn",  N_("Color Burn"))
+  enum_value (GEGL_FLATTEN_MODE_HARD_LIGHT,  "hard-light",  N_("Hard Light"))
+  enum_value (GEGL_FLATTEN_MODE_SOFT_LIGHT,  "soft-light",  N_("Soft Light"))
+  enum_value (GEGL_FLATTEN_MODE_DIFFERENCE,  "difference",  N_("Difference"))
+  enum_value (GEGL_FLATTEN_MODE_EXCLUSION,   "exclusion",   N_("Exclusion"))
+  enum_value (GEGL_FLATTEN_MODE_PLUS,        "plus",        N_("Plus"))
+enum_end (GeglFlattenMode)
+
+property_int (layers, _("Layers"), 0)
+    description (_("Number of layers, connected to the aux1, aux2, ... "
+                   "pads, which are composited over the input from the "
+                   "bottom up"))
+    value_range (0, N_LAYERS)
+
+property_boolean (srgb, _("sRGB"), FALSE)
+    description (_("Use sRGB gamma instead of linear"))
+
+/* the blend mode and opacity of each layer; the optional mask of layer n,
+ * connected to the mask<n> pad, is multiplied by its opacity, like the aux
+ * input of gegl:opacity.
+ */
+#define layer_properties(n)                                           \
+  property_enum (mode##n, _("Mode " #n),                               \
+                 GeglFlattenMode, gegl_flatten_mode,                   \
+                 GEGL_FLATTEN_MODE_NORMAL)                             \
+      description (_("Blend mode of layer " #n))                       \
+                                                                       \
+  property_double (opacity##n, _("Opacity " #n), 1.0)                  \
+      description (_("Opacity of layer " #n))                          \
+      value_range (0.0, 1.0)
+
+layer_properties (1)
+layer_properties (2)
+layer_properties (3)
+layer_properties (4)
+layer_properties (5)
+layer_properties (6)
+layer_properties (7)
+layer_properties (8)
+layer_properties (9)
+layer_properties (10)
+layer_properties (11)
+layer_properties (12)
+layer_properties (13)
+layer_properties (14)
+layer_properties (15)
+layer_properties (16)
+
+#else
+
+#define GEGL_OP_BASE
+#define GEGL_OP_NAME     flatten
+#define GEGL_OP_C_SOURCE flatten.c
+
+#include "gegl-op.h"
+
+typedef struct
+{
+  GeglBuffer      *buffer;
+  GeglBuffer      *mask;
+  GeglFlattenMode  mode;
+  gfloat           opacity;
+} FlattenLayer;
+
+typedef struct
+{
+  GeglBuffer   *input;
+  GeglBuffer   *output;
+  const Babl   *format;
+  const Babl   *mask_format;
+  gint          level;
+  FlattenLayer  layers[N_LAYERS];
+  gint          n_layers;
+} FlattenData;
+
+static void
+get_layer (GeglProperties  *o,
+           gint             i,
+           GeglFlattenMode *mode,
+           gdouble         *opacity)
+{
+  switch (i)
+    {
+#define LAYER(n) \
+    case n: *mode = o->mode##n; *opacity = o->opacity##n; break;
+
+    LAYER (1)  LAYER (2)  LAYER (3)  LAYER (4)
+    LAYER (5)  LAYER (6)  LAYER (7)  LAYER (8)
+    LAYER (9)  LAYER (10) LAYER (11) LAYER (12)
+    LAYER (13) LAYER (14) LAYER (15) LAYER (16)
+
+#undef LAYER
+    }
+}
+
+static void
+attach (GeglOperation *operation)
+{
+  GParamSpec *pspec;
+  gint        i;
+
+  pspec = g_param_spec_object ("output",
+                               "Output",
+                               "Output pad for generated image buffer.",
+                               GEGL_TYPE_BUFFER,
+                               G_PARAM_READABLE |
+                               GEGL_PARAM_PAD_OUTPUT);
+  gegl_operation_create_pad (operation, pspec);
+  g_param_spec_sink (pspec);
+
+  pspec = g_param_spec_object ("input",
+                               "Input",
+                               "Input pad, for image buffer input.",
+                               GEGL_TYPE_BUFFER,
+                               G_PARAM_READWRITE |
+                               GEGL_PARAM_PAD_INPUT);
+  gegl_operation_create_pad (operation, pspec);
+  g_param_spec_sink (pspec);
+
+  for (i = 1; i <= N_LAYERS; i++)
+    {
+      gchar name[32];
+      gchar nick[32];
+
+      sprintf (name, "aux%d",  i);
+      sprintf (nick, "Aux %d", i);
+
+      pspec = g_param_spec_object (name,
+                                   nick,
+                                   "Layer image buffer input pad.",
+                                   GEGL_TYPE_BUFFER,
+                                   G_PARAM_READWRITE |
+                                   GEGL_PARAM_PAD_INPUT);
+      gegl_operation_create_pad (operation, pspec);
+      g_param_spec_sink (pspec);
+
+      sprintf (name, "mask%d",  i);
+      sprintf (nick, "Mask %d", i);
+
+      pspec = g_param_spec_object (name,
+                                   nick,
+                                   "Layer mask buffer input pad.",
+                                   GEGL_TYPE_BUFFER,
+                                   G_PARAM_READWRITE |
+                                   GEGL_PARAM_PAD_INPUT);
+      gegl_operation_create_pad (operation, pspec);
+      g_param_spec_sink (pspec);
+    }
+}
+
+static void
+prepare (GeglOperation *operation)
+{
+  GeglProperties *o     = GEGL_PROPERTIES (operation);
+  const Babl     *space = gegl_operation_get_source_space (operation, "input");
+  const Babl     *format;
+  const Babl     *mask_format;
+  gint            i;
+
+  if (! space)
+    space = gegl_operation_get_source_space (operation, "aux1");
+
+  if (o->srgb)
+    format = babl_format_with_space ("R~aG~aB~aA float", space);
+  else
+    format = babl_format_with_space ("RaGaBaA float", space);
+
+  mask_format = babl_format_with_space ("Y float", space);
+
+  gegl_operation_set_format (operation, "input",  format);
+  gegl_operation_set_format (operation, "output", format);
+
+  for (i = 1; i <= N_LAYERS; i++)
+    {
+      gchar name[32];
+
+      sprintf (name, "aux%d", i);
+      gegl_operation_set_format (operation, name, format);
+
+      sprintf (name, "mask%d", i);
+      gegl_operation_set_format (operation, name, mask_format);
+    }
+}
+
+static GeglRectangle
+get_bounding_box (GeglOperation *operation)
+{
+  GeglProperties *o      = GEGL_PROPERTIES (operation);
+  GeglRectangle  *in_rect;
+  GeglRectangle   result = {};
+  gint            i;
+
+  in_rect = gegl_operation_source_get_bounding_box (operation, "input");
+
+  if (in_rect)
+    result = *in_rect;
+
+  for (i = 1; i <= o->layers; i++)
+    {
+      GeglRectangle *aux_rect;
+      gchar          name[32];
+
+      sprintf (name, "aux%d", i);
+
+      aux_rect = gegl_operation_source_get_bounding_box (operation, name);
+
+      if (aux_rect)
+        gegl_rectangle_bounding_box (&result, &result, aux_rect);
+    }
+
+  return result;
+}
+
+static GeglRectangle
+get_required_for_output (GeglOperation       *operation,
+                         const gchar         *input_pad,
+                         const GeglRectangle *roi)
+{
+  GeglProperties *o      = GEGL_PROPERTIES (operation);
+  GeglRectangle   result = {};
+
+  if (! strcmp (input_pad, "input"))
+    {
+      result = *roi;
+    }
+  else
+    {
+      gint i = 0;
+
+      if (g_str_has_prefix (input_pad, "aux"))
+        i = atoi (input_pad + 3);
+      else if (g_str_has_prefix (input_pad, "mask"))
+        i = atoi (input_pad + 4);
+
+      if (i >= 1 && i <= o->layers)
+        result = *roi;
+    }
+
+  return result;
+}
+
+/* whether @buffer has any pixels in @area, given at @level */
+static gboolean
+flatten_intersects (GeglBuffer          *buffer,
+                    const GeglRectangle *area,
+                    gint                 level)
+{
+  const GeglRectangle *abyss = gegl_buffer_get_abyss (buffer);
+  GeglRectangle        rect;
+
+  rect.x      = abyss->x >> level;
+  rect.y      = abyss->y >> level;
+  rect.width  = ((abyss->x + abyss->width  + (1 << level) - 1) >> level) -
+                rect.x;
+  rect.height = ((abyss->y + abyss->height + (1 << level) - 1) >> level) -
+                rect.y;
+
+  return gegl_rectangle_intersect (NULL, &rect, area);
+}
+
+/* composites the pixels of a layer, with the weights of its opacity and
+ * optional mask, over the pixels of dst, except for those whose topmost
+ * opaque layer, given by start, isn't below the layer.  the modes use the
+ * formulas of the SVG 1.2 compositing operations, like gegl:over and the
+ * generated svg: operations.
+ */
+#define FLATTEN_BLEND(alpha_formula, formula)                               \
+  for (i = 0; i < length; i++)                                               \
+    {                                                                        \
+      gfloat w, aA, aB, aD;                                                  \
+      gint   c;                                                              \
+                                                                             \
+      if (start[i] >= k)                                                     \
+        continue;                                                            \
+                                                                             \
+      w  = mask ? opacity * mask[i] : opacity;                               \
+      aA = src[4 * i + 3] * w;                                               \
+      aB = dst[4 * i + 3];                                                   \
+      aD = alpha_formula;                                                    \
+                                                                             \
+      for (c = 0; c < 3; c++)                                                \
+        {                                                                    \
+          const gfloat cA = src[4 * i + c] * w;                              \
+          const gfloat cB = dst[4 * i + c];                                  \
+                                                                             \
+          dst[4 * i + c] = formula;                                          \
+        }                                                                    \
+      dst[4 * i + 3] = aD;                                                   \
+    }
+
+#define FLATTEN_ALPHA (aA + aB - aA * aB)
+
+static void
+flatten_composite (GeglFlattenMode  mode,
+                   const gfloat    *src,
+                   const gfloat    *mask,
+                   gfloat           opacity,
+                   gfloat          *dst,
+                   const gint      *start,
+                   gint             k,
+                   gint             length)
+{
+  gint i;
+
+  switch (mode)
+    {
+    case GEGL_FLATTEN_MODE_NORMAL:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     cA + cB * (1.0f - aA))
+      break;
+
+    case GEGL_FLATTEN_MODE_MULTIPLY:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (cA * cB + cA * (1 - aB) + cB * (1 - aA), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_SCREEN:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (cA + cB - cA * cB, 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_OVERLAY:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (2 * cB > aB ?
+                            2 * cA * cB + cA * (1 - aB) + cB * (1 - aA) :
+                            aA * aB - 2 * (aB - cB) * (aA - cA) +
+                            cA * (1 - aB) + cB * (1 - aA), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_DARKEN:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (MIN (cA * aB, cB * aA) +
+                            cA * (1 - aB) + cB * (1 - aA), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_LIGHTEN:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (MAX (cA * aB, cB * aA) +
+                            cA * (1 - aB) + cB * (1 - aA), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_COLOR_DODGE:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (cA * aB + cB * aA >= aA * aB ?
+                            aA * aB + cA * (1 - aB) + cB * (1 - aA) :
+                            (cA == aA ? 1 : cB * aA / (aA == 0 ? 1 : 1 - cA / aA)) +
+                            cA * (1 - aB) + cB * (1 - aA), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_COLOR_BURN:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (cA * aB + cB * aA <= aA * aB ?
+                            cA * (1 - aB) + cB * (1 - aA) :
+                            (cA == 0 ? 1 : (aA * (cA * aB + cB * aA - aA * aB) / cA) +
+                             cA * (1 - aB) + cB * (1 - aA)), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_HARD_LIGHT:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (2 * cA < aA ?
+                            2 * cA * cB + cA * (1 - aB) + cB * (1 - aA) :
+                            aA * aB - 2 * (aB - cB) * (aA - cA) +
+                            cA * (1 - aB) + cB * (1 - aA), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_SOFT_LIGHT:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (2 * cA < aA ?
+                            cB * (aA - (aB == 0 ? 1 : 1 - cB / aB) * (2 * cA - aA)) +
+                            cA * (1 - aB) + cB * (1 - aA) :
+                            8 * cB <= aB ?
+                            cB * (aA - (aB == 0 ? 1 : 1 - cB / aB) * (2 * cA - aA) *
+                                  (aB == 0 ? 3 : 3 - 8 * cB / aB)) +
+                            cA * (1 - aB) + cB * (1 - aA) :
+                            (aA * cB + (aB == 0 ? 0 : sqrt (cB / aB) * aB - cB) *
+                                       (2 * cA - aA)) +
+                            cA * (1 - aB) + cB * (1 - aA), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_DIFFERENCE:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP (cA + cB - 2 * (MIN (cA * aB, cB * aA)), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_EXCLUSION:
+      FLATTEN_BLEND (FLATTEN_ALPHA,
+                     CLAMP ((cA * aB + cB * aA - 2 * cA * cB) +
+                            cA * (1 - aB) + cB * (1 - aA), 0, aD))
+      break;
+
+    case GEGL_FLATTEN_MODE_PLUS:
+      FLATTEN_BLEND (MIN (aA + aB, 1),
+                     CLAMP (cA + cB, 0, aD))
+      break;
+    }
+}
+
+#undef FLATTEN_ALPHA
+#undef FLATTEN_BLEND
+
+static void
+flatten_area (const GeglRectangle *area,
+              const FlattenData   *data)
+{
+  const FlattenLayer *layers[N_LAYERS];
+  gint                layer_items[N_LAYERS];
+  gint                mask_items[N_LAYERS];
+  GeglBufferIterator *iter;
+  gint               *start      = NULL;
+  gint                max_length = 0;
+  gint                input_item = -1;
+  gint                n          = 0;
+  gint                k;
+
+  /* layers which have no pixels in the area don't contribute to it */
+  for (k = 0; k < data->n_layers; k++)
+    {
+      const FlattenLayer *layer = &data->layers[k];
+
+      if (flatten_intersects (layer->buffer, area, data->level) &&
+          (! layer->mask ||
+           flatten_intersects (layer->mask, area, data->level)))
+        {
+          layers[n++] = layer;
+        }
+    }
+
+  iter = gegl_buffer_iterator_new (data->output, area, data->level,
+                                   data->format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE,
+                                   2 + 2 * n);
+
+  if (data->input)
+    {
+      input_item = gegl_buffer_iterator_add (iter, data->input, area,
+                                             data->level, data->format,
+                                             GEGL_ACCESS_READ,
+                                             GEGL_ABYSS_NONE);
+    }
+
+  for (k = 0; k < n; k++)
+    {
+      layer_items[k] = gegl_buffer_iterator_add (iter, layers[k]->buffer,
+                                                 area, data->level,
+                                                 data->format,
+                                                 GEGL_ACCESS_READ,
+                                                 GEGL_ABYSS_NONE);
+
+      if (layers[k]->mask)
+        {
+          mask_items[k] = gegl_buffer_iterator_add (iter, layers[k]->mask,
+                                                    area, data->level,
+                                                    data->mask_format,
+                                                    GEGL_ACCESS_READ,
+                                                    GEGL_ABYSS_NONE);
+        }
+      else
+        {
+          mask_items[k] = -1;
+        }
+    }
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *out        = iter->items[0].data;
+      gint    length     = iter->length;
+      gint    remaining  = length;
+      gint    min_start;
+      gint    i;
+
+      if (length > max_length)
+        {
+          g_free (start);
+
+          max_length = length;
+          start      = g_new (gint, max_length);
+        }
+
+      /* find the topmost normal layer which is opaque at each pixel, if
+       * any; neither the input nor the layers below it contribute to the
+       * pixel.
+       */
+      for (i = 0; i < length; i++)
+        start[i] = -1;
+
+      for (k = n - 1; k >= 0 && remaining > 0; k--)
+        {
+          const gfloat *src;
+          const gfloat *mask    = NULL;
+          const gfloat  opacity = layers[k]->opacity;
+
+          if (layers[k]->mode != GEGL_FLATTEN_MODE_NORMAL)
+            continue;
+
+          src = iter->items[layer_items[k]].data;
+
+          if (mask_items[k] >= 0)
+            mask = iter->items[mask_items[k]].data;
+
+          for (i = 0; i < length; i++)
+            {
+              if (start[i] < 0)
+                {
+                  gfloat w = mask ? opacity * mask[i] : opacity;
+
+                  if (src[4 * i + 3] * w == 1.0f)
+                    {
+                      start[i] = k;
+                      remaining--;
+                    }
+                }
+            }
+        }
+
+      if (input_item >= 0)
+        {
+          const gfloat *in = iter->items[input_item].data;
+
+          if (in != out)
+            memcpy (out, in, sizeof (gfloat) * 4 * length);
+        }
+      else
+        {
+          memset (out, 0, sizeof (gfloat) * 4 * length);
+        }
+
+      min_start = remaining > 0 ? -1 : n;
+
+      for (i = 0; i < length; i++)
+        {
+          const FlattenLayer *layer;
+          const gfloat       *src;
+          gfloat              w;
+          gint                c;
+
+          min_start = MIN (min_start, start[i]);
+
+          if (start[i] < 0)
+            continue;
+
+          layer = layers[start[i]];
+          src   = (const gfloat *) iter->items[layer_items[start[i]]].data +
+                  4 * i;
+          w     = layer->opacity;
+
+          if (mask_items[start[i]] >= 0)
+            w *= ((const gfloat *) iter->items[mask_items[start[i]]].data)[i];
+
+          for (c = 0; c < 3; c++)
+            out[4 * i + c] = src[c] * w;
+          out[4 * i + 3] = 1.0f;
+        }
+
+      /* the layers up to the lowest opaque one only contribute to the
+       * pixels they cover
+       */
+      for (k = MAX (min_start + 1, 0); k < n; k++)
+        {
+          const gfloat *mask = NULL;
+
+          if (mask_items[k] >= 0)
+            mask = iter->items[mask_items[k]].data;
+
+          flatten_composite (layers[k]->mode,
+                             iter->items[layer_items[k]].data,
+                             mask, layers[k]->opacity,
+                             out, start, k, length);
+        }
+    }
+
+  g_free (start);
+}
+
+static gboolean
+process (GeglOperation        *operation,
+         GeglOperationContext *context,
+         const gchar          *output_prop,
+         const GeglRectangle  *result,
+         gint                  level)
+{
+  GeglProperties *o             = GEGL_PROPERTIES (operation);
+  GeglRectangle   scaled_result = *result;
+  FlattenData     data;
+  gint            i;
+
+  /* like gegl_operation_composer_process(), the area is given at level 0 */
+  if (level)
+    {
+      scaled_result.x      >>= level;
+      scaled_result.y      >>= level;
+      scaled_result.width  >>= level;
+      scaled_result.height >>= level;
+      result = &scaled_result;
+    }
+
+  data.input       = GEGL_BUFFER (gegl_operation_context_get_object (context,
+                                                                     "input"));
+  data.format      = gegl_operation_get_format (operation, "output");
+  data.mask_format = gegl_operation_get_format (operation, "mask1");
+  data.level       = level;
+  data.n_layers    = 0;
+
+  for (i = 1; i <= o->layers; i++)
+    {
+      FlattenLayer    *layer   = &data.layers[data.n_layers];
+      GeglFlattenMode  mode    = GEGL_FLATTEN_MODE_NORMAL;
+      gdouble          opacity = 0.0;
+      gchar            name[32];
+
+      get_layer (o, i, &mode, &opacity);
+
+      sprintf (name, "aux%d", i);
+      layer->buffer = GEGL_BUFFER (gegl_operation_context_get_object (context,
+                                                                      name));
+
+      sprintf (name, "mask%d", i);
+      layer->mask = GEGL_BUFFER (gegl_operation_context_get_object (context,
+                                                                    name));
+
+      layer->mode    = mode;
+      layer->opacity = opacity;
+
+      if (layer->buffer && opacity > 0.0)
+        data.n_layers++;
+    }
+
+  /* pass the input, or a single opaque normal layer, directly through */
+  if (data.n_layers == 0)
+    {
+      if (data.input)
+        {
+          gegl_operation_context_set_object (context, "output",
+                                             G_OBJECT (data.input));
+        }
+
+      return TRUE;
+    }
+  else if (! data.input                                     &&
+           data.n_layers == 1                               &&
+           data.layers[0].mode    == GEGL_FLATTEN_MODE_NORMAL &&
+           data.layers[0].opacity == 1.0f                     &&
+           ! data.layers[0].mask)
+    {
+      gegl_operation_context_set_object (context, "output",
+                                         G_OBJECT (data.layers[0].buffer));
+
+      return TRUE;
+    }
+
+  if (data.input)
+    {
+      data.output = gegl_operation_context_get_output_maybe_in_place (
+        operation, context, data.input, result);
+    }
+  else
+    {
+      data.output = gegl_operation_context_get_target (context, "output");
+    }
+
+  gegl_parallel_distribute_area (
+    result, gegl_operation_get_pixels_per_thread (operation) / data.n_layers,
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) flatten_area,
+    &data);
+
+  return TRUE;
+}
+
+static void
+gegl_op_class_init (GeglOpClass *klass)
+{
+  GeglOperationClass *operation_class;
+
+  operation_class = GEGL_OPERATION_CLASS (klass);
+
+  operation_class->attach                    = attach;
+  operation_class->prepare                   = prepare;
+  operation_class->get_bounding_box          = get_bounding_box;
+  operation_class->get_required_for_output   = get_required_for_output;
+  operation_class->get_invalidated_by_change = get_required_for_output;
+  operation_class->process                   = process;
+
+  operation_class->threaded      = TRUE;
+  operation_class->want_in_place = TRUE;
+
+  gegl_operation_class_set_keys (operation_class,
+    "name",        "gegl:flatten",
+    "title",       _("Flatten"),
+    "categories",  "compositors:blend",
+    "description", _("Composite a stack of layers over the input in a "
+                     "single pass, each with its own blend mode, opacity "
+                     "and mask"),
+    NULL);
+}
+
+#endif
@@ -61,6 +61,14 @@ property_enum (abyss_policy, _("Abyss policy"), GeglGaussianBlurPolicy,
 property_boolean (clip_extent, _("Clip to the input extent"), TRUE)
    description (_("Should the output extent be clipped to the input extent"))
 
+property_double (max_error, _("Maximal error"), 0.0)
+   description (_("Maximal error, relative to the range of the input, "
+                  "allowed for blurring a decimated copy of the input, which "
+                  "is faster for large blurs; 0.0 always blurs the input "
+                  "itself"))
+   value_range (0.0, 0.1)
+   ui_range    (0.0, 0.05)
+
 #else
 
 #define GEGL_OP_META
@@ -93,11 +101,13 @@ attach (GeglOperation *operation)
   gegl_operation_meta_redirect (operation, "abyss-policy", hblur, "abyss-policy");
   gegl_operation_meta_redirect (operation, "filter",       hblur, "filter");
   gegl_operation_meta_redirect (operation, "clip-extent",  hblur, "clip-extent");
+  gegl_operation_meta_redirect (operation, "max-error",    hblur, "max-error");
 
   gegl_operation_meta_redirect (operation, "std-dev-y",    vblur, "std-dev");
   gegl_operation_meta_redirect (operation, "abyss-policy", vblur, "abyss-policy");
   gegl_operation_meta_redirect (operation, "filter",       vblur, "filter");
   gegl_operation_meta_redirect (operation, "clip-extent",  vblur, "clip-extent");
+  gegl_operation_meta_redirect (operation, "max-error",    vblur, "max-error");
 }
 
 static void
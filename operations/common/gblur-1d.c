@@ -64,6 +64,14 @@ property_enum (abyss_policy, _("Abyss policy"), GeglGblur1dPolicy,
 property_boolean (clip_extent, _("Clip to the input extent"), TRUE)
   description (_("Should the output extent be clipped to the input extent"))
 
+property_double (max_error, _("Maximal error"), 0.0)
+  description (_("Maximal error, relative to the range of the input, "
+                 "allowed for blurring a decimated copy of the input, which "
+                 "is faster for large blurs; 0.0 always blurs the input "
+                 "itself"))
+  value_range (0.0, 0.1)
+  ui_range    (0.0, 0.05)
+
 #else
 
 #define GEGL_OP_FILTER
@@ -71,6 +79,7 @@ property_boolean (clip_extent, _("Clip to the input extent"), TRUE)
 #define GEGL_OP_C_SOURCE gblur-1d.c
 
 #include "gegl-op.h"
+#include "pyramid-common.h"
 
 /**********************************************
  *
@@ -78,15 +87,14 @@ property_boolean (clip_extent, _("Clip to the input extent"), TRUE)
  *
  **********************************************/
 
-typedef void (*IirYoungBlur1dFunc) (gfloat           *buf,
-                                    gdouble          *tmp,
-                                    const gdouble    *b,
-                                    gdouble         (*m)[3],
-                                    const gfloat     *iminus,
-                                    const gfloat     *uplus,
-                                    const gint        len,
-                                    const gint        components,
-                                    GeglAbyssPolicy   policy);
+/* the number of adjacent lines (rows for the horizontal blur, columns for
+ * the vertical one) filtered at once.  The recursion runs along the lines,
+ * while the inner loops run across the interleaved components of the lines
+ * of a block, so that they get vectorized by the compiler; the
+ * gegl-common-x86_64-v2/v3 and gegl-common-arm-neon builds of this file
+ * thereby get SSE4, AVX2 and NEON versions of the filter.
+ */
+#define IIR_BLOCK_LINES 16
 
 static const gfloat white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
 static const gfloat black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
@@ -133,552 +141,279 @@ iir_young_find_constants (gfloat   sigma,
   b[3] = a3;
 }
 
+/* The filtered lines are stored interleaved: sample i of the n_lines lines,
+ * each having nc components, is stored at buf[i * n], with
+ * n = n_lines * nc.  The len samples of the lines are preceded and followed
+ * by 3 samples of padding.
+ */
 static void
 get_boundaries (GeglAbyssPolicy   policy,
-                gfloat           *buf,
+                const gfloat     *buf,
                 gint              len,
                 gint              nc,
-                const gfloat    **out_iminus,
-                const gfloat    **out_uplus)
+                gint              n,
+                gdouble          *iminus,
+                gdouble          *uplus)
 {
-  const gfloat *iminus;
-  const gfloat *uplus;
+  const gfloat *value;
+  gint          i;
 
   switch (policy)
     {
     case GEGL_ABYSS_CLAMP:
     default:
-      iminus = &buf[nc * 3]; uplus = &buf[nc * (len + 2)];
-      break;
+      for (i = 0; i < n; i++)
+        {
+          iminus[i] = buf[n * 3 + i];
+          uplus[i]  = buf[n * (len + 2) + i];
+        }
+      return;
 
     case GEGL_ABYSS_NONE:
-      iminus = uplus = &none[0];
+      value = &none[0];
       break;
 
     case GEGL_ABYSS_WHITE:
-      iminus = uplus = &white[0];
+      value = &white[0];
       break;
 
     case GEGL_ABYSS_BLACK:
-      iminus = uplus = &black[nc == 2 ? 2 : 0];
+      value = &black[nc == 2 ? 2 : 0];
       break;
     }
 
-  if (out_iminus != NULL)
-    *out_iminus = iminus;
-
-  if (out_uplus != NULL)
-    *out_uplus = uplus;
-}
-
-static inline void
-fix_right_boundary_y (gdouble        *buf,
-                      gdouble       (*m)[3],
-                      const gfloat   *uplus)
-{
-  gdouble u[3] = { buf[-1] - uplus[0],
-                   buf[-2] - uplus[0],
-                   buf[-3] - uplus[0] };
-  gint    i, k;
-
-  for (i = 0; i < 3; i++)
-    {
-      gdouble tmp = 0.;
-
-      for (k = 0; k < 3; k++)
-        tmp += m[i][k] * u[k];
-
-      buf[i] = tmp + uplus[0];
-    }
+  for (i = 0; i < n; i++)
+    iminus[i] = uplus[i] = value[i % nc];
 }
 
 static void
-iir_young_blur_1D_y (gfloat        *buf,
-                     gdouble       *tmp,
-                     const gdouble *b,
-                     gdouble      (*m)[3],
-                     const gfloat  *iminus,
-                     const gfloat  *uplus,
-                     const gint     len,
-                     const gint     components,
-                     GeglAbyssPolicy policy)
-{
-  gint    i, j;
-
-  for (i = 0; i < 3; i++, tmp++)
-    tmp[0] = iminus[0];
-
-  buf += 3;
-
-  for (i = 3; i < 3 + len; i++, buf++, tmp++)
-    {
-      tmp[0] = b[0] * buf[0];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = -1 * j;
-          tmp[0] += b[j] * tmp[offset + 0];
-        }
-    }
-
-  fix_right_boundary_y (tmp, m, uplus);
-
-  buf--;
-  tmp--;
-
-  for (i = 3 + len - 1; 3 <= i; i--, buf--, tmp--)
-    {
-      tmp[0] *= b[0];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = j;
-          tmp[0] += b[j] * tmp[offset + 0];
-        }
-
-      buf[0] = tmp[0];
-    }
-}
-
-static inline void
-fix_right_boundary_yA (gdouble        *buf,
-                       gdouble       (*m)[3],
-                       const gfloat   *uplus)
+iir_young_blur_lines (gfloat          *buf,
+                      gdouble         *tmp,
+                      const gdouble   *b,
+                      gdouble        (*m)[3],
+                      const gdouble   *iminus,
+                      const gdouble   *uplus,
+                      const gint       len,
+                      const gint       n)
 {
-  gdouble u[6] = { buf[-2] - uplus[0], buf[-1] - uplus[1],
-                   buf[-4] - uplus[0], buf[-3] - uplus[1],
-                   buf[-6] - uplus[0], buf[-5] - uplus[1] };
-  gint    i, k;
+  gint i, l;
 
   for (i = 0; i < 3; i++)
     {
-      gdouble tmp[2] = { 0.0, 0.0 };
-
-      for (k = 0; k < 3; k++)
-        {
-          tmp[0] += m[i][k] * u[k * 2 + 0];
-          tmp[1] += m[i][k] * u[k * 2 + 1];
-        }
-
-      buf[2 * i + 0] = tmp[0] + uplus[0];
-      buf[2 * i + 1] = tmp[1] + uplus[1];
+      for (l = 0; l < n; l++)
+        tmp[i * n + l] = iminus[l];
     }
-}
-
-static void
-iir_young_blur_1D_yA (gfloat           *buf,
-                      gdouble          *tmp,
-                      const gdouble    *b,
-                      gdouble         (*m)[3],
-                      const gfloat     *iminus,
-                      const gfloat     *uplus,
-                      const gint        len,
-                      const gint        components,
-                      GeglAbyssPolicy   policy)
-{
-  gint    i, j;
 
-  for (i = 0; i < 3; i++, tmp += 2)
+  /* causal filter */
+  for (i = 3; i < 3 + len; i++)
     {
-      tmp[0] = iminus[0];
-      tmp[1] = iminus[1];
+      const gfloat  *restrict src = buf + i * n;
+      gdouble       *restrict t0  = tmp + i * n;
+      const gdouble *restrict t1  = t0 - n;
+      const gdouble *restrict t2  = t1 - n;
+      const gdouble *restrict t3  = t2 - n;
+
+      for (l = 0; l < n; l++)
+        t0[l] = b[0] * src[l] + b[1] * t1[l] + b[2] * t2[l] + b[3] * t3[l];
     }
 
-  buf += 6;
-
-  for (i = 3; i < 3 + len; i++, buf += 2, tmp += 2)
-    {
-      tmp[0] = b[0] * buf[0];
-      tmp[1] = b[0] * buf[1];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = -2 * j;
-
-          tmp[0] += b[j] * tmp[offset + 0];
-          tmp[1] += b[j] * tmp[offset + 1];
-        }
-    }
-
-  fix_right_boundary_yA (tmp, m, uplus);
-
-  buf -= 2;
-  tmp -= 2;
-
-  for (i = 3 + len - 1; 3 <= i; i--, buf -= 2, tmp -= 2)
-    {
-      tmp[0] *= b[0];
-      tmp[1] *= b[0];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = 2 * j;
-
-          tmp[0] += b[j] * tmp[offset + 0];
-          tmp[1] += b[j] * tmp[offset + 1];
-        }
-
-      buf[0] = tmp[0];
-      buf[1] = tmp[1];
-    }
-}
-
-
-static inline void
-fix_right_boundary_generic (gdouble        *buf,
-                            gdouble       (*m)[3],
-                            const gfloat   *uplus,
-                            const gint      nc)
-{
-  gdouble u[nc*3];
-  gint    i, k, c;
-
-  for (k = 0; k < 3; k++)
-    for (c = 0; c < nc; c++)
-   u[k * nc + c] = buf[(-k-1)*nc+c] - uplus[c];
-
-  for (i = 0; i < 3; i++)
-    {
-      gdouble tmp[nc];
-      for (c = 0; c < nc ; c++)
-        tmp[c] = m[i][0] * u[0 * nc + c];
-
-      for (k = 1; k < 3; k++)
-        {
-          for (c = 0; c < nc ; c++)
-            tmp[c] += m[i][k] * u[k * nc + c];
-        }
-
-      for (c = 0; c < nc ; c++)
-        buf[nc * i + c] = tmp[c] + uplus[c];
-    }
-}
-
-static void
-iir_young_blur_1D_generic (gfloat           *buf,
-                           gdouble          *tmp,
-                           const gdouble    *b,
-                           gdouble         (*m)[3],
-                           const gfloat     *iminus,
-                           const gfloat     *uplus,
-                           const gint        len,
-                           const gint        components,
-                           GeglAbyssPolicy   policy)
-{
-  gint    i, j, c;
-  for (i = 0; i < 3; i++, tmp += components)
-    {
-      for (c = 0; c < components; c++)
-        tmp[c] = iminus[c];
-    }
-
-  buf += 3 * components;
-
-  for (i = 0; i < len; i++, buf += components, tmp += components)
-    {
-      for (c = 0; c < components; c++)
-        tmp[c] = b[0] * buf[c];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = -components * j;
-
-          for (c = 0; c < components; c++)
-            tmp[c] += b[j] * tmp[offset + c];
-        }
-    }
-
-  fix_right_boundary_generic (tmp, m, uplus, components);
-
-  buf -= components;
-  tmp -= components;
-
-  for (i = 3 + len - 1; 3 <= i; i--, buf -= components, tmp -= components)
-    {
-      for (c = 0; c < components; c++)
-        tmp[c] *= b[0];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = components * j;
-
-          for (c = 0; c < components; c++)
-            tmp[c] += b[j] * tmp[offset + c];
-        }
-
-      for (c = 0; c < components; c++)
-        buf[c] = tmp[c];
-    }
-}
-
-static inline void
-fix_right_boundary_rgb (gdouble        *buf,
-                        gdouble       (*m)[3],
-                        const gfloat   *uplus)
-{
-  gdouble u[9] = { buf[-3] - uplus[0], buf[-2] - uplus[1], buf[-1] - uplus[2],
-                   buf[-6] - uplus[0], buf[-5] - uplus[1], buf[-4] - uplus[2],
-                   buf[-9] - uplus[0], buf[-8] - uplus[1], buf[-7] - uplus[2] };
-  gint    i, k;
-
+  /* right boundary, see Triggs and Sdika, "Boundary conditions for
+   * Young - van Vliet recursive filtering"
+   */
   for (i = 0; i < 3; i++)
     {
-      gdouble tmp[3] = { 0.0, 0.0, 0.0 };
+      gdouble       *restrict t  = tmp + (3 + len + i) * n;
+      const gdouble *restrict u0 = tmp + (3 + len - 1) * n;
+      const gdouble *restrict u1 = u0 - n;
+      const gdouble *restrict u2 = u1 - n;
 
-      for (k = 0; k < 3; k++)
+      for (l = 0; l < n; l++)
         {
-          tmp[0] += m[i][k] * u[k * 3 + 0];
-          tmp[1] += m[i][k] * u[k * 3 + 1];
-          tmp[2] += m[i][k] * u[k * 3 + 2];
+          t[l] = m[i][0] * (u0[l] - uplus[l]) +
+                 m[i][1] * (u1[l] - uplus[l]) +
+                 m[i][2] * (u2[l] - uplus[l]) + uplus[l];
         }
-
-      buf[3 * i + 0] = tmp[0] + uplus[0];
-      buf[3 * i + 1] = tmp[1] + uplus[1];
-      buf[3 * i + 2] = tmp[2] + uplus[2];
     }
-}
-
-static void
-iir_young_blur_1D_rgb (gfloat           *buf,
-                       gdouble          *tmp,
-                       const gdouble    *b,
-                       gdouble         (*m)[3],
-                       const gfloat     *iminus,
-                       const gfloat     *uplus,
-                       const gint        len,
-                       const gint        components,
-                       GeglAbyssPolicy   policy)
-{
-  gint    i, j;
-
-  for (i = 0; i < 3; i++, tmp += 3)
-    {
-      tmp[0] = iminus[0];
-      tmp[1] = iminus[1];
-      tmp[2] = iminus[2];
-    }
-
-  buf += 9;
-
-  for (i = 3; i < 3 + len; i++, buf += 3, tmp += 3)
-    {
-      tmp[0] = b[0] * buf[0];
-      tmp[1] = b[0] * buf[1];
-      tmp[2] = b[0] * buf[2];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = -3 * j;
-
-          tmp[0] += b[j] * tmp[offset + 0];
-          tmp[1] += b[j] * tmp[offset + 1];
-          tmp[2] += b[j] * tmp[offset + 2];
-        }
-    }
-
-  fix_right_boundary_rgb (tmp, m, uplus);
-
-  buf -= 3;
-  tmp -= 3;
-
-  for (i = 3 + len - 1; 3 <= i; i--, buf -= 3, tmp -= 3)
-    {
-      tmp[0] *= b[0];
-      tmp[1] *= b[0];
-      tmp[2] *= b[0];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = 3 * j;
-
-          tmp[0] += b[j] * tmp[offset + 0];
-          tmp[1] += b[j] * tmp[offset + 1];
-          tmp[2] += b[j] * tmp[offset + 2];
-        }
-
-      buf[0] = tmp[0];
-      buf[1] = tmp[1];
-      buf[2] = tmp[2];
-    }
-}
-
-static inline void
-fix_right_boundary_rgbA (gdouble        *buf,
-                         gdouble       (*m)[3],
-                         const gfloat   *uplus)
-{
-  gdouble u[12] = { buf[-4] - uplus[0], buf[-3] - uplus[1], buf[-2] - uplus[2], buf[-1] - uplus[3],
-                    buf[-8] - uplus[0], buf[-7] - uplus[1], buf[-6] - uplus[2], buf[-5] - uplus[3],
-                    buf[-12] - uplus[0], buf[-11] - uplus[1], buf[-10] - uplus[2], buf[-9] - uplus[3] };
-  gint    i, k;
 
-  for (i = 0; i < 3; i++)
+  /* anti-causal filter */
+  for (i = 3 + len - 1; 3 <= i; i--)
     {
-      gdouble tmp[4] = { 0.0, 0.0, 0.0, 0.0 };
+      gfloat        *restrict dst = buf + i * n;
+      gdouble       *restrict t0  = tmp + i * n;
+      const gdouble *restrict t1  = t0 + n;
+      const gdouble *restrict t2  = t1 + n;
+      const gdouble *restrict t3  = t2 + n;
 
-      for (k = 0; k < 3; k++)
+      for (l = 0; l < n; l++)
         {
-          tmp[0] += m[i][k] * u[k * 4 + 0];
-          tmp[1] += m[i][k] * u[k * 4 + 1];
-          tmp[2] += m[i][k] * u[k * 4 + 2];
-          tmp[3] += m[i][k] * u[k * 4 + 3];
+          t0[l]  = b[0] * t0[l] + b[1] * t1[l] + b[2] * t2[l] + b[3] * t3[l];
+          dst[l] = t0[l];
         }
-
-      buf[4 * i + 0] = tmp[0] + uplus[0];
-      buf[4 * i + 1] = tmp[1] + uplus[1];
-      buf[4 * i + 2] = tmp[2] + uplus[2];
-      buf[4 * i + 3] = tmp[3] + uplus[3];
     }
 }
 
+/* filters the len samples of the lines of buf, the first of which is at
+ * offset.  when factor is greater than 1, a copy of the lines decimated by
+ * factor is filtered instead, using dbuf, and interpolated back into buf.
+ */
 static void
-iir_young_blur_1D_rgbA (gfloat           *buf,
-                        gdouble          *tmp,
-                        const gdouble    *b,
-                        gdouble         (*m)[3],
-                        const gfloat     *iminus,
-                        const gfloat     *uplus,
-                        const gint        len,
-                        const gint        components,
-                        GeglAbyssPolicy   policy)
+iir_young_blur (gfloat          *buf,
+                gfloat          *dbuf,
+                gdouble         *tmp,
+                const gdouble   *b,
+                gdouble        (*m)[3],
+                gdouble         *iminus,
+                gdouble         *uplus,
+                GeglAbyssPolicy  policy,
+                gint             offset,
+                gint             len,
+                gint             nc,
+                gint             n,
+                gint             factor)
 {
-  gint     i, j;
-
-  for (i = 0; i < 3; i++, tmp += 4)
+  if (factor > 1)
     {
-      tmp[0] = iminus[0];
-      tmp[1] = iminus[1];
-      tmp[2] = iminus[2];
-      tmp[3] = iminus[3];
-    }
+      gint d_offset, d_len;
 
-  buf += 12;
+      pyramid_get_decimated_range (offset, len, factor, &d_offset, &d_len);
+      pyramid_decimate_lines (&buf[3 * n], offset, len, n, factor,
+                              &dbuf[3 * n]);
 
-  for (i = 0; i < len; i++, buf += 4, tmp += 4)
-    {
-      tmp[0] = b[0] * buf[0];
-      tmp[1] = b[0] * buf[1];
-      tmp[2] = b[0] * buf[2];
-      tmp[3] = b[0] * buf[3];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = -4 * j;
+      get_boundaries (policy, dbuf, d_len, nc, n, iminus, uplus);
+      iir_young_blur_lines (dbuf, tmp, b, m, iminus, uplus, d_len, n);
 
-          tmp[0] += b[j] * tmp[offset + 0];
-          tmp[1] += b[j] * tmp[offset + 1];
-          tmp[2] += b[j] * tmp[offset + 2];
-          tmp[3] += b[j] * tmp[offset + 3];
-        }
+      pyramid_interpolate_lines (&dbuf[3 * n], d_offset, d_len, n, factor,
+                                 &buf[3 * n], offset, len);
     }
-
-  fix_right_boundary_rgbA (tmp, m, uplus);
-
-  buf -= 4;
-  tmp -= 4;
-
-  for (i = 3 + len - 1; 3 <= i; i--, buf -= 4, tmp -= 4)
+  else
     {
-      tmp[0] *= b[0];
-      tmp[1] *= b[0];
-      tmp[2] *= b[0];
-      tmp[3] *= b[0];
-
-      for (j = 1; j < 4; ++j)
-        {
-          gint offset = 4 * j;
-
-          tmp[0] += b[j] * tmp[offset + 0];
-          tmp[1] += b[j] * tmp[offset + 1];
-          tmp[2] += b[j] * tmp[offset + 2];
-          tmp[3] += b[j] * tmp[offset + 3];
-        }
-
-      buf[0] = tmp[0];
-      buf[1] = tmp[1];
-      buf[2] = tmp[2];
-      buf[3] = tmp[3];
+      get_boundaries (policy, buf, len, nc, n, iminus, uplus);
+      iir_young_blur_lines (buf, tmp, b, m, iminus, uplus, len, n);
     }
 }
 
 static void
-iir_young_hor_blur (IirYoungBlur1dFunc   real_blur_1D,
-                    GeglBuffer          *src,
+iir_young_hor_blur (GeglBuffer          *src,
                     const GeglRectangle *rect,
                     GeglBuffer          *dst,
                     const gdouble       *b,
                     gdouble            (*m)[3],
                     GeglAbyssPolicy      policy,
                     const Babl          *format,
-                    gint                 level)
+                    gint                 level,
+                    gint                 factor)
 {
-  GeglRectangle  cur_row = *rect;
-  const gint     nc = babl_format_get_n_components (format);
-  gfloat        *row = g_new (gfloat, (3 + rect->width + 3) * nc);
-  gdouble       *tmp = g_new (gdouble, (3 + rect->width + 3) * nc);
+  GeglRectangle  cur_rows = *rect;
+  const gint     nc       = babl_format_get_n_components (format);
+  const gint     max_n    = IIR_BLOCK_LINES * nc;
+  gfloat        *rows     = g_new (gfloat, rect->width * max_n);
+  gfloat        *buf      = g_new (gfloat, (3 + rect->width + 3) * max_n);
+  gfloat        *dbuf     = NULL;
+  gdouble       *tmp      = g_new (gdouble, (3 + rect->width + 3) * max_n);
+  gdouble       *iminus   = g_new (gdouble, 2 * max_n);
+  gdouble       *uplus    = iminus + max_n;
   gint           v;
 
-  cur_row.height = 1;
+  if (factor > 1)
+    dbuf = g_new (gfloat, (3 + rect->width / factor + 2 + 3) * max_n);
 
-  for (v = 0; v < rect->height; v++)
+  for (v = 0; v < rect->height; v += IIR_BLOCK_LINES)
     {
-      const gfloat *iminus;
-      const gfloat *uplus;
+      gint n, x, r;
 
-      cur_row.y = rect->y + v;
+      cur_rows.y      = rect->y + v;
+      cur_rows.height = MIN (IIR_BLOCK_LINES, rect->height - v);
 
-      gegl_buffer_get (src, &cur_row, 1.0/(1<<level), format, &row[3 * nc],
+      n = cur_rows.height * nc;
+
+      gegl_buffer_get (src, &cur_rows, 1.0/(1<<level), format, rows,
                        GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-      get_boundaries (policy, row, rect->width, nc, &iminus, &uplus);
-      real_blur_1D (row, tmp, b, m, iminus, uplus, rect->width, nc, policy);
+      /* transpose the rows, so that each of their samples is filtered
+       * along with the samples of the same column of the other rows
+       */
+      for (r = 0; r < cur_rows.height; r++)
+        {
+          const gfloat *row = rows + r * rect->width * nc;
+
+          for (x = 0; x < rect->width; x++)
+            memcpy (&buf[(3 + x) * n + r * nc], &row[x * nc],
+                    nc * sizeof (gfloat));
+        }
+
+      iir_young_blur (buf, dbuf, tmp, b, m, iminus, uplus, policy,
+                      rect->x, rect->width, nc, n, factor);
 
-      gegl_buffer_set (dst, &cur_row, level, format, &row[3 * nc],
+      for (r = 0; r < cur_rows.height; r++)
+        {
+          gfloat *row = rows + r * rect->width * nc;
+
+          for (x = 0; x < rect->width; x++)
+            memcpy (&row[x * nc], &buf[(3 + x) * n + r * nc],
+                    nc * sizeof (gfloat));
+        }
+
+      gegl_buffer_set (dst, &cur_rows, level, format, rows,
                        GEGL_AUTO_ROWSTRIDE);
     }
 
+  g_free (iminus);
   g_free (tmp);
-  g_free (row);
+  g_free (dbuf);
+  g_free (buf);
+  g_free (rows);
 }
 
 static void
-iir_young_ver_blur (IirYoungBlur1dFunc   real_blur_1D,
-                    GeglBuffer          *src,
+iir_young_ver_blur (GeglBuffer          *src,
                     const GeglRectangle *rect,
                     GeglBuffer          *dst,
                     const gdouble       *b,
                     gdouble            (*m)[3],
                     GeglAbyssPolicy      policy,
                     const Babl          *format,
-                    gint                 level)
+                    gint                 level,
+                    gint                 factor)
 {
-  GeglRectangle  cur_col = *rect;
-  const gint     nc = babl_format_get_n_components (format);
-  gfloat        *col = g_new (gfloat, (3 + rect->height + 3) * nc);
-  gdouble       *tmp = g_new (gdouble, (3 + rect->height + 3) * nc);
-  gint           i;
-
-  cur_col.width = 1;
-
-  for (i = 0; i < rect->width; i++)
+  GeglRectangle  cur_cols = *rect;
+  const gint     nc       = babl_format_get_n_components (format);
+  const gint     max_n    = IIR_BLOCK_LINES * nc;
+  gfloat        *buf      = g_new (gfloat, (3 + rect->height + 3) * max_n);
+  gfloat        *dbuf     = NULL;
+  gdouble       *tmp      = g_new (gdouble, (3 + rect->height + 3) * max_n);
+  gdouble       *iminus   = g_new (gdouble, 2 * max_n);
+  gdouble       *uplus    = iminus + max_n;
+  gint           u;
+
+  if (factor > 1)
+    dbuf = g_new (gfloat, (3 + rect->height / factor + 2 + 3) * max_n);
+
+  for (u = 0; u < rect->width; u += IIR_BLOCK_LINES)
     {
-      const gfloat *iminus;
-      const gfloat *uplus;
+      gint n;
 
-      cur_col.x = rect->x + i;
+      cur_cols.x     = rect->x + u;
+      cur_cols.width = MIN (IIR_BLOCK_LINES, rect->width - u);
 
-      gegl_buffer_get (src, &cur_col, 1.0/(1<<level), format, &col[3 * nc],
+      n = cur_cols.width * nc;
+
+      /* the rows of the block of columns are already interleaved the way
+       * iir_young_blur_lines() wants them
+       */
+      gegl_buffer_get (src, &cur_cols, 1.0/(1<<level), format, &buf[3 * n],
                        GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-      get_boundaries (policy, col, rect->height, nc, &iminus, &uplus);
-      real_blur_1D (col, tmp, b, m, iminus, uplus, rect->height, nc, policy);
+      iir_young_blur (buf, dbuf, tmp, b, m, iminus, uplus, policy,
+                      rect->y, rect->height, nc, n, factor);
 
-      gegl_buffer_set (dst, &cur_col, level, format, &col[3 * nc],
+      gegl_buffer_set (dst, &cur_cols, level, format, &buf[3 * n],
                        GEGL_AUTO_ROWSTRIDE);
     }
 
+  g_free (iminus);
   g_free (tmp);
-  g_free (col);
+  g_free (dbuf);
+  g_free (buf);
 }
 
 
@@ -1026,10 +761,8 @@ static void
 gegl_gblur_1d_prepare (GeglOperation *operation)
 {
   const Babl *space = gegl_operation_get_source_space (operation, "input");
-  GeglProperties *o = GEGL_PROPERTIES (operation);
   const Babl *src_format = gegl_operation_get_source_format (operation, "input");
   const char *format     = "RaGaBaA float";
-  o->user_data = iir_young_blur_1D_rgbA;
 
   /*
    * FIXME: when the abyss policy is _NONE, the behavior at the edge
@@ -1043,28 +776,23 @@ gegl_gblur_1d_prepare (GeglOperation *operation)
           babl_model_is (model, "R'G'B'"))
         {
           format = "RGB float";
-          o->user_data = iir_young_blur_1D_rgb;
         }
       else if (babl_model_is (model, "Y") || babl_model_is (model, "Y'"))
         {
           format = "Y float";
-          o->user_data = iir_young_blur_1D_y;
         }
       else if (babl_model_is (model, "YA") || babl_model_is (model, "Y'A") ||
                babl_model_is (model, "YaA") || babl_model_is (model, "Y'aA"))
         {
           format = "YaA float";
-          o->user_data = iir_young_blur_1D_yA;
         }
       else if (babl_model_is (model, "cmyk"))
         {
           format = "cmyk float";
-          o->user_data = iir_young_blur_1D_generic;
         }
       else if (babl_model_is (model, "CMYK"))
         {
           format = "CMYK float";
-          o->user_data = iir_young_blur_1D_generic;
         }
       else if (babl_model_is (model, "cmykA") ||
                babl_model_is (model, "camayakaA") ||
@@ -1072,7 +800,6 @@ gegl_gblur_1d_prepare (GeglOperation *operation)
                babl_model_is (model, "CaMaYaKaA"))
         {
           format = "camayakaA float";
-          o->user_data = iir_young_blur_1D_generic;
         }
     }
 
@@ -1289,15 +1016,33 @@ gegl_gblur_1d_process (GeglOperation       *operation,
 
   if (filter == GEGL_GBLUR_1D_IIR)
     {
-      IirYoungBlur1dFunc real_blur_1D = (IirYoungBlur1dFunc) o->user_data;
       gdouble b[4], m[3][3];
+      gint    factor = 1;
+
+      /* decimating the input by factor, blurring it, and interpolating the
+       * result changes it by at most about 0.2 * factor / std_dev, relative
+       * to the range of the input
+       */
+      if (o->max_error > 0.0)
+        {
+          factor = pyramid_get_factor (MIN (5.0 * o->max_error * std_dev,
+                                            std_dev / 2.0));
+        }
+
+      if (factor > 1)
+        {
+          /* account for the variance of the decimation and of the
+           * interpolation
+           */
+          std_dev = sqrt (std_dev * std_dev - factor * factor / 4.0) / factor;
+        }
 
       iir_young_find_constants (std_dev, b, m);
 
       if (o->orientation == GEGL_ORIENTATION_HORIZONTAL)
-        iir_young_hor_blur (real_blur_1D, input, result, output, b, m, abyss_policy, format, level);
+        iir_young_hor_blur (input, result, output, b, m, abyss_policy, format, level, factor);
       else
-        iir_young_ver_blur (real_blur_1D, input, result, output, b, m, abyss_policy, format, level);
+        iir_young_ver_blur (input, result, output, b, m, abyss_policy, format, level, factor);
     }
   else
     {
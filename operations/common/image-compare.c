@@ -69,36 +69,38 @@ get_cached_region (GeglOperation       *operation,
   return *gegl_operation_source_get_bounding_box (operation, "input");
 }
 
-static gboolean
-process (GeglOperation       *operation,
-         GeglBuffer          *input,
-         GeglBuffer          *aux,
-         GeglBuffer          *output,
-         const GeglRectangle *result,
-         gint                 level)
+typedef struct
 {
-  GeglProperties         *props        = GEGL_PROPERTIES (operation);
-  gdouble             max_diff     = 0.0;
-  gdouble             diffsum      = 0.0;
-  gint                wrong_pixels = 0;
-  const Babl         *cielab       = babl_format ("CIE Lab alpha float");
-  const Babl         *srgb         = babl_format ("R'G'B' u8");
-  const Babl         *yadbl        = babl_format ("YA double");
-  GeglBuffer         *diff_buffer;
-  GeglBufferIterator *iter;
+  gdouble max_diff;
+  gdouble diffsum;
+  gint    wrong_pixels;
+} CompareStats;
 
-  if (aux == NULL)
-    return TRUE;
+typedef struct
+{
+  GeglBuffer *input;
+  GeglBuffer *aux;
+  GeglBuffer *output;
+  GeglBuffer *diff_buffer;
+  gdouble     max_diff;
+} CompareData;
 
-  diff_buffer = gegl_buffer_new (result, yadbl);
+static void
+compare_area (const GeglRectangle *area,
+              CompareStats        *stats,
+              CompareData         *data)
+{
+  const Babl         *cielab = babl_format ("CIE Lab alpha float");
+  const Babl         *yadbl  = babl_format ("YA double");
+  GeglBufferIterator *iter;
 
-  iter = gegl_buffer_iterator_new (diff_buffer, result, 0, yadbl,
+  iter = gegl_buffer_iterator_new (data->diff_buffer, area, 0, yadbl,
                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 3);
 
-  gegl_buffer_iterator_add (iter, input, result, 0, cielab,
+  gegl_buffer_iterator_add (iter, data->input, area, 0, cielab,
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, aux, result, 0, cielab,
+  gegl_buffer_iterator_add (iter, data->aux, area, 0, cielab,
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -121,10 +123,10 @@ process (GeglOperation       *operation,
 
           if (diff >= ERROR_TOLERANCE)
             {
-              wrong_pixels++;
-              diffsum += diff;
-              if (diff > max_diff)
-                max_diff = diff;
+              stats->wrong_pixels++;
+              stats->diffsum += diff;
+              if (diff > stats->max_diff)
+                stats->max_diff = diff;
               data_out[0] = diff;
               data_out[1] = data_in1[0];
             }
@@ -139,23 +141,43 @@ process (GeglOperation       *operation,
           data_in2 += 4;
         }
     }
+}
 
-  iter  = gegl_buffer_iterator_new (output, result, 0, srgb,
+static void
+compare_merge (CompareStats       *stats,
+               const CompareStats *partial,
+               CompareData        *data)
+{
+  stats->max_diff      = MAX (stats->max_diff, partial->max_diff);
+  stats->diffsum      += partial->diffsum;
+  stats->wrong_pixels += partial->wrong_pixels;
+}
+
+static void
+render_area (const GeglRectangle *area,
+             CompareData         *data)
+{
+  const Babl         *srgb     = babl_format ("R'G'B' u8");
+  const Babl         *yadbl    = babl_format ("YA double");
+  const gdouble       max_diff = data->max_diff;
+  GeglBufferIterator *iter;
+
+  iter  = gegl_buffer_iterator_new (data->output, area, 0, srgb,
                                     GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
 
-  gegl_buffer_iterator_add (iter, diff_buffer, result, 0, yadbl,
+  gegl_buffer_iterator_add (iter, data->diff_buffer, area, 0, yadbl,
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
     {
       gint     i;
-      guchar  *out  = iter->items[0].data;
-      gdouble *data = iter->items[1].data;
+      guchar  *out       = iter->items[0].data;
+      gdouble *diff_data = iter->items[1].data;
 
       for (i = 0; i < iter->length; i++)
         {
-          gdouble diff = data[0];
-          gdouble a = data[1];
+          gdouble diff = diff_data[0];
+          gdouble a = diff_data[1];
 
           if (diff >= 0.01)
             {
@@ -170,17 +192,57 @@ process (GeglOperation       *operation,
               out[2] = CLAMP (a / 100.0 * 255, 0, 255);
             }
 
-          out  += 3;
-          data += 2;
+          out       += 3;
+          diff_data += 2;
         }
     }
+}
 
-  g_object_unref (diff_buffer);
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *aux,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  GeglProperties *props = GEGL_PROPERTIES (operation);
+  CompareStats    stats = { 0.0, 0.0, 0 };
+  CompareData     data;
+
+  if (aux == NULL)
+    return TRUE;
 
-  props->wrong_pixels   = wrong_pixels;
-  props->max_diff       = max_diff;
-  props->avg_diff_wrong = diffsum / wrong_pixels;
-  props->avg_diff_total = diffsum / (result->width * result->height);
+  data.input       = input;
+  data.aux         = aux;
+  data.output      = output;
+  data.diff_buffer = gegl_buffer_new (result, babl_format ("YA double"));
+
+  /* the statistics are gathered in parallel, and the visual difference,
+   * which depends on the maximal difference, is rendered afterwards
+   */
+  gegl_parallel_reduce_area (
+    result, gegl_operation_get_pixels_per_thread (operation),
+    GEGL_SPLIT_STRATEGY_HORIZONTAL,
+    &stats, sizeof (stats),
+    (GeglParallelReduceAreaFunc) compare_area,
+    (GeglParallelMergeFunc) compare_merge,
+    &data);
+
+  data.max_diff = stats.max_diff;
+
+  gegl_parallel_distribute_area (
+    result, gegl_operation_get_pixels_per_thread (operation),
+    GEGL_SPLIT_STRATEGY_HORIZONTAL,
+    (GeglParallelDistributeAreaFunc) render_area,
+    &data);
+
+  g_object_unref (data.diff_buffer);
+
+  props->wrong_pixels   = stats.wrong_pixels;
+  props->max_diff       = stats.max_diff;
+  props->avg_diff_wrong = stats.diffsum / stats.wrong_pixels;
+  props->avg_diff_total = stats.diffsum / (result->width * result->height);
 
   return TRUE;
 }
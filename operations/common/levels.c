@@ -205,6 +205,7 @@ gegl_op_class_init (GeglOpClass *klass)
     "name",        "gegl:levels",
     "title",       _("Levels"),
     "categories" , "color",
+    "commutes-with-transforms", "true",
     "description", _("Remaps the intensity range of the image"),
     "reference-hash", "b26ace9ce32e98b8ffa2a57f10a42e0d",
     "reference-composition", composition,
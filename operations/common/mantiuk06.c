@@ -47,6 +47,8 @@ property_double (detail, _("Detail"), 1.0)
 #include "gegl-op.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include "solver-common.h"
+#include "proxy-common.h"
 
 /* Using OMP with clang causes crashes */
 #if defined(HAVE_OPENMP) && ! defined(__clang__)
@@ -229,12 +231,23 @@ static gfloat R_table[] =
  * res should be a pointer to allocated memory for bigger matrix
  * cols and rows are the dimmensions of the output matrix
  */
+typedef struct
+{
+  gint          cols;
+  gint          rows;
+  const gfloat *in;
+  gfloat       *out;
+} Mantiuk06ResampleData;
+
 static void
-mantiuk06_matrix_upsample (const gint          outCols,
-                           const gint          outRows,
-                           const gfloat *const in,
-                           gfloat       *const out)
+mantiuk06_matrix_upsample_rows (gsize                  offset,
+                                gsize                  size,
+                                Mantiuk06ResampleData *data)
 {
+  const gint          outCols = data->cols;
+  const gint          outRows = data->rows;
+  const gfloat *const in      = data->in;
+  gfloat       *const out     = data->out;
   const int inRows = outRows/2;
   const int inCols = outCols/2;
   gint      x, y;
@@ -253,8 +266,7 @@ mantiuk06_matrix_upsample (const gint          outCols,
                                          * best.
                                          */
 
-  _OMP (omp parallel for schedule(static))
-  for (y = 0; y < outRows; y++)
+  for (y = offset; y < offset + size; y++)
     {
       const gfloat sy  = y * dy;
       const gint   iy1 =      (  y   * inRows) / outRows;
@@ -275,14 +287,30 @@ mantiuk06_matrix_upsample (const gint          outCols,
     }
 }
 
+static void
+mantiuk06_matrix_upsample (const gint          outCols,
+                           const gint          outRows,
+                           const gfloat *const in,
+                           gfloat       *const out)
+{
+  Mantiuk06ResampleData data = { outCols, outRows, in, out };
+
+  solver_distribute_rows (outRows, outCols * 4,
+                          (GeglParallelDistributeRangeFunc) mantiuk06_matrix_upsample_rows,
+                          &data);
+}
+
 
 /* downsample the matrix */
 static void
-mantiuk06_matrix_downsample (const gint          inCols,
-                             const gint          inRows,
-                             const gfloat *const data,
-                             gfloat       *const res)
+mantiuk06_matrix_downsample_rows (gsize                  offset,
+                                  gsize                  size,
+                                  Mantiuk06ResampleData *rdata)
 {
+  const gint          inCols  = rdata->cols;
+  const gint          inRows  = rdata->rows;
+  const gfloat *const data    = rdata->in;
+  gfloat       *const res     = rdata->out;
   const int outRows = inRows / 2;
   const int outCols = inCols / 2;
   gint      x, y, i, j;
@@ -308,8 +336,8 @@ mantiuk06_matrix_downsample (const gint          inCols,
    */
 
   const gfloat normalize = 1.0f/(dx*dy);
-  _OMP (omp parallel for schedule(static))
-  for (y = 0; y < outRows; y++)
+
+  for (y = offset; y < offset + size; y++)
     {
       const gint   iy1 = (  y   * inRows) / outRows;
       const gint   iy2 = ((y+1) * inRows) / outRows;
@@ -372,6 +400,19 @@ mantiuk06_matrix_downsample (const gint          inCols,
     }
 }
 
+static void
+mantiuk06_matrix_downsample (const gint          inCols,
+                             const gint          inRows,
+                             const gfloat *const data,
+                             gfloat       *const res)
+{
+  Mantiuk06ResampleData rdata = { inCols, inRows, data, res };
+
+  solver_distribute_rows (inRows / 2, inCols * 2,
+                          (GeglParallelDistributeRangeFunc) mantiuk06_matrix_downsample_rows,
+                          &rdata);
+}
+
 
 /* return = a - b */
 static inline void
@@ -379,11 +420,7 @@ mantiuk06_matrix_subtract (const guint         n,
                            const gfloat *const a,
                            gfloat       *const b)
 {
-  guint i;
-
-  _OMP (omp parallel for schedule(static))
-  for (i = 0; i < n; i++)
-    b[i] = a[i] - b[i];
+  solver_sub (n, a, b);
 }
 
 /* copy matix a to b, return = a  */
@@ -439,14 +476,7 @@ mantiuk06_matrix_dot_product (const guint         n,
                               const gfloat *const a,
                               const gfloat *const b)
 {
-  gfloat val = 0;
-  guint j;
-
-  _OMP (omp parallel for reduction(+:val) schedule(static))
-  for (j = 0; j < n; j++)
-    val += a[j] * b[j];
-
-  return val;
+  return solver_dot (n, a, b);
 }
 
 /* set zeros for matrix elements */
@@ -460,17 +490,27 @@ mantiuk06_matrix_zero (guint   n,
 /* calculate divergence of two gradient maps (Gx and Gy)
  * divG(x,y) = Gx(x,y) - Gx(x-1,y) + Gy(x,y) - Gy(x,y-1)
  */
-static inline void
-mantiuk06_calculate_and_add_divergence (const gint          cols,
-                                        const gint          rows,
-                                        const gfloat *const Gx,
-                                        const gfloat *const Gy,
-                                        gfloat       *const divG)
+typedef struct
 {
+  gint          cols;
+  gint          rows;
+  const gfloat *Gx;
+  const gfloat *Gy;
+  gfloat       *divG;
+} Mantiuk06DivergenceData;
+
+static void
+mantiuk06_calculate_and_add_divergence_rows (gsize                    offset,
+                                             gsize                    size,
+                                             Mantiuk06DivergenceData *data)
+{
+  const gint          cols = data->cols;
+  const gfloat *const Gx   = data->Gx;
+  const gfloat *const Gy   = data->Gy;
+  gfloat       *const divG = data->divG;
   gint ky, kx;
 
-  _OMP (omp parallel for schedule(static))
-  for (ky = 0; ky < rows; ky++)
+  for (ky = offset; ky < offset + size; ky++)
     {
       for (kx = 0; kx<cols; kx++)
         {
@@ -492,6 +532,20 @@ mantiuk06_calculate_and_add_divergence (const gint          cols,
     }
 }
 
+static inline void
+mantiuk06_calculate_and_add_divergence (const gint          cols,
+                                        const gint          rows,
+                                        const gfloat *const Gx,
+                                        const gfloat *const Gy,
+                                        gfloat       *const divG)
+{
+  Mantiuk06DivergenceData data = { cols, rows, Gx, Gy, divG };
+
+  solver_distribute_rows (rows, cols,
+                          (GeglParallelDistributeRangeFunc) mantiuk06_calculate_and_add_divergence_rows,
+                          &data);
+}
+
 /* calculate the sum of divergences for the all pyramid level. the smaller
  * divergence map is upsamled and added to the divergence map for the higher
  * level of pyramid.
@@ -616,10 +670,7 @@ mantiuk06_scale_gradient (const gint          n,
                           gfloat       *const G,
                           const gfloat *const C)
 {
-  gint i;
-  _OMP (omp parallel for schedule(static))
-  for (i = 0; i < n; i++)
-    G[i] *= C[i];
+  solver_mul (n, C, G);
 }
 
 /* scale gradients for the whole one pyramid with the use of (Cx,Cy) from the
@@ -697,17 +748,28 @@ mantiuk06_pyramid_allocate (int cols,
 
 
 /* calculate gradients */
-static inline void
-mantiuk06_calculate_gradient (const gint          cols,
-                              const gint          rows,
-                              const gfloat *const lum,
-                              gfloat       *const Gx,
-                              gfloat       *const Gy)
+typedef struct
+{
+  gint          cols;
+  gint          rows;
+  const gfloat *lum;
+  gfloat       *Gx;
+  gfloat       *Gy;
+} Mantiuk06GradientData;
+
+static void
+mantiuk06_calculate_gradient_rows (gsize                  offset,
+                                   gsize                  size,
+                                   Mantiuk06GradientData *data)
 {
+  const gint          cols = data->cols;
+  const gint          rows = data->rows;
+  const gfloat *const lum  = data->lum;
+  gfloat       *const Gx   = data->Gx;
+  gfloat       *const Gy   = data->Gy;
   gint ky, kx;
 
-  _OMP (omp parallel for schedule(static))
-  for (ky = 0; ky < rows; ky++)
+  for (ky = offset; ky < offset + size; ky++)
     {
       for (kx = 0; kx < cols; kx++)
         {
@@ -726,6 +788,20 @@ mantiuk06_calculate_gradient (const gint          cols,
     }
 }
 
+static inline void
+mantiuk06_calculate_gradient (const gint          cols,
+                              const gint          rows,
+                              const gfloat *const lum,
+                              gfloat       *const Gx,
+                              gfloat       *const Gy)
+{
+  Mantiuk06GradientData data = { cols, rows, lum, Gx, Gy };
+
+  solver_distribute_rows (rows, cols,
+                          (GeglParallelDistributeRangeFunc) mantiuk06_calculate_gradient_rows,
+                          &data);
+}
+
 
 /* calculate gradients for the pyramid
  * lum_temp gets overwritten!
@@ -776,11 +852,7 @@ mantiuk06_solveX (const gint          n,
                   const gfloat *const b,
                   gfloat       *const x)
 {
-  gint i;
-
-  _OMP (omp parallel for schedule(static))
-  for (i = 0; i < n; i++)
-    x[i] = -0.25f * b[i];
+  solver_scale (n, -0.25f, b, x);
 }
 
 /* divG_sum = A * x = sum (divG (x))
@@ -848,11 +920,12 @@ mantiuk06_linbcg (pyramid_t           *pyramid,
 
   for (; iter < itmax; iter++)
     {
-      guint i;
       gfloat bknum, ak, old_err2;
 
-      if (progress_cb != NULL)
-        progress_cb ((int) (logf (err2 / ierr2) * percent_sf));
+      if (progress_cb != NULL &&
+          progress_cb ((int) (logf (err2 / ierr2) * percent_sf)) == PFSTMO_CB_ABORT &&
+          iter > 0) /* User requested abort */
+        break;
 
       mantiuk06_solveX (n,  r,  z); /*  z = ~A (-1) *  r = -0.25 *  r */
       mantiuk06_solveX (n, rr, zz); /* zz = ~A (-1) * rr = -0.25 * rr */
@@ -869,12 +942,8 @@ mantiuk06_linbcg (pyramid_t           *pyramid,
         {
           const gfloat bk = bknum / bkden; /* beta = ...  */
 
-          _OMP (omp parallel for schedule(static))
-          for (i = 0; i < n; i++)
-            {
-              p[i]  =  z[i] + bk *  p[i];
-              pp[i] = zz[i] + bk * pp[i];
-            }
+          solver_xpby (n,  z, bk,  p);
+          solver_xpby (n, zz, bk, pp);
         }
 
       bkden = bknum; /* numerator becomes the dominator for the next iteration */
@@ -884,12 +953,8 @@ mantiuk06_linbcg (pyramid_t           *pyramid,
 
       ak = bknum / mantiuk06_matrix_dot_product (n, z, pp); /* alfa = ...   */
 
-      _OMP (omp parallel for schedule(static))
-      for (i = 0 ; i < n ; i++ )
-        {
-          r[i]  -= ak *  z[i];  /*  r =  r - alfa *  z  */
-          rr[i] -= ak * zz[i];  /* rr = rr - alfa * zz  */
-        }
+      solver_axpy (n, -ak,  z,  r); /*  r =  r - alfa *  z  */
+      solver_axpy (n, -ak, zz, rr); /* rr = rr - alfa * zz  */
 
       old_err2 = err2;
       err2 = mantiuk06_matrix_dot_product (n, r, r);
@@ -911,9 +976,7 @@ mantiuk06_linbcg (pyramid_t           *pyramid,
           num_backwards = 0;
         }
 
-      _OMP (omp parallel for schedule(static))
-      for (i = 0 ; i < n ; i++ )
-        x[i] += ak * p[i];      /* x =  x + alfa * p */
+      solver_axpy (n, ak, p, x);    /* x =  x + alfa * p */
 
       if (num_backwards > num_backwards_ceiling)
         {
@@ -949,7 +1012,7 @@ mantiuk06_linbcg (pyramid_t           *pyramid,
       mantiuk06_matrix_copy (n, x_save, x);
     }
 
-  if (err2/bnrm2 > tol2)
+  if (err2/bnrm2 > tol2 && ! gegl_parallel_is_cancelled ())
     {
       /* Not converged */
       if (progress_cb != NULL)
@@ -1021,7 +1084,6 @@ mantiuk06_lincg (pyramid_t           *pyramid,
   percent_sf = 100.0f / logf (tol2 * bnrm2 / irdotr);
   for (; iter < itmax; iter++)
     {
-      gint  i;
       gfloat alpha, old_rdotr;
 
       if (progress_cb != NULL) {
@@ -1037,9 +1099,7 @@ mantiuk06_lincg (pyramid_t           *pyramid,
       alpha = rdotr / mantiuk06_matrix_dot_product (n, p, Ap);
 
       /* r = r - alpha Ap */
-      _OMP (omp parallel for schedule(static))
-      for (i = 0; i < n; i++)
-        r[i] -= alpha * Ap[i];
+      solver_axpy (n, -alpha, Ap, r);
 
       /* rdotr = r.r */
       old_rdotr = rdotr;
@@ -1063,9 +1123,7 @@ mantiuk06_lincg (pyramid_t           *pyramid,
         }
 
       /* x = x + alpha p */
-      _OMP (omp parallel for schedule(static))
-      for (i = 0; i < n; i++)
-        x[i] += alpha * p[i];
+      solver_axpy (n, alpha, p, x);
 
 
       /* Exit if we're done */
@@ -1096,9 +1154,7 @@ mantiuk06_lincg (pyramid_t           *pyramid,
           /* p = r + beta p */
           const gfloat beta = rdotr/old_rdotr;
 
-          _OMP (omp parallel for schedule(static))
-          for (i = 0; i < n; i++)
-            p[i] = r[i] + beta*p[i];
+          solver_xpby (n, r, beta, p);
         }
     }
 
@@ -1109,7 +1165,7 @@ mantiuk06_lincg (pyramid_t           *pyramid,
       mantiuk06_matrix_copy (n, x_save, x);
     }
 
-  if (rdotr/bnrm2 > tol2)
+  if (rdotr/bnrm2 > tol2 && ! gegl_parallel_is_cancelled ())
     {
       /* Not converged */
       if (progress_cb != NULL)
@@ -1311,10 +1367,19 @@ mantiuk06_transform_to_luminance (pyramid_t                        *pp,
 struct hist_data
 {
   gfloat size;
-  gfloat cdf;
   gint index;
 };
 
+typedef struct
+{
+  gfloat           *Gx;
+  gfloat           *Gy;
+  struct hist_data *hist;
+  gfloat           *scale;
+  gfloat            norm;
+  gfloat            contrastFactor;
+} Mantiuk06HistData;
+
 static int
 mantiuk06_hist_data_order (const void *const v1,
                            const void *const v2)
@@ -1329,21 +1394,67 @@ mantiuk06_hist_data_order (const void *const v1,
 }
 
 
-static int
-mantiuk06_hist_data_index (const void *const v1,
-                           const void *const v2)
+static void
+mantiuk06_hist_data_sizes (gsize              offset,
+                           gsize              size,
+                           Mantiuk06HistData *hdata)
 {
-  return ((struct hist_data*) v1)->index - ((struct hist_data*) v2)->index;
+  gsize c;
+
+  for (c = offset; c < offset + size; c++)
+    {
+      hdata->hist[c].size = sqrtf (hdata->Gx[c] * hdata->Gx[c] +
+                                   hdata->Gy[c] * hdata->Gy[c]);
+    }
 }
 
 
+static void
+mantiuk06_hist_data_scales (gsize              offset,
+                            gsize              size,
+                            Mantiuk06HistData *hdata)
+{
+  gsize i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      const gfloat cdf = ((gfloat) i) * hdata->norm;
+
+      hdata->scale[hdata->hist[i].index] = hdata->contrastFactor *
+                                           cdf                   /
+                                           hdata->hist[i].size;
+    }
+}
+
+
+static void
+mantiuk06_hist_data_remap (gsize              offset,
+                           gsize              size,
+                           Mantiuk06HistData *hdata)
+{
+  gsize c;
+
+  for (c = offset; c < offset + size; c++)
+    {
+      hdata->Gx[c] *= hdata->scale[c];
+      hdata->Gy[c] *= hdata->scale[c];
+    }
+}
+
+
+/* the gradient magnitudes are remapped through their cumulative
+ * distribution, which is given by the rank of each magnitude.  the ranks are
+ * scattered back to the pixels directly, rather than by sorting again.
+ */
 static void
 mantiuk06_contrast_equalization (pyramid_t   *pp,
                                  const gfloat  contrastFactor )
 {
-  gint              i, idx;
-  struct hist_data *hist;
-  gint              total_pixels = 0;
+  Mantiuk06HistData  hdata;
+  struct hist_data  *hist;
+  gfloat            *scale;
+  gint               i, idx;
+  gint               total_pixels = 0;
 
   /* Count sizes */
   pyramid_t *l = pp;
@@ -1354,7 +1465,8 @@ mantiuk06_contrast_equalization (pyramid_t   *pp,
     }
 
   /* Allocate memory */
-  hist = g_new (struct hist_data, total_pixels);
+  hist  = g_new (struct hist_data, total_pixels);
+  scale = g_new (gfloat, total_pixels);
 
   /* Build histogram info */
   l   = pp;
@@ -1362,16 +1474,19 @@ mantiuk06_contrast_equalization (pyramid_t   *pp,
   while (l != NULL)
     {
       const int pixels = l->rows*l->cols;
-      const int offset = idx;
-      gint      c;
 
-      _OMP (omp parallel for schedule(static))
-      for (c = 0; c < pixels; c++)
-        {
-          hist[c+offset].size = sqrtf (l->Gx[c] * l->Gx[c] +
-                                       l->Gy[c] * l->Gy[c]);
-          hist[c+offset].index = c + offset;
-        }
+      hdata.Gx   = l->Gx;
+      hdata.Gy   = l->Gy;
+      hdata.hist = hist + idx;
+
+      gegl_parallel_distribute_range (
+        pixels, SOLVER_THREAD_COST,
+        (GeglParallelDistributeRangeFunc) mantiuk06_hist_data_sizes,
+        &hdata);
+
+      for (i = 0; i < pixels; i++)
+        hist[i + idx].index = i + idx;
+
       idx += pixels;
       l = l->next;
     }
@@ -1380,84 +1495,79 @@ mantiuk06_contrast_equalization (pyramid_t   *pp,
   qsort (hist, total_pixels, sizeof (struct hist_data),
          mantiuk06_hist_data_order);
 
-  /* Calculate cdf */
-  {
-    const gfloat norm = 1.0f / (gfloat) total_pixels;
-    _OMP (omp parallel for schedule(static))
-    for (i = 0; i < total_pixels; i++)
-      hist[i].cdf = ((gfloat) i) * norm;
-  }
+  /* Calculate cdf, in terms of indexes */
+  hdata.hist           = hist;
+  hdata.scale          = scale;
+  hdata.norm           = 1.0f / (gfloat) total_pixels;
+  hdata.contrastFactor = contrastFactor;
 
-  /* Recalculate in terms of indexes */
-  qsort (hist, total_pixels,
-         sizeof (struct hist_data),
-         mantiuk06_hist_data_index);
+  gegl_parallel_distribute_range (
+    total_pixels, SOLVER_THREAD_COST,
+    (GeglParallelDistributeRangeFunc) mantiuk06_hist_data_scales,
+    &hdata);
 
   /*Remap gradient magnitudes */
   l   = pp;
   idx = 0;
   while (l != NULL )
     {
-      gint      c;
       const int pixels = l->rows*l->cols;
-      const int offset = idx;
 
-      _OMP (omp parallel for schedule(static))
-      for (c = 0; c < pixels; c++)
-        {
-          const gfloat scale = contrastFactor      *
-                               hist[c+offset].cdf  /
-                               hist[c+offset].size;
-          l->Gx[c] *= scale;
-          l->Gy[c] *= scale;
-        }
+      hdata.Gx    = l->Gx;
+      hdata.Gy    = l->Gy;
+      hdata.scale = scale + idx;
+
+      gegl_parallel_distribute_range (
+        pixels, SOLVER_THREAD_COST,
+        (GeglParallelDistributeRangeFunc) mantiuk06_hist_data_remap,
+        &hdata);
+
       idx += pixels;
       l    = l->next;
     }
 
+  g_free (scale);
   g_free (hist);
 }
 
 
-/* tone mapping */
-static int
-mantiuk06_contmap (const int                       c,
-                   const int                       r,
-                   gfloat                   *const rgb,
-                   gfloat                   *const Y,
-                   const gfloat                    contrastFactor,
-                   const gfloat                    saturationFactor,
-                   const gboolean                  bcg,
-                   const int                       itmax,
-                   const gfloat                    tol,
-                   pfstmo_progress_callback        progress)
+static gfloat
+mantiuk06_clip_min (const guint         n,
+                    const gfloat *const Y)
 {
-  const guint n = c*r;
-        guint j;
-
-  /* Normalize */
-  gfloat Ymax = Y[0],
-         clip_min;
+  gfloat Ymax = Y[0];
+  guint  j;
 
   for (j = 1; j < n; j++)
       Ymax = MAX (Y[j], Ymax);
 
-  clip_min = 1e-7f * Ymax;
-  _OMP (omp parallel for schedule(static))
-  for (j = 0; j < n * 4; j++)
-      if (G_UNLIKELY (rgb[j] < clip_min)) rgb[j] = clip_min;
+  return 1e-7f * Ymax;
+}
 
-  _OMP (omp parallel for schedule(static))
-  for (j = 0; j < n; j++)
-      if (G_UNLIKELY (  Y[j] < clip_min))   Y[j] = clip_min;
+/* tone mapping of the luminance, which doesn't depend on the colors, and can
+ * be reused when only the saturation changes
+ */
+static int
+mantiuk06_contmap_luminance (const int                       c,
+                             const int                       r,
+                             gfloat                   *const Y,
+                             const gfloat                    contrastFactor,
+                             const gboolean                  bcg,
+                             const int                       itmax,
+                             const gfloat                    tol,
+                             pfstmo_progress_callback        progress)
+{
+  const guint n = c*r;
+        guint j;
+
+  /* Normalize */
+  const gfloat clip_min = mantiuk06_clip_min (n, Y);
 
   _OMP (omp parallel for schedule(static))
   for (j = 0; j < n; j++)
     {
-      rgb[j * 4 + 0] /= Y[j];
-      rgb[j * 4 + 1] /= Y[j];
-      rgb[j * 4 + 2] /= Y[j];
-      Y[j]            = log10f (Y[j]);
+      if (G_UNLIKELY (Y[j] < clip_min)) Y[j] = clip_min;
+      Y[j] = log10f (Y[j]);
     }
 
   {
@@ -1522,28 +1632,57 @@ mantiuk06_contmap (const int                       c,
                  disp_dyn_range - disp_dyn_range;
     }
 
-    /* Transform to linear scale RGB */
+    /* Transform to linear scale */
     _OMP (omp parallel for schedule(static))
     for (j = 0; j < n; j++)
-      {
         Y[j] = powf (10,Y[j]);
-
-        rgb[j * 4 + 0] = powf (rgb[j * 4 + 0], saturationFactor) * Y[j];
-        rgb[j * 4 + 1] = powf (rgb[j * 4 + 1], saturationFactor) * Y[j];
-        rgb[j * 4 + 2] = powf (rgb[j * 4 + 2], saturationFactor) * Y[j];
-      }
   }
 
   return PFSTMO_OK;
 }
 
+/* apply the tone mapped luminance Y_out to the colors, given the original
+ * luminance Y_in
+ */
+static void
+mantiuk06_contmap_color (const int                 c,
+                         const int                 r,
+                         gfloat             *const rgb,
+                         const gfloat       *const Y_in,
+                         const gfloat       *const Y_out,
+                         const gfloat              saturationFactor)
+{
+  const guint  n        = c*r;
+  const gfloat clip_min = mantiuk06_clip_min (n, Y_in);
+        guint  j;
+
+  _OMP (omp parallel for schedule(static))
+  for (j = 0; j < n * 4; j++)
+      if (G_UNLIKELY (rgb[j] < clip_min)) rgb[j] = clip_min;
+
+  /* Transform to linear scale RGB */
+  _OMP (omp parallel for schedule(static))
+  for (j = 0; j < n; j++)
+    {
+      const gfloat Y = MAX (Y_in[j], clip_min);
+
+      rgb[j * 4 + 0] = powf (rgb[j * 4 + 0] / Y, saturationFactor) * Y_out[j];
+      rgb[j * 4 + 1] = powf (rgb[j * 4 + 1] / Y, saturationFactor) * Y_out[j];
+      rgb[j * 4 + 2] = powf (rgb[j * 4 + 2] / Y, saturationFactor) * Y_out[j];
+    }
+}
+
 
 static void
 mantiuk06_prepare (GeglOperation *operation)
 {
-  const Babl *space = gegl_operation_get_source_space (operation, "input");
+  GeglProperties *o     = GEGL_PROPERTIES (operation);
+  const Babl     *space = gegl_operation_get_source_space (operation, "input");
   gegl_operation_set_format (operation, "input",  babl_format_with_space (OUTPUT_FORMAT, space));
   gegl_operation_set_format (operation, "output", babl_format_with_space (OUTPUT_FORMAT, space));
+
+  if (! o->user_data)
+    o->user_data = proxy_cache_new ();
 }
 
 static GeglRectangle
@@ -1567,6 +1706,13 @@ mantiuk06_get_required_for_output (GeglOperation        *operation,
   return mantiuk06_get_cached_region (operation, roi);
 }
 
+/* Abort the iterative solvers once the rendering job is cancelled */
+static gint
+mantiuk06_progress (gint progress)
+{
+  return gegl_parallel_is_cancelled () ? PFSTMO_CB_ABORT : PFSTMO_CB_CONTINUE;
+}
+
 static gboolean
 mantiuk06_process (GeglOperation       *operation,
                    GeglBuffer          *input,
@@ -1575,9 +1721,13 @@ mantiuk06_process (GeglOperation       *operation,
                    gint                 level)
 {
   const Babl *space = gegl_operation_get_source_space (operation, "input");
-  const GeglProperties *o      = GEGL_PROPERTIES (operation);
+  GeglProperties       *o      = GEGL_PROPERTIES (operation);
   const gint            pix_stride = 4; /* RGBA */
   gfloat               *lum, *pix;
+  GBytes               *state;
+  GeglRectangle         rect;
+  gdouble               params[1];
+  gint                  stamp;
 
   g_return_val_if_fail (operation, FALSE);
   g_return_val_if_fail (input, FALSE);
@@ -1586,21 +1736,54 @@ mantiuk06_process (GeglOperation       *operation,
 
   g_return_val_if_fail (babl_format_get_n_components (babl_format_with_space (OUTPUT_FORMAT, space)) == pix_stride, FALSE);
 
+  /* At mipmap levels > 0 we solve for a downscaled proxy of the input */
+  proxy_get_rect (result, level, &rect);
+
   /* Obtain the pixel data */
-  lum = g_new (gfloat, result->width * result->height),
-  gegl_buffer_get (input, result, 1.0, babl_format_with_space ("Y float", space),
+  lum = g_new (gfloat, rect.width * rect.height),
+  gegl_buffer_get (input, &rect, 1.0 / (1 << level),
+                   babl_format_with_space ("Y float", space),
                    lum, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  pix = g_new (gfloat, result->width * result->height * pix_stride);
-  gegl_buffer_get (input, result, 1.0, babl_format_with_space (OUTPUT_FORMAT, space),
+  pix = g_new (gfloat, rect.width * rect.height * pix_stride);
+  gegl_buffer_get (input, &rect, 1.0 / (1 << level),
+                   babl_format_with_space (OUTPUT_FORMAT, space),
                    pix, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  mantiuk06_contmap (result->width, result->height, pix, lum,
-                     o->contrast, o->saturation, FALSE, 200, 1e-3, NULL);
+  /* The tonemapped luminance doesn't depend on the saturation, reuse it
+   * when only that changed
+   */
+  params[0] = o->contrast;
+
+  state = proxy_cache_lookup (o->user_data, operation, &rect, level,
+                              params, G_N_ELEMENTS (params), &stamp);
+
+  if (! state)
+    {
+      gfloat *lum_map = g_new (gfloat, rect.width * rect.height);
+
+      memcpy (lum_map, lum, rect.width * rect.height * sizeof (gfloat));
+
+      mantiuk06_contmap_luminance (rect.width, rect.height, lum_map,
+                                   o->contrast, FALSE, 200, 1e-3,
+                                   mantiuk06_progress);
+
+      state = g_bytes_new_take (lum_map,
+                                rect.width * rect.height * sizeof (gfloat));
+
+      proxy_cache_store (o->user_data, stamp, &rect, level,
+                         params, G_N_ELEMENTS (params), state);
+    }
+
+  mantiuk06_contmap_color (rect.width, rect.height, pix, lum,
+                           g_bytes_get_data (state, NULL), o->saturation);
+
+  g_bytes_unref (state);
 
   /* Cleanup and set the output */
-  gegl_buffer_set (output, result, 0, babl_format_with_space (OUTPUT_FORMAT, space), pix,
-                   GEGL_AUTO_ROWSTRIDE);
+  if (! gegl_parallel_is_cancelled ())
+    gegl_buffer_set (output, &rect, level, babl_format_with_space (OUTPUT_FORMAT, space), pix,
+                     GEGL_AUTO_ROWSTRIDE);
   g_free (pix);
   g_free (lum);
 
@@ -1633,15 +1816,29 @@ mantiuk06_operation_process (GeglOperation        *operation,
                                    gegl_operation_context_get_level (context));
 }
 
+static void
+mantiuk06_finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, proxy_cache_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
+  GObjectClass             *object_class;
   GeglOperationClass       *operation_class;
   GeglOperationFilterClass *filter_class;
 
+  object_class    = G_OBJECT_CLASS (klass);
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  object_class->finalize = mantiuk06_finalize;
+
   filter_class->process = mantiuk06_process;
 
   operation_class->prepare                 = mantiuk06_prepare;
@@ -433,6 +433,258 @@ histogram_update (Histogram                  *hist,
     }
 }
 
+/* Constant-time median of square neighborhoods of quantized values, after
+ * Perreault and Hébert, "Median Filtering in Constant Time".
+ *
+ * Each column of the source keeps a histogram of the 2 * radius + 1 pixels
+ * of the column around the current row, which is updated by one pixel at
+ * the top and one pixel at the bottom as the row advances.  The histogram
+ * of the neighborhood is updated by adding the histogram of the column
+ * entering it and subtracting the histogram of the column leaving it, as it
+ * moves along the row, so that the cost per pixel doesn't depend on the
+ * radius.
+ *
+ * The histograms have CTMF_N_COARSE coarse bins of CTMF_N_FINE fine bins
+ * each.  The coarse bins of the neighborhood histogram are kept up to date,
+ * while its fine bins are only brought up to date when a percentile falls
+ * in their coarse bin.  The bins are updated a whole coarse or fine bin at a
+ * time, in loops that get vectorized by the compiler.
+ */
+
+#define CTMF_N_FINE     16
+#define CTMF_N_COARSE   (DEFAULT_N_BINS / CTMF_N_FINE)
+
+/* below this radius, moving a single histogram is faster */
+#define CTMF_MIN_RADIUS 8
+
+typedef struct
+{
+  gint32 coarse[CTMF_N_COARSE];
+  gint32 fine[CTMF_N_COARSE][CTMF_N_FINE];
+} CtmfHistogram;
+
+typedef struct
+{
+  CtmfHistogram hist;
+  /* the column up to which each group of fine bins is up to date, or
+   * G_MININT if it needs to be recomputed
+   */
+  gint          fine_x[CTMF_N_COARSE];
+} CtmfKernel;
+
+static inline void
+ctmf_column_modify (CtmfHistogram *columns,
+                    const gint32  *src,
+                    gint           width,
+                    gint           n_components,
+                    gint           n_color_components,
+                    gint           diff)
+{
+  gboolean has_alpha = n_color_components < n_components;
+  gint     x;
+  gint     c;
+
+  for (x = 0; x < width; x++, src += n_components, columns += n_components)
+    {
+      gint weight = diff;
+
+      if (has_alpha)
+        {
+          CtmfHistogram *column = &columns[n_color_components];
+          gint           bin    = src[n_color_components];
+
+          weight *= default_alpha_values[bin];
+
+          column->coarse[bin / CTMF_N_FINE]                    += diff;
+          column->fine[bin / CTMF_N_FINE][bin % CTMF_N_FINE] += diff;
+        }
+
+      for (c = 0; c < n_color_components; c++)
+        {
+          CtmfHistogram *column = &columns[c];
+          gint           bin    = src[c];
+
+          column->coarse[bin / CTMF_N_FINE]                    += weight;
+          column->fine[bin / CTMF_N_FINE][bin % CTMF_N_FINE] += weight;
+        }
+    }
+}
+
+static inline void
+ctmf_add_fine (gint32       *restrict dst,
+               const gint32 *restrict add,
+               const gint32 *restrict sub)
+{
+  gint i;
+
+  for (i = 0; i < CTMF_N_FINE; i++)
+    dst[i] += add[i] - sub[i];
+}
+
+/* brings the fine bins of coarse bin b of the kernel at column x up to
+ * date, where columns points to the histograms of the component, and the
+ * kernel covers the columns x .. x + size - 1
+ */
+static inline void
+ctmf_update_fine (CtmfKernel          *kernel,
+                  const CtmfHistogram *columns,
+                  gint                 n_components,
+                  gint                 size,
+                  gint                 b,
+                  gint                 x)
+{
+  gint32 *fine = kernel->hist.fine[b];
+  gint    k;
+  gint    i;
+
+  if (kernel->fine_x[b] == x)
+    return;
+
+  if (x - kernel->fine_x[b] > size)
+    {
+      memset (fine, 0, sizeof (kernel->hist.fine[b]));
+
+      for (k = x; k < x + size; k++)
+        {
+          const gint32 *add = columns[k * n_components].fine[b];
+
+          for (i = 0; i < CTMF_N_FINE; i++)
+            fine[i] += add[i];
+        }
+    }
+  else
+    {
+      for (k = kernel->fine_x[b] + 1; k <= x; k++)
+        {
+          ctmf_add_fine (fine,
+                         columns[(k + size - 1) * n_components].fine[b],
+                         columns[(k - 1)        * n_components].fine[b]);
+        }
+    }
+
+  kernel->fine_x[b] = x;
+}
+
+static inline gfloat
+ctmf_get_median (CtmfKernel          *kernel,
+                 const CtmfHistogram *columns,
+                 gint                 n_components,
+                 gint                 size,
+                 gint                 x,
+                 gdouble              percentile)
+{
+  const gint32 *coarse = kernel->hist.coarse;
+  const gint32 *fine;
+  gint          count  = 0;
+  gint          sum    = 0;
+  gint          b;
+  gint          i;
+
+  for (b = 0; b < CTMF_N_COARSE; b++)
+    count += coarse[b];
+
+  if (count == 0)
+    return 0.0f;
+
+  count = (gint) ceil (count * percentile);
+  count = MAX (count, 1);
+
+  for (b = 0; b < CTMF_N_COARSE - 1 && sum + coarse[b] < count; b++)
+    sum += coarse[b];
+
+  ctmf_update_fine (kernel, columns, n_components, size, b, x);
+
+  fine = kernel->hist.fine[b];
+
+  for (i = 0; i < CTMF_N_FINE - 1 && (sum += fine[i]) < count; i++);
+
+  return default_bin_values[b * CTMF_N_FINE + i];
+}
+
+static void
+ctmf_median (const gint32 *src,
+             gint          src_width,
+             gfloat       *dst,
+             gint          width,
+             gint          height,
+             gint          radius,
+             gint          n_components,
+             gint          n_color_components,
+             gdouble       percentile,
+             gdouble       alpha_percentile)
+{
+  const gint     size       = 2 * radius + 1;
+  const gint     src_stride = src_width * n_components;
+  CtmfHistogram *columns    = g_new0 (CtmfHistogram, src_stride);
+  CtmfKernel    *kernels    = g_new (CtmfKernel, n_components);
+  gint           x, y;
+  gint           c;
+  gint           b;
+
+  for (y = 0; y < size - 1; y++)
+    {
+      ctmf_column_modify (columns, src + y * src_stride, src_width,
+                          n_components, n_color_components, +1);
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      if (y > 0)
+        {
+          ctmf_column_modify (columns, src + (y - 1) * src_stride, src_width,
+                              n_components, n_color_components, -1);
+        }
+
+      ctmf_column_modify (columns, src + (y + size - 1) * src_stride,
+                          src_width, n_components, n_color_components, +1);
+
+      for (c = 0; c < n_components; c++)
+        {
+          CtmfKernel *kernel = &kernels[c];
+
+          memset (kernel->hist.coarse, 0, sizeof (kernel->hist.coarse));
+
+          for (x = 0; x < size; x++)
+            {
+              const gint32 *add = columns[x * n_components + c].coarse;
+
+              for (b = 0; b < CTMF_N_COARSE; b++)
+                kernel->hist.coarse[b] += add[b];
+            }
+
+          for (b = 0; b < CTMF_N_COARSE; b++)
+            kernel->fine_x[b] = G_MININT / 2;
+        }
+
+      for (x = 0; x < width; x++, dst += n_components)
+        {
+          for (c = 0; c < n_components; c++)
+            {
+              CtmfKernel *kernel = &kernels[c];
+
+              if (x > 0)
+                {
+                  const gint32 *restrict add =
+                    columns[(x + size - 1) * n_components + c].coarse;
+                  const gint32 *restrict sub =
+                    columns[(x - 1)        * n_components + c].coarse;
+
+                  for (b = 0; b < CTMF_N_COARSE; b++)
+                    kernel->hist.coarse[b] += add[b] - sub[b];
+                }
+
+              dst[c] = ctmf_get_median (kernel, columns + c, n_components,
+                                        size, x,
+                                        c < n_color_components ?
+                                          percentile : alpha_percentile);
+            }
+        }
+    }
+
+  g_free (kernels);
+  g_free (columns);
+}
+
 static void
 init_neighborhood_outline (GeglMedianBlurNeighborhood  neighborhood,
                            gint                        radius,
@@ -611,6 +863,125 @@ convert_values_to_bins (Histogram *hist,
     }
 }
 
+/* computes the percentiles of the neighborhoods of the width x height
+ * pixels of dst, by moving a single histogram along a serpentine path
+ */
+static void
+histogram_median (Histogram                  *hist,
+                  const gint32               *src_buf,
+                  gint                        src_width,
+                  gfloat                     *dst_buf,
+                  gint                        width,
+                  gint                        height,
+                  GeglMedianBlurNeighborhood  neighborhood,
+                  gint                        radius,
+                  const gint                 *neighborhood_outline,
+                  gdouble                     percentile,
+                  gdouble                     alpha_percentile)
+{
+  gint          n_components       = hist->n_components;
+  gint          n_color_components = hist->n_color_components;
+  gboolean      has_alpha          = n_color_components < n_components;
+  gint          src_stride         = src_width * n_components;
+  gint          dst_stride         = width * n_components;
+  gint          n_dst_pixels       = width * height;
+  const gint32 *src;
+  gfloat       *dst;
+  gint          dst_x, dst_y;
+  Direction     dir;
+  gint          i;
+  gint          c;
+
+  src = src_buf + radius * (src_width + 1) * n_components;
+  dst = dst_buf;
+
+  /* compute the first window */
+
+  for (i = -radius; i <= radius; i++)
+    {
+      histogram_modify_vals (hist, src, src_stride,
+                             i, -neighborhood_outline[abs (i)],
+                             i, +neighborhood_outline[abs (i)],
+                             +1);
+
+      hist->size += 2 * neighborhood_outline[abs (i)] + 1;
+    }
+
+  for (c = 0; c < n_color_components; c++)
+    dst[c] = histogram_get_median (hist, c, percentile);
+  if (has_alpha)
+    dst[c] = histogram_get_median (hist, c, alpha_percentile);
+
+  dst_x = 0;
+  dst_y = 0;
+
+  n_dst_pixels--;
+  dir = LEFT_TO_RIGHT;
+
+  while (n_dst_pixels--)
+    {
+      /* move the src coords based on current direction and positions */
+      if (dir == LEFT_TO_RIGHT)
+        {
+          if (dst_x != width - 1)
+            {
+              dst_x++;
+              src += n_components;
+              dst += n_components;
+            }
+          else
+            {
+              dst_y++;
+              src += src_stride;
+              dst += dst_stride;
+              dir = TOP_TO_BOTTOM;
+            }
+        }
+      else if (dir == TOP_TO_BOTTOM)
+        {
+          if (dst_x == 0)
+            {
+              dst_x++;
+              src += n_components;
+              dst += n_components;
+              dir = LEFT_TO_RIGHT;
+            }
+          else
+            {
+              dst_x--;
+              src -= n_components;
+              dst -= n_components;
+              dir = RIGHT_TO_LEFT;
+            }
+        }
+      else if (dir == RIGHT_TO_LEFT)
+        {
+          if (dst_x != 0)
+            {
+              dst_x--;
+              src -= n_components;
+              dst -= n_components;
+            }
+          else
+            {
+              dst_y++;
+              src += src_stride;
+              dst += dst_stride;
+              dir = TOP_TO_BOTTOM;
+            }
+        }
+
+      histogram_update (hist, src, src_stride,
+                        neighborhood, radius, neighborhood_outline,
+                        dir);
+
+      for (c = 0; c < n_color_components; c++)
+        dst[c] = histogram_get_median (hist, c, percentile);
+      if (has_alpha)
+        dst[c] = histogram_get_median (hist, c, alpha_percentile);
+    }
+}
+
 static void
 prepare (GeglOperation *operation)
 {
@@ -783,19 +1154,11 @@ process (GeglOperation       *operation,
   gint32         *src_buf;
   gfloat         *dst_buf;
   GeglRectangle   src_rect;
-  gint            src_stride;
-  gint            dst_stride;
   gint            n_src_pixels;
   gint            n_dst_pixels;
 
   Histogram      *hist;
 
-  const gint32   *src;
-  gfloat         *dst;
-  gint            dst_x, dst_y;
-  Direction       dir;
-
-  gint            i;
   gint            c;
 
   if (o->radius < 0)
@@ -842,8 +1205,6 @@ process (GeglOperation       *operation,
   hist->n_color_components = n_color_components;
 
   src_rect     = gegl_operation_get_required_for_output (operation, "input", roi);
-  src_stride   = src_rect.width * n_components;
-  dst_stride   = roi->width * n_components;
   n_src_pixels = src_rect.width * src_rect.height;
   n_dst_pixels = roi->width * roi->height;
   src_buf = g_new (gint32, n_src_pixels * n_components);
@@ -853,93 +1214,19 @@ process (GeglOperation       *operation,
                    GEGL_AUTO_ROWSTRIDE, get_abyss_policy (operation, "input"));
   convert_values_to_bins (hist, src_buf, n_src_pixels, data->quantize);
 
-  src = src_buf + radius * (src_rect.width + 1) * n_components;
-  dst = dst_buf;
-
-  /* compute the first window */
-
-  for (i = -radius; i <= radius; i++)
+  if (o->neighborhood == GEGL_MEDIAN_BLUR_NEIGHBORHOOD_SQUARE &&
+      data->quantize && radius >= CTMF_MIN_RADIUS)
     {
-      histogram_modify_vals (hist, src, src_stride,
-                             i, -neighborhood_outline[abs (i)],
-                             i, +neighborhood_outline[abs (i)],
-                             +1);
-
-      hist->size += 2 * neighborhood_outline[abs (i)] + 1;
+      ctmf_median (src_buf, src_rect.width, dst_buf, roi->width, roi->height,
+                   radius, n_components, n_color_components,
+                   percentile, alpha_percentile);
     }
-
-  for (c = 0; c < n_color_components; c++)
-    dst[c] = histogram_get_median (hist, c, percentile);
-  if (has_alpha)
-    dst[c] = histogram_get_median (hist, c, alpha_percentile);
-
-  dst_x = 0;
-  dst_y = 0;
-
-  n_dst_pixels--;
-  dir = LEFT_TO_RIGHT;
-
-  while (n_dst_pixels--)
+  else
     {
-      /* move the src coords based on current direction and positions */
-      if (dir == LEFT_TO_RIGHT)
-        {
-          if (dst_x != roi->width - 1)
-            {
-              dst_x++;
-              src += n_components;
-              dst += n_components;
-            }
-          else
-            {
-              dst_y++;
-              src += src_stride;
-              dst += dst_stride;
-              dir = TOP_TO_BOTTOM;
-            }
-        }
-      else if (dir == TOP_TO_BOTTOM)
-        {
-          if (dst_x == 0)
-            {
-              dst_x++;
-              src += n_components;
-              dst += n_components;
-              dir = LEFT_TO_RIGHT;
-            }
-          else
-            {
-              dst_x--;
-              src -= n_components;
-              dst -= n_components;
-              dir = RIGHT_TO_LEFT;
-            }
-        }
-      else if (dir == RIGHT_TO_LEFT)
-        {
-          if (dst_x != 0)
-            {
-              dst_x--;
-              src -= n_components;
-              dst -= n_components;
-            }
-          else
-            {
-              dst_y++;
-              src += src_stride;
-              dst += dst_stride;
-              dir = TOP_TO_BOTTOM;
-            }
-        }
-
-      histogram_update (hist, src, src_stride,
+      histogram_median (hist, src_buf, src_rect.width, dst_buf,
+                        roi->width, roi->height,
                         o->neighborhood, radius, neighborhood_outline,
-                        dir);
-
-      for (c = 0; c < n_color_components; c++)
-        dst[c] = histogram_get_median (hist, c, percentile);
-      if (has_alpha)
-        dst[c] = histogram_get_median (hist, c, alpha_percentile);
+                        percentile, alpha_percentile);
     }
 
   gegl_buffer_set (output, roi, 0, format, dst_buf, GEGL_AUTO_ROWSTRIDE);
@@ -286,6 +286,7 @@ gegl_op_class_init (GeglOpClass *klass)
   gegl_operation_class_set_keys (operation_class,
     "name"       , "gegl:opacity",
     "categories" , "transparency",
+    "commutes-with-transforms", "true",
     "title",       _("Opacity"),
     "reference-hash", "b20e8c1d7bb20af95f724191feb10103",
     "description",
@@ -213,6 +213,8 @@ gegl_op_class_init (GeglOpClass *klass)
     "description",
           _("Porter Duff operation over (also known as normal mode, and src-over) (d = cA + cB * (1 - aA))"),
     "cl-source"  , svg_src_over_cl_source,
+    "transparent-aux-passthrough", "true",
+    "opaque-aux-replaces", "true",
     NULL);
 }
 
@@ -68,6 +68,7 @@ property_enum   (sampler_type, _("Resampling method"),
 #include "config.h"
 #include <glib/gi18n-lib.h>
 #include "gegl-op.h"
+#include "warp-map-common.h"
 
 typedef struct _Transform Transform;
 struct _Transform
@@ -260,6 +261,9 @@ prepare (GeglOperation *operation)
 
   gegl_operation_set_format (operation, "input", format);
   gegl_operation_set_format (operation, "output", format);
+
+  if (! o->user_data)
+    o->user_data = warp_map_cache_new ();
 }
 
 static GeglRectangle
@@ -321,6 +325,108 @@ get_required_for_output (GeglOperation       *operation,
   return result;
 }
 
+typedef struct
+{
+  Transform transform;
+  gint      factor;
+  gfloat    ud;
+} PanoramaMap;
+
+/* the source coordinates of the pixels of @rect, and, if @jacobians is not
+ * NULL, the neighborhood scale matrices to sample them with.
+ *
+ * u and v are computed for each pixel, rather than accumulated along each
+ * processed chunk, so that a tile of the map doesn't depend on the region it
+ * was first computed for.  this differs from the accumulated coordinates by
+ * float rounding.
+ */
+static void
+panorama_map_func (PanoramaMap         *map,
+                   const GeglRectangle *rect,
+                   gint                 level,
+                   gfloat              *coords,
+                   gfloat              *jacobians)
+{
+  Transform *transform = &map->transform;
+  gint       factor    = map->factor;
+  float      ud        = map->ud;
+  gint       x, y;
+
+  for (y = rect->y; y < rect->y + rect->height; y++)
+    {
+      float v = ((y*factor * 1.0/transform->height));
+
+      for (x = rect->x; x < rect->x + rect->width; x++)
+        {
+          float u = (((x*factor * 1.0f)/transform->width));
+          float cx, cy;
+
+          if (jacobians)
+            {
+              GeglBufferMatrix2 scale_matrix;
+
+/* we need our own jacobian matrix approximator,
+ * since we do not operate on pixel values
+ */
+#define gegl_sampler_compute_scale2(matrix, x, y)        \
+{                                                        \
+  float ax, ay, bx, by;                                  \
+  gegl_unmap(x + 0.5 * ud, y, ax, ay);                   \
+  gegl_unmap(x - 0.5 * ud, y, bx, by);                   \
+  matrix.coeff[0][0] = (ax - bx);   \
+  matrix.coeff[1][0] = (ay - by);  \
+  gegl_unmap(x, y + 0.5 * ud, ax, ay);                   \
+  gegl_unmap(x, y - 0.5 * ud, bx, by);                   \
+  matrix.coeff[0][1] = (ax - bx);   \
+  matrix.coeff[1][1] = (ay - by);  \
+}
+
+#define gegl_unmap(xx,yy,ud,vd) {                                   \
+                  float rx, ry;                                     \
+                  transform->mapfun (transform, xx, yy, &rx, &ry);  \
+                  ud = rx;vd = ry;}
+              gegl_sampler_compute_scale2 (scale_matrix, u, v);
+              gegl_unmap(u,v, cx, cy);
+#undef gegl_unmap
+#undef gegl_sampler_compute_scale2
+
+              if (scale_matrix.coeff[0][0] > 0.5f)
+                scale_matrix.coeff[0][0] = (scale_matrix.coeff[0][0]-1.0) * transform->in_width;
+              else if (scale_matrix.coeff[0][0] < -0.5f)
+                scale_matrix.coeff[0][0] = (scale_matrix.coeff[0][0]+1.0) * transform->in_width;
+              else
+                scale_matrix.coeff[0][0] *= transform->in_width;
+
+              if (scale_matrix.coeff[0][1] > 0.5f)
+                scale_matrix.coeff[0][1] = (scale_matrix.coeff[0][1]-1.0) * transform->in_width;
+              else if (scale_matrix.coeff[0][1] < -0.5f)
+                scale_matrix.coeff[0][1] = (scale_matrix.coeff[0][1]+1.0) * transform->in_width;
+              else
+                scale_matrix.coeff[0][1] *= transform->in_width;
+
+              scale_matrix.coeff[1][1] *= transform->in_height;
+              scale_matrix.coeff[1][0] *= transform->in_height;
+
+              jacobians[0] = scale_matrix.coeff[0][0];
+              jacobians[1] = scale_matrix.coeff[0][1];
+              jacobians[2] = scale_matrix.coeff[1][0];
+              jacobians[3] = scale_matrix.coeff[1][1];
+
+              jacobians += 4;
+            }
+          else
+            {
+              transform->mapfun (transform, u, v, &cx, &cy);
+            }
+
+          coords[0] = cx * transform->in_width + 0.5f;
+          coords[1] = cy * transform->in_height + 0.5f;
+
+          coords += 2;
+        }
+    }
+}
+
 static gboolean
 process (GeglOperation       *operation,
          GeglBuffer          *input,
@@ -329,24 +435,25 @@ process (GeglOperation       *operation,
          gint                 level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
-  Transform           transform;
+  PanoramaMap         panorama_map;
+  Transform          *transform    = &panorama_map.transform;
   GeglSampler        *sampler;
   gint                factor       = 1 << level;
   GeglBufferIterator *it;
-  GeglBufferMatrix2   scale_matrix;
-  GeglBufferMatrix2  *scale        = NULL;
+  gboolean            scale        = FALSE;
   gint                sampler_type = o->sampler_type;
   const Babl         *format_io    = gegl_operation_get_format (operation, "output");
-  GeglSamplerGetFun   getfun;
+  WarpMap            *map;
+  gdouble             params[10];
 
   level = 0;
   factor = 1;
-  prepare_transform2 (&transform, operation, level);
+  prepare_transform2 (transform, operation, level);
 
   if (level)
     sampler_type = GEGL_SAMPLER_NEAREST;
 
-  if (transform.reverse)
+  if (transform->reverse)
   {
     /* artifacts have been observed with these samplers */
     if (sampler_type == GEGL_SAMPLER_NOHALO ||
@@ -358,125 +465,45 @@ process (GeglOperation       *operation,
       !(o->inverse == FALSE && abs(o->tilt < 33)))
     /* skip the computation of sampler neighborhood scale matrix in cases where
      * we are unlikely to be scaling down */
-    scale = &scale_matrix;
+    scale = TRUE;
 
   sampler = gegl_buffer_sampler_new_at_level (input, format_io, sampler_type, 0);
-  getfun = gegl_sampler_get_fun (sampler);
+
+  panorama_map.factor = factor;
+  panorama_map.ud     = ((1.0f/transform->width)*factor);
+
+  /* the mapping only depends on the geometry, keep it across renders */
+  params[0] = o->pan;
+  params[1] = o->tilt;
+  params[2] = o->spin;
+  params[3] = o->zoom;
+  params[4] = o->width;
+  params[5] = o->height;
+  params[6] = o->inverse;
+  params[7] = transform->in_width;
+  params[8] = transform->in_height;
+  params[9] = factor;
+
+  map = warp_map_cache_get (o->user_data, params, G_N_ELEMENTS (params),
+                            scale);
 
   {
-    float   ud = ((1.0f/transform.width)*factor);
-    float   vd = ((1.0f/transform.height)*factor);
-    int abyss_mode = transform.reverse ? GEGL_ABYSS_NONE : GEGL_ABYSS_LOOP;
+    int abyss_mode = transform->reverse ? GEGL_ABYSS_NONE : GEGL_ABYSS_LOOP;
 
     it = gegl_buffer_iterator_new (output, result, level, format_io,
                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
 
     while (gegl_buffer_iterator_next (it))
       {
-        GeglRectangle *roi = &it->items[0].roi;
-        gint i;
-        gint n_pixels = it->length;
-        gint x = roi->width; /* initial x                   */
-
-        float   u0 = (((roi->x*factor * 1.0f)/transform.width));
-        float   u, v;
-
-        float *out = it->items[0].data;
-
-        u = u0;
-        v = ((roi->y*factor * 1.0/transform.height));
-
-        if (scale)
-          {
-            for (i=0; i<n_pixels; i++)
-              {
-                float cx, cy;
-/* we need our own jacobian matrix approximator,
- * since we do not operate on pixel values
- */
-#define gegl_sampler_compute_scale2(matrix, x, y)        \
-{                                                        \
-  float ax, ay, bx, by;                                  \
-  gegl_unmap(x + 0.5 * ud, y, ax, ay);                   \
-  gegl_unmap(x - 0.5 * ud, y, bx, by);                   \
-  matrix.coeff[0][0] = (ax - bx);   \
-  matrix.coeff[1][0] = (ay - by);  \
-  gegl_unmap(x, y + 0.5 * ud, ax, ay);                   \
-  gegl_unmap(x, y - 0.5 * ud, bx, by);                   \
-  matrix.coeff[0][1] = (ax - bx);   \
-  matrix.coeff[1][1] = (ay - by);  \
-}
-
-#define gegl_unmap(xx,yy,ud,vd) {                                  \
-                  float rx, ry;                                    \
-                  transform.mapfun (&transform, xx, yy, &rx, &ry); \
-                  ud = rx;vd = ry;}
-                gegl_sampler_compute_scale2 (scale_matrix, u, v);
-                gegl_unmap(u,v, cx, cy);
-#undef gegl_unmap
-
-#if 1
-                if (scale_matrix.coeff[0][0] > 0.5f)
-                  scale_matrix.coeff[0][0] = (scale_matrix.coeff[0][0]-1.0) * transform.in_width;
-                else if (scale_matrix.coeff[0][0] < -0.5f) 
-                  scale_matrix.coeff[0][0] = (scale_matrix.coeff[0][0]+1.0) * transform.in_width;
-                else
-                  scale_matrix.coeff[0][0] *= transform.in_width;
-
-                if (scale_matrix.coeff[0][1] > 0.5f)
-                  scale_matrix.coeff[0][1] = (scale_matrix.coeff[0][1]-1.0) * transform.in_width;
-                else if (scale_matrix.coeff[0][1] < -0.5f)
-                  scale_matrix.coeff[0][1] = (scale_matrix.coeff[0][1]+1.0) * transform.in_width;
-                else
-                  scale_matrix.coeff[0][1] *= transform.in_width;
-
-                scale_matrix.coeff[1][1] *= transform.in_height;
-                scale_matrix.coeff[1][0] *= transform.in_height;
-#endif
-                getfun (sampler,
-                        cx * transform.in_width + 0.5f,
-                        cy * transform.in_height + 0.5f,
-                        scale, out, abyss_mode);
-
-                out += 4;
-
-                /* update x, y and u,v coordinates */
-                x--;
-                u+=ud;
-                if (x == 0)
-                  {
-                    x = roi->width;
-                    u = u0;
-                    v += vd;
-                  }
-              }
-          }
-        else
-          {
-            for (i=0; i<n_pixels; i++)
-              {
-                float cx, cy;
-                transform.mapfun (&transform, u, v, &cx, &cy);
-                getfun (sampler,
-                        cx * transform.in_width + 0.5f,
-                        cy * transform.in_height + 0.5f,
-                        scale, out, abyss_mode);
-                out += 4;
-
-                /* update x, y and u,v coordinates */
-                x--;
-                u+=ud;
-                if (x <= 0)
-                  {
-                    x = roi->width;
-                    u = u0;
-                    v += vd;
-                  }
-              }
-          }
+        warp_map_process (map, &it->items[0].roi, level,
+                          (WarpMapFunc) panorama_map_func, &panorama_map,
+                          sampler, abyss_mode, 4,
+                          NULL, it->items[0].data);
       }
   }
 
+  warp_map_unref (map);
+
   g_object_unref (sampler);
   return TRUE;
 }
@@ -507,6 +534,16 @@ operation_process (GeglOperation        *operation,
                                    gegl_operation_context_get_level (context));
 }
 
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, warp_map_cache_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static gchar *composition = "<?xml version='1.0' encoding='UTF-8'?>"
     "<gegl>"
     "<node operation='gegl:panorama-projection' width='200' height='200'/>"
@@ -520,11 +557,14 @@ static gchar *composition = "<?xml version='1.0' encoding='UTF-8'?>"
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
+  GObjectClass               *object_class;
   GeglOperationClass         *operation_class;
   GeglOperationFilterClass *filter_class;
+  object_class    = G_OBJECT_CLASS (klass);
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class  = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  object_class->finalize                   = finalize;
   filter_class->process                    = process;
   operation_class->prepare                 = prepare;
   operation_class->process                 = operation_process;
@@ -537,8 +577,7 @@ gegl_op_class_init (GeglOpClass *klass)
     "title",                 _("Panorama Projection"),
     "categories" ,           "map",
     "position-dependent",    "true",
-    "reference-hash",        "3ab9831053ff0a9e32623ecc8a148e67",
-    "reference-hashB",       "cf1ca4a0ffba4ca6157768a34653935d",
+    "reference-hash",        "unstable",
     "reference-composition", composition,
     "description", _("Do panorama viewer rendering mapping or its inverse for an equirectangular input image. (2:1 ratio containing 360x180 degree panorama)."),
     NULL);
@@ -0,0 +1,218 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Helpers for operations which derive global state (statistics, or the
+ * solution of an equation over the whole image) from their entire input,
+ * like the global tone mappers.
+ *
+ * When rendering at a mipmap level > 0, such operations compute their state
+ * and their output from a downscaled proxy of the input, covering
+ * proxy_get_rect() of the processed rectangle, and write the output at that
+ * level; this is what the level-aware point filters do as well.
+ *
+ * The computed state can be kept in a ProxyCache, which holds on to it until
+ * the input of the operation is invalidated, so that changing properties
+ * that only affect how the state is applied doesn't recompute it.  The
+ * properties the state does depend on are passed as an array of parameters.
+ * The state is kept as a GBytes, so that it stays alive while it's used,
+ * even if another thread replaces it; states larger than
+ * PROXY_CACHE_MAX_SIZE bytes aren't kept, and a cached state is dropped as
+ * soon as it doesn't match a lookup, e.g. when the level changes.
+ *
+ * Operations create their cache in prepare(), since process() may run in
+ * several threads at once.
+ */
+
+#ifndef __PROXY_COMMON_H__
+#define __PROXY_COMMON_H__
+
+#define PROXY_CACHE_MAX_PARAMS 8
+#define PROXY_CACHE_MAX_SIZE   (64 << 20)
+
+typedef struct
+{
+  GMutex          mutex;
+
+  GeglNode       *source;   /* weak pointer */
+  gulong          handler;
+  gint            stamp;    /* incremented whenever the input changes */
+
+  GBytes         *data;
+  gint            data_stamp;
+  GeglRectangle   data_rect;
+  gint            data_level;
+  gdouble         data_params[PROXY_CACHE_MAX_PARAMS];
+} ProxyCache;
+
+
+/* the rectangle of the proxy, in the coordinates of @level, like the point
+ * filters compute it
+ */
+static inline void
+proxy_get_rect (const GeglRectangle *rect,
+                gint                 level,
+                GeglRectangle       *proxy_rect)
+{
+  proxy_rect->x      = rect->x      >> level;
+  proxy_rect->y      = rect->y      >> level;
+  proxy_rect->width  = rect->width  >> level;
+  proxy_rect->height = rect->height >> level;
+}
+
+static void
+proxy_cache_source_invalidated (GeglNode            *source,
+                                const GeglRectangle *rect,
+                                ProxyCache          *cache)
+{
+  g_atomic_int_inc (&cache->stamp);
+}
+
+static void
+proxy_cache_disconnect (ProxyCache *cache)
+{
+  if (cache->source)
+    {
+      g_signal_handler_disconnect (cache->source, cache->handler);
+      g_object_remove_weak_pointer (G_OBJECT (cache->source),
+                                    (gpointer *) &cache->source);
+
+      cache->source  = NULL;
+      cache->handler = 0;
+    }
+}
+
+static ProxyCache *
+proxy_cache_new (void)
+{
+  ProxyCache *cache = g_slice_new0 (ProxyCache);
+
+  g_mutex_init (&cache->mutex);
+
+  return cache;
+}
+
+static void
+proxy_cache_free (ProxyCache *cache)
+{
+  proxy_cache_disconnect (cache);
+
+  g_clear_pointer (&cache->data, g_bytes_unref);
+
+  g_mutex_clear (&cache->mutex);
+
+  g_slice_free (ProxyCache, cache);
+}
+
+/* returns a reference to the cached state matching @rect, @level and
+ * @params, which the caller should release using g_bytes_unref(), or NULL.
+ * @stamp receives the stamp to pass to proxy_cache_store() along with the
+ * state computed by the caller.
+ */
+static GBytes *
+proxy_cache_lookup (ProxyCache          *cache,
+                    GeglOperation       *operation,
+                    const GeglRectangle *rect,
+                    gint                 level,
+                    const gdouble       *params,
+                    gint                 n_params,
+                    gint                *stamp)
+{
+  GeglNode *source;
+  GBytes   *data = NULL;
+
+  g_return_val_if_fail (n_params <= PROXY_CACHE_MAX_PARAMS, NULL);
+
+  source = gegl_operation_get_source_node (operation, "input");
+
+  g_mutex_lock (&cache->mutex);
+
+  /* track invalidations of whatever our input is connected to */
+  if (source != cache->source)
+    {
+      proxy_cache_disconnect (cache);
+
+      if (source)
+        {
+          cache->source  = source;
+          cache->handler = g_signal_connect (
+            source, "invalidated",
+            G_CALLBACK (proxy_cache_source_invalidated), cache);
+          g_object_add_weak_pointer (G_OBJECT (source),
+                                     (gpointer *) &cache->source);
+        }
+
+      g_atomic_int_inc (&cache->stamp);
+    }
+
+  *stamp = g_atomic_int_get (&cache->stamp);
+
+  if (cache->data                                     &&
+      cache->source                                   &&
+      cache->data_stamp == *stamp                     &&
+      cache->data_level == level                      &&
+      gegl_rectangle_equal (&cache->data_rect, rect)  &&
+      ! memcmp (cache->data_params, params, n_params * sizeof (gdouble)))
+    {
+      data = g_bytes_ref (cache->data);
+    }
+  else
+    {
+      /* the caller is about to compute a new state; don't hold on to the
+       * stale one meanwhile
+       */
+      g_clear_pointer (&cache->data, g_bytes_unref);
+    }
+
+  g_mutex_unlock (&cache->mutex);
+
+  return data;
+}
+
+/* keeps a reference to @data, unless it's too large to be cached */
+static void
+proxy_cache_store (ProxyCache          *cache,
+                   gint                 stamp,
+                   const GeglRectangle *rect,
+                   gint                 level,
+                   const gdouble       *params,
+                   gint                 n_params,
+                   GBytes              *data)
+{
+  g_return_if_fail (n_params <= PROXY_CACHE_MAX_PARAMS);
+
+  /* don't keep the state of cancelled jobs around */
+  if (gegl_parallel_is_cancelled () ||
+      g_bytes_get_size (data) > PROXY_CACHE_MAX_SIZE)
+    {
+      return;
+    }
+
+  g_mutex_lock (&cache->mutex);
+
+  g_clear_pointer (&cache->data, g_bytes_unref);
+
+  cache->data       = g_bytes_ref (data);
+  cache->data_stamp = stamp;
+  cache->data_rect  = *rect;
+  cache->data_level = level;
+
+  memset (cache->data_params, 0, sizeof (cache->data_params));
+  memcpy (cache->data_params, params, n_params * sizeof (gdouble));
+
+  g_mutex_unlock (&cache->mutex);
+}
+
+#endif /* __PROXY_COMMON_H__ */
@@ -0,0 +1,241 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Helpers for blurs which, when their radius is large, blur a copy of their
+ * input decimated by a power-of-two factor, and interpolate the result back
+ * to full resolution, like gegl:gblur-1d and gegl:lens-blur.
+ *
+ * Decimated sample j covers the full-resolution samples
+ * [j * factor, (j + 1) * factor), whatever the processed region, so that the
+ * results of adjacent regions match; this is also how the mipmap levels of a
+ * buffer are laid out, for a factor of 1 << level.  Full-resolution samples
+ * are linearly interpolated from the centers of the decimated samples.
+ *
+ * These functions work on n interleaved lines, whose consecutive samples are
+ * n floats apart; a single row of pixels is nc interleaved lines.
+ *
+ * This file is included by C++ operations as well.
+ */
+
+#ifndef __PYRAMID_COMMON_H__
+#define __PYRAMID_COMMON_H__
+
+/* the maximal decimation factor */
+#define PYRAMID_MAX_FACTOR (1 << 8)
+
+static inline gint
+pyramid_div_floor (gint a,
+                   gint b)
+{
+  /* we assume b is positive */
+  if (a < 0) a -= b - 1;
+  return a / b;
+}
+
+/* returns the largest power of two not larger than @max_factor, or 1 */
+static inline gint
+pyramid_get_factor (gdouble max_factor)
+{
+  gint factor = 1;
+
+  while (2 * factor <= max_factor && factor < PYRAMID_MAX_FACTOR)
+    factor *= 2;
+
+  return factor;
+}
+
+/* the decimated samples covering the @len samples starting at @offset */
+static inline void
+pyramid_get_decimated_range (gint  offset,
+                             gint  len,
+                             gint  factor,
+                             gint *d_offset,
+                             gint *d_len)
+{
+  *d_offset = pyramid_div_floor (offset, factor);
+  *d_len    = pyramid_div_floor (offset + len - 1, factor) - *d_offset + 1;
+}
+
+/* the decimated samples needed to interpolate the @len samples starting at
+ * @offset
+ */
+static inline void
+pyramid_get_source_range (gint  offset,
+                          gint  len,
+                          gint  factor,
+                          gint *d_offset,
+                          gint *d_len)
+{
+  *d_offset = pyramid_div_floor (2 * offset - factor + 1, 2 * factor);
+  *d_len    = pyramid_div_floor (2 * (offset + len - 1) - factor + 1,
+                                 2 * factor) + 2 - *d_offset;
+}
+
+/* the decimated samples full-resolution sample @i is interpolated from,
+ * relative to @d_offset, and the weight of the second one.  samples past
+ * the ends of the decimated range get the value of the nearest end.
+ */
+static inline void
+pyramid_get_weights (gint    i,
+                     gint    d_offset,
+                     gint    d_len,
+                     gint    factor,
+                     gint   *j0,
+                     gint   *j1,
+                     gfloat *w1)
+{
+  const gint num = 2 * i - factor + 1;
+  const gint den = 2 * factor;
+  gint       j   = pyramid_div_floor (num, den);
+
+  *w1 = (gfloat) (num - j * den) / den;
+
+  j -= d_offset;
+
+  if (j < 0)
+    {
+      *j0 = *j1 = 0;
+      *w1 = 0.0f;
+    }
+  else if (j >= d_len - 1)
+    {
+      *j0 = *j1 = d_len - 1;
+      *w1 = 0.0f;
+    }
+  else
+    {
+      *j0 = j;
+      *j1 = j + 1;
+    }
+}
+
+/* averages the @len samples of @src, the first of which is at @offset, into
+ * the samples of pyramid_get_decimated_range(), which are stored in @dst.
+ * the decimated samples at the ends of the range only average the samples
+ * of @src they cover.
+ */
+static inline void
+pyramid_decimate_lines (const gfloat *src,
+                        gint          offset,
+                        gint          len,
+                        gint          n,
+                        gint          factor,
+                        gfloat       *dst)
+{
+  gint d_offset, d_len;
+  gint j;
+
+  pyramid_get_decimated_range (offset, len, factor, &d_offset, &d_len);
+
+  for (j = 0; j < d_len; j++)
+    {
+      const gint    i0 = MAX ((d_offset + j)     * factor, offset);
+      const gint    i1 = MIN ((d_offset + j + 1) * factor, offset + len);
+      const gfloat  w  = 1.0f / (i1 - i0);
+      gfloat       *d  = dst + (gsize) j * n;
+      gint          i, l;
+
+      for (l = 0; l < n; l++)
+        d[l] = 0.0f;
+
+      for (i = i0; i < i1; i++)
+        {
+          const gfloat *s = src + (gsize) (i - offset) * n;
+
+          for (l = 0; l < n; l++)
+            d[l] += s[l];
+        }
+
+      for (l = 0; l < n; l++)
+        d[l] *= w;
+    }
+}
+
+/* interpolates the @len samples starting at @offset into @dst, from the
+ * @d_len decimated samples of @src, the first of which is at @d_offset
+ */
+static inline void
+pyramid_interpolate_lines (const gfloat *src,
+                           gint          d_offset,
+                           gint          d_len,
+                           gint          n,
+                           gint          factor,
+                           gfloat       *dst,
+                           gint          offset,
+                           gint          len)
+{
+  gint i;
+
+  for (i = 0; i < len; i++)
+    {
+      const gfloat *s0;
+      const gfloat *s1;
+      gfloat       *d = dst + (gsize) i * n;
+      gfloat        w1;
+      gint          j0, j1;
+      gint          l;
+
+      pyramid_get_weights (offset + i, d_offset, d_len, factor, &j0, &j1, &w1);
+
+      s0 = src + (gsize) j0 * n;
+      s1 = src + (gsize) j1 * n;
+
+      for (l = 0; l < n; l++)
+        d[l] = s0[l] + w1 * (s1[l] - s0[l]);
+    }
+}
+
+/* interpolates @rect into @dst, from the pixels of @d_rect, of @nc
+ * components, stored in @src.  both buffers are tightly packed.
+ */
+static inline void
+pyramid_interpolate (const gfloat        *src,
+                     const GeglRectangle *d_rect,
+                     gfloat              *dst,
+                     const GeglRectangle *rect,
+                     gint                 factor,
+                     gint                 nc)
+{
+  const gint  d_stride = d_rect->width * nc;
+  gfloat     *row      = g_new (gfloat, d_stride);
+  gint        y;
+
+  for (y = 0; y < rect->height; y++)
+    {
+      const gfloat *s0;
+      const gfloat *s1;
+      gfloat        w1;
+      gint          j0, j1;
+      gint          l;
+
+      pyramid_get_weights (rect->y + y, d_rect->y, d_rect->height, factor,
+                           &j0, &j1, &w1);
+
+      s0 = src + (gsize) j0 * d_stride;
+      s1 = src + (gsize) j1 * d_stride;
+
+      for (l = 0; l < d_stride; l++)
+        row[l] = s0[l] + w1 * (s1[l] - s0[l]);
+
+      pyramid_interpolate_lines (row, d_rect->x, d_rect->width, nc, factor,
+                                 dst + (gsize) y * rect->width * nc,
+                                 rect->x, rect->width);
+    }
+
+  g_free (row);
+}
+
+#endif /* __PYRAMID_COMMON_H__ */
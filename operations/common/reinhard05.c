@@ -41,6 +41,7 @@ property_double (light, _("Light adaptation"), 1.0)
 #define GEGL_OP_C_SOURCE reinhard05.c
 
 #include "gegl-op.h"
+#include "proxy-common.h"
 
 
 typedef struct {
@@ -48,6 +49,15 @@ typedef struct {
   guint  num;
 } stats;
 
+/* the statistics of the input, which don't depend on the properties, and
+ * are kept in the proxy cache
+ */
+typedef struct {
+  stats world_lin,
+        world_log,
+        channel[3];
+} input_stats;
+
 
 static const gchar *OUTPUT_FORMAT = "RGBA float";
 
@@ -55,9 +65,13 @@ static const gchar *OUTPUT_FORMAT = "RGBA float";
 static void
 reinhard05_prepare (GeglOperation *operation)
 {
-  const Babl *space = gegl_operation_get_source_space (operation, "input");
+  GeglProperties *o     = GEGL_PROPERTIES (operation);
+  const Babl     *space = gegl_operation_get_source_space (operation, "input");
   gegl_operation_set_format (operation, "input",  babl_format_with_space (OUTPUT_FORMAT, space));
   gegl_operation_set_format (operation, "output", babl_format_with_space (OUTPUT_FORMAT, space));
+
+  if (! o->user_data)
+    o->user_data = proxy_cache_new ();
 }
 
 static GeglRectangle
@@ -128,7 +142,7 @@ reinhard05_process (GeglOperation       *operation,
                     gint                 level)
 {
   const Babl *space = gegl_operation_get_format (operation, "output"); /* the format is sufficent */
-  const GeglProperties *o = GEGL_PROPERTIES (operation);
+  GeglProperties *o = GEGL_PROPERTIES (operation);
 
   const gint  pix_stride = 4, /* RGBA */
               RGB        = 3;
@@ -141,12 +155,13 @@ reinhard05_process (GeglOperation       *operation,
           light      =       o->light,
           light_comp = 1.0 - o->light;
 
-  stats   world_lin,
-          world_log,
-          channel [RGB],
-          normalise;
-
-  gint    i, c;
+  input_stats    in;
+  GBytes        *state;
+  stats          normalise;
+  GeglRectangle  rect;
+  gdouble        params[1] = { 0.0 };
+  gint           stamp;
+  gint           i, c, n_pixels;
 
   g_return_val_if_fail (operation, FALSE);
   g_return_val_if_fail (input, FALSE);
@@ -160,55 +175,83 @@ reinhard05_process (GeglOperation       *operation,
   g_return_val_if_fail (light      >= 0.0 && light      <= 1.0, FALSE);
   g_return_val_if_fail (light_comp >= 0.0 && light_comp <= 1.0, FALSE);
 
+  /* At mipmap levels > 0 we work on a downscaled proxy of the input */
+  proxy_get_rect (result, level, &rect);
+  n_pixels = rect.width * rect.height;
 
   /* Obtain the pixel data */
-  lum = g_new (gfloat, result->width * result->height),
-  gegl_buffer_get (input, result, 1.0, babl_format_with_space ("Y float", space),
+  lum = g_new (gfloat, n_pixels),
+  gegl_buffer_get (input, &rect, 1.0 / (1 << level),
+                   babl_format_with_space ("Y float", space),
                    lum, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  pix = g_new (gfloat, result->width * result->height * pix_stride);
-  gegl_buffer_get (input, result, 1.0, babl_format_with_space (OUTPUT_FORMAT, space),
+  pix = g_new (gfloat, n_pixels * pix_stride);
+  gegl_buffer_get (input, &rect, 1.0 / (1 << level),
+                   babl_format_with_space (OUTPUT_FORMAT, space),
                    pix, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  /* Collect the image stats, averages, etc */
-  reinhard05_stats_start (&world_lin);
-  reinhard05_stats_start (&world_log);
-  reinhard05_stats_start (&normalise);
-  for (i = 0; i < RGB; ++i)
+  /* Collect the image stats, averages, etc, unless the input didn't change */
+  state = proxy_cache_lookup (o->user_data, operation, &rect, level,
+                              params, 0, &stamp);
+
+  if (state)
     {
-      reinhard05_stats_start (channel + i);
+      memcpy (&in, g_bytes_get_data (state, NULL), sizeof (in));
     }
-
-  for (i = 0; i < result->width * result->height; ++i)
+  else
     {
-      reinhard05_stats_update (&world_lin,                 lum[i] );
-      reinhard05_stats_update (&world_log, logf (2.3e-5f + lum[i]));
+      reinhard05_stats_start (&in.world_lin);
+      reinhard05_stats_start (&in.world_log);
+      for (i = 0; i < RGB; ++i)
+        {
+          reinhard05_stats_start (in.channel + i);
+        }
 
-      for (c = 0; c < RGB; ++c)
+      for (i = 0; i < n_pixels; ++i)
         {
-          reinhard05_stats_update (channel + c, pix[i * pix_stride + c]);
+          reinhard05_stats_update (&in.world_lin,                 lum[i] );
+          reinhard05_stats_update (&in.world_log, logf (2.3e-5f + lum[i]));
+
+          for (c = 0; c < RGB; ++c)
+            {
+              reinhard05_stats_update (in.channel + c, pix[i * pix_stride + c]);
+            }
+        }
+
+      if (in.world_lin.min < 0.0)
+        {
+          g_free (pix);
+          g_free (lum);
+          g_return_val_if_reached (FALSE);
         }
-    }
 
-  g_return_val_if_fail (world_lin.min >= 0.0, FALSE);
+      reinhard05_stats_finish (&in.world_lin);
+      reinhard05_stats_finish (&in.world_log);
+      for (i = 0; i < RGB; ++i)
+        {
+          reinhard05_stats_finish (in.channel + i);
+        }
 
-  reinhard05_stats_finish (&world_lin);
-  reinhard05_stats_finish (&world_log);
-  for (i = 0; i < RGB; ++i)
-    {
-      reinhard05_stats_finish (channel + i);
+      state = g_bytes_new (&in, sizeof (in));
+
+      proxy_cache_store (o->user_data, stamp, &rect, level, params, 0,
+                         state);
     }
 
+  g_bytes_unref (state);
+
+  reinhard05_stats_start (&normalise);
+
   /* Calculate key parameters */
-  key       = (logf (world_lin.max) -                 world_log.avg) /
-              (logf (world_lin.max) - logf (2.3e-5f + world_lin.min));
+  key       = (logf (in.world_lin.max) -                 in.world_log.avg) /
+              (logf (in.world_lin.max) - logf (2.3e-5f + in.world_lin.min));
   contrast  = 0.3 + 0.7 * powf (key, 1.4);
   intensity = expf (-o->brightness);
 
   g_return_val_if_fail (contrast >= 0.3 && contrast <= 1.0, FALSE);
 
   /* Apply the operator */
-  for (i = 0; i < result->width * result->height; ++i)
+  for (i = 0; i < n_pixels; ++i)
     {
       gfloat local, global, adapt;
 
@@ -222,8 +265,8 @@ reinhard05_process (GeglOperation       *operation,
 
           local  = chrom      * p +
                    chrom_comp * lum[i];
-          global = chrom      * channel[c].avg +
-                   chrom_comp * world_lin.avg;
+          global = chrom      * in.channel[c].avg +
+                   chrom_comp * in.world_lin.avg;
           adapt  = light      * local +
                    light_comp * global;
 
@@ -236,7 +279,7 @@ reinhard05_process (GeglOperation       *operation,
   /* Normalise the pixel values */
   reinhard05_stats_finish (&normalise);
 
-  for (i = 0; i < result->width * result->height; ++i)
+  for (i = 0; i < n_pixels; ++i)
     {
       for (c = 0; c < pix_stride; ++c)
         {
@@ -246,7 +289,7 @@ reinhard05_process (GeglOperation       *operation,
     }
 
   /* Cleanup and set the output */
-  gegl_buffer_set (output, result, 0, babl_format_with_space (OUTPUT_FORMAT, space), pix,
+  gegl_buffer_set (output, &rect, level, babl_format_with_space (OUTPUT_FORMAT, space), pix,
                    GEGL_AUTO_ROWSTRIDE);
   g_free (pix);
   g_free (lum);
@@ -280,9 +323,20 @@ reinhard05_operation_process (GeglOperation        *operation,
                                    gegl_operation_context_get_level (context));
 }
 
+static void
+reinhard05_finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, proxy_cache_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
+  GObjectClass             *object_class;
   GeglOperationClass       *operation_class;
   GeglOperationFilterClass *filter_class;
   gchar                    *composition =
@@ -301,9 +355,12 @@ gegl_op_class_init (GeglOpClass *klass)
     "  </node>"    
     "</gegl>";
 
+  object_class    = G_OBJECT_CLASS (klass);
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  object_class->finalize = reinhard05_finalize;
+
   filter_class->process = reinhard05_process;
 
   operation_class->prepare                 = reinhard05_prepare;
@@ -0,0 +1,232 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Multithreaded vector primitives for the iterative (multigrid and
+ * conjugate-gradient) solvers of the gradient-domain tone mappers,
+ * gegl:fattal02 and gegl:mantiuk06.
+ *
+ * The primitives split their work across threads using
+ * gegl_parallel_distribute_range(); the inner loops are kept simple, with
+ * non-aliasing pointers, so that they get vectorized by the compiler.
+ */
+
+#ifndef __SOLVER_COMMON_H__
+#define __SOLVER_COMMON_H__
+
+/* the cost of using an additional thread, relative to processing a single
+ * vector element
+ */
+#define SOLVER_THREAD_COST 4096.0
+
+/* dot products are accumulated in double precision, in fixed-size blocks
+ * whose partial sums are added in order, so that the result doesn't depend
+ * on the number of threads
+ */
+#define SOLVER_DOT_BLOCK   4096
+
+typedef enum
+{
+  SOLVER_SCALE, /* y = a * x     */
+  SOLVER_AXPY,  /* y = y + a * x */
+  SOLVER_XPBY,  /* y = x + a * y */
+  SOLVER_MUL,   /* y = y * x     */
+  SOLVER_SUB    /* y = x - y     */
+} SolverOp;
+
+typedef struct
+{
+  SolverOp      op;
+  gfloat        a;
+  const gfloat *x;
+  gfloat       *y;
+} SolverVectorData;
+
+typedef struct
+{
+  gsize         n;
+  const gfloat *x;
+  const gfloat *y;
+  gdouble      *sums;
+} SolverDotData;
+
+
+static void
+solver_vector_range (gsize             offset,
+                     gsize             size,
+                     SolverVectorData *data)
+{
+  const gfloat *restrict x = data->x + offset;
+  gfloat       *restrict y = data->y + offset;
+  const gfloat           a = data->a;
+  gsize                  i;
+
+  switch (data->op)
+    {
+    case SOLVER_SCALE:
+      for (i = 0; i < size; i++)
+        y[i] = a * x[i];
+      break;
+
+    case SOLVER_AXPY:
+      for (i = 0; i < size; i++)
+        y[i] += a * x[i];
+      break;
+
+    case SOLVER_XPBY:
+      for (i = 0; i < size; i++)
+        y[i] = x[i] + a * y[i];
+      break;
+
+    case SOLVER_MUL:
+      for (i = 0; i < size; i++)
+        y[i] *= x[i];
+      break;
+
+    case SOLVER_SUB:
+      for (i = 0; i < size; i++)
+        y[i] = x[i] - y[i];
+      break;
+    }
+}
+
+static void
+solver_vector_op (SolverOp      op,
+                  gsize         n,
+                  gfloat        a,
+                  const gfloat *x,
+                  gfloat       *y)
+{
+  SolverVectorData data = { op, a, x, y };
+
+  gegl_parallel_distribute_range (
+    n, SOLVER_THREAD_COST,
+    (GeglParallelDistributeRangeFunc) solver_vector_range,
+    &data);
+}
+
+/* y = a * x */
+static inline void
+solver_scale (gsize         n,
+              gfloat        a,
+              const gfloat *x,
+              gfloat       *y)
+{
+  solver_vector_op (SOLVER_SCALE, n, a, x, y);
+}
+
+/* y = y + a * x */
+static inline void
+solver_axpy (gsize         n,
+             gfloat        a,
+             const gfloat *x,
+             gfloat       *y)
+{
+  solver_vector_op (SOLVER_AXPY, n, a, x, y);
+}
+
+/* y = x + b * y */
+static inline void
+solver_xpby (gsize         n,
+             const gfloat *x,
+             gfloat        b,
+             gfloat       *y)
+{
+  solver_vector_op (SOLVER_XPBY, n, b, x, y);
+}
+
+/* y = y * x */
+static inline void
+solver_mul (gsize         n,
+            const gfloat *x,
+            gfloat       *y)
+{
+  solver_vector_op (SOLVER_MUL, n, 0.0f, x, y);
+}
+
+/* y = x - y */
+static inline void
+solver_sub (gsize         n,
+            const gfloat *x,
+            gfloat       *y)
+{
+  solver_vector_op (SOLVER_SUB, n, 0.0f, x, y);
+}
+
+
+static void
+solver_dot_range (gsize          offset,
+                  gsize          size,
+                  SolverDotData *data)
+{
+  gsize block;
+
+  for (block = offset; block < offset + size; block++)
+    {
+      const gsize             start = block * SOLVER_DOT_BLOCK;
+      const gsize             end   = MIN (start + SOLVER_DOT_BLOCK, data->n);
+      const gfloat *restrict  x     = data->x;
+      const gfloat *restrict  y     = data->y;
+      gdouble                 sum   = 0.0;
+      gsize                   i;
+
+      for (i = start; i < end; i++)
+        sum += (gdouble) x[i] * y[i];
+
+      data->sums[block] = sum;
+    }
+}
+
+/* return x . y */
+static gfloat
+solver_dot (gsize         n,
+            const gfloat *x,
+            const gfloat *y)
+{
+  SolverDotData data;
+  gsize         n_blocks = (n + SOLVER_DOT_BLOCK - 1) / SOLVER_DOT_BLOCK;
+  gdouble       sum      = 0.0;
+  gsize         i;
+
+  data.n    = n;
+  data.x    = x;
+  data.y    = y;
+  data.sums = g_new0 (gdouble, n_blocks);
+
+  gegl_parallel_distribute_range (
+    n_blocks, SOLVER_THREAD_COST / SOLVER_DOT_BLOCK,
+    (GeglParallelDistributeRangeFunc) solver_dot_range,
+    &data);
+
+  for (i = 0; i < n_blocks; i++)
+    sum += data.sums[i];
+
+  g_free (data.sums);
+
+  return sum;
+}
+
+/* calls func() for ranges of the rows of a @cols wide image, in parallel */
+static inline void
+solver_distribute_rows (gint                            rows,
+                        gint                            cols,
+                        GeglParallelDistributeRangeFunc func,
+                        gpointer                        user_data)
+{
+  gegl_parallel_distribute_range (rows, SOLVER_THREAD_COST / MAX (cols, 1),
+                                  func, user_data);
+}
+
+#endif /* __SOLVER_COMMON_H__ */
@@ -64,6 +64,7 @@ property_enum (sampler_type, _("Resampling method"),
 #define GEGL_OP_C_SOURCE spherize.c
 
 #include "gegl-op.h"
+#include "warp-map-common.h"
 
 #define EPSILON 1e-10
 
@@ -156,55 +157,43 @@ parent_process (GeglOperation        *operation,
                                                                result, level);
 }
 
-static gboolean
-process (GeglOperation       *operation,
-         GeglBuffer          *input,
-         GeglBuffer          *output,
-         const GeglRectangle *roi,
-         gint                 level)
+typedef struct
 {
-  GeglProperties      *o      = GEGL_PROPERTIES (operation);
-  const Babl          *format = gegl_operation_get_format (operation, "output");
-  GeglSampler         *sampler;
-  GeglBufferIterator  *iter;
-  const GeglRectangle *in_extent;
-  gdouble              cx, cy;
-  gdouble              dx = 0.0, dy = 0.0;
-  gdouble              coangle_of_view_2;
-  gdouble              focal_length;
-  gdouble              curvature_sign;
-  gdouble              cap_angle_2;
-  gdouble              cap_radius;
-  gdouble              cap_depth;
-  gdouble              factor;
-  gdouble              f, f2, r, r_inv, r2, p, f_p, f_p2, f_pf, a, a_inv, sgn;
-  gboolean             perspective;
-  gboolean             inverse;
-  gint                 i, j;
-
-  sampler = gegl_buffer_sampler_new_at_level (input, format,
-                                              o->sampler_type, level);
-
-  iter = gegl_buffer_iterator_new (output, roi, level, format,
-                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
+  gdouble  cx, cy;
+  gdouble  dx, dy;
+  gdouble  f, f2, r, r_inv, r2, p, f_p, f_p2, f_pf, a, a_inv, sgn;
+  gdouble  factor;
+  gboolean perspective;
+  gboolean inverse;
+} SpherizeMap;
 
-  gegl_buffer_iterator_add (iter, input, roi, level, format,
-                            GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+static void
+spherize_map_init (SpherizeMap         *map,
+                   GeglProperties      *o,
+                   const GeglRectangle *in_extent)
+{
+  gdouble coangle_of_view_2;
+  gdouble focal_length;
+  gdouble curvature_sign;
+  gdouble cap_angle_2;
+  gdouble cap_radius;
+  gdouble cap_depth;
 
-  in_extent = gegl_operation_source_get_bounding_box (operation, "input");
+  map->cx = in_extent->x + in_extent->width  / 2.0;
+  map->cy = in_extent->y + in_extent->height / 2.0;
 
-  cx = in_extent->x + in_extent->width  / 2.0;
-  cy = in_extent->y + in_extent->height / 2.0;
+  map->dx = 0.0;
+  map->dy = 0.0;
 
   if (o->mode == GEGL_SPHERIZE_MODE_RADIAL ||
       o->mode == GEGL_SPHERIZE_MODE_HORIZONTAL)
     {
-      dx = 2.0 / (in_extent->width - 1);
+      map->dx = 2.0 / (in_extent->width - 1);
     }
   if (o->mode == GEGL_SPHERIZE_MODE_RADIAL ||
       o->mode == GEGL_SPHERIZE_MODE_VERTICAL)
     {
-      dy = 2.0 / (in_extent->height - 1);
+      map->dy = 2.0 / (in_extent->height - 1);
     }
 
   coangle_of_view_2 = MAX (180.0 - o->angle_of_view, 0.01) * G_PI / 360.0;
@@ -213,102 +202,198 @@ process (GeglOperation       *operation,
   cap_angle_2       = fabs (o->curvature) * coangle_of_view_2;
   cap_radius        = 1.0 / sin (cap_angle_2);
   cap_depth         = curvature_sign * cap_radius * cos (cap_angle_2);
-  factor            = fabs (o->amount);
-
-  f     = focal_length;
-  f2    = f * f;
-  r     = cap_radius;
-  r_inv = 1 / r;
-  r2    = r * r;
-  p     = cap_depth;
-  f_p   = f + p;
-  f_p2  = f_p * f_p;
-  f_pf  = f_p * f;
-  a     = cap_angle_2;
-  a_inv = 1 / a;
-  sgn   = curvature_sign;
-
-  perspective = o->angle_of_view > EPSILON;
-  inverse     = o->amount < 0.0;
+  map->factor       = fabs (o->amount);
+
+  map->f     = focal_length;
+  map->f2    = map->f * map->f;
+  map->r     = cap_radius;
+  map->r_inv = 1 / map->r;
+  map->r2    = map->r * map->r;
+  map->p     = cap_depth;
+  map->f_p   = map->f + map->p;
+  map->f_p2  = map->f_p * map->f_p;
+  map->f_pf  = map->f_p * map->f;
+  map->a     = cap_angle_2;
+  map->a_inv = 1 / map->a;
+  map->sgn   = curvature_sign;
+
+  map->perspective = o->angle_of_view > EPSILON;
+  map->inverse     = o->amount < 0.0;
+}
 
-  while (gegl_buffer_iterator_next (iter))
-    {
-      gfloat       *out_pixel = iter->items[0].data;
-      const gfloat *in_pixel  = iter->items[1].data;
-      GeglRectangle *roi = &iter->items[0].roi;
-      gfloat        x,  y;
+/* the source coordinates of the pixels of @rect; pixels outside the cap,
+ * which are left as is, get NaN coordinates.
+ *
+ * the normalized coordinates are computed for each pixel, rather than
+ * accumulated along each processed chunk, so that a tile of the map doesn't
+ * depend on the region it was first computed for.  this differs from the
+ * accumulated coordinates by float rounding.
+ */
+static void
+spherize_map_func (const SpherizeMap   *map,
+                   const GeglRectangle *rect,
+                   gint                 level,
+                   gfloat              *coords,
+                   gfloat              *jacobians)
+{
+  const gdouble cx = map->cx, cy = map->cy;
+  const gdouble dx = map->dx, dy = map->dy;
+  gint          i, j;
 
-      y = dy * (roi->y + 0.5 - cy);
+  for (j = rect->y; j < rect->y + rect->height; j++)
+    {
+      gfloat y = dy * (j + 0.5 - cy);
 
-      for (j = roi->y; j < roi->y + roi->height; j++, y += dy)
+      for (i = rect->x; i < rect->x + rect->width; i++)
         {
-          x = dx * (roi->x + 0.5 - cx);
+          gfloat x = dx * (i + 0.5 - cx);
+          gfloat d2;
 
-          for (i = roi->x; i < roi->x + roi->width; i++, x += dx)
-            {
-              gfloat d2;
+          d2 = x * x + y * y;
 
-              d2 = x * x + y * y;
+          if (d2 > EPSILON && d2 < 1.0 - EPSILON)
+            {
+              gdouble d     = sqrt (d2);
+              gdouble src_d = d;
 
-              if (d2 > EPSILON && d2 < 1.0 - EPSILON)
+              if (! map->inverse)
                 {
-                  gdouble d     = sqrt (d2);
-                  gdouble src_d = d;
-                  gdouble src_x, src_y;
+                  gdouble d2_f2 = d2 + map->f2;
 
-                  if (! inverse)
+                  if (map->perspective)
                     {
-                      gdouble d2_f2 = d2 + f2;
+                      src_d = (map->f_pf -
+                               map->sgn * sqrt (d2_f2 * map->r2 -
+                                                map->f_p2 * d2)) *
+                              d / d2_f2;
+                    }
 
-                      if (perspective)
-                        src_d = (f_pf - sgn * sqrt (d2_f2 * r2 - f_p2 * d2)) * d / d2_f2;
+                  src_d = (G_PI_2 - acos (src_d * map->r_inv)) * map->a_inv;
+                }
+              else
+                {
+                  src_d = map->r * cos (G_PI_2 - src_d * map->a);
 
-                      src_d = (G_PI_2 - acos (src_d * r_inv)) * a_inv;
-                    }
-                  else
+                  if (map->perspective)
                     {
-                      src_d = r * cos (G_PI_2 - src_d * a);
-
-                      if (perspective)
-                        src_d = f * src_d / (f_p - sgn * sqrt (r2 - src_d * src_d));
+                      src_d = map->f * src_d /
+                              (map->f_p - map->sgn * sqrt (map->r2 -
+                                                           src_d * src_d));
                     }
+                }
 
-                  if (factor < 1.0)
-                    src_d = d + (src_d - d) * factor;
+              if (map->factor < 1.0)
+                src_d = d + (src_d - d) * map->factor;
 
-                  src_x = dx ? cx + src_d * x / (dx * d) :
+              coords[0] = dx ? cx + src_d * x / (dx * d) :
                                i + 0.5;
-                  src_y = dy ? cy + src_d * y / (dy * d) :
+              coords[1] = dy ? cy + src_d * y / (dy * d) :
                                j + 0.5;
-
-                  gegl_sampler_get (sampler, src_x, src_y,
-                                    NULL, out_pixel, GEGL_ABYSS_NONE);
-                }
-              else
-                {
-                  memcpy (out_pixel, in_pixel, sizeof (gfloat) * 4);
-                }
-
-              out_pixel += 4;
-              in_pixel  += 4;
             }
+          else
+            {
+              coords[0] = coords[1] = NAN;
+            }
+
+          coords += 2;
         }
     }
+}
+
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *output,
+         const GeglRectangle *roi,
+         gint                 level)
+{
+  GeglProperties      *o      = GEGL_PROPERTIES (operation);
+  const Babl          *format = gegl_operation_get_format (operation, "output");
+  GeglSampler         *sampler;
+  GeglBufferIterator  *iter;
+  const GeglRectangle *in_extent;
+  SpherizeMap          spherize_map;
+  WarpMap             *map;
+  gdouble              params[8];
+
+  sampler = gegl_buffer_sampler_new_at_level (input, format,
+                                              o->sampler_type, level);
+
+  iter = gegl_buffer_iterator_new (output, roi, level, format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
+
+  gegl_buffer_iterator_add (iter, input, roi, level, format,
+                            GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  in_extent = gegl_operation_source_get_bounding_box (operation, "input");
+
+  spherize_map_init (&spherize_map, o, in_extent);
+
+  /* the source coordinates don't depend on the sampler, keep them across
+   * renders
+   */
+  params[0] = o->mode;
+  params[1] = o->angle_of_view;
+  params[2] = o->curvature;
+  params[3] = o->amount;
+  params[4] = in_extent->x;
+  params[5] = in_extent->y;
+  params[6] = in_extent->width;
+  params[7] = in_extent->height;
+
+  map = warp_map_cache_get (o->user_data, params, G_N_ELEMENTS (params),
+                            FALSE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      warp_map_process (map, &iter->items[0].roi, level,
+                        (WarpMapFunc) spherize_map_func, &spherize_map,
+                        sampler, GEGL_ABYSS_NONE, 4,
+                        iter->items[1].data, iter->items[0].data);
+    }
+
+  warp_map_unref (map);
 
   g_object_unref (sampler);
 
   return TRUE;
 }
 
+static void
+prepare (GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  GEGL_OPERATION_CLASS (gegl_op_parent_class)->prepare (operation);
+
+  if (! o->user_data)
+    o->user_data = warp_map_cache_new ();
+}
+
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, warp_map_cache_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
+  GObjectClass             *object_class;
   GeglOperationClass       *operation_class;
   GeglOperationFilterClass *filter_class;
 
+  object_class    = G_OBJECT_CLASS (klass);
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  object_class->finalize                     = finalize;
+
+  operation_class->prepare                   = prepare;
   operation_class->get_invalidated_by_change = get_required_for_output;
   operation_class->get_required_for_output   = get_required_for_output;
   operation_class->process                   = parent_process;
@@ -320,7 +405,7 @@ gegl_op_class_init (GeglOpClass *klass)
     "title",              _("Spherize"),
     "categories",         "distort:map",
     "position-dependent", "true",
-    "reference-hash", "215f04f9ad3e27325dfbe834963a6f49",
+    "reference-hash",     "unstable",
     "description",        _("Wrap image around a spherical cap"),
     NULL);
 }
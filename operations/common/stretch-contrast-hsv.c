@@ -33,6 +33,8 @@
 
 #include "gegl-op.h"
 
+#define N_PROGRESS_STEPS 16
+
 typedef struct {
   gfloat slo;
   gfloat sdiff;
@@ -47,42 +49,42 @@ buffer_get_auto_stretch_data (GeglOperation       *operation,
                               AutostretchData     *data,
                               const Babl          *space)
 {
-  gfloat smin =  G_MAXFLOAT;
-  gfloat smax = -G_MAXFLOAT;
-  gfloat vmin =  G_MAXFLOAT;
-  gfloat vmax = -G_MAXFLOAT;
-
-  GeglBufferIterator *gi;
-  gint                done_pixels = 0;
+  const Babl    *format = babl_format_with_space ("HSVA float", space);
+  gdouble        smin   =  G_MAXDOUBLE;
+  gdouble        smax   = -G_MAXDOUBLE;
+  gdouble        vmin   =  G_MAXDOUBLE;
+  gdouble        vmax   = -G_MAXDOUBLE;
+  GeglRectangle  band;
+  gint           band_height;
 
   gegl_operation_progress (operation, 0.0, "");
 
-  gi = gegl_buffer_iterator_new (buffer, result, 0, babl_format_with_space ("HSVA float", space),
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+  /* the statistics are gathered in bands of rows, so that the progress can
+   * be reported in between
+   */
+  band        = *result;
+  band_height = (result->height + N_PROGRESS_STEPS - 1) / N_PROGRESS_STEPS;
 
-  while (gegl_buffer_iterator_next (gi))
+  for (band.y = result->y;
+       band.y < result->y + result->height;
+       band.y += band_height)
     {
-      gfloat *buf = gi->items[0].data;
-      gint    i;
+      gdouble min[4], max[4];
 
-      for (i = 0; i < gi->length; i++)
-        {
-          gfloat sval = buf[1];
-          gfloat vval = buf[2];
+      band.height = MIN (band_height, result->y + result->height - band.y);
 
-          smin = MIN (sval, smin);
-          smax = MAX (sval, smax);
-          vmin = MIN (vval, vmin);
-          vmax = MAX (vval, vmax);
+      gegl_parallel_get_buffer_statistics (buffer, &band, 0, format,
+                                           min, max, NULL, NULL);
 
-          buf += 4;
-        }
-
-      done_pixels += gi->length;
+      smin = MIN (min[1], smin);
+      smax = MAX (max[1], smax);
+      vmin = MIN (min[2], vmin);
+      vmax = MAX (max[2], vmax);
 
       gegl_operation_progress (operation,
-                               (gdouble) 0.5 * done_pixels /
-                               (gdouble) (result->width * result->height),
+                               (gdouble) 0.5 *
+                               (band.y + band.height - result->y) /
+                               (gdouble) result->height,
                                "");
     }
 
@@ -35,36 +35,26 @@ property_boolean (perceptual, _("Non-linear components"), FALSE)
 #define GEGL_OP_C_SOURCE stretch-contrast.c
 
 #include "gegl-op.h"
+#include "proxy-common.h"
 
 static void
-buffer_get_min_max (GeglBuffer *buffer,
-                    const Babl *format,
-                    gfloat     *min,
-                    gfloat     *max)
+buffer_get_min_max (GeglBuffer          *buffer,
+                    const GeglRectangle *rect,
+                    gint                 level,
+                    const Babl          *format,
+                    gfloat              *min,
+                    gfloat              *max)
 {
-  GeglBufferIterator *gi;
-  gint c;
-  gi = gegl_buffer_iterator_new (buffer, NULL, 0, format,
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
-  for (c = 0; c < 3; c++)
-    {
-      min[c] =  G_MAXFLOAT;
-      max[c] = -G_MAXFLOAT;
-    }
+  gdouble dmin[4], dmax[4];
+  gint    c;
 
-  while (gegl_buffer_iterator_next (gi))
-    {
-      gfloat *buf = gi->items[0].data;
+  gegl_parallel_get_buffer_statistics (buffer, rect, level, format,
+                                       dmin, dmax, NULL, NULL);
 
-      gint i;
-      for (i = 0; i < gi->length; i++)
-        {
-          for (c = 0; c < 3; c++)
-            {
-              min[c] = MIN (buf [i * 4 + c], min[c]);
-              max[c] = MAX (buf [i * 4 + c], max[c]);
-            }
-        }
+  for (c = 0; c < 3; c++)
+    {
+      min[c] = dmin[c];
+      max[c] = dmax[c];
     }
 }
 
@@ -105,6 +95,9 @@ static void prepare (GeglOperation *operation)
      gegl_operation_set_format (operation, "input", babl_format_with_space ("RGBA float", space));
      gegl_operation_set_format (operation, "output", babl_format_with_space ("RGBA float", space));
    }
+
+  if (! o->user_data)
+    o->user_data = proxy_cache_new ();
 }
 
 static GeglRectangle
@@ -470,17 +463,52 @@ process (GeglOperation       *operation,
 {
   const Babl *out_format = gegl_operation_get_format (operation, "output");
   gfloat  min[3], max[3], diff[3];
+  gfloat              min_max[6];
+  GBytes             *state;
   GeglBufferIterator *gi;
   GeglProperties         *o;
+  GeglRectangle       extent;
+  GeglRectangle       rect;
+  gdouble             params[1];
+  gint                stamp;
   gint                c;
 
-  if (gegl_cl_is_accelerated ())
+  if (level == 0 && gegl_cl_is_accelerated ())
     if (cl_process (operation, input, output, result))
       return TRUE;
 
   o = GEGL_PROPERTIES (operation);
 
-  buffer_get_min_max (input, out_format, min, max);
+  /* At mipmap levels > 0, both the statistics and the output are computed
+   * at that level
+   */
+  proxy_get_rect (gegl_buffer_get_extent (input), level, &extent);
+  proxy_get_rect (result, level, &rect);
+
+  params[0] = o->perceptual;
+
+  state = proxy_cache_lookup (o->user_data, operation, &extent, level,
+                              params, G_N_ELEMENTS (params), &stamp);
+
+  if (state)
+    {
+      memcpy (min_max, g_bytes_get_data (state, NULL), sizeof (min_max));
+    }
+  else
+    {
+      buffer_get_min_max (input, &extent, level, out_format,
+                          min_max, min_max + 3);
+
+      state = g_bytes_new (min_max, sizeof (min_max));
+
+      proxy_cache_store (o->user_data, stamp, &extent, level,
+                         params, G_N_ELEMENTS (params), state);
+    }
+
+  g_bytes_unref (state);
+
+  memcpy (min, min_max,     sizeof (min));
+  memcpy (max, min_max + 3, sizeof (max));
 
   if (o->keep_colors)
     reduce_min_max_global (min, max);
@@ -497,10 +525,10 @@ process (GeglOperation       *operation,
         }
     }
 
-  gi = gegl_buffer_iterator_new (input, result, 0, out_format,
+  gi = gegl_buffer_iterator_new (input, &rect, level, out_format,
                                  GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
 
-  gegl_buffer_iterator_add (gi, output, result, 0, out_format,
+  gegl_buffer_iterator_add (gi, output, &rect, level, out_format,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (gi))
@@ -560,15 +588,29 @@ operation_process (GeglOperation        *operation,
  * Here we override the standard passthrough options for the rect
  * computations.
  */
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, proxy_cache_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
+  GObjectClass             *object_class;
   GeglOperationClass       *operation_class;
   GeglOperationFilterClass *filter_class;
 
+  object_class    = G_OBJECT_CLASS (klass);
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  object_class->finalize = finalize;
+
   filter_class->process = process;
   operation_class->prepare = prepare;
   operation_class->threaded = FALSE;
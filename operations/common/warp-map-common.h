@@ -0,0 +1,436 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Helpers for distortions whose mapping from output to input coordinates
+ * only depends on their properties, like gegl:spherize and
+ * gegl:panorama-projection.
+ *
+ * Instead of evaluating the mapping for every pixel of every render, such
+ * operations keep a WarpMap, holding the source coordinates of the output
+ * pixels, and optionally the jacobian of the mapping at each of them, as
+ * pairs and quadruples of floats.  The map is divided into
+ * WARP_MAP_TILE_SIZE x WARP_MAP_TILE_SIZE tiles, aligned to the origin, which
+ * are computed the first time they're needed, so that repeated renders of
+ * the same region, such as the frames of a video, or the previews of a
+ * property that doesn't affect the geometry, only pay for sampling.
+ *
+ * Pixels which don't map to the input have NaN coordinates.
+ *
+ * The maps are kept in a WarpMapCache, which replaces its map when the
+ * parameters the mapping depends on change.  The cached tiles take at most
+ * WARP_MAP_MAX_SIZE bytes; past that, tiles are computed for each render.
+ * The cache is created in prepare(), rather than on the first render, which
+ * may be happening in several threads.
+ */
+
+#ifndef __WARP_MAP_COMMON_H__
+#define __WARP_MAP_COMMON_H__
+
+#define WARP_MAP_TILE_SIZE  64
+#define WARP_MAP_MAX_PARAMS 16
+#define WARP_MAP_MAX_SIZE   (64 << 20)
+
+/* fills @coords with the source coordinates of the pixels of @rect, in the
+ * coordinates of the level the map is computed at, and, if @jacobians is not
+ * NULL, @jacobians with the coefficients of the jacobian of the mapping, in
+ * row-major order.  both arrays are tightly packed.
+ */
+typedef void (* WarpMapFunc) (gpointer             data,
+                              const GeglRectangle *rect,
+                              gint                 level,
+                              gfloat              *coords,
+                              gfloat              *jacobians);
+
+typedef struct
+{
+  gint x;
+  gint y;
+  gint level;
+} WarpMapTileKey;
+
+typedef struct
+{
+  WarpMapTileKey  key;
+  gfloat         *coords;
+  gfloat         *jacobians;
+} WarpMapTile;
+
+typedef struct
+{
+  gint        ref_count;
+
+  gdouble     params[WARP_MAP_MAX_PARAMS];
+  gboolean    has_jacobians;
+
+  GMutex      mutex;
+  GHashTable *tiles;
+  gsize       size;
+} WarpMap;
+
+typedef struct
+{
+  GMutex   mutex;
+  WarpMap *map;
+} WarpMapCache;
+
+
+static inline gint
+warp_map_div_floor (gint a,
+                    gint b)
+{
+  /* we assume b is positive */
+  if (a < 0) a -= b - 1;
+  return a / b;
+}
+
+static guint
+warp_map_tile_key_hash (const WarpMapTileKey *key)
+{
+  return ((guint) key->x * 73856093u) ^
+         ((guint) key->y * 19349663u) ^
+         ((guint) key->level);
+}
+
+static gboolean
+warp_map_tile_key_equal (const WarpMapTileKey *key1,
+                         const WarpMapTileKey *key2)
+{
+  return key1->x     == key2->x &&
+         key1->y     == key2->y &&
+         key1->level == key2->level;
+}
+
+static void
+warp_map_tile_free (WarpMapTile *tile)
+{
+  g_free (tile->coords);
+  g_free (tile->jacobians);
+
+  g_slice_free (WarpMapTile, tile);
+}
+
+static gsize
+warp_map_get_tile_size (WarpMap *map)
+{
+  return WARP_MAP_TILE_SIZE * WARP_MAP_TILE_SIZE *
+         (map->has_jacobians ? 6 : 2) * sizeof (gfloat);
+}
+
+static WarpMap *
+warp_map_new (const gdouble *params,
+              gint           n_params,
+              gboolean       has_jacobians)
+{
+  WarpMap *map = g_slice_new0 (WarpMap);
+
+  map->ref_count     = 1;
+  map->has_jacobians = has_jacobians;
+
+  memcpy (map->params, params, n_params * sizeof (gdouble));
+
+  g_mutex_init (&map->mutex);
+
+  map->tiles = g_hash_table_new_full (
+    (GHashFunc) warp_map_tile_key_hash,
+    (GEqualFunc) warp_map_tile_key_equal,
+    NULL,
+    (GDestroyNotify) warp_map_tile_free);
+
+  return map;
+}
+
+static void
+warp_map_unref (WarpMap *map)
+{
+  if (g_atomic_int_dec_and_test (&map->ref_count))
+    {
+      g_hash_table_unref (map->tiles);
+      g_mutex_clear (&map->mutex);
+
+      g_slice_free (WarpMap, map);
+    }
+}
+
+static WarpMapCache *
+warp_map_cache_new (void)
+{
+  WarpMapCache *cache = g_slice_new0 (WarpMapCache);
+
+  g_mutex_init (&cache->mutex);
+
+  return cache;
+}
+
+static void
+warp_map_cache_free (WarpMapCache *cache)
+{
+  g_clear_pointer (&cache->map, warp_map_unref);
+
+  g_mutex_clear (&cache->mutex);
+
+  g_slice_free (WarpMapCache, cache);
+}
+
+/* returns a reference to the map of the mapping identified by @params, which
+ * the caller should release using warp_map_unref()
+ */
+static WarpMap *
+warp_map_cache_get (WarpMapCache  *cache,
+                    const gdouble *params,
+                    gint           n_params,
+                    gboolean       has_jacobians)
+{
+  gdouble  key[WARP_MAP_MAX_PARAMS] = { 0.0, };
+  WarpMap *map;
+
+  g_return_val_if_fail (n_params <= WARP_MAP_MAX_PARAMS, NULL);
+
+  memcpy (key, params, n_params * sizeof (gdouble));
+
+  g_mutex_lock (&cache->mutex);
+
+  if (! cache->map                                  ||
+      cache->map->has_jacobians != has_jacobians    ||
+      memcmp (cache->map->params, key, sizeof (key)))
+    {
+      g_clear_pointer (&cache->map, warp_map_unref);
+
+      cache->map = warp_map_new (key, WARP_MAP_MAX_PARAMS, has_jacobians);
+    }
+
+  map = cache->map;
+  g_atomic_int_inc (&map->ref_count);
+
+  g_mutex_unlock (&cache->mutex);
+
+  return map;
+}
+
+/* returns the tile of @map at (@tx, @ty), in tiles, computing it using @func
+ * if it's not cached.  if the tile can't be cached, it's computed into
+ * @scratch, which should be zero-initialized, and freed by the caller using
+ * g_free() on its arrays.
+ */
+static const WarpMapTile *
+warp_map_get_tile (WarpMap     *map,
+                   gint         tx,
+                   gint         ty,
+                   gint         level,
+                   WarpMapFunc  func,
+                   gpointer     data,
+                   WarpMapTile *scratch)
+{
+  const gint      n_pixels = WARP_MAP_TILE_SIZE * WARP_MAP_TILE_SIZE;
+  WarpMapTileKey  key      = { tx, ty, level };
+  WarpMapTile    *tile;
+  GeglRectangle   rect;
+  gboolean        cache;
+
+  g_mutex_lock (&map->mutex);
+
+  tile  = g_hash_table_lookup (map->tiles, &key);
+  cache = map->size + warp_map_get_tile_size (map) <= WARP_MAP_MAX_SIZE;
+
+  g_mutex_unlock (&map->mutex);
+
+  /* cached tiles are only freed along with the map, which the caller holds
+   * a reference to
+   */
+  if (tile)
+    return tile;
+
+  if (cache)
+    {
+      tile = g_slice_new0 (WarpMapTile);
+
+      tile->coords = g_new (gfloat, 2 * n_pixels);
+
+      if (map->has_jacobians)
+        tile->jacobians = g_new (gfloat, 4 * n_pixels);
+    }
+  else
+    {
+      tile = scratch;
+
+      if (! tile->coords)
+        tile->coords = g_new (gfloat, 2 * n_pixels);
+
+      if (map->has_jacobians && ! tile->jacobians)
+        tile->jacobians = g_new (gfloat, 4 * n_pixels);
+    }
+
+  tile->key = key;
+
+  gegl_rectangle_set (&rect,
+                      tx * WARP_MAP_TILE_SIZE, ty * WARP_MAP_TILE_SIZE,
+                      WARP_MAP_TILE_SIZE, WARP_MAP_TILE_SIZE);
+
+  func (data, &rect, level, tile->coords, tile->jacobians);
+
+  if (cache)
+    {
+      WarpMapTile *other;
+
+      g_mutex_lock (&map->mutex);
+
+      /* another thread may have computed the same tile meanwhile */
+      other = g_hash_table_lookup (map->tiles, &key);
+
+      if (other)
+        {
+          warp_map_tile_free (tile);
+
+          tile = other;
+        }
+      else
+        {
+          g_hash_table_insert (map->tiles, &tile->key, tile);
+
+          map->size += warp_map_get_tile_size (map);
+        }
+
+      g_mutex_unlock (&map->mutex);
+    }
+
+  return tile;
+}
+
+/* samples the pixels of @roi, at @level, into @out, using @sampler, at the
+ * coordinates given by @map.  pixels which don't map to the input are copied
+ * from @in, or cleared if @in is NULL.  @in and @out hold @nc floats per
+ * pixel, and are tightly packed.
+ *
+ * when the map has no jacobians, runs of mapped pixels are sampled at once,
+ * using gegl_sampler_get_n().
+ */
+static void
+warp_map_process (WarpMap             *map,
+                  const GeglRectangle *roi,
+                  gint                 level,
+                  WarpMapFunc          func,
+                  gpointer             data,
+                  GeglSampler         *sampler,
+                  GeglAbyssPolicy      abyss_policy,
+                  gint                 nc,
+                  const gfloat        *in,
+                  gfloat              *out)
+{
+  WarpMapTile scratch = { { 0, }, NULL, NULL };
+  gdouble     x[GEGL_SAMPLER_BATCH_SIZE];
+  gdouble     y[GEGL_SAMPLER_BATCH_SIZE];
+  gboolean    batch;
+  gint        tx0, ty0, tx1, ty1;
+  gint        tx, ty;
+
+  /* gegl_sampler_get_n() samples the level the sampler was created for,
+   * while gegl_sampler_get() samples level 0 of the buffer at other levels
+   */
+  batch = ! map->has_jacobians && level == 0;
+
+  tx0 = warp_map_div_floor (roi->x, WARP_MAP_TILE_SIZE);
+  ty0 = warp_map_div_floor (roi->y, WARP_MAP_TILE_SIZE);
+  tx1 = warp_map_div_floor (roi->x + roi->width  - 1, WARP_MAP_TILE_SIZE);
+  ty1 = warp_map_div_floor (roi->y + roi->height - 1, WARP_MAP_TILE_SIZE);
+
+  for (ty = ty0; ty <= ty1; ty++)
+  for (tx = tx0; tx <= tx1; tx++)
+    {
+      const WarpMapTile *tile;
+      GeglRectangle      tile_rect;
+      GeglRectangle      rect;
+      gint               row;
+
+      gegl_rectangle_set (&tile_rect,
+                          tx * WARP_MAP_TILE_SIZE, ty * WARP_MAP_TILE_SIZE,
+                          WARP_MAP_TILE_SIZE, WARP_MAP_TILE_SIZE);
+
+      gegl_rectangle_intersect (&rect, &tile_rect, roi);
+
+      tile = warp_map_get_tile (map, tx, ty, level, func, data, &scratch);
+
+      for (row = rect.y; row < rect.y + rect.height; row++)
+        {
+          const gint    offset = (row - tile_rect.y) * WARP_MAP_TILE_SIZE +
+                                 (rect.x - tile_rect.x);
+          const gint    pixel  = (row - roi->y) * roi->width +
+                                 (rect.x - roi->x);
+          const gfloat *coords = tile->coords + 2 * offset;
+          const gfloat *src    = in ? in + (gsize) nc * pixel : NULL;
+          gfloat       *dst    = out + (gsize) nc * pixel;
+          gint          i      = 0;
+
+          while (i < rect.width)
+            {
+              if (isnan (coords[2 * i]))
+                {
+                  if (src)
+                    memcpy (dst + nc * i, src + nc * i, nc * sizeof (gfloat));
+                  else
+                    memset (dst + nc * i, 0, nc * sizeof (gfloat));
+
+                  i++;
+                }
+              else if (batch)
+                {
+                  gint n = 0;
+
+                  while (i + n < rect.width              &&
+                         n < GEGL_SAMPLER_BATCH_SIZE     &&
+                         ! isnan (coords[2 * (i + n)]))
+                    {
+                      x[n] = coords[2 * (i + n)];
+                      y[n] = coords[2 * (i + n) + 1];
+
+                      n++;
+                    }
+
+                  gegl_sampler_get_n (sampler, x, y, n, NULL,
+                                      dst + nc * i, abyss_policy);
+
+                  i += n;
+                }
+              else
+                {
+                  GeglBufferMatrix2  scale_matrix;
+                  GeglBufferMatrix2 *scale = NULL;
+
+                  if (tile->jacobians)
+                    {
+                      const gfloat *j = tile->jacobians + 4 * (offset + i);
+
+                      scale_matrix.coeff[0][0] = j[0];
+                      scale_matrix.coeff[0][1] = j[1];
+                      scale_matrix.coeff[1][0] = j[2];
+                      scale_matrix.coeff[1][1] = j[3];
+
+                      scale = &scale_matrix;
+                    }
+
+                  gegl_sampler_get (sampler,
+                                    coords[2 * i], coords[2 * i + 1],
+                                    scale, dst + nc * i, abyss_policy);
+
+                  i++;
+                }
+            }
+        }
+    }
+
+  g_free (scratch.coords);
+  g_free (scratch.jacobians);
+}
+
+#endif /* __WARP_MAP_COMMON_H__ */
@@ -80,6 +80,7 @@ gegl_op_class_init (GeglOpClass *klass)
               "name",        "gegl:nop",
               "title",       _("No Operation"),
               "categories",  "core",
+              "commutes-with-transforms", "true",
               "description", _("No operation (can be used as a routing point)"),
               NULL);
 }
@@ -1381,8 +1381,16 @@ matting_solve_level (gdouble             *restrict pixels,
       g_free (eroded_alpha);
     }
 
+  /* The full solve is by far the most expensive step, skip it when the
+   * result is going to be thrown away anyway.
+   */
+  if (gegl_parallel_is_cancelled ())
+    {
+      if (!new_alpha)
+        new_alpha = g_new0 (gdouble, region->width * region->height);
+    }
   /* Ordinary solution of the matting laplacian */
-  if (active_levels >= levels || levels == 0)
+  else if (active_levels >= levels || levels == 0)
     {
       sparse_t *laplacian;
       g_free (new_alpha);
@@ -1441,8 +1449,9 @@ matting_process (GeglOperation       *operation,
                                 MIN (o->active_levels, o->levels), o->levels,
                                 o->radius, powf (10, o->epsilon), o->lambda,
                                 o->threshold);
-  gegl_buffer_set (output_buf, result, 0, babl_format (FORMAT_OUTPUT), output,
-                   GEGL_AUTO_ROWSTRIDE);
+  if (output && ! gegl_parallel_is_cancelled ())
+    gegl_buffer_set (output_buf, result, 0, babl_format (FORMAT_OUTPUT), output,
+                     GEGL_AUTO_ROWSTRIDE);
 
   success = TRUE;
 
@@ -30,6 +30,7 @@
  * !!!! AUTOGENERATED FILE !!!!!
  */
 #include "config.h"
+#include <string.h>
 #include <glib/gi18n-lib.h>
 
 
@@ -46,6 +47,9 @@ property_boolean (srgb, _("sRGB"), FALSE)
 
 #include "gegl-op.h"
 
+/* the number of pixels composited at once by the RaGaBaA float path */
+#define COMPOSITE_BLOCK 64
+
 static void prepare (GeglOperation *operation)
 {
   const Babl *format = gegl_operation_get_source_format (operation, "input");
@@ -129,6 +133,47 @@ process (GeglOperation       *op,
   if(aux == NULL)
      return TRUE;
 
+  if (components == 4 && alpha)
+    {
+      while (n_pixels > 0)
+        {
+          gfloat block[COMPOSITE_BLOCK * 4];
+          gint   n = MIN (n_pixels, COMPOSITE_BLOCK);
+
+          for (i = 0; i < n; i++)
+            {
+              gfloat aA, aB, aD;
+              gint   j;
+
+              aB = in[4 * i + 3];
+              aA = aux[4 * i + 3];
+              aD = aA + aB - aA * aB;
+
+              for (j = 0; j < 3; j++)
+                {
+                  gfloat cA, cB;
+
+                  cB = in[4 * i + j];
+                  cA = aux[4 * i + j];
+                  if (cA * aB + cB * aA <= aA * aB)
+                    block[4 * i + j] = CLAMP (cA * (1 - aB) + cB * (1 - aA), 0, aD);
+                  else
+                    block[4 * i + j] = CLAMP ((cA == 0 ? 1 : (aA * (cA * aB + cB * aA - aA * aB) / cA) + cA * (1 - aB) + cB * (1 - aA)), 0, aD);
+                }
+              block[4 * i + 3] = aD;
+            }
+
+          memcpy (out, block, sizeof (gfloat) * 4 * n);
+
+          in       += 4 * n;
+          aux      += 4 * n;
+          out      += 4 * n;
+          n_pixels -= n;
+        }
+
+      return TRUE;
+    }
+
   for (i = 0; i < n_pixels; i++)
     {
       gfloat aA, aB, aD;
@@ -188,6 +233,7 @@ gegl_op_class_init (GeglOpClass *klass)
         _("SVG blend operation color-burn (<code>if cA * aB + cB * aA <= aA * aB: d = cA * (1 - aB) + cB * (1 - aA) otherwise: d = (cA == 0 ? 1 : (aA * (cA * aB + cB * aA - aA * aB) / cA) + cA * (1 - aB) + cB * (1 - aA))</code>)"),
         NULL);
   gegl_operation_class_set_key (operation_class, "categories", "compositors:svgfilter");
+  gegl_operation_class_set_key (operation_class, "transparent-aux-passthrough", "true");
 }
 
 #endif
@@ -30,6 +30,7 @@
  * !!!! AUTOGENERATED FILE !!!!!
  */
 #include "config.h"
+#include <string.h>
 #include <glib/gi18n-lib.h>
 
 
@@ -46,6 +47,9 @@ property_boolean (srgb, _("sRGB"), FALSE)
 
 #include "gegl-op.h"
 
+/* the number of pixels composited at once by the RaGaBaA float path */
+#define COMPOSITE_BLOCK 64
+
 static void prepare (GeglOperation *operation)
 {
   const Babl *format = gegl_operation_get_source_format (operation, "input");
@@ -83,6 +87,44 @@ process (GeglOperation        *op,
     return TRUE;
   else
     {
+      if (components == 4)
+        {
+          while (n_pixels > 0)
+            {
+              gfloat block[COMPOSITE_BLOCK * 4];
+              gint   n = MIN (n_pixels, COMPOSITE_BLOCK);
+
+              for (i = 0; i < n; i++)
+                {
+                  gint   j;
+                  gfloat aA G_GNUC_UNUSED, aB G_GNUC_UNUSED, aD G_GNUC_UNUSED;
+
+                  aB = in[4 * i + 3];
+                  aA = aux[4 * i + 3];
+                  aD = aA * aB;
+
+                  for (j = 0; j < 3; j++)
+                    {
+                      gfloat cA G_GNUC_UNUSED, cB G_GNUC_UNUSED;
+
+                      cB = in[4 * i + j];
+                      cA = aux[4 * i + j];
+                      block[4 * i + j] = cB * aA;
+                    }
+                  block[4 * i + 3] = aD;
+                }
+
+              memcpy (out, block, sizeof (gfloat) * 4 * n);
+
+              in       += 4 * n;
+              aux      += 4 * n;
+              out      += 4 * n;
+              n_pixels -= n;
+            }
+
+          return TRUE;
+        }
+
       for (i = 0; i < n_pixels; i++)
         {
           gint   j;
@@ -21,6 +21,7 @@
  * !!!! AUTOGENERATED FILE !!!!!
  */
 #include "config.h"
+#include <string.h>
 #include <glib/gi18n-lib.h>
 
 
@@ -37,14 +38,60 @@ property_double (value, _("Value"), 1.0)
 #define GEGL_OP_C_FILE       "gamma.c"
 
 #include "gegl-op.h"
+#include "gegl-lookup.h"
 
 #ifdef _MSC_VER
 #define powf(a,b) ((gfloat)pow(a,b))
 #endif
 
+/* the number of pixels processed at once by the RGBA float path */
+#define COMPOSITE_BLOCK 64
+
+/* the range of inputs approximated by the lookup table, within an error of
+ * about an ulp of the result; other inputs, including negative ones, are
+ * computed with the formula
+ */
+#define LOOKUP_START (1.0f / (1 << 24))
+#define LOOKUP_END   256.0f
+#define LOOKUP_ERROR 2.5e-7f
+
+typedef struct
+{
+  gfloat           value;
+  GeglLookupTable *table;
+} Lookup;
+
+static gfloat
+lookup_function (gfloat   input,
+                 gpointer data)
+{
+  gfloat value = *(gfloat *) data;
+  gfloat result;
+  result = (input >= 0.0f ? powf (input, value) : -powf (-input, value));
+  return result;
+}
+
+static void
+lookup_free (Lookup *lookup)
+{
+  g_clear_pointer (&lookup->table, gegl_lookup_table_free);
+  g_free (lookup);
+}
+
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, lookup_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 
 static void prepare (GeglOperation *operation)
 {
+  GeglProperties *o = GEGL_PROPERTIES (operation);
   const Babl *format = gegl_operation_get_source_format (operation, "input");
   if (!format)
     format = gegl_operation_get_source_format (operation, "aux");
@@ -53,6 +100,24 @@ static void prepare (GeglOperation *operation)
   gegl_operation_set_format (operation, "input", format);
   gegl_operation_set_format (operation, "aux", format);
   gegl_operation_set_format (operation, "output", format);
+
+  /* the table is kept for as long as the value doesn't change */
+  if (! o->user_data || ((Lookup *) o->user_data)->value != (gfloat) o->value)
+    {
+      Lookup *lookup = g_new (Lookup, 1);
+
+      g_clear_pointer (&o->user_data, lookup_free);
+
+      /* the table is NULL if the formula can't be approximated for the
+       * value, in which case it is evaluated for each pixel
+       */
+      lookup->value = o->value;
+      lookup->table = gegl_lookup_table_new (lookup_function, &lookup->value,
+                                             LOOKUP_START, LOOKUP_END,
+                                             LOOKUP_ERROR);
+
+      o->user_data = lookup;
+    }
 }
 
 static gboolean
@@ -71,8 +136,23 @@ process (GeglOperation       *op,
   gint    components = babl_format_get_n_components (format);
   gint    alpha      = babl_format_has_alpha (format);
   gint    i;
+  Lookup *lookup     = GEGL_PROPERTIES (op)->user_data;
 
-  if (aux == NULL)
+  if (aux == NULL && lookup && lookup->table &&
+      lookup->value == (gfloat) GEGL_PROPERTIES (op)->value)
+    {
+      for (i=0; i<n_pixels; i++)
+        {
+          gint   j;
+          for (j=0; j<components-alpha; j++)
+            out[j]=gegl_lookup_table (lookup->table, in[j]);
+          if (alpha)
+            out[components-1]=in[components-1];
+          in += components;
+          out+= components;
+        }
+    }
+  else if (aux == NULL)
     {
       gfloat value = GEGL_PROPERTIES (op)->value;
       for (i=0; i<n_pixels; i++)
@@ -91,6 +171,41 @@ process (GeglOperation       *op,
           out+= components;
         }
     }
+  else if (components == 4 && alpha)
+    {
+      /* a fixed number of components, which lets the compiler unroll
+       * the channel loop, and vectorize it where it can; the block is
+       * processed into a scratch buffer, since out may be the same
+       * buffer as in.
+       */
+      while (n_pixels > 0)
+        {
+          gfloat block[COMPOSITE_BLOCK * 4];
+          gint   n = MIN (n_pixels, COMPOSITE_BLOCK);
+
+          for (i=0; i<n; i++)
+            {
+              gint   j;
+              gfloat value;
+              for (j=0; j<3; j++)
+                {
+                  gfloat input =in[4 * i + j];
+                  gfloat result;
+                  value=aux[4 * i + j];
+                  result = (input >= 0.0f ? powf (input, value) : -powf (-input, value));
+                  block[4 * i + j]=result;
+                }
+              block[4 * i + 3]=in[4 * i + 3];
+            }
+
+          memcpy (out, block, sizeof (gfloat) * 4 * n);
+
+          in       += 4 * n;
+          aux      += 4 * n;
+          out      += 4 * n;
+          n_pixels -= n;
+        }
+    }
   else
     {
       for (i=0; i<n_pixels; i++)
@@ -128,6 +243,8 @@ gegl_op_class_init (GeglOpClass *klass)
   point_composer_class->process = process;
   operation_class->prepare = prepare;
 
+  G_OBJECT_CLASS (klass)->finalize = finalize;
+
   gegl_operation_class_set_keys (operation_class,
   "name"        , "gegl:gamma",
   "title"       , "Gamma",
@@ -29,7 +29,7 @@ a = [
       ['subtract',  'result = input - value', 0.0, '964b3d0b0afea081c157fe0251600ba3'],
       ['multiply',  'result = input * value', 1.0, 'c80bb8504f405bb0a5ce2be4fad6af69'],
       ['divide',    'result = value==0.0f?0.0f:input/value', 1.0, 'c3bd84f8a6b2c03a239f3f832597592c'],
-      ['gamma',     'result = (input >= 0.0f ? powf (input, value) : -powf (-input, value))', 1.0, '2687ab0395fe31ccc25e2901a43a9c03'],
+      ['gamma',     'result = (input >= 0.0f ? powf (input, value) : -powf (-input, value))', 1.0, '2687ab0395fe31ccc25e2901a43a9c03', true],
 #     ['threshold', 'result = c>=value?1.0f:0.0f', 0.5],
 #     ['invert',    'result = 1.0-c']
     ]
@@ -47,10 +47,107 @@ a.each do
     capitalized = name.capitalize
     swapcased   = name.swapcase
     formula     = item[1]
+    lookup      = item[4]
+
+    # operations marked with lookup approximate the formula with a
+    # GeglLookupTable for the constant value, built in prepare
+    lookup_include   = ''
+    lookup_functions = ''
+    lookup_prepare   = ''
+    lookup_declare   = ''
+    lookup_process   = ''
+    lookup_class     = ''
+
+    if lookup
+      lookup_include = "#include \"gegl-lookup.h\"
+"
+      lookup_functions = "
+/* the range of inputs approximated by the lookup table, within an error of
+ * about an ulp of the result; other inputs, including negative ones, are
+ * computed with the formula
+ */
+#define LOOKUP_START (1.0f / (1 << 24))
+#define LOOKUP_END   256.0f
+#define LOOKUP_ERROR 2.5e-7f
+
+typedef struct
+{
+  gfloat           value;
+  GeglLookupTable *table;
+} Lookup;
+
+static gfloat
+lookup_function (gfloat   input,
+                 gpointer data)
+{
+  gfloat value = *(gfloat *) data;
+  gfloat result;
+  #{formula};
+  return result;
+}
+
+static void
+lookup_free (Lookup *lookup)
+{
+  g_clear_pointer (&lookup->table, gegl_lookup_table_free);
+  g_free (lookup);
+}
+
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, lookup_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+"
+      lookup_prepare = "
+  /* the table is kept for as long as the value doesn't change */
+  if (! o->user_data || ((Lookup *) o->user_data)->value != (gfloat) o->value)
+    {
+      Lookup *lookup = g_new (Lookup, 1);
+
+      g_clear_pointer (&o->user_data, lookup_free);
+
+      /* the table is NULL if the formula can't be approximated for the
+       * value, in which case it is evaluated for each pixel
+       */
+      lookup->value = o->value;
+      lookup->table = gegl_lookup_table_new (lookup_function, &lookup->value,
+                                             LOOKUP_START, LOOKUP_END,
+                                             LOOKUP_ERROR);
+
+      o->user_data = lookup;
+    }
+"
+      lookup_declare = "
+  Lookup *lookup     = GEGL_PROPERTIES (op)->user_data;"
+      lookup_process = "if (aux == NULL && lookup && lookup->table &&
+      lookup->value == (gfloat) GEGL_PROPERTIES (op)->value)
+    {
+      for (i=0; i<n_pixels; i++)
+        {
+          gint   j;
+          for (j=0; j<components-alpha; j++)
+            out[j]=gegl_lookup_table (lookup->table, in[j]);
+          if (alpha)
+            out[components-1]=in[components-1];
+          in += components;
+          out+= components;
+        }
+    }
+  else "
+      lookup_class = "
+  G_OBJECT_CLASS (klass)->finalize = finalize;
+"
+    end
 
     file.write copyright
     file.write "
 #include \"config.h\"
+#include <string.h>
 #include <glib/gi18n-lib.h>
 
 
@@ -67,15 +164,18 @@ property_double (value, _(\"Value\"), #{item[2]})
 #define GEGL_OP_C_FILE       \"#{filename}\"
 
 #include \"gegl-op.h\"
-
+#{lookup_include}
 #ifdef _MSC_VER
 #define powf(a,b) ((gfloat)pow(a,b))
 #endif
 
+/* the number of pixels processed at once by the RGBA float path */
+#define COMPOSITE_BLOCK 64
+#{lookup_functions}
 
 static void prepare (GeglOperation *operation)
 {
-  const Babl *format = gegl_operation_get_source_format (operation, \"input\");
+#{lookup ? "  GeglProperties *o = GEGL_PROPERTIES (operation);\n" : ''}  const Babl *format = gegl_operation_get_source_format (operation, \"input\");
   if (!format)
     format = gegl_operation_get_source_format (operation, \"aux\");
   format = gegl_babl_variant (format, GEGL_BABL_VARIANT_LINEAR);
@@ -83,7 +183,7 @@ static void prepare (GeglOperation *operation)
   gegl_operation_set_format (operation, \"input\", format);
   gegl_operation_set_format (operation, \"aux\", format);
   gegl_operation_set_format (operation, \"output\", format);
-}
+#{lookup_prepare}}
 
 static gboolean
 process (GeglOperation       *op,
@@ -100,9 +200,9 @@ process (GeglOperation       *op,
   const Babl *format = gegl_operation_get_format (op, \"output\");
   gint    components = babl_format_get_n_components (format);
   gint    alpha      = babl_format_has_alpha (format);
-  gint    i;
+  gint    i;#{lookup_declare}
 
-  if (aux == NULL)
+  #{lookup_process}if (aux == NULL)
     {
       gfloat value = GEGL_PROPERTIES (op)->value;
       for (i=0; i<n_pixels; i++)
@@ -121,6 +221,41 @@ process (GeglOperation       *op,
           out+= components;
         }
     }
+  else if (components == 4 && alpha)
+    {
+      /* a fixed number of components, which lets the compiler unroll
+       * the channel loop, and vectorize it where it can; the block is
+       * processed into a scratch buffer, since out may be the same
+       * buffer as in.
+       */
+      while (n_pixels > 0)
+        {
+          gfloat block[COMPOSITE_BLOCK * 4];
+          gint   n = MIN (n_pixels, COMPOSITE_BLOCK);
+
+          for (i=0; i<n; i++)
+            {
+              gint   j;
+              gfloat value;
+              for (j=0; j<3; j++)
+                {
+                  gfloat input =in[4 * i + j];
+                  gfloat result;
+                  value=aux[4 * i + j];
+                  #{formula};
+                  block[4 * i + j]=result;
+                }
+              block[4 * i + 3]=in[4 * i + 3];
+            }
+
+          memcpy (out, block, sizeof (gfloat) * 4 * n);
+
+          in       += 4 * n;
+          aux      += 4 * n;
+          out      += 4 * n;
+          n_pixels -= n;
+        }
+    }
   else
     {
       for (i=0; i<n_pixels; i++)
@@ -157,7 +292,7 @@ gegl_op_class_init (GeglOpClass *klass)
 
   point_composer_class->process = process;
   operation_class->prepare = prepare;
-
+#{lookup_class}
   gegl_operation_class_set_keys (operation_class,
   \"name\"        , \"gegl:#{name}\",
   \"title\"       , \"#{name.capitalize}\",
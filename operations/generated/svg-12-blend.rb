@@ -79,6 +79,7 @@ d = [
 
 file_head1 = '
 #include "config.h"
+#include <string.h>
 #include <glib/gi18n-lib.h>
 
 
@@ -91,6 +92,9 @@ property_boolean (srgb, _("sRGB"), FALSE)
 '
 
 file_head2 = '
+/* the number of pixels composited at once by the RaGaBaA float path */
+#define COMPOSITE_BLOCK 64
+
 static void prepare (GeglOperation *operation)
 {
   const Babl *format = gegl_operation_get_source_format (operation, "input");
@@ -175,6 +179,52 @@ process (GeglOperation       *op,
      return TRUE;
 '
 
+# RaGaBaA float, which all but exotic inputs are composited in, takes a path
+# with a fixed number of components, which lets the compiler unroll the
+# channel loop, and vectorize it where it can.  pixels are composited in
+# blocks, into a scratch buffer, since out may be the same buffer as in.
+def fast_path (a_formula, channel)
+  channel = channel.gsub('out[j]', 'block[4 * i + j]').gsub(/^(?=.)/, '        ')
+  return "
+  if (components == 4 && alpha)
+    {
+      while (n_pixels > 0)
+        {
+          gfloat block[COMPOSITE_BLOCK * 4];
+          gint   n = MIN (n_pixels, COMPOSITE_BLOCK);
+
+          for (i = 0; i < n; i++)
+            {
+              gfloat aA, aB, aD;
+              gint   j;
+
+              aB = in[4 * i + 3];
+              aA = aux[4 * i + 3];
+              aD = #{a_formula};
+
+              for (j = 0; j < 3; j++)
+                {
+                  gfloat cA, cB;
+
+                  cB = in[4 * i + j];
+                  cA = aux[4 * i + j];
+#{channel}                }
+              block[4 * i + 3] = aD;
+            }
+
+          memcpy (out, block, sizeof (gfloat) * 4 * n);
+
+          in       += 4 * n;
+          aux      += 4 * n;
+          out      += 4 * n;
+          n_pixels -= n;
+        }
+
+      return TRUE;
+    }
+"
+end
+
 file_tail1 = '
   return TRUE;
 }
@@ -194,6 +244,7 @@ gegl_op_class_init (GeglOpClass *klass)
 '
 
 file_tail2 = '  gegl_operation_class_set_key (operation_class, "categories", "compositors:svgfilter");
+  gegl_operation_class_set_key (operation_class, "transparent-aux-passthrough", "true");
 }
 
 #endif
@@ -224,7 +275,10 @@ a.each do
 
 #include \"gegl-op.h\"
 "
+    channel     = "          out[j] = CLAMP (#{formula1}, 0, aD);\n"
+
     file.write file_head2
+    file.write fast_path('aA + aB - aA * aB', channel)
     file.write "
   for (i = 0; i < n_pixels; i++)
     {
@@ -248,8 +302,7 @@ a.each do
 
           cB = in[j];
           cA = aux[j];
-          out[j] = CLAMP (#{formula1}, 0, aD);
-        }
+#{channel}        }
       if (alpha)
         out[components-1] = aD;
       in  += components;
@@ -286,6 +339,10 @@ b.each do
     cond1       = item[1]
     formula1    = item[2]
     formula2    = item[3]
+    channel     = "          if (#{cond1})
+            out[j] = CLAMP (#{formula1}, 0, aD);
+          else
+            out[j] = CLAMP (#{formula2}, 0, aD);\n"
 
     file.write copyright
     file.write file_head1
@@ -297,6 +354,7 @@ b.each do
 #include \"gegl-op.h\"
 "
     file.write file_head2
+    file.write fast_path('aA + aB - aA * aB', channel)
     file.write "
   for (i = 0; i < n_pixels; i++)
     {
@@ -320,11 +378,7 @@ b.each do
 
           cB = in[j];
           cA = aux[j];
-          if (#{cond1})
-            out[j] = CLAMP (#{formula1}, 0, aD);
-          else
-            out[j] = CLAMP (#{formula2}, 0, aD);
-        }
+#{channel}        }
       if (alpha)
         out[components-1] = aD;
       in  += components;
@@ -364,6 +418,12 @@ c.each do
     cond2       = item[3]
     formula2    = item[4]
     formula3    = item[5]
+    channel     = "          if (#{cond1})
+            out[j] = CLAMP (#{formula1}, 0, aD);
+          else if (#{cond2})
+            out[j] = CLAMP (#{formula2}, 0, aD);
+          else
+            out[j] = CLAMP (#{formula3}, 0, aD);\n"
 
     file.write copyright
     file.write file_head1
@@ -375,6 +435,7 @@ c.each do
 #include \"gegl-op.h\"
 "
     file.write file_head2
+    file.write fast_path('aA + aB - aA * aB', channel)
     file.write "
   for (i = 0; i < n_pixels; i++)
     {
@@ -398,13 +459,7 @@ c.each do
 
           cB = in[j];
           cA = aux[j];
-          if (#{cond1})
-            out[j] = CLAMP (#{formula1}, 0, aD);
-          else if (#{cond2})
-            out[j] = CLAMP (#{formula2}, 0, aD);
-          else
-            out[j] = CLAMP (#{formula3}, 0, aD);
-        }
+#{channel}        }
       if (alpha)
       {
         out[components-1] = aD;
@@ -442,6 +497,7 @@ d.each do
     swapcased   = name.swapcase
     formula1    = item[1]
     formula2    = item[2]
+    channel     = "          out[j] = CLAMP (#{formula1}, 0, aD);\n"
 
     file.write copyright
     file.write file_head1
@@ -453,6 +509,7 @@ d.each do
 #include \"gegl-op.h\"
 "
     file.write file_head2
+    file.write fast_path(formula2, channel)
     file.write "
   for (i = 0; i < n_pixels; i++)
     {
@@ -476,8 +533,7 @@ d.each do
 
           cB = in[j];
           cA = aux[j];
-          out[j] = CLAMP (#{formula1}, 0, aD);
-        }
+#{channel}        }
       if (alpha)
         out[components-1] = aD;
       in  += components;
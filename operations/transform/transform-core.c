@@ -26,6 +26,7 @@
 
 
 #include "config.h"
+#include <stdlib.h>
 #include <glib/gi18n-lib.h>
 
 #include <gegl.h>
@@ -77,7 +78,14 @@ static gboolean      gegl_transform_scanline_limits              (const GeglMatr
                                                                   gdouble               w0,
                                                                   gint                 *first,
                                                                   gint                 *last);
+static gboolean      gegl_transform_is_transparent_node          (GeglNode             *node);
+static gboolean      gegl_transform_sampler_is_linear            (GeglSamplerType       sampler);
+static gboolean      gegl_transform_is_integer_translation       (OpTransform          *transform);
+static gboolean      gegl_transform_consumers_can_composite      (OpTransform          *transform,
+                                                                  GeglNode             *node,
+                                                                  gboolean              filtered);
 static gboolean      gegl_transform_is_intermediate_node         (OpTransform          *transform);
+static OpTransform  *gegl_transform_get_source_transform         (OpTransform          *transform);
 static gboolean      gegl_transform_is_composite_node            (OpTransform          *transform);
 static void          gegl_transform_get_source_matrix            (OpTransform          *transform,
                                                                   GeglMatrix3          *output);
@@ -656,77 +664,191 @@ gegl_transform_scanline_limits (const GeglMatrix3   *inverse,
   return *first < *last;
 }
 
+/*
+ * Whether @node can be moved across transforms without changing the
+ * result, so that the transforms on either side of it are resampled at
+ * once.  Operations which apply the same function to every pixel, linear in
+ * the premultiplied components (such as an affine map of the color
+ * components which leaves alpha as is), commute with the interpolation of
+ * the samplers; they set the "commutes-with-transforms" key, and qualify
+ * as long as they don't have an aux input.
+ */
 static gboolean
-gegl_transform_is_intermediate_node (OpTransform *transform)
+gegl_transform_is_transparent_node (GeglNode *node)
 {
-  GeglOperation *op = GEGL_OPERATION (transform);
+  GeglOperation *operation = gegl_node_get_gegl_operation (node);
+  const gchar   *commutes;
 
-  gboolean is_intermediate = TRUE;
+  if (! operation)
+    return FALSE;
 
-  GeglNode **consumers = NULL;
+  commutes = gegl_operation_class_get_key (GEGL_OPERATION_GET_CLASS (operation),
+                                           "commutes-with-transforms");
 
-  if (0 == gegl_node_get_consumers (op->node, "output", &consumers, NULL))
-    {
-      is_intermediate = FALSE;
-    }
-  else
+  return ! g_strcmp0 (commutes, "true") &&
+         ! gegl_node_get_producer (node, "aux", NULL);
+}
+
+/*
+ * Whether @sampler interpolates with weights which don't depend on the
+ * pixels, so that the transparent nodes commute with it; the halo samplers
+ * adapt their filters to the pixels, and don't qualify.
+ */
+static gboolean
+gegl_transform_sampler_is_linear (GeglSamplerType sampler)
+{
+  return sampler == GEGL_SAMPLER_NEAREST ||
+         sampler == GEGL_SAMPLER_LINEAR  ||
+         sampler == GEGL_SAMPLER_CUBIC;
+}
+
+/*
+ * Whether the own matrix of @transform is a translation by an integer
+ * vector, which doesn't need any resampling of its own.
+ */
+static gboolean
+gegl_transform_is_integer_translation (OpTransform *transform)
+{
+  GeglMatrix3 matrix;
+
+  gegl_transform_create_matrix (transform, &matrix);
+
+  return gegl_transform_matrix3_allow_fast_translate (&matrix);
+}
+
+/*
+ * Whether all the consumers of the output of @node are transforms which can
+ * resample the input of @transform along with their own matrix: they have
+ * to use the same sampler, abyss policy and near plane, unless @transform is
+ * an integer translation.
+ *
+ * Transparent nodes are looked through, as long as the transform which
+ * resamples the chain uses a linear sampler; @filtered is whether one was
+ * looked through already.  Integer translations which are intermediate
+ * nodes themselves are looked through too, whatever their sampler.
+ */
+static gboolean
+gegl_transform_consumers_can_composite (OpTransform *transform,
+                                        GeglNode    *node,
+                                        gboolean     filtered)
+{
+  GeglNode    **consumers = NULL;
+  const gchar **pads      = NULL;
+  gboolean      result    = TRUE;
+  gint          n_consumers;
+  gint          i;
+
+  n_consumers = gegl_node_get_consumers (node, "output", &consumers, &pads);
+
+  if (n_consumers == 0)
+    result = FALSE;
+
+  for (i = 0; result && i < n_consumers; i++)
     {
-      int i;
-      for (i = 0; consumers[i]; ++i)
-        {
-          GeglOperation *sink = gegl_node_get_gegl_operation (consumers[i]);
+      GeglOperation *sink = gegl_node_get_gegl_operation (consumers[i]);
 
-          if (! IS_OP_TRANSFORM (sink)                              ||
-              transform->sampler != OP_TRANSFORM (sink)->sampler    ||
-              gegl_transform_get_abyss_policy (transform) !=
-              gegl_transform_get_abyss_policy (OP_TRANSFORM (sink)) ||
-              transform->near_z != OP_TRANSFORM (sink)->near_z)
-            {
-              is_intermediate = FALSE;
-              break;
-            }
+      if (strcmp (pads[i], "input"))
+        {
+          result = FALSE;
+        }
+      else if (gegl_transform_is_transparent_node (consumers[i]))
+        {
+          result = gegl_transform_consumers_can_composite (transform,
+                                                           consumers[i],
+                                                           TRUE);
+        }
+      else if (! IS_OP_TRANSFORM (sink))
+        {
+          result = FALSE;
+        }
+      else if (gegl_transform_is_integer_translation (OP_TRANSFORM (sink)) &&
+               gegl_transform_is_intermediate_node (OP_TRANSFORM (sink)))
+        {
+          result = gegl_transform_consumers_can_composite (transform,
+                                                           consumers[i],
+                                                           filtered);
+        }
+      else if (filtered &&
+               ! gegl_transform_sampler_is_linear (OP_TRANSFORM (sink)->sampler))
+        {
+          result = FALSE;
+        }
+      else if (! gegl_transform_is_integer_translation (transform))
+        {
+          result =
+            transform->sampler == OP_TRANSFORM (sink)->sampler    &&
+            gegl_transform_get_abyss_policy (transform) ==
+            gegl_transform_get_abyss_policy (OP_TRANSFORM (sink)) &&
+            transform->near_z == OP_TRANSFORM (sink)->near_z;
         }
     }
 
   g_free (consumers);
+  g_free (pads);
 
-  return is_intermediate;
+  return result;
 }
 
+/*
+ * Whether @transform passes its input through, leaving it to the
+ * transforms downstream to resample it along with their own matrix, see
+ * gegl_transform_consumers_can_composite().  A chain of transforms, possibly
+ * with transparent nodes in between, is therefore resampled only once, by
+ * its last transform, and the transparent nodes process the input of the
+ * chain.
+ */
 static gboolean
-gegl_transform_is_composite_node (OpTransform *transform)
+gegl_transform_is_intermediate_node (OpTransform *transform)
 {
   GeglOperation *op = GEGL_OPERATION (transform);
-  GeglNode *source_node;
+
+  return gegl_transform_consumers_can_composite (transform, op->node, FALSE);
+}
+
+/*
+ * The transform whose output reaches the input of @transform, looking
+ * through transparent nodes, or NULL.
+ */
+static OpTransform *
+gegl_transform_get_source_transform (OpTransform *transform)
+{
+  GeglOperation *op = GEGL_OPERATION (transform);
+  GeglNode      *source_node;
   GeglOperation *source;
 
   source_node = gegl_node_get_producer (op->node, "input", NULL);
 
-  if (!source_node)
-    return FALSE;
+  while (source_node && gegl_transform_is_transparent_node (source_node))
+    source_node = gegl_node_get_producer (source_node, "input", NULL);
+
+  if (! source_node)
+    return NULL;
 
   source = gegl_node_get_gegl_operation (source_node);
 
-  return (IS_OP_TRANSFORM (source) &&
-          gegl_transform_is_intermediate_node (OP_TRANSFORM (source)));
+  if (! source || ! IS_OP_TRANSFORM (source))
+    return NULL;
+
+  return OP_TRANSFORM (source);
+}
+
+static gboolean
+gegl_transform_is_composite_node (OpTransform *transform)
+{
+  OpTransform *source = gegl_transform_get_source_transform (transform);
+
+  return source && gegl_transform_is_intermediate_node (source);
 }
 
 static void
 gegl_transform_get_source_matrix (OpTransform *transform,
                                   GeglMatrix3 *output)
 {
-  GeglOperation *op = GEGL_OPERATION (transform);
-  GeglNode *source_node;
-  GeglOperation *source;
-
-  source_node = gegl_node_get_producer (op->node, "input", NULL);
+  OpTransform *source = gegl_transform_get_source_transform (transform);
 
-  g_assert (source_node);
+  g_assert (source);
 
-  source = gegl_node_get_gegl_operation (source_node);
-  g_assert (IS_OP_TRANSFORM (source));
-
-  gegl_transform_create_composite_matrix (OP_TRANSFORM (source), output);
+  gegl_transform_create_composite_matrix (source, output);
   /*gegl_matrix3_copy (output, OP_TRANSFORM (source)->matrix);*/
 }
 
@@ -1129,8 +1251,6 @@ transform_affine (GeglOperation       *operation,
                                          level?GEGL_SAMPLER_NEAREST:transform->sampler,
                                          level);
 
-  GeglSamplerGetFun sampler_get_fun = gegl_sampler_get_fun (sampler);
-
   GeglRectangle  bounding_box = *gegl_buffer_get_abyss (src);
   GeglRectangle  context_rect = *gegl_sampler_get_context_rect (sampler);
   GeglRectangle  dest_extent  = *roi;
@@ -1226,26 +1346,21 @@ transform_affine (GeglOperation       *operation,
               gdouble u_float = u_start;
               gdouble v_float = v_start;
 
-              gint x;
-
               memset (dest_ptr, 0, (gint) components * sizeof (gfloat) * x1);
               dest_ptr += (gint) components * x1;
 
               u_float += x1 * inverse_jacobian.coeff [0][0];
               v_float += x1 * inverse_jacobian.coeff [1][0];
 
-              for (x = x1; x < x2; x++)
-                {
-                  sampler_get_fun (sampler,
-                                   u_float, v_float,
-                                   &inverse_jacobian,
-                                   dest_ptr,
-                                   abyss_policy);
-                  dest_ptr += (gint) components;
-
-                  u_float += inverse_jacobian.coeff [0][0];
-                  v_float += inverse_jacobian.coeff [1][0];
-                }
+              gegl_sampler_get_line (sampler,
+                                     u_float, v_float,
+                                     inverse_jacobian.coeff [0][0],
+                                     inverse_jacobian.coeff [1][0],
+                                     x2 - x1,
+                                     &inverse_jacobian,
+                                     dest_ptr,
+                                     abyss_policy);
+              dest_ptr += (gint) components * (x2 - x1);
 
               memset (dest_ptr, 0, (gint) components * sizeof (gfloat) * (roi->width - x2));
               dest_ptr += (gint) components * (roi->width - x2);
@@ -1438,7 +1553,6 @@ transform_nearest (GeglOperation       *operation,
   GeglSampler *sampler = gegl_buffer_sampler_new_at_level (src, format,
                                          GEGL_SAMPLER_NEAREST,
                                          level);
-  GeglSamplerGetFun sampler_get_fun = gegl_sampler_get_fun (sampler);
 
   GeglRectangle  bounding_box = *gegl_buffer_get_abyss (src);
   GeglRectangle  dest_extent  = *roi;
@@ -1520,22 +1634,35 @@ transform_nearest (GeglOperation       *operation,
             v_float += x1 * inverse.coeff [1][0];
             w_float += x1 * inverse.coeff [2][0];
 
-            for (x = x1; x < x2; x++)
+            /*
+             * Sample the scanline a batch at a time.
+             */
+            for (x = x1; x < x2; x += GEGL_SAMPLER_BATCH_SIZE)
               {
-                gdouble w_recip = (gdouble) 1.0 / w_float;
-                gdouble u = u_float * w_recip;
-                gdouble v = v_float * w_recip;
-
-                sampler_get_fun (sampler,
-                                 u, v,
-                                 NULL,
-                                 dest_ptr,
-                                 abyss_policy);
-
-                dest_ptr += px_size;
-                u_float += inverse.coeff [0][0];
-                v_float += inverse.coeff [1][0];
-                w_float += inverse.coeff [2][0];
+                gdouble u[GEGL_SAMPLER_BATCH_SIZE];
+                gdouble v[GEGL_SAMPLER_BATCH_SIZE];
+                gint    n = MIN (x2 - x, GEGL_SAMPLER_BATCH_SIZE);
+                gint    j;
+
+                for (j = 0; j < n; j++)
+                  {
+                    gdouble w_recip = (gdouble) 1.0 / w_float;
+
+                    u[j] = u_float * w_recip;
+                    v[j] = v_float * w_recip;
+
+                    u_float += inverse.coeff [0][0];
+                    v_float += inverse.coeff [1][0];
+                    w_float += inverse.coeff [2][0];
+                  }
+
+                gegl_sampler_get_n (sampler,
+                                    u, v, n,
+                                    NULL,
+                                    dest_ptr,
+                                    abyss_policy);
+
+                dest_ptr += px_size * n;
               }
 
             memset (dest_ptr, 0, px_size * (roi->width - x2));
@@ -1556,6 +1683,439 @@ transform_nearest (GeglOperation       *operation,
   g_object_unref (sampler);
 }
 
+/*
+ * Separable path for scaling (and translating) with the linear and cubic
+ * samplers.
+ *
+ * For a matrix which only scales, the filter the sampler applies to each
+ * output pixel -- point interpolation, possibly averaged over a grid of
+ * points when minifying (see _gegl_sampler_box_get()) -- is the product of
+ * a horizontal and a vertical filter, whose taps only depend on the output
+ * column and row, respectively.  The taps are computed once per column and
+ * row, and the output is computed by a horizontal pass over the source rows
+ * the vertical taps refer to, followed by a vertical pass, a strip of
+ * output rows at a time.
+ *
+ * The results match those of transform_affine(), up to rounding.
+ */
+
+/* the number of output rows processed at once */
+#define TRANSFORM_SCALE_STRIP_HEIGHT 16
+
+typedef struct
+{
+  gint   offset;
+  gfloat weight;
+} ScaleTap;
+
+/* matches the kernel of the cubic sampler */
+static inline gfloat
+transform_scale_cubic_kernel (gfloat x,
+                              gfloat b,
+                              gfloat c)
+{
+  const gfloat x2 = x * x;
+  const gfloat ax = fabsf (x);
+
+  if (x2 <= 1.0f)
+    return ((gfloat) ((12 - 9 * b - 6 * c) / 6) * ax +
+            (gfloat) ((-18 + 12 * b + 6 * c) / 6)) * x2 +
+           (gfloat) ((6 - 2 * b) / 6);
+
+  if (x2 < 4.0f)
+    return ((gfloat) ((-b - 6 * c) / 6) * ax +
+            (gfloat) ((6 * b + 30 * c) / 6)) * x2 +
+           (gfloat) ((-12 * b - 48 * c) / 6) * ax +
+           (gfloat) ((8 * b + 24 * c) / 6);
+
+  return 0.0f;
+}
+
+/*
+ * The largest number of points the sampler averages along an axis, the
+ * max_n_samples the sampler passes to _gegl_sampler_box_get(); from
+ * max_n_samples + 1 on, the sampler samples the mipmap levels instead.
+ */
+static inline gint
+transform_scale_get_max_n_samples (GeglSamplerType sampler_type)
+{
+  return sampler_type == GEGL_SAMPLER_CUBIC ? 5 : 4;
+}
+
+/*
+ * The number of points the sampler averages along an axis whose source
+ * coordinates are @step apart, as in _gegl_sampler_box_get(); this is 1
+ * unless minifying by a factor of 2 or more.
+ */
+static inline gint
+transform_scale_get_n_samples (GeglSamplerType sampler_type,
+                               gdouble         step)
+{
+  return CLAMP ((gint) floor (fabs (step)), 1,
+                transform_scale_get_max_n_samples (sampler_type));
+}
+
+/* the number of taps of each output sample along such an axis */
+static inline gint
+transform_scale_get_n_taps (GeglSamplerType sampler_type,
+                            gdouble         step)
+{
+  const gint n_point_taps = sampler_type == GEGL_SAMPLER_CUBIC ? 4 : 2;
+
+  return transform_scale_get_n_samples (sampler_type, step) * n_point_taps;
+}
+
+/*
+ * Computes the taps of @len output samples, the first of which is at source
+ * coordinate @start, and the rest @step apart, the way the sampler
+ * interpolates them, and stores them in @taps,
+ * transform_scale_get_n_taps() per sample.
+ */
+static void
+transform_scale_get_taps (GeglSamplerType  sampler_type,
+                          gfloat           cubic_b,
+                          gfloat           cubic_c,
+                          gdouble          start,
+                          gdouble          step,
+                          gint             len,
+                          ScaleTap        *taps)
+{
+  const gint    n_point_taps  = sampler_type == GEGL_SAMPLER_CUBIC ? 4 : 2;
+  const gint    n_samples     = transform_scale_get_n_samples (sampler_type,
+                                                               step);
+  const gdouble sample_step   = step / n_samples;
+  const gfloat  sample_weight = 1.0f / n_samples;
+  gint          i;
+
+  for (i = 0; i < len; i++)
+    {
+      gdouble x = start + step * i - (step - sample_step) / 2.0;
+      gint    k;
+
+      for (k = 0; k < n_samples; k++)
+        {
+          if (sampler_type == GEGL_SAMPLER_CUBIC)
+            {
+              const gdouble ix_float = x - 0.5;
+              const gint    ix       = floorf ((gfloat) ix_float);
+              const gfloat  fx       = ix_float - ix;
+              gint          j;
+
+              for (j = 0; j < 4; j++)
+                {
+                  taps[j].offset = ix + j - 1;
+                  taps[j].weight = sample_weight *
+                                   transform_scale_cubic_kernel (fx - (j - 1),
+                                                                 cubic_b,
+                                                                 cubic_c);
+                }
+            }
+          else
+            {
+              const gfloat ix_float = (gfloat) x - 0.5;
+              const gint   ix       = floorf (ix_float);
+              const gfloat fx       = ix_float - ix;
+
+              taps[0].offset = ix;
+              taps[0].weight = sample_weight * (1.0f - fx);
+              taps[1].offset = ix + 1;
+              taps[1].weight = sample_weight * fx;
+            }
+
+          taps += n_point_taps;
+          x    += sample_step;
+        }
+    }
+}
+
+static inline void
+transform_scale_filter_row_nc (const gfloat   *src,
+                               gfloat         *dst,
+                               const ScaleTap *taps,
+                               gint            n_taps,
+                               gint            width,
+                               gint            components)
+{
+  gint i;
+
+  for (i = 0; i < width; i++)
+    {
+      gfloat sum[components];
+      gint   c, t;
+
+      for (c = 0; c < components; c++)
+        sum[c] = 0.0f;
+
+      for (t = 0; t < n_taps; t++)
+        {
+          const gfloat *s = src + taps[t].offset;
+          const gfloat  w = taps[t].weight;
+
+          for (c = 0; c < components; c++)
+            sum[c] += w * s[c];
+        }
+
+      for (c = 0; c < components; c++)
+        dst[c] = sum[c];
+
+      taps += n_taps;
+      dst  += components;
+    }
+}
+
+/* the tap offsets are in floats, relative to @src */
+static void
+transform_scale_filter_row (const gfloat   *src,
+                            gfloat         *dst,
+                            const ScaleTap *taps,
+                            gint            n_taps,
+                            gint            width,
+                            gint            components)
+{
+  /* RaGaBaA float, the common case, gets its own loop */
+  if (components == 4)
+    transform_scale_filter_row_nc (src, dst, taps, n_taps, width, 4);
+  else
+    transform_scale_filter_row_nc (src, dst, taps, n_taps, width, components);
+}
+
+static gint
+compare_ints (gconstpointer a,
+              gconstpointer b)
+{
+  const gint x = *(const gint *) a;
+  const gint y = *(const gint *) b;
+
+  return (x > y) - (x < y);
+}
+
+static void
+transform_scale (GeglOperation       *operation,
+                 GeglBuffer          *dest,
+                 GeglBuffer          *src,
+                 GeglMatrix3         *matrix,
+                 const GeglRectangle *roi,
+                 gint                 level)
+{
+  OpTransform     *transform      = (OpTransform *) operation;
+  const Babl      *format         = gegl_operation_get_format (operation, "output");
+  const gint       components     = babl_format_get_n_components (format);
+  GeglAbyssPolicy  abyss_policy   = gegl_transform_get_abyss_policy (transform);
+  gdouble          inverse_near_z = 1.0 / transform->near_z;
+  const gint       width          = roi->width;
+  const gint       height         = roi->height;
+  const gint       row_stride     = width * components;
+  GeglSampler     *sampler;
+  GeglRectangle    bounding_box   = *gegl_buffer_get_abyss (src);
+  GeglRectangle    context_rect;
+  GeglMatrix3      inverse;
+  gfloat           cubic_b        = 0.0f;
+  gfloat           cubic_c        = 0.0f;
+  gdouble          base_u;
+  gdouble          base_v;
+  ScaleTap        *x_taps;
+  ScaleTap        *y_taps;
+  gint             n_x_taps;
+  gint             n_y_taps;
+  gint             span_x;
+  gint             span_width;
+  gint            *rows;
+  gint            *row_indices;
+  gfloat          *src_row;
+  gfloat          *tmp;
+  gfloat          *out;
+  gint             i;
+  gint             y0;
+
+  /* the separable path is only taken at level 0, where the sampler isn't
+   * replaced by the nearest-neighbor one
+   */
+  g_return_if_fail (level == 0);
+
+  sampler      = gegl_buffer_sampler_new_at_level (src, format,
+                                                   transform->sampler, 0);
+  context_rect = *gegl_sampler_get_context_rect (sampler);
+
+  if (transform->sampler == GEGL_SAMPLER_CUBIC)
+    {
+      gdouble b;
+
+      /* the cubic sampler derives c from b, so that it's a Keys spline */
+      g_object_get (sampler, "b", &b, NULL);
+
+      cubic_b = b;
+      cubic_c = 0.5 * (1.0 - b);
+    }
+
+  g_object_unref (sampler);
+
+  bounding_box.x      += context_rect.x;
+  bounding_box.y      += context_rect.y;
+  bounding_box.width  += context_rect.width  - 1;
+  bounding_box.height += context_rect.height - 1;
+
+  gegl_matrix3_copy_into (&inverse, matrix);
+  gegl_matrix3_invert (&inverse);
+
+  base_u = inverse.coeff [0][0] * ((gdouble) 0.5) +
+           inverse.coeff [0][1] * ((gdouble) 0.5) +
+           inverse.coeff [0][2];
+  base_v = inverse.coeff [1][0] * ((gdouble) 0.5) +
+           inverse.coeff [1][1] * ((gdouble) 0.5) +
+           inverse.coeff [1][2];
+
+  /*
+   * Compute the taps of all the output columns and rows.
+   */
+  n_x_taps = transform_scale_get_n_taps (transform->sampler,
+                                         inverse.coeff [0][0]);
+  n_y_taps = transform_scale_get_n_taps (transform->sampler,
+                                         inverse.coeff [1][1]);
+
+  x_taps = g_new (ScaleTap, (gsize) width  * n_x_taps);
+  y_taps = g_new (ScaleTap, (gsize) height * n_y_taps);
+
+  transform_scale_get_taps (transform->sampler, cubic_b, cubic_c,
+                            base_u + inverse.coeff [0][0] * roi->x,
+                            inverse.coeff [0][0],
+                            width, x_taps);
+  transform_scale_get_taps (transform->sampler, cubic_b, cubic_c,
+                            base_v + inverse.coeff [1][1] * roi->y,
+                            inverse.coeff [1][1],
+                            height, y_taps);
+
+  /*
+   * Make the column taps relative to the span of source columns they refer
+   * to, in floats.
+   */
+  span_x     = G_MAXINT;
+  span_width = G_MININT;
+
+  for (i = 0; i < width * n_x_taps; i++)
+    {
+      span_x     = MIN (span_x,     x_taps[i].offset);
+      span_width = MAX (span_width, x_taps[i].offset);
+    }
+
+  span_width -= span_x - 1;
+
+  for (i = 0; i < width * n_x_taps; i++)
+    x_taps[i].offset = (x_taps[i].offset - span_x) * components;
+
+  rows        = g_new (gint, TRANSFORM_SCALE_STRIP_HEIGHT * n_y_taps);
+  row_indices = g_new (gint, TRANSFORM_SCALE_STRIP_HEIGHT * n_y_taps);
+
+  src_row = gegl_malloc (sizeof (gfloat) * span_width * components);
+  tmp     = gegl_malloc (sizeof (gfloat) * row_stride *
+                         TRANSFORM_SCALE_STRIP_HEIGHT * n_y_taps);
+  out     = gegl_malloc (sizeof (gfloat) * row_stride *
+                         TRANSFORM_SCALE_STRIP_HEIGHT);
+
+  for (y0 = 0; y0 < height; y0 += TRANSFORM_SCALE_STRIP_HEIGHT)
+    {
+      const gint      strip_height = MIN (TRANSFORM_SCALE_STRIP_HEIGHT,
+                                          height - y0);
+      const gint      n_strip_taps = strip_height * n_y_taps;
+      const ScaleTap *strip_taps   = y_taps + (gsize) y0 * n_y_taps;
+      gint            n_rows       = 0;
+      gint            y;
+
+      /*
+       * Collect the distinct source rows the strip refers to.
+       */
+      for (i = 0; i < n_strip_taps; i++)
+        rows[i] = strip_taps[i].offset;
+
+      qsort (rows, n_strip_taps, sizeof (gint), compare_ints);
+
+      for (i = 0; i < n_strip_taps; i++)
+        {
+          if (n_rows == 0 || rows[i] != rows[n_rows - 1])
+            rows[n_rows++] = rows[i];
+        }
+
+      for (i = 0; i < n_strip_taps; i++)
+        {
+          const gint *row = bsearch (&strip_taps[i].offset,
+                                     rows, n_rows, sizeof (gint),
+                                     compare_ints);
+
+          row_indices[i] = row - rows;
+        }
+
+      /*
+       * Horizontal pass.
+       */
+      for (i = 0; i < n_rows; i++)
+        {
+          gegl_buffer_get (src,
+                           GEGL_RECTANGLE (span_x, rows[i], span_width, 1),
+                           1.0, format, src_row,
+                           GEGL_AUTO_ROWSTRIDE, abyss_policy);
+
+          transform_scale_filter_row (src_row,
+                                      tmp + (gsize) i * row_stride,
+                                      x_taps, n_x_taps,
+                                      width, components);
+        }
+
+      /*
+       * Vertical pass, leaving the pixels transform_affine() wouldn't
+       * sample cleared.
+       */
+      for (y = 0; y < strip_height; y++)
+        {
+          gfloat *restrict  dst     = out + (gsize) y * row_stride;
+          const ScaleTap   *taps    = strip_taps + y * n_y_taps;
+          const gint       *indices = row_indices + y * n_y_taps;
+          const gint        row_y   = roi->y + y0 + y;
+          const gdouble     u_start = base_u +
+                                      inverse.coeff [0][0] * roi->x +
+                                      inverse.coeff [0][1] * row_y;
+          const gdouble     v_start = base_v +
+                                      inverse.coeff [1][0] * roi->x +
+                                      inverse.coeff [1][1] * row_y;
+          gint              x1      = 0;
+          gint              x2      = width;
+          gint              t;
+
+          memset (dst, 0, sizeof (gfloat) * row_stride);
+
+          if (! gegl_transform_scanline_limits (&inverse, inverse_near_z,
+                                                &bounding_box,
+                                                u_start, v_start, 1.0,
+                                                &x1, &x2))
+            {
+              continue;
+            }
+
+          for (t = 0; t < n_y_taps; t++)
+            {
+              const gfloat *restrict row    = tmp +
+                                              (gsize) indices[t] * row_stride;
+              const gfloat           weight = taps[t].weight;
+              gint                   k;
+
+              for (k = x1 * components; k < x2 * components; k++)
+                dst[k] += weight * row[k];
+            }
+        }
+
+      gegl_buffer_set (dest,
+                       GEGL_RECTANGLE (roi->x, roi->y + y0,
+                                       width, strip_height),
+                       0, format, out, GEGL_AUTO_ROWSTRIDE);
+    }
+
+  gegl_free (out);
+  gegl_free (tmp);
+  gegl_free (src_row);
+  g_free (row_indices);
+  g_free (rows);
+  g_free (y_taps);
+  g_free (x_taps);
+}
+
 static inline gboolean is_zero (const gdouble f)
 {
   return (((gdouble) f)*((gdouble) f)
@@ -1585,6 +2145,37 @@ gegl_transform_matrix3_allow_fast_translate (GeglMatrix3 *matrix)
   return gegl_matrix3_is_translate (matrix);
 }
 
+/*
+ * Whether to use transform_scale() rather than transform_affine(): when the
+ * matrix only scales and translates, and the sampler is linear or cubic,
+ * whose filters are separable.  Magnifications, where each output pixel
+ * only has a few source pixels to interpolate, gain little from it, and
+ * keep using transform_affine(), as do minifications by a factor of
+ * max_n_samples + 1 or more, for which the sampler switches from the box
+ * filter to the mipmap levels.
+ */
+static gboolean
+gegl_transform_use_separable_scale (OpTransform *transform,
+                                    GeglMatrix3 *matrix)
+{
+  gdouble min_scale;
+
+  if (transform->sampler != GEGL_SAMPLER_LINEAR &&
+      transform->sampler != GEGL_SAMPLER_CUBIC)
+    return FALSE;
+
+  if (! gegl_matrix3_is_scale (matrix))
+    return FALSE;
+
+  min_scale = 1.0 / (transform_scale_get_max_n_samples (transform->sampler) +
+                     1);
+
+  return fabs (matrix->coeff [0][0]) >  min_scale &&
+         fabs (matrix->coeff [1][1]) >  min_scale &&
+         fabs (matrix->coeff [0][0]) <= 1.0       &&
+         fabs (matrix->coeff [1][1]) <= 1.0;
+}
+
 static gboolean
 gegl_transform_process (GeglOperation        *operation,
                         GeglOperationContext *context,
@@ -1663,6 +2254,10 @@ gegl_transform_process (GeglOperation        *operation,
       if (gegl_matrix3_is_affine (&matrix) && !is_cmyk)
         func = transform_affine;
 
+      if (func == transform_affine && level == 0 &&
+          gegl_transform_use_separable_scale (transform, &matrix))
+        func = transform_scale;
+
       if (transform->sampler == GEGL_SAMPLER_NEAREST)
         func = transform_nearest;
 
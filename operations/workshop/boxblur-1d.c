@@ -48,6 +48,8 @@ property_enum (orientation, _("Orientation"),
 
 #include "opencl/boxblur-1d.cl.h"
 
+#include "../common/box-blur-common.h"
+
 static GeglClRunData *cl_data = NULL;
 
 
@@ -276,45 +278,6 @@ get_cached_region (GeglOperation       *operation,
   return cached_region;
 }
 
-static inline void
-box_blur_1d (gfloat  *src_buf,
-             gfloat  *dst_buf,
-             gint     dst_size,
-             gint     radius,
-             gint     n_components)
-{
-  gint   n, i;
-  gint   src_offset;
-  gint   dst_offset = 0;
-  gint   prev_rad = radius * n_components + n_components;
-  gint   next_rad = radius * n_components;
-  gfloat rad1 = 1.f / (gfloat)(radius * 2 + 1);
-
-  for (i = 0; i < (2 * radius + 1); i++)
-    {
-      src_offset = i * n_components;
-      for (n = 0; n < n_components; n++)
-        {
-          dst_buf[dst_offset + n] += src_buf[src_offset + n] * rad1;
-        }    
-    }
-  
-  dst_offset += n_components;
-  
-  for (i = 1; i < dst_size; i++)
-    {
-      src_offset = (i + radius) * n_components;
-      for (n = 0; n < n_components; n++)
-        {
-          dst_buf[dst_offset] = dst_buf[dst_offset - n_components]
-                              - src_buf[src_offset - prev_rad] * rad1
-                              + src_buf[src_offset + next_rad] * rad1;
-          src_offset++;
-          dst_offset++;
-        }
-    }
-}
-
 static gboolean
 process (GeglOperation       *operation,
          GeglBuffer          *input,
@@ -326,8 +289,8 @@ process (GeglOperation       *operation,
   const Babl *format = gegl_operation_get_format (operation, "input");
   gint n_components  = babl_format_get_n_components (format);
   GeglRectangle src_rect;
-  GeglRectangle dst_rect;
   GeglRectangle scaled_roi;
+  BoxBlurData   data;
   gfloat       *src_buf;
   gfloat       *dst_buf;
   gfloat        factor = 1.0f / (1 << level);
@@ -350,68 +313,44 @@ process (GeglOperation       *operation,
                          o->radius, o->orientation);
     }
 
+  src_rect = scaled_roi;
+
   if (o->orientation == GEGL_ORIENTATION_HORIZONTAL)
     {
-      src_rect.x      = scaled_roi.x - scaled_radius;
-      src_rect.width  = scaled_roi.width + 2 * scaled_radius;
-      src_rect.height = 1;
-      
-      dst_rect.x      = scaled_roi.x;
-      dst_rect.width  = scaled_roi.width;
-      dst_rect.height = 1; 
-
-      src_buf = g_new (gfloat, src_rect.width * n_components);
-
-      for (src_rect.y = scaled_roi.y;
-           src_rect.y < scaled_roi.y + scaled_roi.height;
-           src_rect.y++)
-        {
-          dst_rect.y = src_rect.y;
-          dst_buf = g_new0 (gfloat, dst_rect.width * n_components);
-
-          gegl_buffer_get (input, &src_rect, factor, format, src_buf,
-                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-
-          box_blur_1d (src_buf, dst_buf, dst_rect.width, scaled_radius,
-                       n_components);
-
-          gegl_buffer_set (output, &dst_rect, level, format, dst_buf,
-                           GEGL_AUTO_ROWSTRIDE);
-          g_free (dst_buf);
-        }
+      src_rect.x     -= scaled_radius;
+      src_rect.width += 2 * scaled_radius;
     }
   else
     {
-      src_rect.y      = scaled_roi.y - scaled_radius;
-      src_rect.width  = 1;
-      src_rect.height = scaled_roi.height + 2 * scaled_radius;
-      
-      dst_rect.y      = scaled_roi.y;
-      dst_rect.width  = 1;
-      dst_rect.height = scaled_roi.height;
+      src_rect.y      -= scaled_radius;
+      src_rect.height += 2 * scaled_radius;
+    }
 
-      src_buf = g_new  (gfloat, src_rect.height * n_components);
+  src_buf = g_new (gfloat, (gsize) src_rect.width * src_rect.height * n_components);
+  dst_buf = g_new (gfloat, (gsize) src_rect.width * src_rect.height * n_components);
 
-      for (src_rect.x = scaled_roi.x;
-           src_rect.x < scaled_roi.x + scaled_roi.width;
-           src_rect.x++)
-        {
-          dst_rect.x = src_rect.x;
-          dst_buf = g_new0 (gfloat, dst_rect.height * n_components);
+  gegl_buffer_get (input, &src_rect, factor, format, src_buf,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
 
-          gegl_buffer_get (input, &src_rect, factor, format, src_buf,
-                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+  data.src               = src_buf;
+  data.dst               = dst_buf;
+  data.rowstride         = src_rect.width * n_components;
+  data.width             = scaled_roi.width;
+  data.height            = scaled_roi.height;
+  data.n_components      = n_components;
+  data.radius            = scaled_radius;
+  data.pixels_per_thread = gegl_operation_get_pixels_per_thread (operation);
 
-          box_blur_1d (src_buf, dst_buf, dst_rect.height, scaled_radius,
-                       n_components);
+  if (o->orientation == GEGL_ORIENTATION_HORIZONTAL)
+    box_blur_hor (&data);
+  else
+    box_blur_ver (&data);
 
-          gegl_buffer_set (output, &dst_rect, level, format, dst_buf,
-                           GEGL_AUTO_ROWSTRIDE);
-          g_free (dst_buf);
-        }
-    }  
+  gegl_buffer_set (output, &scaled_roi, level, format, dst_buf,
+                   data.rowstride * sizeof (gfloat));
 
   g_free (src_buf);
+  g_free (dst_buf);
 
   return TRUE;
 }
@@ -459,6 +398,7 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class->opencl_support    = TRUE;
   operation_class->prepare           = prepare;
   operation_class->process           = operation_process;
+  operation_class->threaded          = FALSE;
 
   gegl_operation_class_set_keys (operation_class,
       "name",        "gegl:boxblur-1d",
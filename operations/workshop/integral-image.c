@@ -35,52 +35,78 @@ property_boolean (squared, _("squared integral"), FALSE)
 
 #define SQR(x) ((x) * (x))
 
-static inline void
-compute_row_integral (gdouble  *src_row,
-                      gdouble  *top_row,
-                      gdouble  *dst_row,
-                      gint      width,
-                      gint      n_components,
-                      gboolean  squared)
+/* the number of rows integrated at once */
+#define STRIP_ROWS 64
+
+typedef struct
+{
+  const gdouble *src;
+  gdouble       *dst;
+  const gdouble *top_row;
+  gint           width;          /* of a row, in pixels */
+  gint           n_rows;
+  gint           src_components;
+  gint           dst_components;
+  gboolean       squared;
+} IntegralData;
+
+/* the running sums along each row */
+static void
+compute_row_sums (gsize               offset,
+                  gsize               size,
+                  const IntegralData *data)
 {
-  gint b;
+  const gint src_components = data->src_components;
+  const gint dst_components = data->dst_components;
+  gsize      y;
 
-  if (squared)
+  for (y = offset; y < offset + size; y++)
     {
-      while (width--)
+      const gdouble *src_row = data->src + y * data->width * src_components;
+      gdouble       *dst_row = data->dst + y * data->width * dst_components;
+      gint           x, b;
+
+      for (b = 0; b < dst_components; b++)
+        dst_row[b] = 0.0;
+
+      for (x = 1; x < data->width; x++)
         {
-          for (b = 0; b < n_components; b++)
+          src_row += src_components;
+          dst_row += dst_components;
+
+          for (b = 0; b < src_components; b++)
+            dst_row[b] = dst_row[b - dst_components] + src_row[b];
+
+          if (data->squared)
             {
-              dst_row[b] = src_row[b] +
-                           dst_row[b - n_components] +
-                           top_row[b] -
-                           top_row[b - n_components];
-
-              dst_row[b + n_components] =   SQR(src_row[b])
-                                          + dst_row[b - n_components * 2]
-                                          + top_row[b + n_components]
-                                          - top_row[b - n_components * 2];
+              for (b = 0; b < src_components; b++)
+                dst_row[b + src_components] =
+                  dst_row[b + src_components - dst_components] +
+                  SQR (src_row[b]);
             }
-
-          src_row += n_components;
-          top_row += n_components * 2;
-          dst_row += n_components * 2;
         }
     }
-  else
+}
+
+/* adds the row above to each row, for a range of the columns' components */
+static void
+compute_column_sums (gsize               offset,
+                     gsize               size,
+                     const IntegralData *data)
+{
+  const gsize    row_size = (gsize) data->width * data->dst_components;
+  const gdouble *top      = data->top_row + offset;
+  gint           y;
+
+  for (y = 0; y < data->n_rows; y++)
     {
-      while (width--)
-        {
-          for (b = 0; b < n_components; b++)
-            dst_row[b] =   src_row[b]
-                         + dst_row[b - n_components]
-                         + top_row[b]
-                         - top_row[b - n_components];
-
-          src_row += n_components;
-          top_row += n_components;
-          dst_row += n_components;
-        }
+      gdouble *restrict dst = data->dst + y * row_size + offset;
+      gsize             i;
+
+      for (i = 0; i < size; i++)
+        dst[i] += top[i];
+
+      top = dst;
     }
 }
 
@@ -133,54 +159,63 @@ process (GeglOperation       *operation,
   gint        src_components = babl_format_get_n_components (src_format);
   gint        dst_components = babl_format_get_n_components (dst_format);
 
-  gint     width, height;
-  gint     row_size;
-  gint     y;
-  gdouble *top_row  = NULL;
-  gdouble *dst_row  = NULL;
-  gdouble *src_row  = NULL;
-  gdouble *p_top    = NULL;
-  gdouble *p_dst    = NULL;
+  IntegralData data;
+  gint         width, height;
+  gint         y;
+  gdouble     *src_buf;
+  gdouble     *dst_buf;
+  gdouble     *top_row;
 
-  width = gegl_buffer_get_width (input);
+  width  = gegl_buffer_get_width (input);
   height = gegl_buffer_get_height (input);
-  row_size = width + 1;
 
-  top_row = g_new0 (gdouble, row_size * dst_components);
-  dst_row = g_new0 (gdouble, row_size * dst_components);
-  src_row = g_new  (gdouble, row_size * src_components);
+  /* the first column and the row above the first row are zero */
+  data.width          = width + 1;
+  data.src_components = src_components;
+  data.dst_components = dst_components;
+  data.squared        = o->squared;
+
+  src_buf = g_new  (gdouble, (gsize) data.width * STRIP_ROWS * src_components);
+  dst_buf = g_new  (gdouble, (gsize) data.width * STRIP_ROWS * dst_components);
+  top_row = g_new0 (gdouble, (gsize) data.width * dst_components);
 
-  p_top = top_row;
-  p_dst = dst_row;
+  data.src     = src_buf;
+  data.dst     = dst_buf;
+  data.top_row = top_row;
 
-  for (y = 0; y < height; y++)
+  for (y = 0; y < height; y += STRIP_ROWS)
     {
-      GeglRectangle row_rect = {-1, y, width + 1, 1};
+      GeglRectangle strip_rect = {-1, y, data.width, MIN (STRIP_ROWS, height - y)};
+
+      data.n_rows = strip_rect.height;
 
-      gegl_buffer_get (input, &row_rect, 1.0, src_format, src_row,
+      gegl_buffer_get (input, &strip_rect, 1.0, src_format, src_buf,
                        GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-      compute_row_integral (src_row + src_components,
-                            p_top + dst_components,
-                            p_dst + dst_components,
-                            width,
-                            src_components,
-                            o->squared);
+      gegl_parallel_distribute_range (
+        data.n_rows,
+        gegl_operation_get_pixels_per_thread (operation) / data.width,
+        (GeglParallelDistributeRangeFunc) compute_row_sums,
+        &data);
 
-      gegl_buffer_set (output, &row_rect, 0, dst_format, p_dst,
-                       GEGL_AUTO_ROWSTRIDE);
+      gegl_parallel_distribute_range (
+        (gsize) data.width * dst_components,
+        gegl_operation_get_pixels_per_thread (operation) * dst_components /
+        data.n_rows,
+        (GeglParallelDistributeRangeFunc) compute_column_sums,
+        &data);
 
-      p_top = p_dst;
+      gegl_buffer_set (output, &strip_rect, 0, dst_format, dst_buf,
+                       GEGL_AUTO_ROWSTRIDE);
 
-      if (p_dst == top_row)
-        p_dst = dst_row;
-      else
-        p_dst = top_row;
+      memcpy (top_row,
+              dst_buf + (gsize) (data.n_rows - 1) * data.width * dst_components,
+              (gsize) data.width * dst_components * sizeof (gdouble));
     }
 
+  g_free (src_buf);
+  g_free (dst_buf);
   g_free (top_row);
-  g_free (dst_row);
-  g_free (src_row);
 
   return TRUE;
 }
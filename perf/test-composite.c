@@ -0,0 +1,59 @@
+#include "test-common.h"
+
+void composite(GeglBuffer *buffer);
+
+static const gchar *operation;
+static GeglBuffer  *aux_buffer;
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  /* a selection of the generated composers: svg blend modes with one, two
+   * and three cases, porter-duff operators, and a math operation
+   */
+  const gchar *operations[] = { "gegl:screen", "gegl:overlay",
+                                "gegl:soft-light", "gegl:dst-in", "gegl:xor",
+                                "gegl:multiply" };
+  GeglBuffer  *buffer;
+  gint         i;
+
+  gegl_init (&argc, &argv);
+
+  buffer     = test_buffer (1024, 1024, babl_format ("RaGaBaA float"));
+  aux_buffer = test_buffer (1024, 1024, babl_format ("RaGaBaA float"));
+
+  for (i = 0; i < G_N_ELEMENTS (operations); i++)
+    {
+      gchar *id = g_strdup_printf ("%s (RaGaBaA)", operations[i]);
+
+      operation = operations[i];
+      bench (id, buffer, &composite);
+
+      g_free (id);
+    }
+
+  g_object_unref (buffer);
+  g_object_unref (aux_buffer);
+
+  gegl_exit ();
+  return 0;
+}
+
+void composite(GeglBuffer *buffer)
+{
+  GeglBuffer *buffer2;
+  GeglNode   *gegl, *source, *aux, *node, *sink;
+
+  gegl = gegl_node_new ();
+  source = gegl_node_new_child (gegl, "operation", "gegl:buffer-source", "buffer", buffer, NULL);
+  aux = gegl_node_new_child (gegl, "operation", "gegl:buffer-source", "buffer", aux_buffer, NULL);
+  node = gegl_node_new_child (gegl, "operation", operation, NULL);
+  sink = gegl_node_new_child (gegl, "operation", "gegl:buffer-sink", "buffer", &buffer2, NULL);
+
+  gegl_node_link_many (source, node, sink, NULL);
+  gegl_node_connect (aux, "output", node, "aux");
+  gegl_node_process (sink);
+  g_object_unref (gegl);
+  g_object_unref (buffer2);
+}
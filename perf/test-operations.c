@@ -0,0 +1,631 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Data-driven benchmark of the registered operations.
+ *
+ * Every operation matching --ops is rendered, with its default property
+ * values, for each combination of input format, size, thread count and
+ * mipmap level.  The input is random data from a fixed --seed, so that runs
+ * are reproducible.  The results (throughput in megapixels/second, the
+ * tile cache high-water mark, and the growth of the process' peak memory
+ * use during each case) are printed, can be written to a JSON file, and can be
+ * compared against a previously written JSON file, in which case the
+ * program fails when an operation got slower than --tolerance allows.
+ *
+ * Example:
+ *
+ *   perf/operations --ops 'gegl:*blur*' --threads 1,4 -o baseline.json
+ *   (upgrade)
+ *   perf/operations --ops 'gegl:*blur*' --threads 1,4 -b baseline.json
+ */
+
+#include <string.h>
+#include <json-glib/json-glib.h>
+#include "test-common.h"
+#include "gegl-stats.h"
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#define MAX_ITERATIONS 1000
+
+static gchar   *opt_ops            = "*";
+static gchar   *opt_exclude        = NULL;
+static gchar   *opt_formats        = "RGBA float,R'G'B'A u8";
+static gchar   *opt_sizes          = "1024x1024";
+static gchar   *opt_threads        = NULL;
+static gchar   *opt_levels         = "0";
+static gdouble  opt_time           = 0.5;
+static gint     opt_min_iterations = 3;
+static gchar   *opt_output         = NULL;
+static gchar   *opt_baseline       = NULL;
+static gdouble  opt_tolerance      = 0.1;
+static gboolean opt_list           = FALSE;
+static gint     opt_seed           = 1;
+
+static const GOptionEntry entries[] =
+{
+  { "ops", 0, 0, G_OPTION_ARG_STRING, &opt_ops,
+    "Comma separated glob patterns of the operations to run (default: *)", "PATTERNS" },
+  { "exclude", 0, 0, G_OPTION_ARG_STRING, &opt_exclude,
+    "Comma separated glob patterns of operations to skip", "PATTERNS" },
+  { "formats", 0, 0, G_OPTION_ARG_STRING, &opt_formats,
+    "Comma separated babl formats of the input", "FORMATS" },
+  { "sizes", 0, 0, G_OPTION_ARG_STRING, &opt_sizes,
+    "Comma separated WIDTHxHEIGHT sizes of the input", "SIZES" },
+  { "threads", 0, 0, G_OPTION_ARG_STRING, &opt_threads,
+    "Comma separated thread counts (default: 1 and all cores)", "COUNTS" },
+  { "levels", 0, 0, G_OPTION_ARG_STRING, &opt_levels,
+    "Comma separated mipmap levels to render at", "LEVELS" },
+  { "time", 't', 0, G_OPTION_ARG_DOUBLE, &opt_time,
+    "Minimal number of seconds to spend measuring each case", "SECONDS" },
+  { "min-iterations", 0, 0, G_OPTION_ARG_INT, &opt_min_iterations,
+    "Minimal number of measurements of each case", "N" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
+    "Write the results as JSON to FILE", "FILE" },
+  { "baseline", 'b', 0, G_OPTION_ARG_FILENAME, &opt_baseline,
+    "Compare the results against the JSON results in FILE", "FILE" },
+  { "tolerance", 0, 0, G_OPTION_ARG_DOUBLE, &opt_tolerance,
+    "Allowed relative slowdown against the baseline (default: 0.1)", "FRACTION" },
+  { "list", 'l', 0, G_OPTION_ARG_NONE, &opt_list,
+    "Only list the operations that would be run", NULL },
+  { "seed", 0, 0, G_OPTION_ARG_INT, &opt_seed,
+    "Seed of the random input data (default: 1)", "SEED" },
+  { NULL }
+};
+
+typedef struct
+{
+  const gchar *operation;
+  const Babl  *format;
+  gint         width;
+  gint         height;
+  gint         level;
+  gint         threads;
+
+  gint         iterations;
+  gdouble      median;           /* seconds */
+  gdouble      megapixels_per_second;
+  guint64      tile_cache_max;   /* bytes */
+  gint64       max_rss_growth;   /* bytes; growth of the process' peak
+                                  * resident set during the case, 0 when it
+                                  * stayed below the peak of earlier cases
+                                  */
+} Result;
+
+
+static gboolean
+match_patterns (const gchar  *name,
+                GPatternSpec **patterns)
+{
+  for (; *patterns; patterns++)
+    {
+      if (g_pattern_match_string (*patterns, name))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static GPatternSpec **
+parse_patterns (const gchar *str)
+{
+  gchar        **strv = g_strsplit (str ? str : "", ",", -1);
+  GPatternSpec **patterns;
+  gint           i;
+
+  patterns = g_new0 (GPatternSpec *, g_strv_length (strv) + 1);
+
+  for (i = 0; strv[i]; i++)
+    patterns[i] = g_pattern_spec_new (g_strstrip (strv[i]));
+
+  g_strfreev (strv);
+
+  return patterns;
+}
+
+static void
+free_patterns (GPatternSpec **patterns)
+{
+  GPatternSpec **p;
+
+  for (p = patterns; *p; p++)
+    g_pattern_spec_free (*p);
+
+  g_free (patterns);
+}
+
+static GArray *
+parse_ints (const gchar *str)
+{
+  GArray  *array = g_array_new (FALSE, FALSE, sizeof (gint));
+  gchar  **strv  = g_strsplit (str, ",", -1);
+  gint     i;
+
+  for (i = 0; strv[i]; i++)
+    {
+      gint value = atoi (strv[i]);
+
+      g_array_append_val (array, value);
+    }
+
+  g_strfreev (strv);
+
+  return array;
+}
+
+/* operations which can't run in isolation with their default properties,
+ * or which only pass their input along
+ */
+static gboolean
+is_benchmarkable (const gchar *operation)
+{
+  static const gchar *skipped_categories[] = { "hidden", "input", "output",
+                                               "programming" };
+  const gchar *categories;
+  GeglNode    *node;
+  gboolean     result;
+  guint        i;
+
+  categories = gegl_operation_get_key (operation, "categories");
+
+  if (categories)
+    {
+      gchar **strv = g_strsplit (categories, ":", -1);
+      guint   j;
+
+      for (i = 0; strv[i]; i++)
+        {
+          for (j = 0; j < G_N_ELEMENTS (skipped_categories); j++)
+            {
+              if (! strcmp (strv[i], skipped_categories[j]))
+                {
+                  g_strfreev (strv);
+
+                  return FALSE;
+                }
+            }
+        }
+
+      g_strfreev (strv);
+    }
+
+  node = gegl_node_new_child (NULL, "operation", operation, NULL);
+
+  result = gegl_node_has_pad (node, "output");
+
+  g_object_unref (node);
+
+  return result;
+}
+
+/* creates an input buffer of random data in the -0.5 to 2.0 range, like
+ * test_buffer(), but from a fixed seed
+ */
+static GeglBuffer *
+create_input (gint        width,
+              gint        height,
+              const Babl *format)
+{
+  GeglRectangle  bound = {0, 0, width, height};
+  GeglBuffer    *buffer;
+  GRand         *rand  = g_rand_new_with_seed (opt_seed);
+  gfloat        *buf   = g_new (gfloat, (gsize) width * height * 4);
+  gsize          i;
+
+  buffer = gegl_buffer_new (&bound, format);
+
+  for (i = 0; i < (gsize) width * height * 4; i++)
+    buf[i] = g_rand_double_range (rand, -0.5, 2.0);
+
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), buf, 0);
+
+  g_free (buf);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+#ifdef G_OS_UNIX
+static gint64
+get_max_rss (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return (gint64) usage.ru_maxrss * 1024;
+}
+#endif
+
+static void
+run_case (GeglBuffer    *input,
+          const gchar   *operation,
+          GeglBuffer    *output,
+          GeglRectangle *roi,
+          gint           level)
+{
+  GeglNode *gegl, *source, *node;
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  node   = gegl_node_new_child (gegl, "operation", operation, NULL);
+
+  if (gegl_node_has_pad (node, "input"))
+    gegl_node_connect (source, "output", node, "input");
+  if (gegl_node_has_pad (node, "aux"))
+    gegl_node_connect (source, "output", node, "aux");
+
+  gegl_node_blit_buffer (node, output, roi, level, GEGL_ABYSS_NONE);
+
+  g_object_unref (gegl);
+}
+
+static int
+compare_double (const void *a,
+                const void *b)
+{
+  gdouble x = *(const gdouble *) a;
+  gdouble y = *(const gdouble *) b;
+
+  return (x > y) - (x < y);
+}
+
+static void
+measure (Result     *result,
+         GeglBuffer *input)
+{
+  GeglRectangle  roi = {0, 0,
+                        result->width  >> result->level,
+                        result->height >> result->level};
+  GeglBuffer    *output;
+  gdouble        samples[MAX_ITERATIONS];
+  gint64         start;
+  gint64         max_rss = 0;
+  gint           n = 0;
+
+  g_object_set (gegl_config (), "threads", result->threads, NULL);
+
+#ifdef G_OS_UNIX
+  max_rss = get_max_rss ();
+#endif
+
+  output = gegl_buffer_new (&roi, result->format);
+
+  /* warm up, and let the operation initialize its static state */
+  run_case (input, result->operation, output, &roi, result->level);
+
+  gegl_stats_reset (gegl_stats ());
+
+  start = g_get_monotonic_time ();
+
+  do
+    {
+      gint64 t = g_get_monotonic_time ();
+
+      run_case (input, result->operation, output, &roi, result->level);
+
+      samples[n++] = (g_get_monotonic_time () - t) / (gdouble) G_TIME_SPAN_SECOND;
+    }
+  while (n < MAX_ITERATIONS &&
+         (n < opt_min_iterations ||
+          g_get_monotonic_time () - start < opt_time * G_TIME_SPAN_SECOND));
+
+  qsort (samples, n, sizeof (gdouble), compare_double);
+
+  result->iterations = n;
+  result->median     = samples[n / 2];
+
+  result->megapixels_per_second = (gdouble) roi.width * roi.height / 1e6 /
+                                  MAX (result->median, 1e-9);
+
+  g_object_get (gegl_stats (),
+                "tile-cache-total-max", &result->tile_cache_max,
+                NULL);
+
+#ifdef G_OS_UNIX
+  result->max_rss_growth = get_max_rss () - max_rss;
+#else
+  result->max_rss_growth = 0;
+#endif
+
+  g_object_unref (output);
+}
+
+static gchar *
+result_key (const gchar *operation,
+            const gchar *format,
+            gint         width,
+            gint         height,
+            gint         level,
+            gint         threads)
+{
+  return g_strdup_printf ("%s|%s|%dx%d|%d|%d",
+                          operation, format, width, height, level, threads);
+}
+
+/* maps result_key() to the throughput in the baseline file */
+static GHashTable *
+load_baseline (const gchar *path)
+{
+  GHashTable *baseline;
+  JsonParser *parser = json_parser_new ();
+  JsonArray  *cases;
+  GError     *error  = NULL;
+  guint       i;
+
+  if (! json_parser_load_from_file (parser, path, &error))
+    {
+      g_printerr ("unable to load baseline '%s': %s\n", path, error->message);
+      g_error_free (error);
+      g_object_unref (parser);
+
+      return NULL;
+    }
+
+  baseline = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  cases = json_object_get_array_member (
+    json_node_get_object (json_parser_get_root (parser)), "cases");
+
+  for (i = 0; cases && i < json_array_get_length (cases); i++)
+    {
+      JsonObject *c = json_array_get_object_element (cases, i);
+      gdouble    *mps;
+
+      mps  = g_new (gdouble, 1);
+      *mps = json_object_get_double_member (c, "megapixels-per-second");
+
+      g_hash_table_insert (baseline,
+                           result_key (json_object_get_string_member (c, "operation"),
+                                       json_object_get_string_member (c, "format"),
+                                       json_object_get_int_member (c, "width"),
+                                       json_object_get_int_member (c, "height"),
+                                       json_object_get_int_member (c, "level"),
+                                       json_object_get_int_member (c, "threads")),
+                           mps);
+    }
+
+  g_object_unref (parser);
+
+  return baseline;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GOptionContext  *context;
+  GError          *error = NULL;
+  GPatternSpec   **include, **exclude;
+  gchar          **operations;
+  gchar          **formats;
+  gchar          **sizes;
+  GArray          *threads, *levels;
+  GHashTable      *baseline    = NULL;
+  gchar           *default_threads = NULL;
+  JsonBuilder     *builder;
+  guint            n_operations;
+  gint             n_regressions = 0;
+  guint            o;
+  guint            t, l;
+  gint             f, s;
+
+  gegl_init (&argc, &argv);
+
+  context = g_option_context_new ("- benchmark GEGL operations");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+
+      return 1;
+    }
+
+  g_option_context_free (context);
+
+  if (! opt_threads)
+    opt_threads = default_threads = g_strdup_printf ("1,%d",
+                                                     g_get_num_processors ());
+
+  if (opt_baseline)
+    {
+      baseline = load_baseline (opt_baseline);
+
+      if (! baseline)
+        return 1;
+    }
+
+  include = parse_patterns (opt_ops);
+  exclude = parse_patterns (opt_exclude);
+  formats = g_strsplit (opt_formats, ",", -1);
+  sizes   = g_strsplit (opt_sizes,   ",", -1);
+  threads = parse_ints (opt_threads);
+  levels  = parse_ints (opt_levels);
+
+  operations = gegl_list_operations (&n_operations);
+
+  builder = json_builder_new ();
+  json_builder_begin_object (builder);
+  json_builder_set_member_name (builder, "gegl-version");
+  {
+    gint major, minor, micro;
+    gchar *version;
+
+    gegl_get_version (&major, &minor, &micro);
+    version = g_strdup_printf ("%d.%d.%d", major, minor, micro);
+    json_builder_add_string_value (builder, version);
+    g_free (version);
+  }
+  json_builder_set_member_name (builder, "cases");
+  json_builder_begin_array (builder);
+
+  for (o = 0; o < n_operations; o++)
+    {
+      const gchar *operation = operations[o];
+
+      if (! match_patterns (operation, include) ||
+          match_patterns (operation, exclude)   ||
+          ! is_benchmarkable (operation))
+        continue;
+
+      if (opt_list)
+        {
+          g_print ("%s\n", operation);
+          continue;
+        }
+
+      for (f = 0; formats[f]; f++)
+      for (s = 0; sizes[s]; s++)
+        {
+          const Babl *format = babl_format (g_strstrip (formats[f]));
+          GeglBuffer *input;
+          gint        width, height;
+
+          if (sscanf (sizes[s], "%dx%d", &width, &height) != 2)
+            {
+              g_printerr ("invalid size '%s'\n", sizes[s]);
+              continue;
+            }
+
+          input = create_input (width, height, format);
+
+          for (t = 0; t < threads->len; t++)
+          for (l = 0; l < levels->len; l++)
+            {
+              Result  result = { 0, };
+              gchar  *key;
+              gdouble reference = 0.0;
+
+              result.operation = operation;
+              result.format    = format;
+              result.width     = width;
+              result.height    = height;
+              result.threads   = g_array_index (threads, gint, t);
+              result.level     = g_array_index (levels, gint, l);
+
+              measure (&result, input);
+
+              key = result_key (operation, babl_get_name (format),
+                                width, height, result.level, result.threads);
+
+              if (baseline && g_hash_table_lookup (baseline, key))
+                reference = *(gdouble *) g_hash_table_lookup (baseline, key);
+
+              g_free (key);
+
+              g_print ("@ %s (%s %dx%d, level %d, %d threads): "
+                       "%.2f megapixels/second",
+                       operation, babl_get_name (format), width, height,
+                       result.level, result.threads,
+                       result.megapixels_per_second);
+
+              if (reference > 0.0)
+                {
+                  gdouble ratio = result.megapixels_per_second / reference;
+
+                  g_print (" (%+.1f%%)", (ratio - 1.0) * 100.0);
+
+                  if (ratio < 1.0 - opt_tolerance)
+                    {
+                      g_print (" REGRESSION");
+                      n_regressions++;
+                    }
+                }
+
+              g_print ("\n");
+
+              json_builder_begin_object (builder);
+              json_builder_set_member_name (builder, "operation");
+              json_builder_add_string_value (builder, operation);
+              json_builder_set_member_name (builder, "format");
+              json_builder_add_string_value (builder, babl_get_name (format));
+              json_builder_set_member_name (builder, "width");
+              json_builder_add_int_value (builder, width);
+              json_builder_set_member_name (builder, "height");
+              json_builder_add_int_value (builder, height);
+              json_builder_set_member_name (builder, "level");
+              json_builder_add_int_value (builder, result.level);
+              json_builder_set_member_name (builder, "threads");
+              json_builder_add_int_value (builder, result.threads);
+              json_builder_set_member_name (builder, "iterations");
+              json_builder_add_int_value (builder, result.iterations);
+              json_builder_set_member_name (builder, "median-seconds");
+              json_builder_add_double_value (builder, result.median);
+              json_builder_set_member_name (builder, "megapixels-per-second");
+              json_builder_add_double_value (builder, result.megapixels_per_second);
+              json_builder_set_member_name (builder, "tile-cache-max-bytes");
+              json_builder_add_int_value (builder, result.tile_cache_max);
+              json_builder_set_member_name (builder, "max-rss-growth-bytes");
+              json_builder_add_int_value (builder, result.max_rss_growth);
+              if (reference > 0.0)
+                {
+                  json_builder_set_member_name (builder, "baseline-megapixels-per-second");
+                  json_builder_add_double_value (builder, reference);
+                }
+              json_builder_end_object (builder);
+            }
+
+          g_object_unref (input);
+        }
+    }
+
+  json_builder_end_array (builder);
+  json_builder_end_object (builder);
+
+  if (opt_output && ! opt_list)
+    {
+      JsonGenerator *generator = json_generator_new ();
+      JsonNode      *root      = json_builder_get_root (builder);
+
+      json_generator_set_root (generator, root);
+      json_generator_set_pretty (generator, TRUE);
+
+      if (! json_generator_to_file (generator, opt_output, &error))
+        {
+          g_printerr ("unable to write '%s': %s\n", opt_output, error->message);
+          g_clear_error (&error);
+        }
+
+      json_node_unref (root);
+      g_object_unref (generator);
+    }
+
+  if (n_regressions)
+    g_print ("%d case(s) regressed by more than %.0f%%\n",
+             n_regressions, opt_tolerance * 100.0);
+
+  g_object_unref (builder);
+  g_free (operations);
+  g_strfreev (formats);
+  g_strfreev (sizes);
+  g_array_free (threads, TRUE);
+  g_array_free (levels, TRUE);
+  g_free (default_threads);
+  free_patterns (include);
+  free_patterns (exclude);
+  if (baseline)
+    g_hash_table_unref (baseline);
+
+  gegl_exit ();
+
+  return n_regressions ? 1 : 0;
+}
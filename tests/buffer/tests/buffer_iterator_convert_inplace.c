@@ -0,0 +1,33 @@
+TEST ()
+{
+  GeglBuffer    *buffer;
+  GeglRectangle  extent = {0, 0, 20, 20};
+  GeglRectangle  roi = {2, 4, 12, 10};
+  GeglBufferIterator *iter;
+
+  test_start ();
+
+  buffer = gegl_buffer_new (&extent, babl_format ("Y u8"));
+  vgrad (buffer);
+
+  /* the output is an alias of the input, sharing its converted data */
+  iter = gegl_buffer_iterator_new (buffer, &roi, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
+
+  gegl_buffer_iterator_add (iter, buffer, &roi, 0, babl_format ("Y float"),
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *s = iter->items[0].data;
+      gfloat *d = iter->items[1].data;
+      gint length = iter->length;
+
+      while (length--)
+        *d++ = 1.0 - *s++;
+    }
+
+  print_buffer (buffer);
+  g_object_unref (buffer);
+  test_end ();
+}
@@ -0,0 +1,43 @@
+TEST ()
+{
+  GeglBuffer    *buffer, *buffer2;
+  GeglRectangle  roi = {0, 5, 20, 10};
+  GeglBufferIterator *iter;
+
+  test_start ();
+
+  /* the chunks span whole tiles, which are converted in one batch */
+  buffer  = g_object_new (GEGL_TYPE_BUFFER,
+                          "x", 0, "y", 0, "width", 20, "height", 20,
+                          "tile-width", 10, "tile-height", 5,
+                          "format", babl_format ("Y u8"),
+                          NULL);
+  buffer2 = g_object_new (GEGL_TYPE_BUFFER,
+                          "x", 0, "y", 0, "width", 20, "height", 20,
+                          "tile-width", 10, "tile-height", 5,
+                          "format", babl_format ("Y float"),
+                          NULL);
+
+  vgrad (buffer);
+
+  iter = gegl_buffer_iterator_new (buffer, &roi, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
+
+  gegl_buffer_iterator_add (iter, buffer2, &roi, 0, NULL,
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *s = iter->items[0].data;
+      gfloat *d = iter->items[1].data;
+      gint length = iter->length;
+
+      while (length--)
+        *d++ = *s++;
+    }
+
+  print_buffer (buffer2);
+  g_object_unref (buffer2);
+  g_object_unref (buffer);
+  test_end ();
+}
@@ -0,0 +1,29 @@
+TEST ()
+{
+  GeglBuffer    *buffer;
+  GeglRectangle  extent = {0, 0, 20, 20};
+  GeglRectangle  roi = {5, 5, 10, 10};
+  GeglBufferIterator *iter;
+
+  test_start ();
+
+  buffer = gegl_buffer_new (&extent, babl_format ("Y u8"));
+
+  /* the chunk covers part of the rows of a tile */
+  iter = gegl_buffer_iterator_new (buffer, &roi, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *d = iter->items[0].data;
+      GeglRectangle *r = &iter->items[0].roi;
+      gint i;
+
+      for (i = 0; i < iter->length; i++)
+        d[i] = (r->x + i % r->width) / 20.0;
+    }
+
+  print_buffer (buffer);
+  g_object_unref (buffer);
+  test_end ();
+}
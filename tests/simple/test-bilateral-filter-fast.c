@@ -0,0 +1,231 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define WIDTH      96
+#define HEIGHT     80
+#define EPSILON    1e-5
+
+typedef enum
+{
+  PATTERN_EDGE,
+  PATTERN_CHECKERBOARD,
+  PATTERN_NOISE
+} Pattern;
+
+static GeglBuffer *
+create_buffer (Pattern pattern)
+{
+  const Babl *format = babl_format ("RGBA float");
+  GeglBuffer *buffer;
+  GRand      *rand   = g_rand_new_with_seed (0);
+  gfloat     *data;
+  gint        x, y, c;
+
+  data = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        gfloat *pixel = data + (y * WIDTH + x) * 4;
+
+        for (c = 0; c < 3; c++)
+          {
+            switch (pattern)
+              {
+              case PATTERN_EDGE:
+                pixel[c] = x < WIDTH / 2 - 3 ? 0.2f : 0.8f;
+                break;
+
+              case PATTERN_CHECKERBOARD:
+                pixel[c] = (x + y) % 2 ? 0.45f : 0.55f;
+                break;
+
+              case PATTERN_NOISE:
+                pixel[c] = g_rand_double (rand);
+                break;
+              }
+          }
+
+        pixel[3] = pattern == PATTERN_NOISE ? g_rand_double (rand) : 1.0f;
+      }
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format, data);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+/* renders @rect of the filtered @pattern with @threads threads, in a graph of
+ * its own, so that nothing is reused between renders.  the result is stored
+ * in @data, which is WIDTH x HEIGHT, at the position of @rect.
+ */
+static void
+render (Pattern              pattern,
+        gdouble              r_sigma,
+        gint                 s_sigma,
+        const GeglRectangle *rect,
+        gint                 threads,
+        gfloat              *data)
+{
+  GeglBuffer *buffer = create_buffer (pattern);
+  GeglNode   *graph  = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *filter;
+  gint        old_threads;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  filter = gegl_node_new_child (graph,
+                                "operation", "gegl:bilateral-filter-fast",
+                                "r-sigma",   r_sigma,
+                                "s-sigma",   s_sigma,
+                                NULL);
+
+  gegl_node_link (source, filter);
+
+  old_threads = test_set_threads (threads);
+
+  gegl_node_blit (filter, 1.0, rect,
+                  babl_format ("RGBA float"),
+                  data + (rect->y * WIDTH + rect->x) * 4,
+                  WIDTH * 4 * sizeof (gfloat), GEGL_BLIT_DEFAULT);
+
+  test_set_threads (old_threads);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+}
+
+/* compares the pixels of @rect against opaque pixels of @value */
+static gint
+compare_value (const gfloat        *result,
+               gfloat               value,
+               const GeglRectangle *rect)
+{
+  gfloat *expected = g_new (gfloat, WIDTH * HEIGHT * 4);
+  gint    status;
+  gint    i;
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    expected[i] = i % 4 == 3 ? 1.0f : value;
+
+  status = test_compare (result, expected, WIDTH, 4, rect, EPSILON);
+
+  g_free (expected);
+
+  return status;
+}
+
+/* an edge much stronger than the range sigma isn't blurred at all, not even
+ * next to it
+ */
+static gint
+test_edge (void)
+{
+  const GeglRectangle *rect   = GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT);
+  gfloat              *result = g_new0 (gfloat, WIDTH * HEIGHT * 4);
+  gint                 status;
+
+  render (PATTERN_EDGE, 10.0, 4, rect, 1, result);
+
+  status = compare_value (result, 0.2f,
+                          GEGL_RECTANGLE (0, 0, WIDTH / 2 - 3, HEIGHT));
+
+  if (status == SUCCESS)
+    {
+      status = compare_value (result, 0.8f,
+                              GEGL_RECTANGLE (WIDTH / 2 - 3, 0,
+                                              WIDTH / 2 + 3, HEIGHT));
+    }
+
+  g_free (result);
+
+  return status;
+}
+
+/* variations within the range sigma are smoothed out */
+static gint
+test_smoothing (void)
+{
+  const GeglRectangle *rect   = GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT);
+  gfloat              *result = g_new0 (gfloat, WIDTH * HEIGHT * 4);
+  gint                 status;
+
+  render (PATTERN_CHECKERBOARD, 50.0, 4, rect, 1, result);
+
+  status = compare_value (result, 0.5f, rect);
+
+  g_free (result);
+
+  return status;
+}
+
+/* the grid is aligned to absolute coordinates, so the result doesn't depend
+ * on the rendered region, nor on how it is split between the threads
+ */
+static gint
+test_split (void)
+{
+  const GeglRectangle *rect     = GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT);
+  const GeglRectangle *sub_rect = GEGL_RECTANGLE (17, 11, 41, 50);
+  gfloat              *expected = g_new0 (gfloat, WIDTH * HEIGHT * 4);
+  gfloat              *result   = g_new0 (gfloat, WIDTH * HEIGHT * 4);
+  gint                 status;
+
+  render (PATTERN_NOISE, 30.0, 3, rect, 1, expected);
+
+  render (PATTERN_NOISE, 30.0, 3, rect, 4, result);
+  status = test_compare (result, expected, WIDTH, 4, rect, 0.0);
+
+  if (status == SUCCESS)
+    {
+      render (PATTERN_NOISE, 30.0, 3, sub_rect, 3, result);
+      status = test_compare (result, expected, WIDTH, 4, sub_rect, 0.0);
+    }
+
+  g_free (expected);
+  g_free (result);
+
+  return status;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (edge);
+  RUN_TEST (smoothing);
+  RUN_TEST (split);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,272 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define SIZE       384
+#define BAR_WIDTH  8
+#define EPSILON    1e-5
+
+typedef enum
+{
+  PATTERN_STEP,
+  PATTERN_BAR
+} Pattern;
+
+static GeglBuffer *
+create_buffer (Pattern pattern)
+{
+  const Babl *format = babl_format ("RGBA float");
+  GeglBuffer *buffer;
+  gfloat     *data;
+  gint        x, y, c;
+
+  data = g_new (gfloat, SIZE * SIZE * 4);
+
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        gfloat value;
+
+        if (pattern == PATTERN_STEP)
+          {
+            /* steps along both axes */
+            value = (x >= SIZE / 2) != (y >= SIZE / 2);
+          }
+        else
+          {
+            /* a horizontal and a vertical bar */
+            value = abs (x - SIZE / 2) < BAR_WIDTH / 2 ||
+                    abs (y - SIZE / 2) < BAR_WIDTH / 2;
+          }
+
+        for (c = 0; c < 3; c++)
+          data[(y * SIZE + x) * 4 + c] = value;
+
+        data[(y * SIZE + x) * 4 + 3] = 1.0f;
+      }
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE), format, data);
+
+  g_free (data);
+
+  return buffer;
+}
+
+static gfloat *
+render (GeglNode     *node,
+        GeglBlitFlags flags)
+{
+  return test_render (node, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                      babl_format ("RGBA float"), flags);
+}
+
+/* compares the pixels at least @margin pixels away from the edges */
+static gint
+compare (const gfloat *result,
+         const gfloat *expected,
+         gint          margin,
+         gdouble       tolerance)
+{
+  return test_compare (result, expected, SIZE, 4,
+                       GEGL_RECTANGLE (margin, margin,
+                                       SIZE - 2 * margin, SIZE - 2 * margin),
+                       tolerance);
+}
+
+/* returns the largest difference between the pixels at least @margin pixels
+ * away from the edges
+ */
+static gdouble
+max_difference (const gfloat *result,
+                const gfloat *expected,
+                gint          margin)
+{
+  gdouble max = 0.0;
+  gint    x, y, c;
+
+  for (y = margin; y < SIZE - margin; y++)
+    for (x = margin; x < SIZE - margin; x++)
+      for (c = 0; c < 4; c++)
+        {
+          gint i = (y * SIZE + x) * 4 + c;
+
+          max = MAX (max, fabs (result[i] - expected[i]));
+        }
+
+  return max;
+}
+
+/* blurring with @max_error differs from the exact blur, since the input is
+ * decimated, but by at most @max_error, and rendering it in chunks gives the
+ * same result as rendering it at once
+ */
+static gint
+test_max_error (const gchar *operation,
+                const gchar *size_property,
+                gdouble      size,
+                gdouble      max_error,
+                gint         margin)
+{
+  Pattern pattern;
+  gint    status = SUCCESS;
+
+  for (pattern = PATTERN_STEP; pattern <= PATTERN_BAR; pattern++)
+    {
+      GeglBuffer    *buffer = create_buffer (pattern);
+      GeglNode      *graph  = gegl_node_new ();
+      GeglNode      *source;
+      GeglNode      *exact;
+      GeglNode      *decimated;
+      GeglProcessor *processor;
+      gfloat        *expected;
+      gfloat        *result;
+      gfloat        *chunked;
+
+      source    = gegl_node_new_child (graph,
+                                       "operation", "gegl:buffer-source",
+                                       "buffer",    buffer,
+                                       NULL);
+      exact     = gegl_node_new_child (graph,
+                                       "operation", operation,
+                                       NULL);
+      decimated = gegl_node_new_child (graph,
+                                       "operation", operation,
+                                       "max-error", max_error,
+                                       NULL);
+
+      if (! strcmp (size_property, "std-dev"))
+        {
+          gegl_node_set (exact,
+                         "std-dev-x", size,
+                         "std-dev-y", size,
+                         NULL);
+          gegl_node_set (decimated,
+                         "std-dev-x", size,
+                         "std-dev-y", size,
+                         NULL);
+        }
+      else
+        {
+          gegl_node_set (exact,     size_property, size, NULL);
+          gegl_node_set (decimated, size_property, size, NULL);
+        }
+
+      gegl_node_link (source, exact);
+      gegl_node_link (source, decimated);
+
+      expected = render (exact,     GEGL_BLIT_DEFAULT);
+      result   = render (decimated, GEGL_BLIT_DEFAULT);
+
+      if (compare (result, expected, margin, max_error) != SUCCESS)
+        {
+          printf ("\n  %s pattern exceeds the maximal error",
+                  pattern == PATTERN_STEP ? "step" : "bar");
+
+          status = FAILURE;
+        }
+
+      /* an identical result means the input wasn't decimated at all, and
+       * the comparison above proves nothing
+       */
+      if (max_difference (result, expected, margin) <= EPSILON)
+        {
+          printf ("\n  %s pattern wasn't decimated",
+                  pattern == PATTERN_STEP ? "step" : "bar");
+
+          status = FAILURE;
+        }
+
+      /* render the decimated blur into its cache, in small chunks */
+      processor = gegl_node_new_processor (decimated,
+                                           GEGL_RECTANGLE (0, 0, SIZE, SIZE));
+
+      while (gegl_processor_work (processor, NULL));
+
+      g_object_unref (processor);
+
+      chunked = render (decimated, GEGL_BLIT_CACHE | GEGL_BLIT_DIRTY);
+
+      if (compare (chunked, result, 0, EPSILON) != SUCCESS)
+        {
+          printf ("\n  %s pattern differs when rendered in chunks",
+                  pattern == PATTERN_STEP ? "step" : "bar");
+
+          status = FAILURE;
+        }
+
+      g_free (expected);
+      g_free (result);
+      g_free (chunked);
+
+      g_object_unref (graph);
+      g_object_unref (buffer);
+    }
+
+  return status;
+}
+
+static gint
+test_gaussian_blur_factor_2 (void)
+{
+  /* decimates by 2 */
+  return test_max_error ("gegl:gaussian-blur", "std-dev", 32.0, 0.02, 0);
+}
+
+static gint
+test_gaussian_blur_factor_8 (void)
+{
+  /* decimates by 8 */
+  return test_max_error ("gegl:gaussian-blur", "std-dev", 32.0, 0.05, 0);
+}
+
+static gint
+test_lens_blur (void)
+{
+  /* decimates by 4; the edges of the input are handled differently at the
+   * mipmap levels, so only the inside is compared
+   */
+  return test_max_error ("gegl:lens-blur", "radius", 48.0, 0.1, 48);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* small chunks, so that the decimated samples of adjacent chunks overlap */
+  g_object_set (gegl_config (),
+                "chunk-size", 100 * 100,
+                NULL);
+
+  RUN_TEST (gaussian_blur_factor_2);
+  RUN_TEST (gaussian_blur_factor_8);
+  RUN_TEST (lens_blur);
+
+  gegl_exit ();
+
+  return result;
+}
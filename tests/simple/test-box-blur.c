@@ -0,0 +1,198 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define WIDTH      96
+#define HEIGHT     80
+#define RADIUS     4
+#define EPSILON    1e-5
+
+static GeglBuffer *
+create_buffer (void)
+{
+  const Babl *format = babl_format ("RaGaBaA float");
+  GeglBuffer *buffer;
+  GRand      *rand   = g_rand_new_with_seed (0);
+  gfloat     *data;
+  gint        i;
+
+  data = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    data[i] = g_rand_double (rand);
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format, data);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static gfloat *
+render (GeglNode *node)
+{
+  return test_render (node, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                      babl_format ("RaGaBaA float"), GEGL_BLIT_DEFAULT);
+}
+
+/* compares the pixels at least @margin pixels away from the edges */
+static gint
+compare (const gfloat *result,
+         const gfloat *expected,
+         gint          margin)
+{
+  return test_compare (result, expected, WIDTH, 4,
+                       GEGL_RECTANGLE (margin, margin,
+                                       WIDTH  - 2 * margin,
+                                       HEIGHT - 2 * margin),
+                       EPSILON);
+}
+
+/* a single iteration averages the square neighborhood of each pixel, as the
+ * serial implementation did
+ */
+static gint
+test_single_iteration (void)
+{
+  GeglBuffer *buffer = create_buffer ();
+  GeglNode   *graph  = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *blur;
+  gfloat     *input;
+  gfloat     *expected;
+  gfloat     *result;
+  gint        status = SUCCESS;
+  gint        x, y, c, u, v;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  blur   = gegl_node_new_child (graph,
+                                "operation",  "gegl:box-blur",
+                                "radius",     RADIUS,
+                                "iterations", 1,
+                                NULL);
+
+  gegl_node_link (source, blur);
+
+  input    = render (source);
+  result   = render (blur);
+  expected = g_new0 (gfloat, WIDTH * HEIGHT * 4);
+
+  for (y = RADIUS; y < HEIGHT - RADIUS; y++)
+    for (x = RADIUS; x < WIDTH - RADIUS; x++)
+      for (c = 0; c < 4; c++)
+        {
+          gdouble sum = 0.0;
+
+          for (v = -RADIUS; v <= RADIUS; v++)
+            for (u = -RADIUS; u <= RADIUS; u++)
+              sum += input[((y + v) * WIDTH + x + u) * 4 + c];
+
+          expected[(y * WIDTH + x) * 4 + c] =
+            sum / ((2 * RADIUS + 1) * (2 * RADIUS + 1));
+        }
+
+  status = compare (result, expected, RADIUS);
+
+  g_free (input);
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+/* repeating the blur is the same as chaining single iterations */
+static gint
+test_iterations (void)
+{
+  GeglBuffer *buffer = create_buffer ();
+  GeglNode   *graph  = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *blur;
+  GeglNode   *blur1;
+  GeglNode   *blur2;
+  GeglNode   *blur3;
+  gfloat     *expected;
+  gfloat     *result;
+  gint        status = SUCCESS;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  blur   = gegl_node_new_child (graph,
+                                "operation",  "gegl:box-blur",
+                                "radius",     RADIUS,
+                                "iterations", 3,
+                                NULL);
+  blur1  = gegl_node_new_child (graph,
+                                "operation",  "gegl:box-blur",
+                                "radius",     RADIUS,
+                                NULL);
+  blur2  = gegl_node_new_child (graph,
+                                "operation",  "gegl:box-blur",
+                                "radius",     RADIUS,
+                                NULL);
+  blur3  = gegl_node_new_child (graph,
+                                "operation",  "gegl:box-blur",
+                                "radius",     RADIUS,
+                                NULL);
+
+  gegl_node_link (source, blur);
+  gegl_node_link_many (source, blur1, blur2, blur3, NULL);
+
+  result   = render (blur);
+  expected = render (blur3);
+
+  /* the edges depend on how each node extends its input */
+  status = compare (result, expected, 3 * RADIUS);
+
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (single_iteration);
+  RUN_TEST (iterations);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,169 @@
+/* This file is part of the GEGL test-cases
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* The fixture shared by the test-cases comparing the output of operations:
+ * creating input buffers, rendering nodes, and comparing the results.
+ *
+ * Include it after "gegl.h", and run the tests with RUN_TEST() from a main()
+ * which has a gint result variable.
+ */
+
+#ifndef __TEST_COMMON_H__
+#define __TEST_COMMON_H__
+
+#include <math.h>
+#include <stdio.h>
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define RUN_TEST(test) \
+  do \
+  { \
+    printf (#test "..."); \
+    fflush (stdout); \
+    \
+    if (test_##test () == SUCCESS) \
+      printf (" passed\n"); \
+    else \
+      { \
+        printf (" FAILED\n"); \
+        result = FAILURE; \
+      } \
+  } while (FALSE)
+
+/* creates a buffer of @format covering @extent, and sets its pixels to
+ * @data, which is in @format too
+ */
+G_GNUC_UNUSED static GeglBuffer *
+test_buffer_new (const GeglRectangle *extent,
+                 const Babl          *format,
+                 gconstpointer        data)
+{
+  GeglBuffer *buffer = gegl_buffer_new (extent, format);
+
+  gegl_buffer_set (buffer, extent, 0, format, data, GEGL_AUTO_ROWSTRIDE);
+
+  return buffer;
+}
+
+/* creates a buffer of @format covering @extent, whose components follow a
+ * fixed pseudo-random pattern of multiples of 1/255, varied by @seed.  some
+ * of the pixels are opaque, and some are transparent.
+ */
+G_GNUC_UNUSED static GeglBuffer *
+test_pattern_buffer_new (const GeglRectangle *extent,
+                         const Babl          *format,
+                         gint                 seed)
+{
+  const Babl *float_format;
+  GeglBuffer *buffer;
+  gchar      *name;
+  gfloat     *data;
+  gint        n;
+  gint        i;
+
+  /* the pattern is computed as floats, in the model of @format, so that
+   * integer formats get exactly the multiples of 1/255
+   */
+  name         = g_strdup_printf ("%s float",
+                                  babl_get_name (babl_format_get_model (format)));
+  float_format = babl_format (name);
+  g_free (name);
+
+  n    = extent->width * extent->height *
+         babl_format_get_n_components (float_format);
+  data = g_new (gfloat, n);
+
+  for (i = 0; i < n; i++)
+    data[i] = ((i * 97 + (i / 7) * 13 + seed * 41) & 0xff) / 255.0f;
+
+  buffer = gegl_buffer_new (extent, format);
+
+  gegl_buffer_set (buffer, extent, 0, float_format, data,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+
+  return buffer;
+}
+
+/* renders @rect of @node at @scale, in @format, into a new array */
+G_GNUC_UNUSED static gpointer
+test_render (GeglNode            *node,
+             gdouble              scale,
+             const GeglRectangle *rect,
+             const Babl          *format,
+             GeglBlitFlags        flags)
+{
+  gpointer data = g_malloc (rect->width * rect->height *
+                            babl_format_get_bytes_per_pixel (format));
+
+  gegl_node_blit (node, scale, rect, format, data,
+                  GEGL_AUTO_ROWSTRIDE, flags);
+
+  return data;
+}
+
+/* sets the number of threads to render with, and returns the previous one */
+G_GNUC_UNUSED static gint
+test_set_threads (gint n_threads)
+{
+  gint old_n_threads;
+
+  g_object_get (gegl_config (), "threads", &old_n_threads, NULL);
+  g_object_set (gegl_config (), "threads", n_threads, NULL);
+
+  return old_n_threads;
+}
+
+/* compares the pixels of @rect of @result and @expected, which are @width
+ * pixels wide, start at the origin, and have @n_components float components
+ * per pixel.  the first component differing by more than @epsilon, or NaN in
+ * only one of them, is reported.
+ */
+G_GNUC_UNUSED static gint
+test_compare (const gfloat        *result,
+              const gfloat        *expected,
+              gint                 width,
+              gint                 n_components,
+              const GeglRectangle *rect,
+              gdouble              epsilon)
+{
+  gint x, y, c;
+
+  for (y = rect->y; y < rect->y + rect->height; y++)
+    for (x = rect->x; x < rect->x + rect->width; x++)
+      for (c = 0; c < n_components; c++)
+        {
+          gint i = (y * width + x) * n_components + c;
+
+          if (isnan (result[i]) && isnan (expected[i]))
+            continue;
+
+          if (! (fabs (result[i] - expected[i]) <= epsilon))
+            {
+              printf ("\n  pixel %d,%d, component %d: expected %g, got %g",
+                      x, y, c, expected[i], result[i]);
+
+              return FAILURE;
+            }
+        }
+
+  return SUCCESS;
+}
+
+#endif /* __TEST_COMMON_H__ */
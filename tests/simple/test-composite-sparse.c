@@ -0,0 +1,286 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+#include "gegl-buffer-private.h"
+
+#include "test-common.h"
+
+#define TILE_SIZE  128
+#define WIDTH      (4 * TILE_SIZE)
+#define HEIGHT     (2 * TILE_SIZE)
+#define EPSILON    1e-5
+
+/* computes a color component of the result from the components and alphas of
+ * aux and input
+ */
+typedef gfloat (* Formula) (gfloat cA,
+                            gfloat cB,
+                            gfloat aA,
+                            gfloat aB);
+
+static gfloat
+over (gfloat cA,
+      gfloat cB,
+      gfloat aA,
+      gfloat aB)
+{
+  return cA + cB * (1.0f - aA);
+}
+
+static gfloat
+screen (gfloat cA,
+        gfloat cB,
+        gfloat aA,
+        gfloat aB)
+{
+  return CLAMP (cA + cB - cA * cB, 0.0f, aA + aB - aA * aB);
+}
+
+static void
+fill_rect (GeglBuffer          *buffer,
+           const GeglRectangle *rect,
+           gint                 seed,
+           gfloat               alpha)
+{
+  const Babl *format = babl_format ("RGBA float");
+  gint        n      = rect->width * rect->height * 4;
+  gfloat     *data   = g_new (gfloat, n);
+  gint        i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (i % 4 == 3 && alpha >= 0.0f)
+        data[i] = alpha;
+      else
+        data[i] = ((i * 97 + (i / 7) * 13 + seed * 41) & 0xff) / 255.0f;
+    }
+
+  gegl_buffer_set (buffer, rect, 0, format, data, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+}
+
+/* returns the data of the tile at @x, @y of @buffer, which is only used to
+ * tell which tiles share their data
+ */
+static gpointer
+get_tile_data (GeglBuffer *buffer,
+               gint        x,
+               gint        y)
+{
+  GeglTile *tile = gegl_tile_source_get_tile (GEGL_TILE_SOURCE (buffer),
+                                              x, y, 0);
+  gpointer  data = gegl_tile_get_data (tile);
+
+  gegl_tile_unref (tile);
+
+  return data;
+}
+
+/* composites @aux over @input with @operation, and compares the result with
+ * @formula.  each row of tiles of the result is described by a string of
+ * @sharing, 'i' for a tile shared with input, 'a' for a tile shared with aux,
+ * and '-' for a tile which was processed.
+ */
+static gint
+compare_composite (const gchar  *operation,
+                   Formula       formula,
+                   GeglBuffer   *input,
+                   GeglBuffer   *aux,
+                   const gchar **sharing)
+{
+  const Babl *format   = babl_format ("RaGaBaA float");
+  GeglBuffer *output   = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                                          format);
+  GeglNode   *graph    = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *aux_source;
+  GeglNode   *composite;
+  gfloat     *in_data  = g_new (gfloat, WIDTH * HEIGHT * 4);
+  gfloat     *aux_data = g_new (gfloat, WIDTH * HEIGHT * 4);
+  gfloat     *result   = g_new (gfloat, WIDTH * HEIGHT * 4);
+  gfloat     *expected = g_new (gfloat, WIDTH * HEIGHT * 4);
+  gint        status;
+  gint        x, y, i;
+
+  source     = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    input,
+                                    NULL);
+  aux_source = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    aux,
+                                    NULL);
+  composite  = gegl_node_new_child (graph,
+                                    "operation", operation,
+                                    NULL);
+
+  gegl_node_link (source, composite);
+  gegl_node_connect_from (composite, "aux", aux_source, "output");
+
+  gegl_node_blit_buffer (composite, output, NULL, 0, GEGL_ABYSS_NONE);
+
+  gegl_buffer_get (output, NULL, 1.0, format, result,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (input, NULL, 1.0, format, in_data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (aux, NULL, 1.0, format, aux_data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    {
+      gfloat aA = aux_data[i - i % 4 + 3];
+      gfloat aB = in_data[i - i % 4 + 3];
+
+      if (i % 4 == 3)
+        expected[i] = aA + aB - aA * aB;
+      else
+        expected[i] = formula (aux_data[i], in_data[i], aA, aB);
+    }
+
+  status = test_compare (result, expected, WIDTH, 4,
+                         GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), EPSILON);
+
+  /* the skipped tiles are copied, which shares them all the way to the
+   * output, rather than merely giving the same pixels
+   */
+  for (y = 0; y < HEIGHT / TILE_SIZE && status == SUCCESS; y++)
+    for (x = 0; x < WIDTH / TILE_SIZE && status == SUCCESS; x++)
+      {
+        gpointer data = get_tile_data (output, x, y);
+        gchar    shared;
+
+        if (data == get_tile_data (input, x, y))
+          shared = 'i';
+        else if (data == get_tile_data (aux, x, y))
+          shared = 'a';
+        else
+          shared = '-';
+
+        if (shared != sharing[y][x])
+          {
+            printf ("\n  %s, tile %d,%d: expected '%c', got '%c'",
+                    operation, x, y, sharing[y][x], shared);
+
+            status = FAILURE;
+          }
+      }
+
+  g_free (in_data);
+  g_free (aux_data);
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (output);
+
+  return status;
+}
+
+/* compositing a layer which is transparent or opaque over whole tiles with
+ * @operation copies those tiles rather than processing them, and gives the
+ * same result as processing them, also after the layer changes.  @sharing1
+ * and @sharing2 describe the tiles of the result before and after the
+ * change, as in compare_composite().
+ */
+static gint
+test_sparse (const gchar  *operation,
+             Formula       formula,
+             const gchar **sharing1,
+             const gchar **sharing2)
+{
+  const Babl *format = babl_format ("RaGaBaA float");
+  GeglBuffer *input;
+  GeglBuffer *aux;
+  gint        status = SUCCESS;
+
+  input = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+  aux   = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+
+  fill_rect (input, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), 0, -1.0f);
+
+  /* an opaque tile, and a translucent area across two tiles */
+  fill_rect (aux, GEGL_RECTANGLE (TILE_SIZE, 0, TILE_SIZE, TILE_SIZE),
+             1, 1.0f);
+  fill_rect (aux, GEGL_RECTANGLE (300, 100, 60, 60), 2, 0.5f);
+
+  if (compare_composite (operation, formula, input, aux, sharing1) != SUCCESS)
+    status = FAILURE;
+
+  /* paint into a transparent tile, and over part of the opaque one */
+  fill_rect (aux, GEGL_RECTANGLE (10, 140, 20, 20), 3, 0.25f);
+  fill_rect (aux, GEGL_RECTANGLE (200, 60, 10, 10), 4, 0.75f);
+
+  if (compare_composite (operation, formula, input, aux, sharing2) != SUCCESS)
+    status = FAILURE;
+
+  g_object_unref (input);
+  g_object_unref (aux);
+
+  return status;
+}
+
+/* gegl:over passes input through transparent tiles, and replaces it with
+ * aux in opaque ones
+ */
+static gint
+test_sparse_over (void)
+{
+  const gchar *sharing1[] = {"ia-i",
+                             "ii-i"};
+  const gchar *sharing2[] = {"i--i",
+                             "-i-i"};
+
+  return test_sparse ("gegl:over", over, sharing1, sharing2);
+}
+
+/* the generated gegl:screen only passes input through transparent tiles */
+static gint
+test_sparse_screen (void)
+{
+  const gchar *sharing1[] = {"i--i",
+                             "ii-i"};
+  const gchar *sharing2[] = {"i--i",
+                             "-i-i"};
+
+  return test_sparse ("gegl:screen", screen, sharing1, sharing2);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* the tiles of the result are checked one by one */
+  g_object_set (gegl_config (),
+                "tile-width",  TILE_SIZE,
+                "tile-height", TILE_SIZE,
+                NULL);
+
+  RUN_TEST (sparse_over);
+  RUN_TEST (sparse_screen);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,212 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define WIDTH        160
+#define HEIGHT       128
+#define N_SEEDS      6
+#define MAX_DISTANCE 20.0
+#define EPSILON      1e-4
+
+/* a foreground with a few background pixels, far enough apart for the
+ * distances to exceed the cut-off
+ */
+static GeglBuffer *
+create_buffer (void)
+{
+  const Babl *format = babl_format ("Y float");
+  GeglBuffer *buffer;
+  GRand      *rand   = g_rand_new_with_seed (0);
+  gfloat     *data;
+  gint        i;
+
+  data = g_new (gfloat, WIDTH * HEIGHT);
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    data[i] = 1.0f;
+
+  for (i = 0; i < N_SEEDS; i++)
+    data[g_rand_int_range (rand, 0, WIDTH * HEIGHT)] = 0.0f;
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format, data);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static gfloat *
+render (GeglNode     *node,
+        GeglBlitFlags flags)
+{
+  return test_render (node, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                      babl_format ("Y float"), flags);
+}
+
+/* the distances with a cut-off are the distances without it, clamped to
+ * the cut-off, also when rendered in chunks smaller than the cut-off
+ */
+static gint
+test_max_distance (GeglDistanceMetric metric,
+                   gint               edge_handling,
+                   gboolean           normalize)
+{
+  GeglBuffer    *buffer = create_buffer ();
+  GeglNode      *graph  = gegl_node_new ();
+  GeglNode      *source;
+  GeglNode      *unclamped;
+  GeglNode      *clamped;
+  GeglProcessor *processor;
+  gfloat        *expected;
+  gfloat        *result;
+  gfloat        *chunked;
+  gdouble        max    = 0.0;
+  gint           status = SUCCESS;
+  gint           i;
+
+  source    = gegl_node_new_child (graph,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    buffer,
+                                   NULL);
+  unclamped = gegl_node_new_child (graph,
+                                   "operation",     "gegl:distance-transform",
+                                   "metric",        metric,
+                                   "edge-handling", edge_handling,
+                                   "normalize",     FALSE,
+                                   NULL);
+  clamped   = gegl_node_new_child (graph,
+                                   "operation",     "gegl:distance-transform",
+                                   "metric",        metric,
+                                   "edge-handling", edge_handling,
+                                   "normalize",     normalize,
+                                   "max-distance",  MAX_DISTANCE,
+                                   NULL);
+
+  gegl_node_link (source, unclamped);
+  gegl_node_link (source, clamped);
+
+  expected = render (unclamped, GEGL_BLIT_DEFAULT);
+  result   = render (clamped,   GEGL_BLIT_DEFAULT);
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+      max = MAX (max, expected[i]);
+
+      expected[i] = MIN (expected[i], MAX_DISTANCE);
+
+      /* the cut-off maps to 1.0 when normalizing */
+      if (normalize)
+        expected[i] /= MAX_DISTANCE;
+    }
+
+  status = test_compare (result, expected, WIDTH, 1,
+                         GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), EPSILON);
+
+  if (max <= MAX_DISTANCE)
+    {
+      printf ("\n  the distances don't exceed the cut-off");
+
+      status = FAILURE;
+    }
+
+  /* render the clamped distances into the cache, in small chunks */
+  processor = gegl_node_new_processor (clamped,
+                                       GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT));
+
+  while (gegl_processor_work (processor, NULL));
+
+  g_object_unref (processor);
+
+  chunked = render (clamped, GEGL_BLIT_CACHE | GEGL_BLIT_DIRTY);
+
+  if (test_compare (chunked, result, WIDTH, 1,
+                    GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), EPSILON) != SUCCESS)
+    {
+      printf (" when rendered in chunks");
+
+      status = FAILURE;
+    }
+
+  g_free (expected);
+  g_free (result);
+  g_free (chunked);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+static gint
+test_euclidean (void)
+{
+  return test_max_distance (GEGL_DISTANCE_METRIC_EUCLIDEAN, 1, FALSE);
+}
+
+static gint
+test_euclidean_abyss_above (void)
+{
+  return test_max_distance (GEGL_DISTANCE_METRIC_EUCLIDEAN, 0, FALSE);
+}
+
+static gint
+test_manhattan (void)
+{
+  return test_max_distance (GEGL_DISTANCE_METRIC_MANHATTAN, 1, FALSE);
+}
+
+static gint
+test_chebyshev (void)
+{
+  return test_max_distance (GEGL_DISTANCE_METRIC_CHEBYSHEV, 1, FALSE);
+}
+
+static gint
+test_normalized (void)
+{
+  return test_max_distance (GEGL_DISTANCE_METRIC_EUCLIDEAN, 1, TRUE);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* chunks smaller than the cut-off, so that each needs the input around it */
+  g_object_set (gegl_config (),
+                "chunk-size", 16 * 16,
+                NULL);
+
+  RUN_TEST (euclidean);
+  RUN_TEST (euclidean_abyss_above);
+  RUN_TEST (manhattan);
+  RUN_TEST (chebyshev);
+  RUN_TEST (normalized);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,193 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define WIDTH      150
+#define HEIGHT     100
+#define OFFSET_X   37
+#define OFFSET_Y   -21
+#define EPSILON    1e-6
+
+static GeglBuffer *
+create_buffer (void)
+{
+  const Babl *format = babl_format ("R'G'B'A u8");
+  GeglBuffer *buffer;
+  guchar     *data;
+  gint        x, y, c;
+
+  data = g_new (guchar, WIDTH * HEIGHT * 4);
+
+  /* smooth gradients, separated by edges */
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        for (c = 0; c < 3; c++)
+          {
+            gint value = (x * (c + 1) + y * (3 - c)) % 128;
+
+            if ((x / 32 + y / 24) % 2)
+              value += 127;
+
+            data[(y * WIDTH + x) * 4 + c] = value;
+          }
+
+        data[(y * WIDTH + x) * 4 + 3] = 255;
+      }
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format, data);
+
+  g_free (data);
+
+  return buffer;
+}
+
+static gfloat *
+render (GeglNode            *node,
+        const GeglRectangle *rect)
+{
+  return test_render (node, 1.0, rect, babl_format ("R'G'B'A float"),
+                      GEGL_BLIT_DEFAULT);
+}
+
+static gint
+compare (const gfloat *result,
+         const gfloat *expected)
+{
+  return test_compare (result, expected, WIDTH, 4,
+                       GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), EPSILON);
+}
+
+/* filtering an input which doesn't start at the origin gives the same
+ * result as filtering it at the origin and translating the result
+ */
+static gint
+test_translated_input (void)
+{
+  GeglBuffer *buffer = create_buffer ();
+  GeglNode   *graph  = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *translate1;
+  GeglNode   *filter1;
+  GeglNode   *filter2;
+  GeglNode   *translate2;
+  gfloat     *result;
+  gfloat     *expected;
+  gint        status;
+
+  source     = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    buffer,
+                                    NULL);
+  translate1 = gegl_node_new_child (graph,
+                                    "operation", "gegl:translate",
+                                    "x",         (gdouble) OFFSET_X,
+                                    "y",         (gdouble) OFFSET_Y,
+                                    NULL);
+  filter1    = gegl_node_new_child (graph,
+                                    "operation", "gegl:domain-transform",
+                                    NULL);
+  filter2    = gegl_node_new_child (graph,
+                                    "operation", "gegl:domain-transform",
+                                    NULL);
+  translate2 = gegl_node_new_child (graph,
+                                    "operation", "gegl:translate",
+                                    "x",         (gdouble) OFFSET_X,
+                                    "y",         (gdouble) OFFSET_Y,
+                                    NULL);
+
+  gegl_node_link_many (source, translate1, filter1, NULL);
+  gegl_node_link_many (source, filter2, translate2, NULL);
+
+  result   = render (filter1,
+                     GEGL_RECTANGLE (OFFSET_X, OFFSET_Y, WIDTH, HEIGHT));
+  expected = render (translate2,
+                     GEGL_RECTANGLE (OFFSET_X, OFFSET_Y, WIDTH, HEIGHT));
+
+  status = compare (result, expected);
+
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+/* the result doesn't depend on the number of threads */
+static gint
+test_threads (void)
+{
+  GeglBuffer *buffer = create_buffer ();
+  GeglNode   *graph  = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *filter;
+  gfloat     *result;
+  gfloat     *expected;
+  gint        threads;
+  gint        status;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  filter = gegl_node_new_child (graph,
+                                "operation", "gegl:domain-transform",
+                                NULL);
+
+  gegl_node_link (source, filter);
+
+  threads  = test_set_threads (1);
+  expected = render (filter, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT));
+
+  test_set_threads (4);
+  result = render (filter, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT));
+
+  test_set_threads (threads);
+
+  status = compare (result, expected);
+
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (translated_input);
+  RUN_TEST (threads);
+
+  gegl_exit ();
+
+  return result;
+}
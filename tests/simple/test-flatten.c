@@ -0,0 +1,208 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define SIZE       48
+#define EPSILON    1e-5
+
+/* values of the flatten modes */
+#define MODE_SCREEN  2
+#define MODE_OVERLAY 3
+
+static GeglBuffer *
+create_mask (void)
+{
+  const Babl *format = babl_format ("Y float");
+  GeglBuffer *buffer;
+  gfloat     *data;
+  gint        i;
+
+  data = g_new (gfloat, SIZE * SIZE);
+
+  for (i = 0; i < SIZE * SIZE; i++)
+    data[i] = (gfloat) (i % SIZE) / (SIZE - 1);
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE), format, data);
+
+  g_free (data);
+
+  return buffer;
+}
+
+/* compositing a stack of layers with gegl:flatten should give the same
+ * result as a chain of gegl:opacity and compositing operations, when
+ * rendering @rect at @scale
+ */
+static gint
+flatten_chain (gdouble              scale,
+               const GeglRectangle *rect)
+{
+  const gchar   *ops[]           = { "gegl:over", "gegl:screen",
+                                     "gegl:overlay" };
+  const gint     modes[]         = { 0, MODE_SCREEN, MODE_OVERLAY };
+  const gdouble  opacities[]     = { 1.0, 0.6, 0.8 };
+  const gchar   *mode_props[]    = { "mode1", "mode2", "mode3" };
+  const gchar   *opacity_props[] = { "opacity1", "opacity2", "opacity3" };
+  GeglBuffer    *buffers[4];
+  GeglBuffer    *mask   = create_mask ();
+  GeglNode      *graph  = gegl_node_new ();
+  GeglNode      *input;
+  GeglNode      *mask_source;
+  GeglNode      *flatten;
+  GeglNode      *chain;
+  gfloat        *result;
+  gfloat        *expected;
+  gint           status = SUCCESS;
+  gint           i;
+
+  for (i = 0; i < 4; i++)
+    {
+      buffers[i] = test_pattern_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                                            babl_format ("RGBA float"), i);
+    }
+
+  input       = gegl_node_new_child (graph,
+                                     "operation", "gegl:buffer-source",
+                                     "buffer",    buffers[0],
+                                     NULL);
+  mask_source = gegl_node_new_child (graph,
+                                     "operation", "gegl:buffer-source",
+                                     "buffer",    mask,
+                                     NULL);
+  flatten     = gegl_node_new_child (graph,
+                                     "operation", "gegl:flatten",
+                                     "layers",    3,
+                                     NULL);
+
+  gegl_node_link (input, flatten);
+
+  chain = input;
+
+  for (i = 0; i < 3; i++)
+    {
+      GeglNode *layer;
+      GeglNode *layer_opacity;
+      GeglNode *composite;
+      gchar     pad[32];
+
+      layer         = gegl_node_new_child (graph,
+                                           "operation", "gegl:buffer-source",
+                                           "buffer",    buffers[i + 1],
+                                           NULL);
+      layer_opacity = gegl_node_new_child (graph,
+                                           "operation", "gegl:opacity",
+                                           "value",     opacities[i],
+                                           NULL);
+      composite     = gegl_node_new_child (graph,
+                                           "operation", ops[i],
+                                           NULL);
+
+      gegl_node_set (flatten,
+                     mode_props[i],    modes[i],
+                     opacity_props[i], opacities[i],
+                     NULL);
+
+      sprintf (pad, "aux%d", i + 1);
+      gegl_node_connect_from (flatten, pad, layer, "output");
+
+      /* the second layer is masked */
+      if (i == 1)
+        {
+          gegl_node_connect_from (flatten, "mask2", mask_source, "output");
+          gegl_node_connect_from (layer_opacity, "aux", mask_source, "output");
+        }
+
+      gegl_node_link (layer, layer_opacity);
+      gegl_node_connect_from (composite, "aux", layer_opacity, "output");
+      gegl_node_link (chain, composite);
+
+      chain = composite;
+    }
+
+  result   = test_render (flatten, scale, rect,
+                          babl_format ("RaGaBaA float"), GEGL_BLIT_DEFAULT);
+  expected = test_render (chain,   scale, rect,
+                          babl_format ("RaGaBaA float"), GEGL_BLIT_DEFAULT);
+
+  status = test_compare (result, expected, rect->width, 4,
+                         GEGL_RECTANGLE (0, 0, rect->width, rect->height),
+                         EPSILON);
+
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (mask);
+
+  for (i = 0; i < 4; i++)
+    g_object_unref (buffers[i]);
+
+  return status;
+}
+
+static gint
+test_flatten_chain (void)
+{
+  return flatten_chain (1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE));
+}
+
+/* at level 1, the area to process is halved, which matters for an area
+ * which doesn't start at the origin
+ */
+static gint
+test_flatten_chain_level_1 (void)
+{
+  gboolean mipmap_rendering;
+  gint     status;
+
+  g_object_get (gegl_config (),
+                "mipmap-rendering", &mipmap_rendering,
+                NULL);
+  g_object_set (gegl_config (),
+                "mipmap-rendering", TRUE,
+                NULL);
+
+  status = flatten_chain (0.5, GEGL_RECTANGLE (SIZE / 4, SIZE / 4,
+                                               SIZE / 4, SIZE / 4));
+
+  g_object_set (gegl_config (),
+                "mipmap-rendering", mipmap_rendering,
+                NULL);
+
+  return status;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (flatten_chain);
+  RUN_TEST (flatten_chain_level_1);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,335 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+/* gegl:gblur-1d filters blocks of 16 lines at once; odd sizes which aren't
+ * multiples of the block size leave a partial block in both orientations
+ */
+#define WIDTH      83
+#define HEIGHT     37
+#define EPSILON    1e-5
+
+/* the value of the "filter" property selecting the IIR filter */
+#define FILTER_IIR 2
+
+/* the values of the "abyss-policy" property */
+typedef enum
+{
+  POLICY_NONE,
+  POLICY_CLAMP,
+  POLICY_BLACK,
+  POLICY_WHITE
+} Policy;
+
+static const gchar *policy_names[] = {"none", "clamp", "black", "white"};
+
+static const gfloat white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+static const gfloat black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+static const gfloat none[4]  = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+/* the Young - van Vliet coefficients, as computed by gegl:gblur-1d */
+static void
+find_constants (gfloat   sigma,
+                gdouble *b,
+                gdouble (*m)[3])
+{
+  const gdouble K1 = 2.44413;
+  const gdouble K2 = 1.4281;
+  const gdouble K3 = 0.422205;
+  const gdouble q = sigma >= 2.5 ?
+                    0.98711 * sigma - 0.96330 :
+                    3.97156 - 4.14554 * sqrt (1 - 0.26891 * sigma);
+
+  const gdouble b0 = 1.57825 + q*(K1 + q*(    K2 + q *     K3));
+  const gdouble b1 =           q*(K1 + q*(2 * K2 + q * 3 * K3));
+  const gdouble b2 =     (-K2 * q * q) + (-K3 * 3 * q * q * q);
+  const gdouble b3 =           q*      q*          q *     K3;
+
+  const gdouble a1 = b1 / b0;
+  const gdouble a2 = b2 / b0;
+  const gdouble a3 = b3 / b0;
+
+  const gdouble c  = 1. / ((1+a1-a2+a3) * (1+a2+(a1-a3)*a3));
+
+  m[0][0] = c * (-a3*(a1+a3)-a2 + 1);
+  m[0][1] = c * (a3+a1)*(a2+a3*a1);
+  m[0][2] = c * a3*(a1+a3*a2);
+
+  m[1][0] = c * (a1+a3*a2);
+  m[1][1] = c * (1-a2)*(a2+a3*a1);
+  m[1][2] = c * a3*(1-a3*a1-a3*a3-a2);
+
+  m[2][0] = c * (a3*a1+a2+a1*a1-a2*a2);
+  m[2][1] = c * (a1*a2+a3*a2*a2-a1*a3*a3-a3*a3*a3-a3*a2+a3);
+  m[2][2] = c * a3*(a1+a3*a2);
+
+  b[0] = 1. - (b1 + b2 + b3) / b0;
+  b[1] = a1;
+  b[2] = a2;
+  b[3] = a3;
+}
+
+/* filters one component of a single line of @len samples, @stride floats
+ * apart, the way the per-line iir_young_blur_1D_*() kernels which preceded
+ * the block kernel did
+ */
+static void
+reference_blur_line (gfloat        *line,
+                     gint           len,
+                     gint           stride,
+                     gfloat         iminus,
+                     gfloat         uplus,
+                     const gdouble *b,
+                     gdouble      (*m)[3])
+{
+  gdouble *tmp = g_new (gdouble, 3 + len + 3);
+  gdouble  u[3];
+  gint     i, k;
+
+  for (i = 0; i < 3; i++)
+    tmp[i] = iminus;
+
+  /* causal filter */
+  for (i = 3; i < 3 + len; i++)
+    {
+      tmp[i] = b[0] * line[(i - 3) * stride];
+
+      for (k = 1; k < 4; k++)
+        tmp[i] += b[k] * tmp[i - k];
+    }
+
+  /* right boundary, see Triggs and Sdika, "Boundary conditions for
+   * Young - van Vliet recursive filtering"
+   */
+  for (k = 0; k < 3; k++)
+    u[k] = tmp[3 + len - 1 - k] - uplus;
+
+  for (i = 0; i < 3; i++)
+    {
+      gdouble value = 0.0;
+
+      for (k = 0; k < 3; k++)
+        value += m[i][k] * u[k];
+
+      tmp[3 + len + i] = value + uplus;
+    }
+
+  /* anti-causal filter */
+  for (i = 3 + len - 1; 3 <= i; i--)
+    {
+      tmp[i] *= b[0];
+
+      for (k = 1; k < 4; k++)
+        tmp[i] += b[k] * tmp[i + k];
+
+      line[(i - 3) * stride] = tmp[i];
+    }
+
+  g_free (tmp);
+}
+
+/* blurs @data, which is WIDTH x HEIGHT with @nc components per pixel, in
+ * place, line by line
+ */
+static void
+reference_blur (gfloat          *data,
+                gint             nc,
+                GeglOrientation  orientation,
+                Policy           policy,
+                gdouble          std_dev)
+{
+  gboolean horizontal = orientation == GEGL_ORIENTATION_HORIZONTAL;
+  gint     n_lines    = horizontal ? HEIGHT : WIDTH;
+  gint     len        = horizontal ? WIDTH  : HEIGHT;
+  gint     stride     = horizontal ? nc     : WIDTH * nc;
+  gdouble  b[4], m[3][3];
+  gint     l, c;
+
+  find_constants (std_dev, b, m);
+
+  for (l = 0; l < n_lines; l++)
+    {
+      gfloat *line = data + (horizontal ? l * WIDTH * nc : l * nc);
+
+      for (c = 0; c < nc; c++)
+        {
+          gfloat iminus, uplus;
+
+          switch (policy)
+            {
+            case POLICY_CLAMP:
+            default:
+              iminus = line[c];
+              uplus  = line[(len - 1) * stride + c];
+              break;
+
+            case POLICY_NONE:
+              iminus = uplus = none[c];
+              break;
+
+            case POLICY_BLACK:
+              iminus = uplus = black[(nc == 2 ? 2 : 0) + c];
+              break;
+
+            case POLICY_WHITE:
+              iminus = uplus = white[c];
+              break;
+            }
+
+          reference_blur_line (line + c, len, stride, iminus, uplus, b, m);
+        }
+    }
+}
+
+/* blurs the pattern in @format with the IIR filter of gegl:gblur-1d, and
+ * compares the result with the per-line reference, rendering it with one
+ * thread and with several, so that the lines are split differently
+ */
+static gint
+test_format (const gchar *format_name)
+{
+  const Babl          *format      = babl_format (format_name);
+  const GeglRectangle *rect        = GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT);
+  const gint           nc          = babl_format_get_n_components (format);
+  const gdouble        std_devs[]  = {3.0, 20.0};
+  const gint           threads[]   = {1, 3};
+  GeglBuffer          *buffer      = test_pattern_buffer_new (rect, format, 0);
+  gfloat              *input       = g_new (gfloat, WIDTH * HEIGHT * nc);
+  gfloat              *expected    = g_new (gfloat, WIDTH * HEIGHT * nc);
+  gint                 status      = SUCCESS;
+  GeglOrientation      orientation;
+  Policy               policy;
+  gint                 s, t;
+
+  gegl_buffer_get (buffer, rect, 1.0, format, input,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (orientation = GEGL_ORIENTATION_HORIZONTAL;
+       orientation <= GEGL_ORIENTATION_VERTICAL && status == SUCCESS;
+       orientation++)
+    for (policy = POLICY_NONE; policy <= POLICY_WHITE && status == SUCCESS;
+         policy++)
+      for (s = 0; s < G_N_ELEMENTS (std_devs) && status == SUCCESS; s++)
+        {
+          memcpy (expected, input, WIDTH * HEIGHT * nc * sizeof (gfloat));
+          reference_blur (expected, nc, orientation, policy, std_devs[s]);
+
+          for (t = 0; t < G_N_ELEMENTS (threads) && status == SUCCESS; t++)
+            {
+              GeglNode *graph = gegl_node_new ();
+              GeglNode *source;
+              GeglNode *blur;
+              gfloat   *result;
+              gint      old_threads;
+
+              /* a graph of its own for each render, so that nothing is
+               * reused from the node caches
+               */
+              source = gegl_node_new_child (graph,
+                                            "operation", "gegl:buffer-source",
+                                            "buffer",    buffer,
+                                            NULL);
+              blur   = gegl_node_new_child (graph,
+                                            "operation",    "gegl:gblur-1d",
+                                            "std-dev",      std_devs[s],
+                                            "orientation",  orientation,
+                                            "filter",       FILTER_IIR,
+                                            "abyss-policy", policy,
+                                            NULL);
+
+              gegl_node_link (source, blur);
+
+              old_threads = test_set_threads (threads[t]);
+
+              result = test_render (blur, 1.0, rect, format,
+                                    GEGL_BLIT_DEFAULT);
+
+              test_set_threads (old_threads);
+
+              status = test_compare (result, expected, WIDTH, nc, rect,
+                                     EPSILON);
+
+              if (status != SUCCESS)
+                {
+                  printf (", %s, %s, %s abyss, std-dev %g, %d threads",
+                          format_name,
+                          orientation == GEGL_ORIENTATION_HORIZONTAL ?
+                          "horizontal" : "vertical",
+                          policy_names[policy], std_devs[s], threads[t]);
+                }
+
+              g_free (result);
+
+              g_object_unref (graph);
+            }
+        }
+
+  g_free (input);
+  g_free (expected);
+
+  g_object_unref (buffer);
+
+  return status;
+}
+
+static gint
+test_y (void)
+{
+  return test_format ("Y float");
+}
+
+static gint
+test_ya (void)
+{
+  return test_format ("YaA float");
+}
+
+static gint
+test_rgb (void)
+{
+  return test_format ("RGB float");
+}
+
+static gint
+test_rgba (void)
+{
+  return test_format ("RaGaBaA float");
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (y);
+  RUN_TEST (ya);
+  RUN_TEST (rgb);
+  RUN_TEST (rgba);
+
+  gegl_exit ();
+
+  return result;
+}
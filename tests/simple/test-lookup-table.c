@@ -0,0 +1,216 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+#include "gegl-lookup.h"
+
+/* the range and error bound gegl:gamma uses */
+#define START      (1.0f / (1 << 24))
+#define END        256.0f
+#define MAX_ERROR  2.5e-7f
+
+/* the distance between the bits of the floats the table is checked at */
+#define STRIDE     61
+
+static gfloat
+gamma_function (gfloat   input,
+                gpointer data)
+{
+  gfloat value = *(gfloat *) data;
+
+  return input >= 0.0f ? powf (input, value) : -powf (-input, value);
+}
+
+static gfloat
+float_from_bits (guint32 bits)
+{
+  union
+  {
+    float   f;
+    guint32 i;
+  } u;
+
+  u.i = bits;
+
+  return u.f;
+}
+
+static guint32
+bits_from_float (gfloat value)
+{
+  union
+  {
+    float   f;
+    guint32 i;
+  } u;
+
+  u.f = value;
+
+  return u.i;
+}
+
+/* the table is within the error bound of the function over its range, and
+ * exact where the function is the identity
+ */
+static gint
+test_error_bound (void)
+{
+  const gfloat  values[] = { 1.0f, 0.5f, 2.2f, 4.0f, 10.0f };
+  gint          status   = SUCCESS;
+  gint          i;
+
+  for (i = 0; i < G_N_ELEMENTS (values) && status == SUCCESS; i++)
+    {
+      GeglLookupTable *table;
+      gfloat           value = values[i];
+      guint32          bits;
+
+      table = gegl_lookup_table_new (gamma_function, &value,
+                                     START, END, MAX_ERROR);
+
+      if (! table)
+        {
+          printf ("\n  gamma %g: no table", value);
+
+          return FAILURE;
+        }
+
+      for (bits  = bits_from_float (START);
+           bits  < bits_from_float (END) && status == SUCCESS;
+           bits += STRIDE)
+        {
+          gfloat x        = float_from_bits (bits);
+          gfloat expected = gamma_function (x, &value);
+          gfloat result   = gegl_lookup_table (table, x);
+          gfloat error    = fabsf (result - expected) /
+                            MAX (fabsf (expected), 1.0f);
+
+          if (value == 1.0f ? result != expected : error > MAX_ERROR)
+            {
+              printf ("\n  gamma %g, input %g: expected %.9g, got %.9g",
+                      value, x, expected, result);
+
+              status = FAILURE;
+            }
+        }
+
+      gegl_lookup_table_free (table);
+    }
+
+  return status;
+}
+
+/* a function which overflows within the range can't be approximated */
+static gint
+test_no_table (void)
+{
+  GeglLookupTable *table;
+  gfloat           value = 100.0f;
+
+  table = gegl_lookup_table_new (gamma_function, &value,
+                                 START, END, MAX_ERROR);
+
+  if (table)
+    {
+      printf ("\n  gamma %g: unexpected table", value);
+
+      gegl_lookup_table_free (table);
+
+      return FAILURE;
+    }
+
+  return SUCCESS;
+}
+
+/* the values outside of the range of the table are passed to the function */
+static gint
+test_out_of_range (void)
+{
+  const gfloat     inputs[] = { 0.0f, -0.0f, -0.5f, -300.0f, START / 2.0f,
+                                END, 1000.0f, INFINITY, -INFINITY };
+  GeglLookupTable *table;
+  gfloat           value    = 2.2f;
+  gint             status   = SUCCESS;
+  gint             i;
+
+  table = gegl_lookup_table_new (gamma_function, &value,
+                                 START, END, MAX_ERROR);
+
+  if (! table)
+    {
+      printf ("\n  gamma %g: no table", value);
+
+      return FAILURE;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (inputs); i++)
+    {
+      gfloat x        = inputs[i];
+      gfloat expected = gamma_function (x, &value);
+      gfloat result   = gegl_lookup_table (table, x);
+
+      if (gegl_lookup_table_contains (table, x) ||
+          bits_from_float (result) != bits_from_float (expected))
+        {
+          printf ("\n  input %g: expected %.9g, got %.9g",
+                  x, expected, result);
+
+          status = FAILURE;
+        }
+    }
+
+  if (! isnan (gegl_lookup_table (table, NAN)))
+    {
+      printf ("\n  input nan: expected nan");
+
+      status = FAILURE;
+    }
+
+  /* the ends of the range are in the table */
+  if (! gegl_lookup_table_contains (table, START) ||
+      ! gegl_lookup_table_contains (table, nextafterf (END, 0.0f)))
+    {
+      printf ("\n  the ends of the range are not in the table");
+
+      status = FAILURE;
+    }
+
+  gegl_lookup_table_free (table);
+
+  return status;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (error_bound);
+  RUN_TEST (no_table);
+  RUN_TEST (out_of_range);
+
+  gegl_exit ();
+
+  return result;
+}
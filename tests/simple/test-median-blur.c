@@ -0,0 +1,173 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define WIDTH      80
+#define HEIGHT     64
+
+static GeglBuffer *
+create_buffer (void)
+{
+  const Babl *format = babl_format ("R'G'B' u8");
+  GeglBuffer *buffer;
+  GRand      *rand   = g_rand_new_with_seed (0);
+  guchar     *data;
+  gint        i;
+
+  data = g_new (guchar, WIDTH * HEIGHT * 3);
+
+  for (i = 0; i < WIDTH * HEIGHT * 3; i++)
+    data[i] = g_rand_int_range (rand, 0, 256);
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format, data);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static int
+compare_uchar (const void *a,
+               const void *b)
+{
+  return *(const guchar *) a - *(const guchar *) b;
+}
+
+/* the square neighborhood percentile of each pixel at least @radius pixels
+ * away from the edges matches a brute-force percentile
+ */
+static gint
+test_percentile (gint    radius,
+                 gdouble percentile)
+{
+  const Babl *format     = babl_format ("R'G'B' u8");
+  const gint  n          = (2 * radius + 1) * (2 * radius + 1);
+  GeglBuffer *buffer     = create_buffer ();
+  GeglNode   *graph      = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *median;
+  guchar     *input      = g_new (guchar, WIDTH * HEIGHT * 3);
+  guchar     *result     = g_new (guchar, WIDTH * HEIGHT * 3);
+  guchar     *neighbors  = g_new (guchar, n);
+  gint        rank;
+  gint        status     = SUCCESS;
+  gint        x, y, c, u, v;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  median = gegl_node_new_child (graph,
+                                "operation",    "gegl:median-blur",
+                                "neighborhood", 0, /* square */
+                                "radius",       radius,
+                                "percentile",   percentile,
+                                NULL);
+
+  gegl_node_link (source, median);
+
+  gegl_buffer_get (buffer, NULL, 1.0, format, input,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  gegl_node_blit (median, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                  format, result, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  /* the smallest value at least a percentile of the neighborhood is less
+   * than or equal to
+   */
+  rank = MAX ((gint) ceil (n * percentile / 100.0), 1) - 1;
+
+  for (y = radius; y < HEIGHT - radius && status == SUCCESS; y++)
+    for (x = radius; x < WIDTH - radius && status == SUCCESS; x++)
+      for (c = 0; c < 3; c++)
+        {
+          gint i = 0;
+
+          for (v = -radius; v <= radius; v++)
+            for (u = -radius; u <= radius; u++)
+              neighbors[i++] = input[((y + v) * WIDTH + x + u) * 3 + c];
+
+          qsort (neighbors, n, 1, compare_uchar);
+
+          if (result[(y * WIDTH + x) * 3 + c] != neighbors[rank])
+            {
+              printf ("\n  radius %d, percentile %g, pixel %d,%d, "
+                      "component %d: expected %d, got %d",
+                      radius, percentile, x, y, c,
+                      neighbors[rank], result[(y * WIDTH + x) * 3 + c]);
+
+              status = FAILURE;
+              break;
+            }
+        }
+
+  g_free (input);
+  g_free (result);
+  g_free (neighbors);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+/* small radii use the sliding histogram */
+static gint
+test_histogram (void)
+{
+  if (test_percentile (3, 50.0) != SUCCESS ||
+      test_percentile (5, 20.0) != SUCCESS)
+    return FAILURE;
+
+  return SUCCESS;
+}
+
+/* larger radii use the constant-time median */
+static gint
+test_constant_time (void)
+{
+  if (test_percentile (8,  50.0) != SUCCESS ||
+      test_percentile (12, 50.0) != SUCCESS ||
+      test_percentile (12, 90.0) != SUCCESS ||
+      test_percentile (20, 0.0)  != SUCCESS)
+    return FAILURE;
+
+  return SUCCESS;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (histogram);
+  RUN_TEST (constant_time);
+
+  gegl_exit ();
+
+  return result;
+}
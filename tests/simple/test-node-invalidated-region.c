@@ -0,0 +1,108 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+/* Checks that invalidating a small area of a source which reaches a
+ * composer through two paths far apart from each other does not invalidate
+ * the bounding box of both paths.
+ */
+
+static void
+invalidated (GeglNode            *node,
+             const GeglRectangle *rect,
+             gpointer             data)
+{
+  GeglRectangle *largest = data;
+
+  if (rect->width * rect->height > largest->width * largest->height)
+    *largest = *rect;
+}
+
+int main(int argc, char *argv[])
+{
+  gint           result  = SUCCESS;
+  GeglRectangle  extent  = { 0, 0, 2000, 100 };
+  GeglRectangle  dirty   = { 10, 10, 10, 10 };
+  GeglRectangle  largest = { 0, 0, 0, 0 };
+  gfloat         pixels[10 * 10 * 4];
+  GeglBuffer    *buffer;
+  GeglNode      *gegl;
+  GeglNode      *source;
+  GeglNode      *translate;
+  GeglNode      *over;
+  GeglNode      *sink;
+  GeglProcessor *processor;
+
+  gegl_init (&argc, &argv);
+
+  buffer = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+
+  gegl      = gegl_node_new ();
+  source    = gegl_node_new_child (gegl,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    buffer,
+                                   NULL);
+  translate = gegl_node_new_child (gegl,
+                                   "operation", "gegl:translate",
+                                   "x",         1000.0,
+                                   "y",         0.0,
+                                   NULL);
+  over      = gegl_node_new_child (gegl,
+                                   "operation", "gegl:over",
+                                   NULL);
+  sink      = gegl_node_new_child (gegl,
+                                   "operation", "gegl:buffer-sink",
+                                   NULL);
+
+  gegl_node_link_many (source, over, sink, NULL);
+  gegl_node_link (source, translate);
+  gegl_node_connect (translate, "output", over, "aux");
+
+  processor = gegl_node_new_processor (sink, NULL);
+  while (gegl_processor_work (processor, NULL));
+
+  g_signal_connect (over, "invalidated", G_CALLBACK (invalidated), &largest);
+
+  memset (pixels, 0, sizeof (pixels));
+  gegl_buffer_set (buffer, &dirty, 0, babl_format ("RGBA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  if (largest.width == 0 || largest.height == 0)
+    {
+      g_printerr ("test-node-invalidated-region: no invalidation received\n");
+      result = FAILURE;
+    }
+  else if (largest.width >= 1000)
+    {
+      g_printerr ("test-node-invalidated-region: invalidated %d×%d, "
+                  "expected two disjoint areas\n",
+                  largest.width, largest.height);
+      result = FAILURE;
+    }
+
+  g_object_unref (processor);
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+  gegl_exit ();
+
+  return result;
+}
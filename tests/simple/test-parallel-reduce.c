@@ -0,0 +1,349 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define WIDTH      509
+#define HEIGHT     383
+#define EPSILON    1e-9
+
+/* the reductions are compared against serial loops with these numbers of
+ * threads
+ */
+static const gint threads[] = {1, 2, 3, 4, 7};
+
+typedef struct
+{
+  guint64 n_pixels;
+  guint64 sum;
+  gint    n_areas;
+} AreaResult;
+
+/* the reduced rectangle, which isn't aligned to the tiles */
+static const GeglRectangle rect = {13, 7, WIDTH - 29, HEIGHT - 18};
+
+static GeglBuffer *
+create_buffer (void)
+{
+  GeglBuffer *buffer;
+  GRand      *rand   = g_rand_new_with_seed (0);
+  gfloat     *data;
+  gint        i;
+
+  data = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    data[i] = g_rand_double_range (rand, -1.0, 2.0);
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGBA float"), data);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static void
+area_reduce (const GeglRectangle *area,
+             AreaResult          *partial,
+             gpointer             user_data)
+{
+  gint x, y;
+
+  for (y = area->y; y < area->y + area->height; y++)
+    for (x = area->x; x < area->x + area->width; x++)
+      {
+        partial->n_pixels++;
+        partial->sum += (guint64) y * WIDTH + x;
+      }
+
+  partial->n_areas++;
+}
+
+static void
+area_merge (AreaResult       *result,
+            const AreaResult *partial,
+            gpointer          user_data)
+{
+  result->n_pixels += partial->n_pixels;
+  result->sum      += partial->sum;
+  result->n_areas  += partial->n_areas;
+}
+
+/* each pixel of the area is reduced exactly once, by at most one sub-area
+ * per thread
+ */
+static gint
+test_reduce_area (void)
+{
+  AreaResult expected = {0, 0, 0};
+  gint       status   = SUCCESS;
+  gint       old_threads;
+  gint       i;
+
+  area_reduce (&rect, &expected, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (threads) && status == SUCCESS; i++)
+    {
+      GeglSplitStrategy strategies[] = {GEGL_SPLIT_STRATEGY_HORIZONTAL,
+                                        GEGL_SPLIT_STRATEGY_VERTICAL};
+      gint              s;
+
+      old_threads = test_set_threads (threads[i]);
+
+      for (s = 0; s < G_N_ELEMENTS (strategies) && status == SUCCESS; s++)
+        {
+          AreaResult result = {0, 0, 0};
+
+          gegl_parallel_reduce_area (
+            &rect, 0.0, strategies[s],
+            &result, sizeof (result),
+            (GeglParallelReduceAreaFunc) area_reduce,
+            (GeglParallelMergeFunc) area_merge,
+            NULL);
+
+          if (result.n_pixels != expected.n_pixels ||
+              result.sum      != expected.sum      ||
+              result.n_areas  <  1                 ||
+              result.n_areas  >  threads[i])
+            {
+              printf ("\n  %d threads, strategy %d: "
+                      "expected %" G_GUINT64_FORMAT " pixels "
+                      "(%" G_GUINT64_FORMAT "), "
+                      "got %" G_GUINT64_FORMAT " (%" G_GUINT64_FORMAT ") "
+                      "in %d areas",
+                      threads[i], strategies[s],
+                      expected.n_pixels, expected.sum,
+                      result.n_pixels, result.sum, result.n_areas);
+
+              status = FAILURE;
+            }
+        }
+
+      test_set_threads (old_threads);
+    }
+
+  return status;
+}
+
+static void
+buffer_reduce (const guint8 *pixels,
+               gint          n_pixels,
+               guint64      *partial,
+               gpointer      user_data)
+{
+  gint i;
+
+  for (i = 0; i < n_pixels; i++)
+    partial[0] += pixels[i];
+
+  partial[1] += n_pixels;
+}
+
+static void
+buffer_merge (guint64       *result,
+              const guint64 *partial,
+              gpointer       user_data)
+{
+  result[0] += partial[0];
+  result[1] += partial[1];
+}
+
+/* the pixels of the rectangle are each passed to the reduce function once,
+ * in the requested format
+ */
+static gint
+test_reduce_buffer (void)
+{
+  const Babl *format      = babl_format ("Y u8");
+  GeglBuffer *buffer      = create_buffer ();
+  guint8     *data        = g_new (guint8, rect.width * rect.height);
+  guint64     expected[2] = {0, rect.width * rect.height};
+  gint        status      = SUCCESS;
+  gint        old_threads;
+  gint        i;
+
+  gegl_buffer_get (buffer, &rect, 1.0, format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < rect.width * rect.height; i++)
+    expected[0] += data[i];
+
+  for (i = 0; i < G_N_ELEMENTS (threads) && status == SUCCESS; i++)
+    {
+      guint64 result[2] = {0, 0};
+
+      old_threads = test_set_threads (threads[i]);
+
+      gegl_parallel_reduce_buffer (buffer, &rect, 0, format,
+                                   result, sizeof (result),
+                                   (GeglParallelReduceBufferFunc) buffer_reduce,
+                                   (GeglParallelMergeFunc) buffer_merge,
+                                   NULL);
+
+      test_set_threads (old_threads);
+
+      if (result[0] != expected[0] || result[1] != expected[1])
+        {
+          printf ("\n  %d threads: expected a sum of %" G_GUINT64_FORMAT
+                  " over %" G_GUINT64_FORMAT " pixels, "
+                  "got %" G_GUINT64_FORMAT " over %" G_GUINT64_FORMAT,
+                  threads[i], expected[0], expected[1], result[0], result[1]);
+
+          status = FAILURE;
+        }
+    }
+
+  g_free (data);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+static gboolean
+equal (gdouble value,
+       gdouble expected,
+       gdouble epsilon)
+{
+  return fabs (value - expected) <= epsilon * MAX (fabs (expected), 1.0);
+}
+
+/* the statistics match a serial loop over the pixels, the minima and maxima
+ * exactly, and the sums up to rounding
+ */
+static gint
+test_statistics (void)
+{
+  const Babl *format = babl_format ("RGBA float");
+  GeglBuffer *buffer = create_buffer ();
+  gfloat     *data   = g_new (gfloat, rect.width * rect.height * 4);
+  gdouble     expected_min[4], expected_max[4];
+  gdouble     expected_sum[4], expected_sum_squares[4];
+  gint        status = SUCCESS;
+  gint        old_threads;
+  gint        i, c;
+
+  gegl_buffer_get (buffer, &rect, 1.0, format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (c = 0; c < 4; c++)
+    {
+      expected_min[c]         =  G_MAXDOUBLE;
+      expected_max[c]         = -G_MAXDOUBLE;
+      expected_sum[c]         = 0.0;
+      expected_sum_squares[c] = 0.0;
+
+      for (i = 0; i < rect.width * rect.height; i++)
+        {
+          gdouble value = data[i * 4 + c];
+
+          expected_min[c]          = MIN (expected_min[c], value);
+          expected_max[c]          = MAX (expected_max[c], value);
+          expected_sum[c]         += value;
+          expected_sum_squares[c] += value * value;
+        }
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (threads) && status == SUCCESS; i++)
+    {
+      gdouble min[4], max[4], sum[4], sum_squares[4];
+
+      old_threads = test_set_threads (threads[i]);
+
+      gegl_parallel_get_buffer_statistics (buffer, &rect, 0, format,
+                                           min, max, sum, sum_squares);
+
+      test_set_threads (old_threads);
+
+      for (c = 0; c < 4 && status == SUCCESS; c++)
+        {
+          if (min[c] != expected_min[c]                         ||
+              max[c] != expected_max[c]                         ||
+              ! equal (sum[c], expected_sum[c], EPSILON)        ||
+              ! equal (sum_squares[c], expected_sum_squares[c], EPSILON))
+            {
+              printf ("\n  %d threads, component %d: "
+                      "expected %g, %g, %g, %g, got %g, %g, %g, %g",
+                      threads[i], c,
+                      expected_min[c], expected_max[c],
+                      expected_sum[c], expected_sum_squares[c],
+                      min[c], max[c], sum[c], sum_squares[c]);
+
+              status = FAILURE;
+            }
+        }
+    }
+
+  g_free (data);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+/* an empty rectangle leaves the statistics at their identities */
+static gint
+test_statistics_empty (void)
+{
+  const Babl *format = babl_format ("RGBA float");
+  GeglBuffer *buffer = create_buffer ();
+  gdouble     min[4], max[4], sum[4], sum_squares[4];
+  gint        status = SUCCESS;
+  gint        c;
+
+  gegl_parallel_get_buffer_statistics (buffer, GEGL_RECTANGLE (5, 5, 0, 10),
+                                       0, format,
+                                       min, max, sum, sum_squares);
+
+  for (c = 0; c < 4; c++)
+    {
+      if (min[c] != G_MAXDOUBLE || max[c] != -G_MAXDOUBLE ||
+          sum[c] != 0.0         || sum_squares[c] != 0.0)
+        {
+          printf ("\n  component %d: got %g, %g, %g, %g",
+                  c, min[c], max[c], sum[c], sum_squares[c]);
+
+          status = FAILURE;
+        }
+    }
+
+  g_object_unref (buffer);
+
+  return status;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (reduce_area);
+  RUN_TEST (reduce_buffer);
+  RUN_TEST (statistics);
+  RUN_TEST (statistics_empty);
+
+  gegl_exit ();
+
+  return result;
+}
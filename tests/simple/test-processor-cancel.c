@@ -0,0 +1,202 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define SIZE       512
+#define N_CANCELS  200
+#define EPSILON    1e-6
+
+typedef struct
+{
+  GeglProcessor *processor;
+  gint           done;
+} Canceller;
+
+static GeglNode *
+create_graph (GeglNode **node)
+{
+  GeglNode *graph = gegl_node_new ();
+  GeglNode *source;
+  GeglNode *blur;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                "x",         13,
+                                "y",         7,
+                                NULL);
+  blur   = gegl_node_new_child (graph,
+                                "operation", "gegl:gaussian-blur",
+                                "std-dev-x", 8.0,
+                                "std-dev-y", 8.0,
+                                NULL);
+  *node  = gegl_node_new_child (graph,
+                                "operation", "gegl:invert-linear",
+                                NULL);
+
+  gegl_node_link_many (source, blur, *node, NULL);
+
+  return graph;
+}
+
+static gfloat *
+render_reference (void)
+{
+  GeglNode *node;
+  GeglNode *graph = create_graph (&node);
+  gfloat   *data;
+
+  data = test_render (node, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                      babl_format ("RGBA float"), GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+
+  return data;
+}
+
+/* compares the cache of @node, without rendering anything, with @expected */
+static gint
+compare_cache (GeglNode     *node,
+               const gfloat *expected)
+{
+  gfloat *data;
+  gint    status;
+
+  data   = test_render (node, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                        babl_format ("RGBA float"),
+                        GEGL_BLIT_CACHE | GEGL_BLIT_DIRTY);
+  status = test_compare (data, expected, SIZE, 4,
+                         GEGL_RECTANGLE (0, 0, SIZE, SIZE), EPSILON);
+
+  g_free (data);
+
+  return status;
+}
+
+static gpointer
+cancel_thread (Canceller *canceller)
+{
+  gint i;
+
+  for (i = 0; i < N_CANCELS && ! g_atomic_int_get (&canceller->done); i++)
+    {
+      gegl_processor_cancel (canceller->processor);
+
+      g_usleep (g_random_int_range (50, 500));
+    }
+
+  return NULL;
+}
+
+/* cancelling gegl_processor_work() before it starts leaves the chunk
+ * unrendered, and the processor renders it later
+ */
+static gint
+test_cancel_before_work (void)
+{
+  GeglNode      *node;
+  GeglNode      *graph     = create_graph (&node);
+  gfloat        *expected  = render_reference ();
+  GeglProcessor *processor;
+  gint           status    = SUCCESS;
+
+  processor = gegl_node_new_processor (node,
+                                       GEGL_RECTANGLE (0, 0, SIZE, SIZE));
+
+  gegl_processor_cancel (processor);
+
+  if (! gegl_processor_work (processor, NULL))
+    {
+      printf ("\n  no work left after a cancelled call");
+
+      status = FAILURE;
+    }
+
+  while (gegl_processor_work (processor, NULL));
+
+  if (compare_cache (node, expected) != SUCCESS)
+    status = FAILURE;
+
+  g_object_unref (processor);
+  g_object_unref (graph);
+  g_free (expected);
+
+  return status;
+}
+
+/* cancelling at arbitrary points while rendering, and re-rendering the
+ * cancelled chunks, gives the same result as an uncancelled render
+ */
+static gint
+test_cancel_during_work (void)
+{
+  GeglNode      *node;
+  GeglNode      *graph     = create_graph (&node);
+  gfloat        *expected  = render_reference ();
+  Canceller      canceller;
+  GThread       *thread;
+  gint           status    = SUCCESS;
+
+  canceller.processor = gegl_node_new_processor (node,
+                                                 GEGL_RECTANGLE (0, 0,
+                                                                 SIZE, SIZE));
+  canceller.done      = FALSE;
+
+  thread = g_thread_new ("canceller", (GThreadFunc) cancel_thread, &canceller);
+
+  while (gegl_processor_work (canceller.processor, NULL));
+
+  g_atomic_int_set (&canceller.done, TRUE);
+  g_thread_join (thread);
+
+  /* the last cancellation may have hit the final call */
+  while (gegl_processor_work (canceller.processor, NULL));
+
+  if (compare_cache (node, expected) != SUCCESS)
+    status = FAILURE;
+
+  g_object_unref (canceller.processor);
+  g_object_unref (graph);
+  g_free (expected);
+
+  return status;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* small chunks, so that cancellations hit different chunks */
+  g_object_set (gegl_config (),
+                "chunk-size", 64 * 64,
+                NULL);
+
+  RUN_TEST (cancel_before_work);
+  RUN_TEST (cancel_during_work);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,157 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+typedef struct
+{
+  GeglRectangle rectangle;
+  GeglRectangle last;
+  gint          tile_width;
+  gint          tile_height;
+  gint          n_chunks;
+  gint          area;
+  gboolean      aligned;
+} Chunks;
+
+static gboolean
+on_grid (gint position,
+         gint edge,
+         gint tile_size)
+{
+  return position == edge || ((position % tile_size) + tile_size) % tile_size == 0;
+}
+
+static void
+computed (GeglNode            *node,
+          const GeglRectangle *rect,
+          Chunks              *chunks)
+{
+  const GeglRectangle *r = &chunks->rectangle;
+
+  /* both the node and the processor report each chunk to the cache */
+  if (gegl_rectangle_equal (rect, &chunks->last))
+    return;
+
+  chunks->last = *rect;
+
+  chunks->n_chunks++;
+  chunks->area += rect->width * rect->height;
+
+  if (! gegl_rectangle_contains (r, rect) ||
+      ! on_grid (rect->x, r->x, chunks->tile_width) ||
+      ! on_grid (rect->x + rect->width, r->x + r->width, chunks->tile_width) ||
+      ! on_grid (rect->y, r->y, chunks->tile_height) ||
+      ! on_grid (rect->y + rect->height, r->y + r->height, chunks->tile_height))
+    {
+      printf ("\n  chunk %d,%d %dx%d is not on the tile grid",
+              rect->x, rect->y, rect->width, rect->height);
+
+      chunks->aligned = FALSE;
+    }
+}
+
+/* the chunks rendered by a processor start and end on the tile grid of the
+ * cache, except at the edges of the rendered rectangle
+ */
+static gint
+test_chunks_on_tile_grid (gdouble std_dev)
+{
+  GeglNode      *graph = gegl_node_new ();
+  GeglNode      *source;
+  GeglNode      *blur;
+  GeglProcessor *processor;
+  Chunks         chunks = { { -50, 30, 700, 500 }, { 0, }, 0, 0, 0, 0, TRUE };
+  gint           status = SUCCESS;
+
+  g_object_get (gegl_config (),
+                "tile-width",  &chunks.tile_width,
+                "tile-height", &chunks.tile_height,
+                NULL);
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                NULL);
+  blur   = gegl_node_new_child (graph,
+                                "operation", "gegl:gaussian-blur",
+                                "std-dev-x", std_dev,
+                                "std-dev-y", std_dev,
+                                NULL);
+
+  gegl_node_link (source, blur);
+
+  g_signal_connect (blur, "computed", G_CALLBACK (computed), &chunks);
+
+  processor = gegl_node_new_processor (blur, &chunks.rectangle);
+
+  while (gegl_processor_work (processor, NULL));
+
+  if (! chunks.aligned)
+    status = FAILURE;
+
+  /* the rectangle is rendered in more than one chunk, each of them once */
+  if (chunks.n_chunks < 2 ||
+      chunks.area != chunks.rectangle.width * chunks.rectangle.height)
+    {
+      printf ("\n  %d chunks, covering %d pixels",
+              chunks.n_chunks, chunks.area);
+
+      status = FAILURE;
+    }
+
+  g_object_unref (processor);
+  g_object_unref (graph);
+
+  return status;
+}
+
+static gint
+test_point_chunks (void)
+{
+  return test_chunks_on_tile_grid (0.0);
+}
+
+static gint
+test_area_chunks (void)
+{
+  return test_chunks_on_tile_grid (20.0);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* small chunks, so that the rectangle is split */
+  g_object_set (gegl_config (),
+                "chunk-size", 128 * 128,
+                "threads",    1,
+                NULL);
+
+  RUN_TEST (point_chunks);
+  RUN_TEST (area_chunks);
+
+  gegl_exit ();
+
+  return result;
+}
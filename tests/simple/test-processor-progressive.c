@@ -0,0 +1,253 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define PREVIEW_LEVEL 2
+
+/* the rendered rectangle doesn't overlap itself at the preview level */
+static const GeglRectangle rectangle = { 512, 512, 1024, 1024 };
+
+typedef struct
+{
+  GArray *rects;
+} Computed;
+
+static void
+computed (GeglNode            *node,
+          const GeglRectangle *rect,
+          Computed            *c)
+{
+  /* both the node and the processor report each chunk to the cache */
+  if (c->rects->len > 0 &&
+      gegl_rectangle_equal (rect, &g_array_index (c->rects, GeglRectangle,
+                                                  c->rects->len - 1)))
+    return;
+
+  g_array_append_val (c->rects, *rect);
+}
+
+static GeglNode *
+create_graph (GeglNode **node)
+{
+  GeglNode *graph = gegl_node_new ();
+  GeglNode *source;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                NULL);
+  *node  = gegl_node_new_child (graph,
+                                "operation", "gegl:invert-linear",
+                                NULL);
+
+  gegl_node_link (source, *node);
+
+  return graph;
+}
+
+/* the first chunk rendered contains the center of the priority rectangle */
+static gint
+test_priority_first (void)
+{
+  GeglRectangle  priority = { 1300, 1400, 100, 80 };
+  Computed       c;
+  GeglNode      *node;
+  GeglNode      *graph    = create_graph (&node);
+  GeglProcessor *processor;
+  GeglRectangle *first;
+  gint           status   = SUCCESS;
+
+  c.rects = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
+  g_signal_connect (node, "computed", G_CALLBACK (computed), &c);
+
+  processor = gegl_node_new_processor (node, &rectangle);
+  gegl_processor_set_priority_rectangle (processor, &priority);
+
+  while (c.rects->len == 0 && gegl_processor_work (processor, NULL));
+
+  first = &g_array_index (c.rects, GeglRectangle, 0);
+
+  if (c.rects->len == 0 ||
+      ! gegl_rectangle_contains (first,
+                                 GEGL_RECTANGLE (priority.x +
+                                                 priority.width / 2,
+                                                 priority.y +
+                                                 priority.height / 2,
+                                                 1, 1)))
+    {
+      printf ("\n  the first chunk doesn't contain the priority center");
+
+      status = FAILURE;
+    }
+
+  g_array_free (c.rects, TRUE);
+
+  g_object_unref (processor);
+  g_object_unref (graph);
+
+  return status;
+}
+
+/* with a preview level, the rectangle is rendered at the preview level
+ * first, and then completely at level 0
+ */
+static gint
+test_preview_refined (void)
+{
+  GeglRectangle  preview = { rectangle.x >> PREVIEW_LEVEL,
+                             rectangle.y >> PREVIEW_LEVEL,
+                             rectangle.width >> PREVIEW_LEVEL,
+                             rectangle.height >> PREVIEW_LEVEL };
+  Computed       c;
+  GeglNode      *node;
+  GeglNode      *graph    = create_graph (&node);
+  GeglProcessor *processor;
+  gdouble        progress = 0.0;
+  gint           last_preview = -1;
+  gint           area     = 0;
+  gint           status   = SUCCESS;
+  gint           i;
+
+  c.rects = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
+  g_signal_connect (node, "computed", G_CALLBACK (computed), &c);
+
+  processor = gegl_node_new_processor (node, &rectangle);
+  gegl_processor_set_preview_level (processor, PREVIEW_LEVEL);
+
+  while (gegl_processor_work (processor, &progress));
+
+  /* the chunks of the preview are reported in the coordinates of the
+   * preview level, which don't overlap the rectangle
+   */
+  for (i = 0; i < c.rects->len; i++)
+    {
+      if (gegl_rectangle_contains (&preview,
+                                   &g_array_index (c.rects, GeglRectangle, i)))
+        last_preview = i;
+    }
+
+  for (i = last_preview + 1; i < c.rects->len; i++)
+    {
+      GeglRectangle *rect = &g_array_index (c.rects, GeglRectangle, i);
+
+      if (gegl_rectangle_contains (&rectangle, rect))
+        area += rect->width * rect->height;
+    }
+
+  if (last_preview < 0)
+    {
+      printf ("\n  no preview was rendered");
+
+      status = FAILURE;
+    }
+  else if (area != rectangle.width * rectangle.height)
+    {
+      printf ("\n  the refinement covers %d of %d pixels",
+              area, rectangle.width * rectangle.height);
+
+      status = FAILURE;
+    }
+  else if (progress != 1.0)
+    {
+      printf ("\n  the progress ended at %f", progress);
+
+      status = FAILURE;
+    }
+
+  g_array_free (c.rects, TRUE);
+
+  g_object_unref (processor);
+  g_object_unref (graph);
+
+  return status;
+}
+
+/* with a generous time budget, a single call renders everything */
+static gint
+test_time_budget (void)
+{
+  Computed       c;
+  GeglNode      *node;
+  GeglNode      *graph  = create_graph (&node);
+  GeglProcessor *processor;
+  gint           area   = 0;
+  gint           status = SUCCESS;
+  gint           i;
+
+  c.rects = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
+  g_signal_connect (node, "computed", G_CALLBACK (computed), &c);
+
+  processor = gegl_node_new_processor (node, &rectangle);
+  gegl_processor_set_time_budget (processor, 60.0);
+
+  if (gegl_processor_work (processor, NULL))
+    {
+      printf ("\n  there is work left after the first call");
+
+      status = FAILURE;
+    }
+
+  for (i = 0; i < c.rects->len; i++)
+    {
+      GeglRectangle *rect = &g_array_index (c.rects, GeglRectangle, i);
+
+      area += rect->width * rect->height;
+    }
+
+  if (c.rects->len < 2 || area != rectangle.width * rectangle.height)
+    {
+      printf ("\n  %d chunks covering %d pixels", c.rects->len, area);
+
+      status = FAILURE;
+    }
+
+  g_array_free (c.rects, TRUE);
+
+  g_object_unref (processor);
+  g_object_unref (graph);
+
+  return status;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* small chunks, so that the rectangle is split */
+  g_object_set (gegl_config (),
+                "chunk-size", 128 * 128,
+                "threads",    1,
+                NULL);
+
+  RUN_TEST (priority_first);
+  RUN_TEST (preview_refined);
+  RUN_TEST (time_budget);
+
+  gegl_exit ();
+
+  return result;
+}
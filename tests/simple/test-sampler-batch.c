@@ -0,0 +1,219 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+#include "buffer/gegl-sampler.h"
+
+#include "test-common.h"
+
+#define WIDTH      61
+#define HEIGHT     47
+#define N_SAMPLES  300
+#define EPSILON    1e-5
+
+static GeglBuffer *
+create_buffer (void)
+{
+  return test_pattern_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                                  babl_format ("R'G'B'A u8"), 0);
+}
+
+/* compares gegl_sampler_get_line() and gegl_sampler_get_n() against
+ * sampling each point separately
+ */
+static gint
+compare_samples (GeglBuffer        *buffer,
+                 GeglSamplerType    sampler_type,
+                 GeglBufferMatrix2 *scale,
+                 GeglAbyssPolicy    abyss_policy)
+{
+  const Babl        *format  = babl_format ("RaGaBaA float");
+  GeglSampler       *sampler = gegl_buffer_sampler_new (buffer, format,
+                                                        sampler_type);
+  GeglSamplerGetFun  get     = gegl_sampler_get_fun (sampler);
+  gdouble            x[N_SAMPLES];
+  gdouble            y[N_SAMPLES];
+  gfloat             expected[N_SAMPLES * 4];
+  gfloat             line[N_SAMPLES * 4];
+  gfloat             points[N_SAMPLES * 4];
+  gdouble            u  = -13.3;
+  gdouble            v  = -4.9;
+  const gdouble      du = 0.283;
+  const gdouble      dv = 0.217;
+  gint               result = SUCCESS;
+  gint               i;
+
+  for (i = 0; i < N_SAMPLES; i++)
+    {
+      x[i] = u;
+      y[i] = v;
+
+      get (sampler, u, v, scale, expected + 4 * i, abyss_policy);
+
+      u += du;
+      v += dv;
+    }
+
+  gegl_sampler_get_line (sampler, x[0], y[0], du, dv, N_SAMPLES,
+                         scale, line, abyss_policy);
+
+  /* sample the points in reverse order, so that they don't form a line */
+  for (i = 0; i < N_SAMPLES / 2; i++)
+    {
+      gdouble t;
+
+      t = x[i]; x[i] = x[N_SAMPLES - 1 - i]; x[N_SAMPLES - 1 - i] = t;
+      t = y[i]; y[i] = y[N_SAMPLES - 1 - i]; y[N_SAMPLES - 1 - i] = t;
+    }
+
+  gegl_sampler_get_n (sampler, x, y, N_SAMPLES, scale, points, abyss_policy);
+
+  for (i = 0; i < N_SAMPLES * 4; i++)
+    {
+      gfloat reversed = points[(N_SAMPLES - 1 - i / 4) * 4 + i % 4];
+
+      if (fabs (line[i] - expected[i]) > EPSILON ||
+          fabs (reversed - expected[i]) > EPSILON)
+        {
+          printf ("\n  sampler %d, abyss %d, sample %d: expected %g, "
+                  "got %g and %g",
+                  sampler_type, abyss_policy, i / 4,
+                  expected[i], line[i], reversed);
+
+          result = FAILURE;
+          break;
+        }
+    }
+
+  g_object_unref (sampler);
+
+  return result;
+}
+
+static gint
+test_sampler_batch (GeglBufferMatrix2 *scale)
+{
+  const GeglSamplerType sampler_types[] = { GEGL_SAMPLER_NEAREST,
+                                            GEGL_SAMPLER_LINEAR,
+                                            GEGL_SAMPLER_CUBIC,
+                                            GEGL_SAMPLER_NOHALO,
+                                            GEGL_SAMPLER_LOHALO };
+  const GeglAbyssPolicy abyss_policies[] = { GEGL_ABYSS_NONE,
+                                             GEGL_ABYSS_CLAMP,
+                                             GEGL_ABYSS_LOOP,
+                                             GEGL_ABYSS_BLACK,
+                                             GEGL_ABYSS_WHITE };
+  GeglBuffer           *buffer = create_buffer ();
+  gint                  result = SUCCESS;
+  gint                  i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (sampler_types); i++)
+    {
+      for (j = 0; j < G_N_ELEMENTS (abyss_policies); j++)
+        {
+          if (compare_samples (buffer, sampler_types[i], scale,
+                               abyss_policies[j]) != SUCCESS)
+            {
+              result = FAILURE;
+            }
+        }
+    }
+
+  g_object_unref (buffer);
+
+  return result;
+}
+
+/* the samplers with a batch function of their own use it, rather than the
+ * generic one, which samples each point separately
+ */
+static gint
+test_batch_functions (void)
+{
+  const GeglSamplerType  sampler_types[] = { GEGL_SAMPLER_NEAREST,
+                                             GEGL_SAMPLER_LINEAR,
+                                             GEGL_SAMPLER_CUBIC };
+  GeglBuffer            *buffer          = create_buffer ();
+  GeglSamplerClass      *generic_class   = g_type_class_ref (GEGL_TYPE_SAMPLER);
+  gint                   result          = SUCCESS;
+  gint                   i;
+
+  for (i = 0; i < G_N_ELEMENTS (sampler_types); i++)
+    {
+      GeglSampler *sampler = gegl_buffer_sampler_new (buffer,
+                                                      babl_format ("RaGaBaA float"),
+                                                      sampler_types[i]);
+
+      if (GEGL_SAMPLER_GET_CLASS (sampler)->get_n == generic_class->get_n ||
+          sampler->get_n != GEGL_SAMPLER_GET_CLASS (sampler)->get_n)
+        {
+          printf ("\n  sampler %d doesn't use its batch function",
+                  sampler_types[i]);
+
+          result = FAILURE;
+        }
+
+      g_object_unref (sampler);
+    }
+
+  g_type_class_unref (generic_class);
+  g_object_unref (buffer);
+
+  return result;
+}
+
+static gint
+test_point_sampling (void)
+{
+  return test_sampler_batch (NULL);
+}
+
+static gint
+test_affine_sampling (void)
+{
+  GeglBufferMatrix2 scale = {{{ 0.9, 0.3 }, { -0.2, 1.1 }}};
+
+  return test_sampler_batch (&scale);
+}
+
+static gint
+test_box_filtered_sampling (void)
+{
+  GeglBufferMatrix2 scale = {{{ 2.7, 0.0 }, { 0.0, 3.4 }}};
+
+  return test_sampler_batch (&scale);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (batch_functions);
+  RUN_TEST (point_sampling);
+  RUN_TEST (affine_sampling);
+  RUN_TEST (box_filtered_sampling);
+
+  gegl_exit ();
+
+  return result;
+}
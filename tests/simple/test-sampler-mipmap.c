@@ -0,0 +1,154 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define SIZE       256
+#define EPSILON    1e-4
+
+/* a checkerboard of single black and white pixels, all of whose mipmap
+ * levels are uniformly gray
+ */
+static GeglBuffer *
+create_checkerboard (void)
+{
+  const Babl *format = babl_format ("RGBA float");
+  GeglBuffer *buffer;
+  gfloat     *data;
+  gint        x, y, c;
+
+  data = g_new (gfloat, SIZE * SIZE * 4);
+
+  for (y = 0; y < SIZE; y++)
+    {
+      for (x = 0; x < SIZE; x++)
+        {
+          gfloat *pixel = data + (y * SIZE + x) * 4;
+
+          for (c = 0; c < 3; c++)
+            pixel[c] = (x + y) % 2;
+
+          pixel[3] = 1.0f;
+        }
+    }
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE), format, data);
+
+  g_free (data);
+
+  return buffer;
+}
+
+/* samples the checkerboard with footprints larger than the box filter
+ * covers, which should average it to gray rather than alias
+ */
+static gint
+test_footprint (GeglSamplerType    sampler_type,
+                GeglBufferMatrix2 *scale)
+{
+  GeglBuffer  *buffer  = create_checkerboard ();
+  GeglSampler *sampler = gegl_buffer_sampler_new (buffer,
+                                                  babl_format ("RGBA float"),
+                                                  sampler_type);
+  gint         result  = SUCCESS;
+  gint         x, y, c;
+
+  for (y = SIZE / 4; y < 3 * SIZE / 4 && result == SUCCESS; y += 7)
+    {
+      for (x = SIZE / 4; x < 3 * SIZE / 4 && result == SUCCESS; x += 5)
+        {
+          gfloat pixel[4];
+
+          gegl_sampler_get (sampler, x + 0.5, y + 0.5, scale, pixel,
+                            GEGL_ABYSS_NONE);
+
+          for (c = 0; c < 3; c++)
+            {
+              if (fabs (pixel[c] - 0.5) > EPSILON)
+                {
+                  printf ("\n  sampler %d, (%d, %d): expected 0.5, got %g",
+                          sampler_type, x, y, pixel[c]);
+
+                  result = FAILURE;
+                  break;
+                }
+            }
+        }
+    }
+
+  g_object_unref (sampler);
+  g_object_unref (buffer);
+
+  return result;
+}
+
+static gint
+test_footprints (GeglBufferMatrix2 *scale)
+{
+  if (test_footprint (GEGL_SAMPLER_LINEAR, scale) != SUCCESS ||
+      test_footprint (GEGL_SAMPLER_CUBIC,  scale) != SUCCESS)
+    {
+      return FAILURE;
+    }
+
+  return SUCCESS;
+}
+
+static gint
+test_isotropic_footprint (void)
+{
+  GeglBufferMatrix2 scale = {{{ 16.0, 0.0 }, { 0.0, 16.0 }}};
+
+  return test_footprints (&scale);
+}
+
+static gint
+test_anisotropic_footprint (void)
+{
+  GeglBufferMatrix2 scale = {{{ 20.0, 0.0 }, { 0.0, 1.5 }}};
+
+  return test_footprints (&scale);
+}
+
+static gint
+test_rotated_footprint (void)
+{
+  GeglBufferMatrix2 scale = {{{ 12.0, -12.0 }, { 12.0, 12.0 }}};
+
+  return test_footprints (&scale);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (isotropic_footprint);
+  RUN_TEST (anisotropic_footprint);
+  RUN_TEST (rotated_footprint);
+
+  gegl_exit ();
+
+  return result;
+}
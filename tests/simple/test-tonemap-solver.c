@@ -0,0 +1,195 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define SIZE      128
+#define STEP      16
+#define N_SAMPLES (SIZE / STEP)
+#define TOLERANCE 2e-3
+
+/* the output of the single-threaded solvers the gradient-domain tone
+ * mappers used before solver-common.h, with the default properties, sampled
+ * at the centers of STEP x STEP squares
+ */
+static const gfloat fattal02_reference[N_SAMPLES * N_SAMPLES] =
+{
+  0.018707f, 0.032894f, 0.037837f, 0.041936f, 0.046891f, 0.051491f, 0.055966f, 0.061598f,
+  0.026003f, 0.033840f, 0.032710f, 0.035428f, 0.044448f, 0.053331f, 0.058171f, 0.063595f,
+  0.029262f, 0.030917f, 0.923661f, 0.860353f, 0.039409f, 0.053403f, 0.059370f, 0.064575f,
+  0.032553f, 0.032615f, 0.895504f, 0.834318f, 0.040790f, 0.054755f, 0.060484f, 0.065496f,
+  0.036849f, 0.040208f, 0.037755f, 0.040196f, 0.049576f, 0.057683f, 0.061856f, 0.066594f,
+  0.040910f, 0.047843f, 0.050377f, 0.053113f, 0.056904f, 0.060226f, 0.063498f, 0.067899f,
+  0.044747f, 0.051735f, 0.055286f, 0.057808f, 0.060100f, 0.062535f, 0.065319f, 0.069365f,
+  0.049218f, 0.055766f, 0.058964f, 0.061214f, 0.063186f, 0.065257f, 0.067670f, 0.071398f
+};
+
+static const gfloat mantiuk06_reference[N_SAMPLES * N_SAMPLES] =
+{
+  0.018986f, 0.044660f, 0.074810f, 0.109673f, 0.151215f, 0.205736f, 0.273794f, 0.362931f,
+  0.033833f, 0.069055f, 0.108010f, 0.144707f, 0.181832f, 0.243461f, 0.319672f, 0.417399f,
+  0.049987f, 0.100085f, 0.888551f, 0.930652f, 0.201976f, 0.280739f, 0.367097f, 0.474189f,
+  0.066734f, 0.121428f, 0.915847f, 0.964763f, 0.236522f, 0.325583f, 0.421316f, 0.538020f,
+  0.084006f, 0.132479f, 0.166632f, 0.216381f, 0.290908f, 0.382162f, 0.484339f, 0.610765f,
+  0.105038f, 0.157894f, 0.206629f, 0.267089f, 0.347970f, 0.444003f, 0.553142f, 0.689328f,
+  0.131183f, 0.190893f, 0.249434f, 0.319198f, 0.406450f, 0.508433f, 0.626967f, 0.773417f,
+  0.166015f, 0.233719f, 0.299668f, 0.377128f, 0.471504f, 0.580657f, 0.707519f, 0.863867f
+};
+
+/* a bright square on a gradient, with a dim checkerboard */
+static GeglBuffer *
+create_buffer (void)
+{
+  const Babl *format = babl_format ("Y float");
+  GeglBuffer *buffer;
+  gfloat     *data;
+  gint        x, y;
+
+  data = g_new (gfloat, SIZE * SIZE);
+
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        gfloat value = 0.02f + 0.5f * x / SIZE + 0.25f * y / SIZE;
+
+        if ((x / 4 + y / 4) % 2)
+          value *= 0.5f;
+
+        if (x >= SIZE / 4 && x < SIZE / 2 && y >= SIZE / 4 && y < SIZE / 2)
+          value = 40.0f;
+
+        data[y * SIZE + x] = value;
+      }
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE), format, data);
+
+  g_free (data);
+
+  return buffer;
+}
+
+/* renders @operation with @threads threads, in a graph of its own, so that
+ * nothing is reused between renders
+ */
+static gfloat *
+render (const gchar *operation,
+        gint         threads)
+{
+  GeglBuffer *buffer = create_buffer ();
+  GeglNode   *graph  = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *filter;
+  gfloat     *data;
+  gint        old_threads;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  filter = gegl_node_new_child (graph,
+                                "operation", operation,
+                                NULL);
+
+  gegl_node_link (source, filter);
+
+  old_threads = test_set_threads (threads);
+
+  data = test_render (filter, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                      babl_format ("Y float"), GEGL_BLIT_DEFAULT);
+
+  test_set_threads (old_threads);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return data;
+}
+
+/* the result matches the previous solver, and doesn't depend on the number
+ * of threads
+ */
+static gint
+test_tonemap (const gchar  *operation,
+              const gfloat *reference)
+{
+  gfloat *result  = render (operation, 1);
+  gfloat *result4 = render (operation, 4);
+  gint    status  = SUCCESS;
+  gint    x, y;
+
+  for (y = 0; y < N_SAMPLES && status == SUCCESS; y++)
+    for (x = 0; x < N_SAMPLES && status == SUCCESS; x++)
+      {
+        gfloat value = result[(y * STEP + STEP / 2) * SIZE +
+                              (x * STEP + STEP / 2)];
+
+        if (! (fabs (value - reference[y * N_SAMPLES + x]) <= TOLERANCE))
+          {
+            printf ("\n  pixel %d,%d: expected %g, got %g",
+                    x * STEP + STEP / 2, y * STEP + STEP / 2,
+                    reference[y * N_SAMPLES + x], value);
+
+            status = FAILURE;
+          }
+      }
+
+  if (status == SUCCESS &&
+      test_compare (result4, result, SIZE, 1,
+                    GEGL_RECTANGLE (0, 0, SIZE, SIZE), 0.0) != SUCCESS)
+    {
+      printf (" with 4 threads");
+
+      status = FAILURE;
+    }
+
+  g_free (result);
+  g_free (result4);
+
+  return status;
+}
+
+static gint
+test_fattal02 (void)
+{
+  return test_tonemap ("gegl:fattal02", fattal02_reference);
+}
+
+static gint
+test_mantiuk06 (void)
+{
+  return test_tonemap ("gegl:mantiuk06", mantiuk06_reference);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (fattal02);
+  RUN_TEST (mantiuk06);
+
+  gegl_exit ();
+
+  return result;
+}
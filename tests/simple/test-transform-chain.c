@@ -0,0 +1,145 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define SIZE       32
+#define EPSILON    1e-5
+
+/* translating by half a pixel, applying a point filter which commutes with
+ * transforms, and translating back, should resample the input once, by the
+ * identity, rather than blur it twice, when @fused; the point filter doesn't
+ * commute with the interpolation of the non-linear samplers, so with those,
+ * the input should be resampled twice.
+ */
+static gint
+test_chain (GeglSamplerType sampler,
+            gboolean        fused)
+{
+  const Babl          *format = babl_format ("RGBA float");
+  const GeglRectangle *rect   = GEGL_RECTANGLE (0, 0, SIZE, SIZE);
+  GeglBuffer          *buffer = test_pattern_buffer_new (rect, format, 0);
+  GeglNode            *graph  = gegl_node_new ();
+  GeglNode            *source;
+  GeglNode            *translate1;
+  GeglNode            *invert;
+  GeglNode            *translate2;
+  GeglNode            *reference;
+  gfloat              *result;
+  gfloat              *expected;
+  gint                 status = SUCCESS;
+
+  source     = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    buffer,
+                                    NULL);
+  translate1 = gegl_node_new_child (graph,
+                                    "operation", "gegl:translate",
+                                    "x",         0.5,
+                                    "sampler",   sampler,
+                                    NULL);
+  invert     = gegl_node_new_child (graph,
+                                    "operation", "gegl:invert-linear",
+                                    NULL);
+  translate2 = gegl_node_new_child (graph,
+                                    "operation", "gegl:translate",
+                                    "x",         -0.5,
+                                    "sampler",   sampler,
+                                    NULL);
+  reference  = gegl_node_new_child (graph,
+                                    "operation", "gegl:invert-linear",
+                                    NULL);
+
+  gegl_node_link_many (source, translate1, invert, translate2, NULL);
+  gegl_node_link (source, reference);
+
+  result   = test_render (translate2, 1.0, rect, format, GEGL_BLIT_DEFAULT);
+  expected = test_render (reference,  1.0, rect, format, GEGL_BLIT_DEFAULT);
+
+  if (fused)
+    {
+      status = test_compare (result, expected, SIZE, 4, rect, EPSILON);
+
+      if (status != SUCCESS)
+        printf ("\n  sampler %d: the input was resampled twice", sampler);
+    }
+  else
+    {
+      gint i;
+
+      for (i = 0; i < SIZE * SIZE * 4; i++)
+        {
+          if (fabs (result[i] - expected[i]) > EPSILON)
+            break;
+        }
+
+      if (i == SIZE * SIZE * 4)
+        {
+          printf ("\n  sampler %d: the input was resampled once", sampler);
+
+          status = FAILURE;
+        }
+    }
+
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+static gint
+test_transparent_point_filter (void)
+{
+  if (test_chain (GEGL_SAMPLER_LINEAR, TRUE) != SUCCESS ||
+      test_chain (GEGL_SAMPLER_CUBIC,  TRUE) != SUCCESS)
+    return FAILURE;
+
+  return SUCCESS;
+}
+
+static gint
+test_non_linear_sampler (void)
+{
+  if (test_chain (GEGL_SAMPLER_LOHALO, FALSE) != SUCCESS ||
+      test_chain (GEGL_SAMPLER_NOHALO, FALSE) != SUCCESS)
+    return FAILURE;
+
+  return SUCCESS;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (transparent_point_filter);
+  RUN_TEST (non_linear_sampler);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,177 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define WIDTH      200
+#define HEIGHT     160
+#define MARGIN     3
+#define EPSILON    1e-3
+
+/* a shear too small to change the result, but large enough for the matrix
+ * not to be a scale, so that transform_affine() is used rather than the
+ * separable path
+ */
+#define SHEAR      1e-7
+
+static GeglBuffer *
+create_buffer (void)
+{
+  const Babl *format = babl_format ("RaGaBaA float");
+  GeglBuffer *buffer;
+  GRand      *rand   = g_rand_new_with_seed (0);
+  gfloat     *data;
+  gint        i;
+
+  data = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    data[i] = i % 4 == 3 ? 1.0f : g_rand_double (rand);
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format, data);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static GeglNode *
+create_transform (GeglNode       *graph,
+                  GeglNode       *source,
+                  gdouble         scale_x,
+                  gdouble         scale_y,
+                  gdouble         shear,
+                  GeglSamplerType sampler)
+{
+  GeglNode *node;
+  gchar    *transform;
+
+  /* the columns of the matrix */
+  transform = g_strdup_printf ("matrix(%.9g,0,0,%.9g,%.9g,0,%.9g,%.9g,1)",
+                               scale_x, shear, scale_y, 3.25, -2.5);
+
+  node = gegl_node_new_child (graph,
+                              "operation", "gegl:transform",
+                              "transform", transform,
+                              "sampler",   sampler,
+                              NULL);
+
+  gegl_node_link (source, node);
+
+  g_free (transform);
+
+  return node;
+}
+
+/* scaling down through the separable path matches transform_affine() */
+static gint
+test_scale (gdouble         scale_x,
+            gdouble         scale_y,
+            GeglSamplerType sampler)
+{
+  GeglBuffer    *buffer = create_buffer ();
+  GeglNode      *graph  = gegl_node_new ();
+  GeglNode      *source;
+  GeglNode      *separable;
+  GeglNode      *affine;
+  GeglRectangle  rect;
+  gfloat        *result;
+  gfloat        *expected;
+  gint           status;
+
+  source    = gegl_node_new_child (graph,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    buffer,
+                                   NULL);
+  separable = create_transform (graph, source, scale_x, scale_y, 0.0, sampler);
+  affine    = create_transform (graph, source, scale_x, scale_y, SHEAR, sampler);
+
+  rect = gegl_node_get_bounding_box (separable);
+
+  result   = test_render (separable, 1.0, &rect,
+                          babl_format ("RaGaBaA float"), GEGL_BLIT_DEFAULT);
+  expected = test_render (affine,    1.0, &rect,
+                          babl_format ("RaGaBaA float"), GEGL_BLIT_DEFAULT);
+
+  /* the pixels on the edges depend on the scanline limits, which the shear
+   * may move.  the pixels are reported relative to the bounding box.
+   */
+  status = test_compare (result, expected, rect.width, 4,
+                         GEGL_RECTANGLE (MARGIN, MARGIN,
+                                         rect.width  - 2 * MARGIN,
+                                         rect.height - 2 * MARGIN),
+                         EPSILON);
+
+  if (status != SUCCESS)
+    printf (", at scale %g x %g", scale_x, scale_y);
+
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+static gint
+test_scales (GeglSamplerType sampler)
+{
+  /* interpolation only, box averaging, mirrored, and past the box filter,
+   * where the mipmap levels are sampled
+   */
+  if (test_scale (0.7,   0.8,  sampler) != SUCCESS ||
+      test_scale (0.3,   0.45, sampler) != SUCCESS ||
+      test_scale (-0.45, 0.2,  sampler) != SUCCESS ||
+      test_scale (0.6,   0.15, sampler) != SUCCESS)
+    return FAILURE;
+
+  return SUCCESS;
+}
+
+static gint
+test_linear (void)
+{
+  return test_scales (GEGL_SAMPLER_LINEAR);
+}
+
+static gint
+test_cubic (void)
+{
+  return test_scales (GEGL_SAMPLER_CUBIC);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (linear);
+  RUN_TEST (cubic);
+
+  gegl_exit ();
+
+  return result;
+}
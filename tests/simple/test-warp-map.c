@@ -0,0 +1,230 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#include "test-common.h"
+
+#define WIDTH      160
+#define HEIGHT     120
+
+static GeglBuffer *
+create_buffer (gint width,
+               gint height)
+{
+  const Babl *format = babl_format ("R'G'B'A u8");
+  GeglBuffer *buffer;
+  guchar     *data;
+  gint        x, y;
+
+  data = g_new (guchar, width * height * 4);
+
+  /* a checkerboard, so that displacements are visible */
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        guchar value = (x / 8 + y / 8) % 2 ? 255 : 0;
+
+        data[(y * width + x) * 4 + 0] = value;
+        data[(y * width + x) * 4 + 1] = x;
+        data[(y * width + x) * 4 + 2] = y;
+        data[(y * width + x) * 4 + 3] = 255;
+      }
+
+  buffer = test_buffer_new (GEGL_RECTANGLE (0, 0, width, height), format, data);
+
+  g_free (data);
+
+  return buffer;
+}
+
+static guchar *
+render (GeglNode *node)
+{
+  return test_render (node, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                      babl_format ("R'G'B'A u8"), GEGL_BLIT_DEFAULT);
+}
+
+/* renders @operation, with the properties in @before, then with the
+ * properties in @after, and compares the second render with the render of a
+ * new node with the properties in @after.  the maps of the coordinates
+ * computed for the first render should be dropped, rather than reused.
+ *
+ * if @buffer_after is not NULL, it replaces the input for the second render.
+ */
+static gint
+test_rebuild (const gchar  *operation,
+              const gchar  *property,
+              const GValue *before,
+              const GValue *after,
+              GeglBuffer   *buffer_after)
+{
+  GeglBuffer *buffer = create_buffer (WIDTH, HEIGHT);
+  GeglNode   *graph  = gegl_node_new ();
+  GeglNode   *source;
+  GeglNode   *changed;
+  GeglNode   *fresh_source;
+  GeglNode   *fresh;
+  guchar     *first;
+  guchar     *result;
+  guchar     *expected;
+  gint        status = SUCCESS;
+
+  source       = gegl_node_new_child (graph,
+                                      "operation", "gegl:buffer-source",
+                                      "buffer",    buffer,
+                                      NULL);
+  changed      = gegl_node_new_child (graph,
+                                      "operation", operation,
+                                      NULL);
+  fresh_source = gegl_node_new_child (graph,
+                                      "operation", "gegl:buffer-source",
+                                      "buffer",    buffer_after ? buffer_after :
+                                                                  buffer,
+                                      NULL);
+  fresh        = gegl_node_new_child (graph,
+                                      "operation", operation,
+                                      NULL);
+
+  gegl_node_link (source, changed);
+  gegl_node_link (fresh_source, fresh);
+
+  if (before)
+    gegl_node_set_property (changed, property, before);
+
+  if (after)
+    gegl_node_set_property (fresh, property, after);
+
+  first = render (changed);
+
+  if (after)
+    gegl_node_set_property (changed, property, after);
+
+  if (buffer_after)
+    gegl_node_set (source, "buffer", buffer_after, NULL);
+
+  result   = render (changed);
+  expected = render (fresh);
+
+  if (! memcmp (first, expected, WIDTH * HEIGHT * 4))
+    {
+      printf ("\n  %s: the change doesn't affect the output", operation);
+
+      status = FAILURE;
+    }
+  else if (memcmp (result, expected, WIDTH * HEIGHT * 4))
+    {
+      printf ("\n  %s: the output after the change differs from the output "
+              "of a new node", operation);
+
+      status = FAILURE;
+    }
+
+  g_free (first);
+  g_free (result);
+  g_free (expected);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return status;
+}
+
+static gint
+test_double_property (const gchar *operation,
+                      const gchar *property,
+                      gdouble      before,
+                      gdouble      after)
+{
+  GValue value_before = G_VALUE_INIT;
+  GValue value_after  = G_VALUE_INIT;
+  gint   status;
+
+  g_value_init (&value_before, G_TYPE_DOUBLE);
+  g_value_init (&value_after,  G_TYPE_DOUBLE);
+
+  g_value_set_double (&value_before, before);
+  g_value_set_double (&value_after,  after);
+
+  status = test_rebuild (operation, property, &value_before, &value_after,
+                         NULL);
+
+  g_value_unset (&value_before);
+  g_value_unset (&value_after);
+
+  return status;
+}
+
+static gint
+test_spherize_amount (void)
+{
+  return test_double_property ("gegl:spherize", "amount", 0.5, -0.5);
+}
+
+static gint
+test_spherize_angle_of_view (void)
+{
+  return test_double_property ("gegl:spherize", "angle-of-view", 0.0, 60.0);
+}
+
+/* the map depends on the extent of the input, not only on the properties */
+static gint
+test_spherize_input_extent (void)
+{
+  GeglBuffer *buffer = create_buffer (WIDTH / 2, HEIGHT);
+  gint        status;
+
+  status = test_rebuild ("gegl:spherize", NULL, NULL, NULL, buffer);
+
+  g_object_unref (buffer);
+
+  return status;
+}
+
+static gint
+test_panorama_projection_pan (void)
+{
+  return test_double_property ("gegl:panorama-projection", "pan", 0.0, 45.0);
+}
+
+static gint
+test_panorama_projection_zoom (void)
+{
+  return test_double_property ("gegl:panorama-projection", "zoom",
+                               100.0, 50.0);
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  RUN_TEST (spherize_amount);
+  RUN_TEST (spherize_angle_of_view);
+  RUN_TEST (spherize_input_extent);
+  RUN_TEST (panorama_projection_pan);
+  RUN_TEST (panorama_projection_zoom);
+
+  gegl_exit ();
+
+  return result;
+}